@@ -1,15 +1,53 @@
+#define _DEFAULT_SOURCE
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Largest array size benchmarked by default; --max-size raises it up to 1e9
+#define DEFAULT_MAX_SIZE (1 << 26)
+#define LARGEST_SIZE 1000000000
+
+// Elements each thread of the parallel reduction gets at least
+#define PARALLEL_MIN_CHUNK 65536
+
+// Items removed in the multi-missing pass
+#define MAX_MISSING 16
+
+// Smallest buffer streamed to measure memory read bandwidth; it grows to
+// four times the last-level cache so no pass is served from the cache
+#define BANDWIDTH_MIN_BYTES ((size_t)256 << 20)
+
+// Instruction sets an algorithm needs
+enum { FEATURE_NONE = 0, FEATURE_AVX2, FEATURE_AVX512 };
+
+// Threads used by the parallel reduction, set from --threads
+static int benchmark_threads = 1;
 
-// Function to measure execution time
-double time_function(int (*func)(int*, int, int*, int), int* a, int size_a, int* b, int size_b) {
-    clock_t start = clock();
-    func(a, size_a, b, size_b);  // We don't need the result for timing
-    clock_t end = clock();
-    double elapsed = ((double)(end - start)) / CLOCKS_PER_SEC;
-    return elapsed;
+// Monotonic wall-clock seconds; CPU time would bill every thread
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int cpu_has(int feature) {
+#ifdef HAVE_X86_SIMD
+    if (feature == FEATURE_AVX2) return __builtin_cpu_supports("avx2");
+    if (feature == FEATURE_AVX512) return __builtin_cpu_supports("avx512f");
+#endif
+    return feature == FEATURE_NONE;
 }
 
 // XOR method - original approach
@@ -81,124 +119,1067 @@ int find_missing_linear(int* a, int size_a, int* b, int size_b) {
     return -1; // Not found
 }
 
-// Utility function to copy array
-void copy_array(int* src, int* dest, int size) {
+// Block kernels: XOR or sum of n contiguous ints. The vector versions use
+// unaligned loads and several independent accumulators, so the loop is
+// limited by load throughput instead of the latency of one dependency chain.
+static int xor_block_scalar(const int* data, size_t n) {
+    int result = 0;
+    for (size_t i = 0; i < n; i++) {
+        result ^= data[i];
+    }
+    return result;
+}
+
+static long long sum_block_scalar(const int* data, size_t n) {
+    long long sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+#ifdef HAVE_X86_SIMD
+__attribute__((target("avx2")))
+static int xor_block_avx2(const int* data, size_t n) {
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    __m256i acc2 = _mm256_setzero_si256(), acc3 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0 = _mm256_xor_si256(acc0, _mm256_loadu_si256((const __m256i*)(data + i)));
+        acc1 = _mm256_xor_si256(acc1, _mm256_loadu_si256((const __m256i*)(data + i + 8)));
+        acc2 = _mm256_xor_si256(acc2, _mm256_loadu_si256((const __m256i*)(data + i + 16)));
+        acc3 = _mm256_xor_si256(acc3, _mm256_loadu_si256((const __m256i*)(data + i + 24)));
+    }
+    __m256i acc = _mm256_xor_si256(_mm256_xor_si256(acc0, acc1), _mm256_xor_si256(acc2, acc3));
+    __m128i half = _mm_xor_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    half = _mm_xor_si128(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_xor_si128(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(half) ^ xor_block_scalar(data + i, n - i);
+}
+
+// Each group of four ints is sign-extended to 64 bits before it is added
+__attribute__((target("avx2")))
+static long long sum_block_avx2(const int* data, size_t n) {
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    __m256i acc2 = _mm256_setzero_si256(), acc3 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(data + i))));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(data + i + 4))));
+        acc2 = _mm256_add_epi64(acc2, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(data + i + 8))));
+        acc3 = _mm256_add_epi64(acc3, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(data + i + 12))));
+    }
+    __m256i acc = _mm256_add_epi64(_mm256_add_epi64(acc0, acc1), _mm256_add_epi64(acc2, acc3));
+    long long lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sum_block_scalar(data + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static int xor_block_avx512(const int* data, size_t n) {
+    __m512i acc0 = _mm512_setzero_si512(), acc1 = _mm512_setzero_si512();
+    __m512i acc2 = _mm512_setzero_si512(), acc3 = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        acc0 = _mm512_xor_si512(acc0, _mm512_loadu_si512((const void*)(data + i)));
+        acc1 = _mm512_xor_si512(acc1, _mm512_loadu_si512((const void*)(data + i + 16)));
+        acc2 = _mm512_xor_si512(acc2, _mm512_loadu_si512((const void*)(data + i + 32)));
+        acc3 = _mm512_xor_si512(acc3, _mm512_loadu_si512((const void*)(data + i + 48)));
+    }
+    __m512i acc = _mm512_xor_si512(_mm512_xor_si512(acc0, acc1), _mm512_xor_si512(acc2, acc3));
+    int lanes[16];
+    _mm512_storeu_si512((void*)lanes, acc);
+    int result = xor_block_scalar(data + i, n - i);
+    for (int k = 0; k < 16; k++) {
+        result ^= lanes[k];
+    }
+    return result;
+}
+
+__attribute__((target("avx512f")))
+static long long sum_block_avx512(const int* data, size_t n) {
+    __m512i acc0 = _mm512_setzero_si512(), acc1 = _mm512_setzero_si512();
+    __m512i acc2 = _mm512_setzero_si512(), acc3 = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0 = _mm512_add_epi64(acc0, _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i*)(data + i))));
+        acc1 = _mm512_add_epi64(acc1, _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i*)(data + i + 8))));
+        acc2 = _mm512_add_epi64(acc2, _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i*)(data + i + 16))));
+        acc3 = _mm512_add_epi64(acc3, _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i*)(data + i + 24))));
+    }
+    __m512i acc = _mm512_add_epi64(_mm512_add_epi64(acc0, acc1), _mm512_add_epi64(acc2, acc3));
+    return _mm512_reduce_add_epi64(acc) + sum_block_scalar(data + i, n - i);
+}
+#endif
+
+// The widest kernels this CPU runs
+static int xor_block(const int* data, size_t n) {
+#ifdef HAVE_X86_SIMD
+    if (cpu_has(FEATURE_AVX512)) return xor_block_avx512(data, n);
+    if (cpu_has(FEATURE_AVX2)) return xor_block_avx2(data, n);
+#endif
+    return xor_block_scalar(data, n);
+}
+
+static long long sum_block(const int* data, size_t n) {
+#ifdef HAVE_X86_SIMD
+    if (cpu_has(FEATURE_AVX512)) return sum_block_avx512(data, n);
+    if (cpu_has(FEATURE_AVX2)) return sum_block_avx2(data, n);
+#endif
+    return sum_block_scalar(data, n);
+}
+
+// XOR and sum methods with explicit vector kernels. They are only run
+// when cpu_has reports the instruction set.
+#ifdef HAVE_X86_SIMD
+int find_missing_xor_avx2(int* a, int size_a, int* b, int size_b) {
+    return xor_block_avx2(a, (size_t)size_a) ^ xor_block_avx2(b, (size_t)size_b);
+}
+
+int find_missing_xor_avx512(int* a, int size_a, int* b, int size_b) {
+    return xor_block_avx512(a, (size_t)size_a) ^ xor_block_avx512(b, (size_t)size_b);
+}
+
+int find_missing_sum_avx2(int* a, int size_a, int* b, int size_b) {
+    return (int)(sum_block_avx2(a, (size_t)size_a) - sum_block_avx2(b, (size_t)size_b));
+}
+
+int find_missing_sum_avx512(int* a, int size_a, int* b, int size_b) {
+    return (int)(sum_block_avx512(a, (size_t)size_a) - sum_block_avx512(b, (size_t)size_b));
+}
+#else
+int find_missing_xor_avx2(int* a, int size_a, int* b, int size_b) {
+    return find_missing_xor_optimized(a, size_a, b, size_b);
+}
+
+int find_missing_xor_avx512(int* a, int size_a, int* b, int size_b) {
+    return find_missing_xor_optimized(a, size_a, b, size_b);
+}
+
+int find_missing_sum_avx2(int* a, int size_a, int* b, int size_b) {
+    return find_missing_sum(a, size_a, b, size_b);
+}
+
+int find_missing_sum_avx512(int* a, int size_a, int* b, int size_b) {
+    return find_missing_sum(a, size_a, b, size_b);
+}
+#endif
+
+// One thread's share of a parallel reduction: a slice of a and of b
+typedef struct {
+    const int* a;
+    size_t count_a;
+    const int* b;
+    size_t count_b;
+    int use_sum;
+    int xor_result;
+    long long sum_result;
+} ReduceChunk;
+
+static void* reduce_worker(void* arg) {
+    ReduceChunk* chunk = arg;
+    if (chunk->use_sum) {
+        chunk->sum_result = sum_block(chunk->a, chunk->count_a) - sum_block(chunk->b, chunk->count_b);
+    } else {
+        chunk->xor_result = xor_block(chunk->a, chunk->count_a) ^ xor_block(chunk->b, chunk->count_b);
+    }
+    return NULL;
+}
+
+// Split both arrays into one slice per thread, reduce the slices at once
+// with the widest kernel, then combine the partial results. Small inputs
+// use fewer threads, so start-up cost does not dominate.
+static long long parallel_reduce(int* a, int size_a, int* b, int size_b, int use_sum) {
+    int threads = benchmark_threads;
+    if (threads > size_a / PARALLEL_MIN_CHUNK) threads = size_a / PARALLEL_MIN_CHUNK;
+    if (threads < 1) threads = 1;
+    
+    ReduceChunk chunks[threads];
+    pthread_t workers[threads];
+    for (int t = 0; t < threads; t++) {
+        size_t first_a = (size_t)size_a * t / threads, last_a = (size_t)size_a * (t + 1) / threads;
+        size_t first_b = (size_t)size_b * t / threads, last_b = (size_t)size_b * (t + 1) / threads;
+        chunks[t].a = a + first_a;
+        chunks[t].count_a = last_a - first_a;
+        chunks[t].b = b + first_b;
+        chunks[t].count_b = last_b - first_b;
+        chunks[t].use_sum = use_sum;
+    }
+    
+    // Thread 0 is the caller; a failed start runs that slice inline
+    int started[threads];
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&workers[t], NULL, reduce_worker, &chunks[t]) == 0;
+        if (!started[t]) reduce_worker(&chunks[t]);
+    }
+    reduce_worker(&chunks[0]);
+    
+    long long result = 0;
+    for (int t = 0; t < threads; t++) {
+        if (t > 0 && started[t]) pthread_join(workers[t], NULL);
+        if (use_sum) {
+            result += chunks[t].sum_result;
+        } else {
+            result ^= chunks[t].xor_result;
+        }
+    }
+    return result;
+}
+
+int find_missing_xor_parallel(int* a, int size_a, int* b, int size_b) {
+    return (int)parallel_reduce(a, size_a, b, size_b, 0);
+}
+
+int find_missing_sum_parallel(int* a, int size_a, int* b, int size_b) {
+    return (int)parallel_reduce(a, size_a, b, size_b, 1);
+}
+
+// Methods that find every missing item, for multisets and for several
+// missing items. Each writes up to max_missing missing values to missing,
+// in ascending order, and returns how many items are missing (which can
+// exceed max_missing), or -1 when it cannot run on this input. b must be
+// a with some items removed.
+
+// Small results come out of the hash table unordered
+static void sort_small(int* values, int count) {
+    for (int i = 1; i < count; i++) {
+        int value = values[i];
+        int j = i - 1;
+        while (j >= 0 && values[j] > value) {
+            values[j + 1] = values[j];
+            j--;
+        }
+        values[j + 1] = value;
+    }
+}
+
+// Open-addressing hash count: +1 for every item of a, -1 for every item
+// of b, linear probing in a power-of-2 table at most half full. A slot
+// left with count c > 0 is a value missing c times.
+int find_missing_hash_k(int* a, int size_a, int* b, int size_b, int* missing, int max_missing) {
+    int bits = 4;
+    while (((size_t)1 << bits) < 2 * (size_t)size_a) bits++;
+    size_t capacity = (size_t)1 << bits;
+    size_t mask = capacity - 1;
+    int* keys = malloc(capacity * sizeof(int));
+    int* counts = malloc(capacity * sizeof(int));
+    unsigned char* used = calloc(capacity, 1);
+    if (!keys || !counts || !used) {
+        free(keys);
+        free(counts);
+        free(used);
+        return -1;
+    }
+    
+    for (int pass = 0; pass < 2; pass++) {
+        const int* items = pass == 0 ? a : b;
+        int count = pass == 0 ? size_a : size_b;
+        int delta = pass == 0 ? 1 : -1;
+        for (int i = 0; i < count; i++) {
+            int key = items[i];
+            size_t slot = (size_t)(((unsigned long long)(unsigned int)key * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+            while (used[slot] && keys[slot] != key) {
+                slot = (slot + 1) & mask;
+            }
+            if (!used[slot]) {
+                used[slot] = 1;
+                keys[slot] = key;
+                counts[slot] = 0;
+            }
+            counts[slot] += delta;
+        }
+    }
+    
+    int found = 0;
+    for (size_t slot = 0; slot < capacity; slot++) {
+        for (int c = 0; used[slot] && c < counts[slot]; c++) {
+            if (found < max_missing) missing[found] = keys[slot];
+            found++;
+        }
+    }
+    sort_small(missing, found < max_missing ? found : max_missing);
+    
+    free(keys);
+    free(counts);
+    free(used);
+    return found;
+}
+
+// LSD radix sort of n keys in 4 passes of 8 bits, the sign bit flipped so
+// unsigned order is signed order. The result ends up back in data.
+static void radix_sort(unsigned int* data, unsigned int* scratch, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        data[i] ^= 0x80000000u;
+    }
+    for (int shift = 0; shift < 32; shift += 8) {
+        size_t counts[256] = {0};
+        for (size_t i = 0; i < n; i++) {
+            counts[(data[i] >> shift) & 0xFF]++;
+        }
+        size_t offset = 0;
+        for (int d = 0; d < 256; d++) {
+            size_t count = counts[d];
+            counts[d] = offset;
+            offset += count;
+        }
+        for (size_t i = 0; i < n; i++) {
+            scratch[counts[(data[i] >> shift) & 0xFF]++] = data[i];
+        }
+        unsigned int* swap = data;
+        data = scratch;
+        scratch = swap;
+    }
+    for (size_t i = 0; i < n; i++) {
+        data[i] ^= 0x80000000u;
+    }
+}
+
+// Radix sort copies of both arrays, then merge: an item of a with no
+// partner left in b is missing
+int find_missing_radix_k(int* a, int size_a, int* b, int size_b, int* missing, int max_missing) {
+    unsigned int* sorted_a = malloc((size_t)size_a * sizeof(int));
+    unsigned int* sorted_b = malloc((size_t)size_b * sizeof(int) + sizeof(int));
+    unsigned int* scratch = malloc((size_t)size_a * sizeof(int));
+    if (!sorted_a || !sorted_b || !scratch) {
+        free(sorted_a);
+        free(sorted_b);
+        free(scratch);
+        return -1;
+    }
+    memcpy(sorted_a, a, (size_t)size_a * sizeof(int));
+    memcpy(sorted_b, b, (size_t)size_b * sizeof(int));
+    radix_sort(sorted_a, scratch, (size_t)size_a);
+    radix_sort(sorted_b, scratch, (size_t)size_b);
+    
+    int found = 0;
+    int j = 0;
+    for (int i = 0; i < size_a; i++) {
+        int value = (int)sorted_a[i];
+        while (j < size_b && (int)sorted_b[j] < value) j++;
+        if (j < size_b && (int)sorted_b[j] == value) {
+            j++;
+        } else {
+            if (found < max_missing) missing[found] = value;
+            found++;
+        }
+    }
+    
+    free(sorted_a);
+    free(sorted_b);
+    free(scratch);
+    return found;
+}
+
+// Parity bitmap over [min(a), max(a)]: every item of a and b flips its
+// bit, so a set bit is a value missing an odd number of times. That is
+// exact for ID sets and for any single missing item. A value missing
+// twice cancels out. Ranges wider than BITMAP_MAX_SPREAD bits per item
+// return -1.
+#define BITMAP_MAX_SPREAD 64
+
+int find_missing_bitmap_k(int* a, int size_a, int* b, int size_b, int* missing, int max_missing) {
+    int low = a[0], high = a[0];
+    for (int i = 1; i < size_a; i++) {
+        if (a[i] < low) low = a[i];
+        if (a[i] > high) high = a[i];
+    }
+    unsigned long long range = (unsigned long long)((long long)high - (long long)low) + 1;
+    if (range > (unsigned long long)BITMAP_MAX_SPREAD * (unsigned long long)size_a + 64) return -1;
+    
+    size_t words = (size_t)((range + 63) / 64);
+    unsigned long long* bits = calloc(words, sizeof(unsigned long long));
+    if (!bits) return -1;
+    
+    for (int i = 0; i < size_a; i++) {
+        unsigned long long offset = (unsigned long long)((long long)a[i] - low);
+        bits[offset >> 6] ^= 1ull << (offset & 63);
+    }
+    for (int i = 0; i < size_b; i++) {
+        unsigned long long offset = (unsigned long long)((long long)b[i] - low);
+        if (offset < range) bits[offset >> 6] ^= 1ull << (offset & 63);
+    }
+    
+    int found = 0;
+    for (size_t w = 0; w < words; w++) {
+        unsigned long long word = bits[w];
+        while (word) {
+            int bit = __builtin_ctzll(word);
+            if (found < max_missing) missing[found] = (int)((long long)low + (long long)(w * 64 + (size_t)bit));
+            found++;
+            word &= word - 1;
+        }
+    }
+    
+    free(bits);
+    return found;
+}
+
+// Single-item forms for the main table
+int find_missing_hash(int* a, int size_a, int* b, int size_b) {
+    int missing = -1;
+    return find_missing_hash_k(a, size_a, b, size_b, &missing, 1) >= 1 ? missing : -1;
+}
+
+int find_missing_radix(int* a, int size_a, int* b, int size_b) {
+    int missing = -1;
+    return find_missing_radix_k(a, size_a, b, size_b, &missing, 1) >= 1 ? missing : -1;
+}
+
+int find_missing_bitmap(int* a, int size_a, int* b, int size_b) {
+    int missing = -1;
+    return find_missing_bitmap_k(a, size_a, b, size_b, &missing, 1) >= 1 ? missing : -1;
+}
+
+// Element i of the test array, computed independently of every other
+// element (splitmix64), so any slice can be generated on its own
+static int array_value(unsigned long long seed, size_t i, int size) {
+    unsigned long long z = seed + 0x9E3779B97F4A7C15ull * (i + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return (int)(z % (unsigned long long)size);
+}
+
+// Fill a with size random values in [0, size)
+static void fill_array(int* a, int size, unsigned long long seed) {
     for (int i = 0; i < size; i++) {
-        dest[i] = src[i];
+        a[i] = array_value(seed, (size_t)i, size);
+    }
+}
+
+// Copy a to b without the items at the k ascending indices in removed
+static void remove_items(const int* a, int size, int* b, const int* removed, int k) {
+    int from = 0, to = 0;
+    for (int r = 0; r <= k; r++) {
+        int end = r < k ? removed[r] : size;
+        memcpy(b + to, a + from, (size_t)(end - from) * sizeof(int));
+        to += end - from;
+        from = end + 1;
+    }
+}
+
+// k distinct random indices below size, ascending
+static void pick_indices(int* indices, int k, int size) {
+    for (int i = 0; i < k; i++) {
+        int index, duplicate;
+        do {
+            index = (int)(((unsigned long long)rand() * ((unsigned long long)RAND_MAX + 1) + (unsigned long long)rand()) %
+                          (unsigned long long)size);
+            duplicate = 0;
+            for (int j = 0; j < i; j++) {
+                duplicate |= indices[j] == index;
+            }
+        } while (duplicate);
+        indices[i] = index;
     }
+    sort_small(indices, k);
 }
 
-// Utility function to remove random element
-int remove_random_element(int* array, int size) {
-    int index = rand() % size;
-    int removed = array[index];
+// Storage for one size: heap memory, or a file-backed shared mapping once
+// both arrays would not fit comfortably in RAM. The kernel then streams
+// pages from the file during each pass.
+typedef struct {
+    int* a;
+    int* b;
+    void* map_base;
+    size_t map_bytes;
+} TestArrays;
+
+static int arrays_allocate(TestArrays* arrays, int size, int file_backed, const char* scratch_dir) {
+    memset(arrays, 0, sizeof(*arrays));
+    size_t bytes = (2 * (size_t)size - 1) * sizeof(int);
+    
+    if (!file_backed) {
+        arrays->a = malloc((size_t)size * sizeof(int));
+        arrays->b = malloc((size_t)(size - 1) * sizeof(int));
+        if (!arrays->a || !arrays->b) {
+            free(arrays->a);
+            free(arrays->b);
+            return -1;
+        }
+        return 0;
+    }
     
-    // Shift elements to remove the element at index
-    for (int i = index; i < size - 1; i++) {
-        array[i] = array[i + 1];
+    // The file is unlinked right away; the mapping keeps its pages
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/missing-item-XXXXXX", scratch_dir);
+    int fd = mkstemp(path);
+    if (fd < 0) return -1;
+    unlink(path);
+    if (ftruncate(fd, (off_t)bytes) != 0) {
+        close(fd);
+        return -1;
     }
+    void* base = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return -1;
+    madvise(base, bytes, MADV_SEQUENTIAL);
     
-    return removed;
+    arrays->map_base = base;
+    arrays->map_bytes = bytes;
+    arrays->a = base;
+    arrays->b = arrays->a + size;
+    return 0;
 }
 
-int main() {
-    srand(time(NULL));
+static void arrays_free(TestArrays* arrays) {
+    if (arrays->map_base) {
+        munmap(arrays->map_base, arrays->map_bytes);
+    } else {
+        free(arrays->a);
+        free(arrays->b);
+    }
+}
+
+// Last-level cache size in bytes, or 0 when the system does not say
+static size_t cache_bytes(void) {
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (l3 > 0) return (size_t)l3;
+#endif
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (l2 > 0) return (size_t)l2;
+#endif
+    return 0;
+}
+
+// Best streaming read rate over a buffer far larger than the caches, on
+// 1 thread and on all of them, using the widest XOR kernel. Results are
+// in GB/s (1e9 bytes).
+static int measure_bandwidth(double* single_gbs, double* multi_gbs) {
+    size_t bytes = 4 * cache_bytes();
+    if (bytes < BANDWIDTH_MIN_BYTES) bytes = BANDWIDTH_MIN_BYTES;
+    size_t count = bytes / sizeof(int);
+    int* buffer = malloc(bytes);
+    if (!buffer) return -1;
+    for (size_t i = 0; i < count; i++) {
+        buffer[i] = (int)i;
+    }
+    
+    // Half the buffer stands in for each array of a parallel reduction
+    int half = (int)(count / 2);
+    int all_threads = benchmark_threads;
+    volatile int sink = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        benchmark_threads = pass == 0 ? 1 : all_threads;
+        double best = 0.0;
+        for (int run = 0; run < 5; run++) {
+            double start = now_seconds();
+            sink ^= (int)parallel_reduce(buffer, half, buffer + half, half, 0);
+            double seconds = now_seconds() - start;
+            if (seconds > 0.0 && (best == 0.0 || seconds < best)) best = seconds;
+        }
+        double gbs = best > 0.0 ? (double)count * sizeof(int) / best / 1e9 : 0.0;
+        *(pass == 0 ? single_gbs : multi_gbs) = gbs;
+    }
+    (void)sink;
+    
+    free(buffer);
+    return 0;
+}
+
+// Timing harness. Each method gets untimed warm-up calls, then a
+// calibrated number of calls per sample so that one sample lasts at
+// least sample_ns; a sample's time divided by its calls is one
+// measurement. With flush_cache, the flush buffer is rewritten before every
+// sample and each sample is a single cold call. Every result is folded
+// into timing_sink so the compiler cannot drop the work.
+typedef struct {
+    int warmup;                 // Untimed calls before calibration
+    int samples;                // Timed samples; 0 picks by array size
+    unsigned long long sample_ns;
+    int flush_cache;
+    unsigned char* flush_buffer;
+    size_t flush_bytes;
+} TimingConfig;
+
+// Nanoseconds per call over the samples
+typedef struct {
+    long calls;                 // Calls per sample
+    int samples;
+    double min_ns;
+    double median_ns;
+    double p99_ns;              // Nearest rank, so the maximum for under 100 samples
+    double mean_ns;
+} TimingStats;
+
+// One benchmarked call; returns the method's result
+typedef int (*TimedCall)(void* context);
+
+// More calls per sample than this means the timer is not the limit
+#define TIMING_MAX_CALLS (1L << 24)
+
+static volatile int timing_sink;
+
+static unsigned long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+static void flush_caches(const TimingConfig* config) {
+    // Writes evict dirty lines too; the sink keeps the loop alive
+    for (size_t i = 0; i < config->flush_bytes; i += 64) {
+        config->flush_buffer[i] = (unsigned char)(config->flush_buffer[i] + 1);
+    }
+    timing_sink ^= config->flush_buffer[0];
+}
+
+static int compare_doubles(const void* x, const void* y) {
+    double a = *(const double*)x, b = *(const double*)y;
+    return (a > b) - (a < b);
+}
+
+// Time call and fill stats. Returns the result of the last call, or -1
+// with stats->samples = 0 when the sample buffer cannot be allocated.
+static int time_call(TimedCall call, void* context, const TimingConfig* config, int samples, TimingStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    double* times = malloc((size_t)samples * sizeof(double));
+    if (!times) return -1;
+    
+    int result = 0;
+    for (int i = 0; i < config->warmup; i++) {
+        result = call(context);
+        timing_sink ^= result;
+    }
+    
+    // Double the calls per sample until one sample is long enough; a
+    // single call that already is counts as the first sample
+    long calls = 1;
+    int taken = 0;
+    for (;;) {
+        if (config->flush_cache) flush_caches(config);
+        unsigned long long start = now_ns();
+        for (long c = 0; c < calls; c++) {
+            result = call(context);
+            timing_sink ^= result;
+        }
+        unsigned long long elapsed = now_ns() - start;
+        if (config->flush_cache || elapsed >= config->sample_ns || calls >= TIMING_MAX_CALLS) {
+            if (calls == 1) times[taken++] = (double)elapsed;
+            break;
+        }
+        calls *= 2;
+    }
+    
+    while (taken < samples) {
+        if (config->flush_cache) flush_caches(config);
+        unsigned long long start = now_ns();
+        for (long c = 0; c < calls; c++) {
+            result = call(context);
+            timing_sink ^= result;
+        }
+        times[taken++] = (double)(now_ns() - start) / (double)calls;
+    }
+    
+    qsort(times, (size_t)samples, sizeof(double), compare_doubles);
+    double total = 0.0;
+    for (int i = 0; i < samples; i++) {
+        total += times[i];
+    }
+    int p99_rank = (99 * samples + 99) / 100;
+    stats->calls = calls;
+    stats->samples = samples;
+    stats->min_ns = times[0];
+    stats->median_ns = samples % 2 ? times[samples / 2] : 0.5 * (times[samples / 2 - 1] + times[samples / 2]);
+    stats->p99_ns = times[p99_rank - 1];
+    stats->mean_ns = total / samples;
+    
+    free(times);
+    return result;
+}
+
+// Context of a single-missing method
+typedef struct {
+    int (*func)(int*, int, int*, int);
+    int* a;
+    int size_a;
+    int* b;
+    int size_b;
+} SingleCall;
+
+static int run_single(void* context) {
+    SingleCall* c = context;
+    return c->func(c->a, c->size_a, c->b, c->size_b);
+}
+
+// Context of a k-missing method; the result is the count found
+typedef struct {
+    int (*func)(int*, int, int*, int, int*, int);
+    int* a;
+    int size_a;
+    int* b;
+    int size_b;
+    int* missing;
+    int max_missing;
+} MultiCall;
+
+static int run_multi(void* context) {
+    MultiCall* c = context;
+    return c->func(c->a, c->size_a, c->b, c->size_b, c->missing, c->max_missing);
+}
+
+// Results file in the schema shared with the Python and Go versions (see
+// the README): one object with the run settings and a results array
+static void json_begin(FILE* json, const TimingConfig* config, unsigned long long seed) {
+    fprintf(json, "{\n  \"schema\": \"missing-item-benchmark\",\n  \"version\": 1,\n");
+    fprintf(json, "  \"language\": \"c\",\n  \"timer\": \"clock_gettime(CLOCK_MONOTONIC)\",\n");
+    fprintf(json, "  \"config\": {\"warmup\": %d, \"samples\": %d, \"sample_ns\": %llu, \"flush_cache\": %s, "
+                  "\"threads\": %d, \"seed\": %llu},\n",
+            config->warmup, config->samples, config->sample_ns, config->flush_cache ? "true" : "false",
+            benchmark_threads, seed);
+    fprintf(json, "  \"results\": [");
+}
+
+static void json_result(FILE* json, int* first, int size, int missing, const char* method, const char* name,
+                        int threads, long result, int correct, size_t bytes, const TimingStats* stats) {
+    fprintf(json, "%s\n    {\"size\": %d, \"missing\": %d, \"method\": \"%s\", \"name\": \"%s\", \"threads\": %d, "
+                  "\"result\": %ld, \"correct\": %s, \"bytes\": %zu, \"calls\": %ld, \"samples\": %d, "
+                  "\"min_ns\": %.1f, \"median_ns\": %.1f, \"p99_ns\": %.1f, \"mean_ns\": %.1f}",
+            *first ? "" : ",", size, missing, method, name, threads, result, correct ? "true" : "false", bytes,
+            stats->calls, stats->samples, stats->min_ns, stats->median_ns, stats->p99_ns, stats->mean_ns);
+    *first = 0;
+}
+
+static void json_end(FILE* json) {
+    fprintf(json, "\n  ]\n}\n");
+}
+
+static void print_usage(const char* program) {
+    printf("Usage: %s [options]\n", program);
+    printf("  --max-size <n>     Largest array size, up to %d (default: %d)\n", LARGEST_SIZE, DEFAULT_MAX_SIZE);
+    printf("  --threads <n>      Threads for the parallel reduction (default: online CPUs)\n");
+    printf("  --mmap             Always keep the arrays in a file-backed mapping\n");
+    printf("  --scratch <dir>    Directory for the mapping's file (default: .)\n");
+    printf("  --samples <n>      Timed samples per method (default: 10, or 3 above 256 MB)\n");
+    printf("  --warmup <n>       Untimed calls before timing (default: 1)\n");
+    printf("  --sample-ms <ms>   Shortest sample; fast methods repeat until it is reached (default: 1)\n");
+    printf("  --flush-cache      Evict the caches before every sample and time single cold calls\n");
+    printf("  --json <file>      Also write the results as JSON (schema in the README)\n");
+    printf("  --help             Show this help message\n");
+}
+
+int main(int argc, char* argv[]) {
+    long max_size = DEFAULT_MAX_SIZE;
+    int force_mmap = 0;
+    const char* scratch_dir = ".";
+    const char* json_path = NULL;
+    TimingConfig timing = {1, 0, 1000000ull, 0, NULL, 0};
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    benchmark_threads = cpus > 0 ? (int)cpus : 1;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-size") == 0 && i + 1 < argc) {
+            max_size = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            benchmark_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mmap") == 0) {
+            force_mmap = 1;
+        } else if (strcmp(argv[i], "--scratch") == 0 && i + 1 < argc) {
+            scratch_dir = argv[++i];
+        } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            timing.samples = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            timing.warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sample-ms") == 0 && i + 1 < argc) {
+            double ms = strtod(argv[++i], NULL);
+            timing.sample_ns = ms > 0.0 ? (unsigned long long)(ms * 1e6) : 0;
+        } else if (strcmp(argv[i], "--flush-cache") == 0) {
+            timing.flush_cache = 1;
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            printf("Unknown argument: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (max_size < 2 || max_size > LARGEST_SIZE || benchmark_threads < 1) {
+        printf("Error: --max-size must be 2 to %d and --threads at least 1\n", LARGEST_SIZE);
+        return 1;
+    }
+    if (timing.samples < 0 || timing.warmup < 0) {
+        printf("Error: --samples and --warmup cannot be negative\n");
+        return 1;
+    }
+    
+    unsigned long long seed = (unsigned long long)time(NULL);
+    srand((unsigned int)seed);
     
     printf("XOR Benchmark - C Implementation\n");
     printf("=================================\n\n");
     
-    // Test different sizes (powers of 2)
-    int sizes[] = {2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768};
-    int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+    // Arrays larger than half of RAM go to a file-backed mapping
+    long pages = sysconf(_SC_PHYS_PAGES), page_size = sysconf(_SC_PAGE_SIZE);
+    double ram_bytes = pages > 0 && page_size > 0 ? (double)pages * (double)page_size : 0.0;
+    
+    double single_gbs = 0.0, multi_gbs = 0.0;
+    if (measure_bandwidth(&single_gbs, &multi_gbs) != 0) {
+        printf("Error: Could not allocate the bandwidth buffer\n");
+        return 1;
+    }
+    printf("Vector kernels: %s\n", cpu_has(FEATURE_AVX512) ? "AVX-512" : cpu_has(FEATURE_AVX2) ? "AVX2" : "scalar");
+    printf("Memory read bandwidth: %.2f GB/s on 1 thread, %.2f GB/s on %d thread%s\n\n", single_gbs, multi_gbs,
+           benchmark_threads, benchmark_threads == 1 ? "" : "s");
+    size_t cache = cache_bytes();
+    
+    // Twice the last-level cache, so rewriting it displaces the arrays
+    if (timing.flush_cache) {
+        timing.flush_bytes = 2 * (cache > 0 ? cache : (size_t)32 << 20);
+        timing.flush_buffer = calloc(timing.flush_bytes, 1);
+        if (!timing.flush_buffer) {
+            printf("Error: Could not allocate the cache flush buffer\n");
+            return 1;
+        }
+    }
+    
+    // Wrong results make the run fail, so CI gates on them
+    int wrong = 0;
+    FILE* json = NULL;
+    int json_first = 1;
+    if (json_path) {
+        json = fopen(json_path, "w");
+        if (!json) {
+            printf("Error: Could not open %s\n", json_path);
+            free(timing.flush_buffer);
+            return 1;
+        }
+        json_begin(json, &timing, seed);
+    }
+    
+    // Powers of 2 up to the largest size, then the largest size itself
+    int sizes[40];
+    int num_sizes = 0;
+    for (long size = 2; size <= max_size; size *= 2) {
+        sizes[num_sizes++] = (int)size;
+    }
+    if (sizes[num_sizes - 1] != max_size) sizes[num_sizes++] = (int)max_size;
     
     // Function pointers for different algorithms
     int (*algorithms[])(int*, int, int*, int) = {
         find_missing_xor_original,
         find_missing_xor_optimized,
         find_missing_sum,
-        find_missing_linear
+        find_missing_linear,
+        find_missing_xor_avx2,
+        find_missing_xor_avx512,
+        find_missing_sum_avx2,
+        find_missing_sum_avx512,
+        find_missing_xor_parallel,
+        find_missing_sum_parallel,
+        find_missing_hash,
+        find_missing_radix,
+        find_missing_bitmap
     };
     
     const char* algorithm_names[] = {
         "XOR (original)",
-        "XOR (optimized)", 
+        "XOR (optimized)",
         "Sum difference",
-        "Linear search"
+        "Linear search",
+        "XOR (AVX2)",
+        "XOR (AVX-512)",
+        "Sum difference (AVX2)",
+        "Sum difference (AVX-512)",
+        "XOR (parallel)",
+        "Sum difference (parallel)",
+        "Hash count",
+        "Radix sort",
+        "Parity bitmap"
+    };
+    
+    // Method names in the JSON results, shared with the other versions
+    // where the method is the same
+    const char* algorithm_ids[] = {
+        "xor", "xor_opt", "sum", "linear",
+        "xor_avx2", "xor_avx512", "sum_avx2", "sum_avx512",
+        "xor_parallel", "sum_parallel",
+        "hash", "radix", "bitmap"
     };
     
+    // Instruction set each method needs, the largest size it is run at
+    // (0 = any; linear search is quadratic, and the hash table and sorted
+    // copies take several times the input), and whether it is threaded
+    const int algorithm_features[] = {
+        FEATURE_NONE, FEATURE_NONE, FEATURE_NONE, FEATURE_NONE,
+        FEATURE_AVX2, FEATURE_AVX512, FEATURE_AVX2, FEATURE_AVX512,
+        FEATURE_NONE, FEATURE_NONE,
+        FEATURE_NONE, FEATURE_NONE, FEATURE_NONE
+    };
+    const int algorithm_max_size[] = {0, 0, 0, 32768, 0, 0, 0, 0, 0, 0, 1 << 24, 1 << 24, 0};
+    const int algorithm_parallel[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0};
+    
     int num_algorithms = sizeof(algorithms) / sizeof(algorithms[0]);
     
+    // Methods that report every missing item, for the multi-missing pass
+    int (*multi_algorithms[])(int*, int, int*, int, int*, int) = {
+        find_missing_hash_k,
+        find_missing_radix_k,
+        find_missing_bitmap_k
+    };
+    const char* multi_names[] = {"Hash count", "Radix sort", "Parity bitmap"};
+    const char* multi_ids[] = {"hash", "radix", "bitmap"};
+    const int multi_max_size[] = {1 << 24, 1 << 24, 0};
+    const int multi_parity[] = {0, 0, 1};
+    int num_multi = sizeof(multi_algorithms) / sizeof(multi_algorithms[0]);
+    
     for (int s = 0; s < num_sizes; s++) {
         int size = sizes[s];
-        printf("=== Testing with array size: %d ===\n", size);
+        size_t bytes = (2 * (size_t)size - 1) * sizeof(int);
+        int file_backed = force_mmap || (ram_bytes > 0.0 && (double)bytes > 0.5 * ram_bytes);
+        int cached = bytes <= cache;
+        printf("=== Testing with array size: %d%s ===\n", size,
+               file_backed ? " (file-backed mapping)" : cached ? " (fits in cache)" : "");
         
-        // Create array with random integers
-        int* a = malloc(size * sizeof(int));
-        int* b = malloc((size - 1) * sizeof(int));
-        
-        for (int i = 0; i < size; i++) {
-            a[i] = rand() % size;
+        TestArrays arrays;
+        if (arrays_allocate(&arrays, size, file_backed, scratch_dir) != 0) {
+            printf("Error: Could not allocate %.2f GB for size %d\n\n", (double)bytes / 1e9, size);
+            break;
         }
-        
-        // Copy array a to b, then remove one element
-        copy_array(a, b, size);
-        remove_random_element(b, size);
+        int* a = arrays.a;
+        int* b = arrays.b;
+        fill_array(a, size, seed + (unsigned long long)s);
+        int removed = rand() % size;
+        remove_items(a, size, b, &removed, 1);
         int size_b = size - 1;
         
-        // Run each algorithm multiple times and calculate average
-        const int iterations = 10;
-        double avg_times[num_algorithms];
+        // Large sizes get fewer samples; each call already streams the arrays
+        int samples = timing.samples > 0 ? timing.samples : bytes > ((size_t)256 << 20) ? 3 : 10;
+        int expected_single = a[removed];
+        TimingStats stats[num_algorithms];
         int results[num_algorithms];
+        int ran[num_algorithms];
         
         for (int alg = 0; alg < num_algorithms; alg++) {
-            double total_time = 0.0;
+            ran[alg] = cpu_has(algorithm_features[alg]) &&
+                       (algorithm_max_size[alg] == 0 || size <= algorithm_max_size[alg]);
+            if (!ran[alg]) continue;
             
-            for (int iter = 0; iter < iterations; iter++) {
-                double elapsed = time_function(algorithms[alg], a, size, b, size_b);
-                total_time += elapsed;
+            SingleCall call = {algorithms[alg], a, size, b, size_b};
+            results[alg] = time_call(run_single, &call, &timing, samples, &stats[alg]);
+            if (stats[alg].samples == 0) {
+                ran[alg] = 0;
+                continue;
             }
             
-            avg_times[alg] = total_time / iterations;
-            results[alg] = algorithms[alg](a, size, b, size_b);
-            
-            printf("Average time using %s: %.8f seconds\n", 
-                   algorithm_names[alg], avg_times[alg]);
+            // Data read per second, against the memory bandwidth of as many
+            // threads; cache-resident sizes can exceed it
+            double seconds = stats[alg].median_ns * 1e-9;
+            double gbs = seconds > 0.0 ? (double)bytes / seconds / 1e9 : 0.0;
+            double peak = algorithm_parallel[alg] ? multi_gbs : single_gbs;
+            double share = peak > 0.0 ? 100.0 * gbs / peak : 0.0;
+            printf("Median time using %s: %.8f seconds (min %.8f, p99 %.8f; %.2f GB/s, %.0f%% of %s bandwidth%s)\n",
+                   algorithm_names[alg], seconds, stats[alg].min_ns * 1e-9, stats[alg].p99_ns * 1e-9, gbs, share,
+                   algorithm_parallel[alg] ? "all-thread" : "1-thread",
+                   !cached && share >= 80.0 ? ", memory-bound" : "");
+            if (json) {
+                json_result(json, &json_first, size, 1, algorithm_ids[alg], algorithm_names[alg],
+                            algorithm_parallel[alg] ? benchmark_threads : 1, results[alg],
+                            results[alg] == expected_single, bytes, &stats[alg]);
+            }
         }
         
         // Find fastest method
-        int fastest_idx = 0;
-        for (int i = 1; i < num_algorithms; i++) {
-            if (avg_times[i] < avg_times[fastest_idx]) {
+        int fastest_idx = -1;
+        for (int i = 0; i < num_algorithms; i++) {
+            if (ran[i] && (fastest_idx < 0 || stats[i].median_ns < stats[fastest_idx].median_ns)) {
                 fastest_idx = i;
             }
         }
+        if (fastest_idx < 0) {
+            printf("Error: Could not time any method at size %d\n\n", size);
+            arrays_free(&arrays);
+            break;
+        }
         
-        printf("Fastest method: %s (%.8f seconds)\n", 
-               algorithm_names[fastest_idx], avg_times[fastest_idx]);
+        printf("Fastest method: %s (%.8f seconds)\n",
+               algorithm_names[fastest_idx], stats[fastest_idx].median_ns * 1e-9);
         
         // Check for result consistency
         int consistent = 1;
-        for (int i = 1; i < num_algorithms; i++) {
-            if (results[i] != results[0]) {
+        for (int i = 0; i < num_algorithms; i++) {
+            if (ran[i] && results[i] != expected_single) {
                 consistent = 0;
                 break;
             }
         }
         
         if (consistent) {
-            printf("All methods returned the same result: %d\n", results[0]);
+            printf("All methods returned the same result: %d\n", expected_single);
         } else {
-            printf("Discrepancy found in results:\n");
+            printf("Discrepancy found in results (missing item is %d):\n", expected_single);
             for (int i = 0; i < num_algorithms; i++) {
-                printf("  %s: %d\n", algorithm_names[i], results[i]);
+                if (ran[i]) printf("  %s: %d\n", algorithm_names[i], results[i]);
+                if (ran[i] && results[i] != expected_single) wrong++;
+            }
+        }
+        
+        // Now remove several items; values repeat in a, so the same value
+        // can go missing more than once
+        int k = size / 2 < MAX_MISSING ? size / 2 : MAX_MISSING;
+        int indices[MAX_MISSING], expected[MAX_MISSING], odd[MAX_MISSING];
+        pick_indices(indices, k, size);
+        for (int i = 0; i < k; i++) {
+            expected[i] = a[indices[i]];
+        }
+        sort_small(expected, k);
+        remove_items(a, size, b, indices, k);
+        size_b = size - k;
+        
+        // The parity bitmap reports the values missing an odd number of times
+        int num_odd = 0;
+        for (int i = 0; i < k;) {
+            int j = i;
+            while (j < k && expected[j] == expected[i]) j++;
+            if ((j - i) % 2 == 1) odd[num_odd++] = expected[i];
+            i = j;
+        }
+        
+        // Both arrays are read in full; b is now k items short
+        size_t multi_bytes = ((size_t)size + (size_t)size_b) * sizeof(int);
+        printf("With %d item%s missing:\n", k, k == 1 ? "" : "s");
+        for (int m = 0; m < num_multi; m++) {
+            if (multi_max_size[m] != 0 && size > multi_max_size[m]) continue;
+            
+            int found[MAX_MISSING];
+            MultiCall call = {multi_algorithms[m], a, size, b, size_b, found, MAX_MISSING};
+            TimingStats multi_stats;
+            int count = time_call(run_multi, &call, &timing, samples, &multi_stats);
+            if (multi_stats.samples == 0) continue;
+            
+            const int* want = multi_parity[m] ? odd : expected;
+            int want_count = multi_parity[m] ? num_odd : k;
+            int correct = count == want_count && memcmp(found, want, (size_t)count * sizeof(int)) == 0;
+            printf("Median time using %s: %.8f seconds (min %.8f, p99 %.8f), %d found%s\n", multi_names[m],
+                   multi_stats.median_ns * 1e-9, multi_stats.min_ns * 1e-9, multi_stats.p99_ns * 1e-9,
+                   count < 0 ? 0 : count, count < 0 ? " (not run: value range too wide)" :
+                   correct ? "" : " (WRONG)");
+            if (count >= 0 && !correct) wrong++;
+            if (json && count >= 0) {
+                json_result(json, &json_first, size, k, multi_ids[m], multi_names[m], 1, count, correct, multi_bytes,
+                            &multi_stats);
             }
         }
         
         printf("\n");
         
-        free(a);
-        free(b);
+        arrays_free(&arrays);
     }
     
+    if (json) {
+        json_end(json);
+        fclose(json);
+        printf("Results written to %s\n", json_path);
+    }
+    free(timing.flush_buffer);
+    
+    if (wrong > 0) {
+        printf("Error: %d wrong result%s\n", wrong, wrong == 1 ? "" : "s");
+        return 1;
+    }
     return 0;
 }
@@ -0,0 +1,38 @@
+"""Fail when a missing-item benchmark JSON file holds a wrong result.
+
+Usage: python3 check-results.py <results.json> [...]
+
+CI runs this on every version's --json output, so a method that returns
+the wrong item fails the build even when the benchmark itself exits 0.
+"""
+import json
+import sys
+
+
+def check(path):
+    with open(path) as source:
+        document = json.load(source)
+    if document.get("schema") != "missing-item-benchmark":
+        print(f"{path}: not a missing-item-benchmark results file")
+        return False
+
+    results = document.get("results", [])
+    wrong = [r for r in results if not r.get("correct")]
+    for r in wrong:
+        print(f"{path}: {document['language']} {r['method']} size {r['size']} missing {r['missing']}: "
+              f"wrong result {r['result']}")
+    if not results:
+        print(f"{path}: no results")
+        return False
+    print(f"{path}: {len(results) - len(wrong)} of {len(results)} {document['language']} results correct")
+    return not wrong
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print(__doc__.strip())
+        sys.exit(2)
+    ok = True
+    for path in sys.argv[1:]:
+        ok = check(path) and ok
+    sys.exit(0 if ok else 1)
@@ -1,17 +1,165 @@
 package main
 
 import (
+	"encoding/json"
+	"flag"
 	"fmt"
 	"math/rand"
+	"os"
+	"path/filepath"
+	"sort"
+	"strconv"
+	"strings"
 	"time"
 )
 
-// timeFunction measures the execution time of a function
-func timeFunction(fn func([]int, []int) int, a, b []int) (int, time.Duration) {
-	start := time.Now()
-	result := fn(a, b)
-	elapsed := time.Since(start)
-	return result, elapsed
+// schemaVersion is the version of the JSON results shared with the C and
+// Python versions (see the README)
+const schemaVersion = 1
+
+// maxCalls caps the calls per sample; beyond it the timer is not the limit
+const maxCalls = 1 << 24
+
+// sink keeps every result alive so the compiler cannot drop the work
+var sink int
+
+// timingConfig holds the harness settings from the command line
+type timingConfig struct {
+	Warmup     int    `json:"warmup"`
+	Samples    int    `json:"samples"`
+	SampleNs   int64  `json:"sample_ns"`
+	FlushCache bool   `json:"flush_cache"`
+	Threads    int    `json:"threads"`
+	Seed       int64  `json:"seed"`
+	flushBuf   []byte `json:"-"`
+}
+
+// timingStats are nanoseconds per call over the samples
+type timingStats struct {
+	Calls    int     `json:"calls"`
+	Samples  int     `json:"samples"`
+	MinNs    float64 `json:"min_ns"`
+	MedianNs float64 `json:"median_ns"`
+	P99Ns    float64 `json:"p99_ns"`
+	MeanNs   float64 `json:"mean_ns"`
+}
+
+// result is one method at one size in the JSON results
+type result struct {
+	Size    int    `json:"size"`
+	Missing int    `json:"missing"`
+	Method  string `json:"method"`
+	Name    string `json:"name"`
+	Threads int    `json:"threads"`
+	Result  int    `json:"result"`
+	Correct bool   `json:"correct"`
+	Bytes   int    `json:"bytes"`
+	timingStats
+}
+
+// document is the whole JSON results file
+type document struct {
+	Schema   string       `json:"schema"`
+	Version  int          `json:"version"`
+	Language string       `json:"language"`
+	Timer    string       `json:"timer"`
+	Config   timingConfig `json:"config"`
+	Results  []result     `json:"results"`
+}
+
+// cacheBytes returns the largest CPU cache reported by sysfs, or 32 MB
+func cacheBytes() int {
+	largest := 32 << 20
+	paths, _ := filepath.Glob("/sys/devices/system/cpu/cpu0/cache/index*/size")
+	for _, path := range paths {
+		text, err := os.ReadFile(path)
+		if err != nil {
+			continue
+		}
+		value := strings.TrimSpace(string(text))
+		scale := 1
+		if strings.HasSuffix(value, "K") {
+			scale, value = 1<<10, strings.TrimSuffix(value, "K")
+		} else if strings.HasSuffix(value, "M") {
+			scale, value = 1<<20, strings.TrimSuffix(value, "M")
+		}
+		if n, err := strconv.Atoi(value); err == nil && n*scale > largest {
+			largest = n * scale
+		}
+	}
+	return largest
+}
+
+// flushCaches rewrites a buffer larger than the last-level cache
+func flushCaches(buf []byte) {
+	for i := 0; i < len(buf); i += 64 {
+		buf[i]++
+	}
+	sink ^= int(buf[0])
+}
+
+// timeFunction runs untimed warm-up calls, doubles the calls per sample
+// until one sample lasts at least SampleNs, then takes the samples on the
+// monotonic clock behind time.Since. With FlushCache, every sample is a
+// single call after the caches are evicted.
+func timeFunction(fn func([]int, []int) int, a, b []int, config *timingConfig) (int, timingStats) {
+	res := 0
+	for i := 0; i < config.Warmup; i++ {
+		res = fn(a, b)
+		sink ^= res
+	}
+
+	times := make([]float64, 0, config.Samples)
+	calls := 1
+	for {
+		if config.FlushCache {
+			flushCaches(config.flushBuf)
+		}
+		start := time.Now()
+		for c := 0; c < calls; c++ {
+			res = fn(a, b)
+			sink ^= res
+		}
+		elapsed := time.Since(start).Nanoseconds()
+		if config.FlushCache || elapsed >= config.SampleNs || calls >= maxCalls {
+			if calls == 1 {
+				times = append(times, float64(elapsed))
+			}
+			break
+		}
+		calls *= 2
+	}
+
+	for len(times) < config.Samples {
+		if config.FlushCache {
+			flushCaches(config.flushBuf)
+		}
+		start := time.Now()
+		for c := 0; c < calls; c++ {
+			res = fn(a, b)
+			sink ^= res
+		}
+		times = append(times, float64(time.Since(start).Nanoseconds())/float64(calls))
+	}
+
+	sort.Float64s(times)
+	n := len(times)
+	total := 0.0
+	for _, t := range times {
+		total += t
+	}
+	median := times[n/2]
+	if n%2 == 0 {
+		median = 0.5 * (times[n/2-1] + times[n/2])
+	}
+	return res, timingStats{
+		Calls:    calls,
+		Samples:  n,
+		MinNs:    times[0],
+		MedianNs: median,
+		P99Ns:    times[(99*n+99)/100-1],
+		MeanNs:   total / float64(n),
+	}
 }
 
 // findMissingXOROriginal - XOR method using separate loops
@@ -61,8 +209,8 @@ func findMissingSum(a, b []int) int {
 	return sumA - sumB
 }
 
-// findMissingLinear - Linear search method using map
-func findMissingLinear(a, b []int) int {
+// findMissingCount - Count method: compare hash-map counts of both slices
+func findMissingCount(a, b []int) int {
 	// Count occurrences in both slices
 	countA := make(map[int]int)
 	countB := make(map[int]int)
@@ -108,8 +256,9 @@ func findMissingSet(a, b []int) int {
 	return 0 // Should never reach here if input is valid
 }
 
-// generateTestData creates test arrays with one missing element
-func generateTestData(size int) ([]int, []int) {
+// generateTestData creates test arrays with one missing element and
+// returns the missing value
+func generateTestData(size int) ([]int, []int, int) {
 	// Create array a with random integers
 	a := make([]int, size)
 	for i := 0; i < size; i++ {
@@ -122,109 +271,130 @@ func generateTestData(size int) ([]int, []int) {
 
 	// Remove a random element
 	removeIndex := rand.Intn(len(b))
+	missing := b[removeIndex]
 	b = append(b[:removeIndex], b[removeIndex+1:]...)
 
-	return a, b
+	return a, b, missing
 }
 
 func main() {
+	config := timingConfig{Threads: 1}
+	sampleMs := 1.0
+	jsonPath := ""
+	flag.IntVar(&config.Samples, "samples", 10, "timed samples per method")
+	flag.IntVar(&config.Warmup, "warmup", 1, "untimed calls before timing")
+	flag.Float64Var(&sampleMs, "sample-ms", 1.0, "shortest sample; fast methods repeat until it is reached")
+	flag.BoolVar(&config.FlushCache, "flush-cache", false, "evict the caches before every sample and time single cold calls")
+	flag.StringVar(&jsonPath, "json", "", "also write the results as JSON to this file (schema in the README)")
+	flag.Parse()
+	if config.Samples < 1 || config.Warmup < 0 {
+		fmt.Println("Error: -samples must be at least 1 and -warmup cannot be negative")
+		os.Exit(1)
+	}
+	config.SampleNs = int64(sampleMs * 1e6)
+	if config.FlushCache {
+		config.flushBuf = make([]byte, 2*cacheBytes())
+	}
+
 	// Test with different list sizes
 	sizes := []int{2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768}
 
-	// Define test functions
-	testFunctions := map[string]func([]int, []int) int{
-		"xor_original":  findMissingXOROriginal,
-		"xor_optimized": findMissingXOROptimized,
-		"sum":           findMissingSum,
-		"linear":        findMissingLinear,
-		"set":           findMissingSet,
+	// Test functions in output order; the IDs match the other versions
+	testFunctions := []struct {
+		id   string
+		name string
+		fn   func([]int, []int) int
+	}{
+		{"xor", "XOR (original)", findMissingXOROriginal},
+		{"xor_opt", "XOR (optimized)", findMissingXOROptimized},
+		{"sum", "Sum", findMissingSum},
+		{"count", "Count", findMissingCount},
+		{"set", "Set", findMissingSet},
 	}
 
 	// Seed random number generator
-	rand.Seed(time.Now().UnixNano())
+	config.Seed = time.Now().UnixNano()
+	rand.Seed(config.Seed)
+
+	doc := document{
+		Schema:   "missing-item-benchmark",
+		Version:  schemaVersion,
+		Language: "go",
+		Timer:    "time.Now (monotonic)",
+		Config:   config,
+		Results:  []result{},
+	}
 
 	for _, size := range sizes {
 		fmt.Printf("\n=== Testing with list size: %d ===\n", size)
 
 		// Generate test data
-		a, b := generateTestData(size)
+		a, b, missing := generateTestData(size)
 
-		// Run multiple times and average
-		timeResults := make(map[string][]time.Duration)
-		for key := range testFunctions {
-			timeResults[key] = make([]time.Duration, 0, 10)
-		}
-
-		var results []int
-
-		// Run 10 times for better average
-		for i := 0; i < 10; i++ {
-			for key, fn := range testFunctions {
-				result, elapsed := timeFunction(fn, a, b)
-				timeResults[key] = append(timeResults[key], elapsed)
-				if i == 0 { // Only store results from first run for comparison
-					results = append(results, result)
-				}
+		fastest := -1
+		allSame := true
+		results := make([]result, 0, len(testFunctions))
+		for _, test := range testFunctions {
+			res, stats := timeFunction(test.fn, a, b, &config)
+			fmt.Printf("Median time using %s: %v (min %v, p99 %v)\n", test.name,
+				time.Duration(stats.MedianNs), time.Duration(stats.MinNs), time.Duration(stats.P99Ns))
+
+			results = append(results, result{
+				Size:        size,
+				Missing:     1,
+				Method:      test.id,
+				Name:        test.name,
+				Threads:     1,
+				Result:      res,
+				Correct:     res == missing,
+				Bytes:       8 * (2*size - 1),
+				timingStats: stats,
+			})
+			if fastest < 0 || stats.MedianNs < results[fastest].MedianNs {
+				fastest = len(results) - 1
 			}
+			allSame = allSame && res == missing
 		}
 
-		// Calculate averages
-		avgTimes := make(map[string]time.Duration)
-		for key, times := range timeResults {
-			var total time.Duration
-			for _, t := range times {
-				total += t
+		fmt.Printf("Fastest method: %s (%v)\n", results[fastest].Name, time.Duration(results[fastest].MedianNs))
+
+		// Check for discrepancies - every result should be the missing item
+		if !allSame {
+			fmt.Printf("Discrepancy found in results (missing item is %d):\n", missing)
+			for _, r := range results {
+				fmt.Printf("  %s: %d\n", r.Name, r.Result)
 			}
-			avgTimes[key] = total / time.Duration(len(times))
+		} else {
+			fmt.Printf("All methods returned the same result: %d\n", missing)
 		}
+		doc.Results = append(doc.Results, results...)
+	}
 
-		// Print results
-		fmt.Printf("Average time using XOR (original): %v\n", avgTimes["xor_original"])
-		fmt.Printf("Average time using XOR (optimized): %v\n", avgTimes["xor_optimized"])
-		fmt.Printf("Average time using Sum: %v\n", avgTimes["sum"])
-		fmt.Printf("Average time using Linear: %v\n", avgTimes["linear"])
-		fmt.Printf("Average time using Set: %v\n", avgTimes["set"])
-
-		// Find the fastest method
-		var fastestMethod string
-		var fastestTime time.Duration = time.Hour // Start with a very large time
-
-		times := map[string]time.Duration{
-			"XOR (original)":  avgTimes["xor_original"],
-			"XOR (optimized)": avgTimes["xor_optimized"],
-			"Sum":             avgTimes["sum"],
-			"Linear":          avgTimes["linear"],
-			"Set":             avgTimes["set"],
+	if jsonPath != "" {
+		out, err := json.MarshalIndent(doc, "", "  ")
+		if err == nil {
+			err = os.WriteFile(jsonPath, append(out, '\n'), 0o644)
 		}
-
-		for method, t := range times {
-			if t < fastestTime {
-				fastestTime = t
-				fastestMethod = method
-			}
+		if err != nil {
+			fmt.Printf("Error: Could not write %s: %v\n", jsonPath, err)
+			os.Exit(1)
 		}
+		fmt.Printf("\nResults written to %s\n", jsonPath)
+	}
 
-		fmt.Printf("Fastest method: %s (%v)\n", fastestMethod, fastestTime)
-
-		// Check for discrepancies - all results should be the same
-		firstResult := results[0]
-		allSame := true
-		for _, result := range results[1:] {
-			if result != firstResult {
-				allSame = false
-				break
-			}
+	// Wrong results make the run fail, so CI gates on them
+	wrong := 0
+	for _, r := range doc.Results {
+		if !r.Correct {
+			wrong++
 		}
-
-		if !allSame {
-			fmt.Println("Discrepancy found in results:")
-			i := 0
-			for key := range testFunctions {
-				fmt.Printf("%s: %d\n", key, results[i])
-				i++
-			}
-		} else {
-			fmt.Printf("All methods returned the same result: %d\n", firstResult)
+	}
+	if wrong > 0 {
+		plural := "s"
+		if wrong == 1 {
+			plural = ""
 		}
+		fmt.Printf("Error: %d wrong result%s\n", wrong, plural)
+		os.Exit(1)
 	}
 }
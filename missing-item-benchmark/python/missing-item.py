@@ -1,4 +1,8 @@
+import argparse
+import json
+import os
 import random
+import sys
 import time
 from collections import Counter
 try:
@@ -20,11 +24,71 @@ except ImportError:
 # 7. Set difference method (using Counter)
 # 8. Sum difference method
 
-def time_function(func, *args):
-    start_time = time.time()
-    result = func(*args)
-    end_time = time.time()
-    return result, end_time - start_time
+# Timing harness shared in spirit with the C and Go versions: untimed
+# warm-up calls, then calls per sample doubled until one sample lasts at
+# least sample_ns, then the samples. Times are nanoseconds per call from
+# the monotonic perf_counter_ns. With flush_cache, a buffer larger than the
+# last-level cache is rewritten before every sample and each sample is a
+# single call.
+SCHEMA_VERSION = 1
+MAX_CALLS = 1 << 24
+
+
+def cache_bytes():
+    for name in ("SC_LEVEL3_CACHE_SIZE", "SC_LEVEL2_CACHE_SIZE"):
+        try:
+            size = os.sysconf(name)
+        except (ValueError, OSError, AttributeError):
+            continue
+        if size > 0:
+            return size
+    return 32 << 20
+
+
+def flush_caches(buffer):
+    buffer[:] = bytes(len(buffer))
+
+
+def time_function(func, args, warmup, samples, sample_ns, flush_buffer=None):
+    result = None
+    for _ in range(warmup):
+        result = func(*args)
+
+    times = []
+    calls = 1
+    while True:
+        if flush_buffer is not None:
+            flush_caches(flush_buffer)
+        start = time.perf_counter_ns()
+        for _ in range(calls):
+            result = func(*args)
+        elapsed = time.perf_counter_ns() - start
+        if flush_buffer is not None or elapsed >= sample_ns or calls >= MAX_CALLS:
+            if calls == 1:
+                times.append(float(elapsed))
+            break
+        calls *= 2
+
+    while len(times) < samples:
+        if flush_buffer is not None:
+            flush_caches(flush_buffer)
+        start = time.perf_counter_ns()
+        for _ in range(calls):
+            result = func(*args)
+        times.append((time.perf_counter_ns() - start) / calls)
+
+    times.sort()
+    n = len(times)
+    median = times[n // 2] if n % 2 else 0.5 * (times[n // 2 - 1] + times[n // 2])
+    stats = {
+        "calls": calls,
+        "samples": n,
+        "min_ns": times[0],
+        "median_ns": median,
+        "p99_ns": times[(99 * n + 99) // 100 - 1],
+        "mean_ns": sum(times) / n,
+    }
+    return result, stats
 
 # function to find the missing element using xor
 def find_missing_xor_element(a, b):
@@ -99,25 +163,52 @@ def find_missing_sum_element(a, b):
     return sum(a) - sum(b)
 
 if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Missing item benchmark")
+    parser.add_argument("--samples", type=int, default=10, help="timed samples per method (default: 10)")
+    parser.add_argument("--warmup", type=int, default=1, help="untimed calls before timing (default: 1)")
+    parser.add_argument("--sample-ms", type=float, default=1.0,
+                        help="shortest sample; fast methods repeat until it is reached (default: 1)")
+    parser.add_argument("--flush-cache", action="store_true",
+                        help="evict the caches before every sample and time single cold calls")
+    parser.add_argument("--json", metavar="FILE", help="also write the results as JSON (schema in the README)")
+    options = parser.parse_args()
+    if options.samples < 1 or options.warmup < 0:
+        parser.error("--samples must be at least 1 and --warmup cannot be negative")
+    sample_ns = int(options.sample_ms * 1e6)
+    flush_buffer = bytearray(2 * cache_bytes()) if options.flush_cache else None
 
     # Test with different list sizes
-    sizes = [2**x for x in range(1, 16)]  # Sizes: 2 -> 4 -> 8 -> ... -> 2^31
+    sizes = [2**x for x in range(1, 16)]  # Sizes: 2 -> 4 -> 8 -> ... -> 2^15
     test_functions = {
         "xor": find_missing_xor_element,
         "xor_opt": find_missing_xor_element_optimized,
         "xor_reduce": find_missing_xor_element_reduce,
         "xor_numpy": find_missing_xor_element_numpy,
         "xor_numpy_combined": find_missing_xor_element_numpy_combined,
-        "loop": find_missing_element,
+        "count": find_missing_element,
         "set": find_missing_set_element,
         "sum": find_missing_sum_element
     }
+    names = {
+        "xor": "XOR",
+        "xor_opt": "XOR (optimized)",
+        "xor_reduce": "XOR (reduce)",
+        "xor_numpy": "XOR (NumPy)",
+        "xor_numpy_combined": "XOR (NumPy combined)",
+        "count": "Count",
+        "set": "Set",
+        "sum": "Sum"
+    }
 
     if not HAS_NUMPY:
         print("NumPy is not available. Skipping NumPy-based tests.")
         del test_functions["xor_numpy"]
         del test_functions["xor_numpy_combined"]
-    
+
+    seed = time.time_ns()
+    random.seed(seed)
+    records = []
+
     for size in sizes:
         print(f"\n=== Testing with list size: {size} ===")
         
@@ -126,69 +217,64 @@ if __name__ == "__main__":
 
         # random same as list a, but with 1 random element removed
         b = a.copy()
-        b.remove(random.choice(b))
-
-        # Run multiple times and average
-        time_results = {
-            'xor': [],
-            'xor_opt': [],
-            'xor_reduce': [],
-            'xor_numpy': [],
-            'xor_numpy_combined': [],
-            'loop': [],
-            'set': [],
-            'sum': []
-        }
+        missing = random.choice(b)
+        b.remove(missing)
 
-        results = []
-        
-        for _ in range(10):  # Run 10 times for better average
-            for key, func in test_functions.items():
-                result, elapsed = time_function(func, a, b)
-                time_results[key].append(elapsed)
-                results.append(result)
-
-        # Calculate averages only for available functions
-        avg_times = {}
-        for key in test_functions.keys():
-            if time_results[key]:  # Only calculate if we have results
-                avg_times[key] = sum(time_results[key]) / len(time_results[key])
-
-        print(f"Average time using XOR: {avg_times['xor']:.8f} seconds")
-        print(f"Average time using XOR (optimized): {avg_times['xor_opt']:.8f} seconds")
-        print(f"Average time using XOR (reduce): {avg_times['xor_reduce']:.8f} seconds")
-        if 'xor_numpy' in avg_times:
-            print(f"Average time using XOR (NumPy): {avg_times['xor_numpy']:.8f} seconds")
-        if 'xor_numpy_combined' in avg_times:
-            print(f"Average time using XOR (NumPy combined): {avg_times['xor_numpy_combined']:.8f} seconds")
-        print(f"Average time using Loop: {avg_times['loop']:.8f} seconds")
-        print(f"Average time using Set: {avg_times['set']:.8f} seconds")
-        print(f"Average time using Sum: {avg_times['sum']:.8f} seconds")
+        results = {}
+        stats = {}
+        for key, func in test_functions.items():
+            result, stats[key] = time_function(func, (a, b), options.warmup, options.samples, sample_ns,
+                                               flush_buffer)
+            results[key] = int(result) if result is not None else None
+            print(f"Median time using {names[key]}: {stats[key]['median_ns'] * 1e-9:.8f} seconds "
+                  f"(min {stats[key]['min_ns'] * 1e-9:.8f}, p99 {stats[key]['p99_ns'] * 1e-9:.8f})")
+            records.append({
+                "size": size,
+                "missing": 1,
+                "method": key,
+                "name": names[key],
+                "threads": 1,
+                "result": results[key],
+                "correct": results[key] == missing,
+                "bytes": 8 * (2 * size - 1),
+                **stats[key],
+            })
 
         # Find the fastest method
-        times = {
-            'XOR': avg_times['xor'],
-            'XOR (optimized)': avg_times['xor_opt'],
-            'XOR (reduce)': avg_times['xor_reduce'],
-            'Loop': avg_times['loop'],
-            'Set': avg_times['set'],
-            'Sum': avg_times['sum']
-        }
-        
-        # Add NumPy methods only if they were tested
-        if 'xor_numpy' in avg_times:
-            times['XOR (NumPy)'] = avg_times['xor_numpy']
-        if 'xor_numpy_combined' in avg_times:
-            times['XOR (NumPy combined)'] = avg_times['xor_numpy_combined']
-
-        fastest_method = min(times, key=times.get)
-        print(f"Fastest method: {fastest_method} ({times[fastest_method]:.8f} seconds)")
+        fastest_method = min(stats, key=lambda key: stats[key]["median_ns"])
+        print(f"Fastest method: {names[fastest_method]} ({stats[fastest_method]['median_ns'] * 1e-9:.8f} seconds)")
 
         # Check for discrepancies
-        if len(set(results)) > 1:
-            print("Discrepancy found in results:")
-            for func, result in zip(test_functions, results):
-                print(f"{func[1]}: {result}")
+        if any(result != missing for result in results.values()):
+            print(f"Discrepancy found in results (missing item is {missing}):")
+            for key, result in results.items():
+                print(f"  {names[key]}: {result}")
         else:
-            print("All methods returned the same result:", results[0])
+            print("All methods returned the same result:", missing)
+
+    if options.json:
+        document = {
+            "schema": "missing-item-benchmark",
+            "version": SCHEMA_VERSION,
+            "language": "python",
+            "timer": "time.perf_counter_ns",
+            "config": {
+                "warmup": options.warmup,
+                "samples": options.samples,
+                "sample_ns": sample_ns,
+                "flush_cache": options.flush_cache,
+                "threads": 1,
+                "seed": seed,
+            },
+            "results": records,
+        }
+        with open(options.json, "w") as out:
+            json.dump(document, out, indent=2)
+            out.write("\n")
+        print(f"\nResults written to {options.json}")
 
+    # Wrong results make the run fail, so CI gates on them
+    wrong = sum(1 for record in records if not record["correct"])
+    if wrong:
+        print(f"Error: {wrong} wrong result{'' if wrong == 1 else 's'}")
+        sys.exit(1)
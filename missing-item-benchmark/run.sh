@@ -7,6 +7,9 @@ set -e  # Exit on any error
 
 echo "🚀 Setting up Missing Item benchmark testing environment..."
 
+# Each version writes its timings here in the shared JSON schema (see README)
+mkdir -p results
+
 # Function to test Python version
 test_python() {
     echo ""
@@ -61,7 +64,7 @@ test_python() {
     # Run the missing item script
     echo "🧪 Running Python Missing Item benchmark..."
     cd python
-    python missing-item.py
+    python missing-item.py --json ../results/python.json
     cd ..
     
     deactivate
@@ -94,7 +97,7 @@ test_c() {
     make
     
     echo "🧪 Running C Missing Item benchmark..."
-    make test
+    ./missing-item --json ../results/c.json
     
     echo "🔍 Testing debug build..."
     make debug
@@ -125,7 +128,7 @@ test_go() {
     make
     
     echo "🧪 Running Go Missing Item benchmark..."
-    make run
+    ./missing-item -json ../results/go.json
     
     echo "🔍 Testing with timing..."
     make time
@@ -180,6 +183,8 @@ if [[ "$1" == "-h" || "$1" == "--help" ]]; then
     echo "  make           # Build"
     echo "  make run       # Build and run"
     echo "  make time      # Build and run with timing"
+    echo "  ./missing-item --max-size 1000000000   # Up to 1e9 elements"
+    echo "  ./missing-item --json results.json     # Also write JSON results"
     echo "  make clean     # Clean build files"
     echo ""
     echo "Go version:"
@@ -196,8 +201,13 @@ test_python
 test_c
 test_go
 
+# Fail on any wrong result recorded in the JSON files
+echo ""
+python3 check-results.py results/*.json
+
 echo ""
 echo "🎉 All tests completed successfully!"
+echo "📊 JSON results are in results/"
 
 # Clean up after successful completion
 cleanup
@@ -0,0 +1,44 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "matrix.h"
+
+// Bump allocator for scratch memory.
+//
+// An arena is one MATRIX_ALIGNMENT-aligned block handed out front to back.
+// Allocations are never freed one by one: arena_mark records the current
+// position and arena_release (or arena_reset) rolls back to it in O(1), so a
+// call can take a mark on entry and drop everything it created on exit.
+// Each worker owns its arena, which keeps per-step scratch off the shared
+// heap. The high-water mark is kept for sizing reports.
+//
+// Matrices are created in an arena with matrix_create_in / matrix_wrap_in
+// (matrix.h). When the arena is NULL or full they fall back to the heap and
+// the miss is counted, so an undersized arena costs speed, not correctness.
+struct Arena {
+    unsigned char* base;
+    size_t capacity;
+    size_t used;
+    size_t peak;            // Largest value of used since creation
+    long overflows;         // Matrix allocations that fell back to the heap
+};
+typedef struct Arena Arena;
+
+Arena* arena_create(size_t capacity);
+void arena_free(Arena* arena);
+
+// MATRIX_ALIGNMENT-aligned block of bytes, or NULL when the arena is full
+void* arena_alloc(Arena* arena, size_t bytes);
+
+size_t arena_mark(const Arena* arena);
+void arena_release(Arena* arena, size_t mark);  // Drop everything allocated after mark
+void arena_reset(Arena* arena);                 // Drop everything
+
+// Arena bytes taken by matrix_create_in(rows, cols) and matrix_wrap_in(rows)
+size_t arena_matrix_bytes(int rows, int cols);
+size_t arena_view_bytes(int rows);
+
+// "12.5 KB of 64.0 KB peak" style summary
+void arena_print_usage(const Arena* arena, const char* label);
+
+#endif // ARENA_H
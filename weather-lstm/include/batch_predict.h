@@ -0,0 +1,44 @@
+#ifndef BATCH_PREDICT_H
+#define BATCH_PREDICT_H
+
+#include "lstm.h"
+#include "thread_pool.h"
+
+// Batched inference over many independent windows.
+//
+// Up to batch_size windows run side by side, one per column, so every step
+// is one [4H x I] and one [4H x H] GEMM over the whole batch instead of a
+// gemv per window. State is kept in place and no tape is recorded, so the
+// workspace does not grow with the window length.
+//
+// Stacked networks keep each layer's state in its own rows. Hidden states
+// are double-buffered by step parity, so when pool is set the layers run as
+// a wavefront (wavefront.h): layer l + 1 reads step t of layer l while
+// layer l already writes step t + 1 into the other buffer.
+typedef struct {
+    int batch_size;
+    int columns;        // Live columns of the last run (the rest are padding)
+    int num_layers;
+    ThreadPool* pool;   // Optional, borrowed: pipelines the layers when set
+    Matrix* x;          // [I x B] inputs of the current step
+    Matrix* gates;      // [L*4H x B]
+    Matrix* cell;       // [L*H x B]
+    Matrix* hidden;     // [2*L*H x B], two buffers per layer
+    Matrix* output;     // [O x B] predictions of the last run, one per column
+    
+    // Row views of the blocks above, per layer
+    Matrix* layer_gates[LSTM_MAX_LAYERS];
+    Matrix* layer_cell[LSTM_MAX_LAYERS];
+    Matrix* layer_hidden[LSTM_MAX_LAYERS][2];   // Step t writes buffer t % 2
+} BatchPredictor;
+
+BatchPredictor* batch_predictor_create(LSTMNetwork* network, int batch_size);
+void batch_predictor_free(BatchPredictor* predictor);
+
+// Predict from count <= batch_size windows, each steps contiguous rows of
+// network->input_size values. Column b of predictor->output holds the
+// prediction for windows[b]. Returns 0 on success.
+int batch_predictor_run(BatchPredictor* predictor, LSTMNetwork* network,
+                        double** windows, int count, int steps);
+
+#endif // BATCH_PREDICT_H
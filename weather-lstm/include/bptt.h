@@ -0,0 +1,90 @@
+#ifndef BPTT_H
+#define BPTT_H
+
+#include "lstm.h"
+#include "arena.h"
+#include "thread_pool.h"
+
+// Gradients for every trainable tensor of an LSTMNetwork, shaped like the
+// parameters they belong to, with one set of gate gradients per layer
+typedef struct {
+    int num_layers;
+    Matrix* dW[LSTM_MAX_LAYERS];    // [4H x I] fused input weights (I = H above layer 0)
+    Matrix* dU[LSTM_MAX_LAYERS];    // [4H x H] fused recurrent weights
+    Matrix* db[LSTM_MAX_LAYERS];    // [4H x 1] fused biases
+    Matrix* dW_output;  // [O x H] output layer weights
+    Matrix* db_output;  // [O x 1] output layer bias
+} LSTMGradients;
+
+// Per-timestep activations recorded by the forward pass for a batch of B
+// sequences, one per column. All entries are views into one block allocated
+// up front for max_steps steps.
+typedef struct {
+    int max_steps;
+    int batch_size;
+    int steps;          // Steps recorded by the last forward pass
+    Matrix** x;         // [max_steps] inputs [I x B] (borrowed from the caller)
+    Matrix** gates;     // [max_steps] activated gates [4H x B]
+    Matrix** c;         // [max_steps + 1] cell states [H x B]; c[0] is the initial state
+    Matrix** h;         // [max_steps + 1] hidden states [H x B]; h[0] is the initial state
+    Matrix** c_tanh;    // [max_steps] tanh(c_t) [H x B]
+    Matrix* block;      // Storage behind every view above
+} LSTMTape;
+
+// Backpropagation-through-time engine: tapes, gradients, batch staging and
+// backward scratch for mini-batches of up to batch_size sequences. Stacked
+// networks get a tape and backward scratch per layer, so the layers of a
+// pass can run as a wavefront (wavefront.h) when pool is set.
+typedef struct {
+    int batch_size;
+    int columns;            // Live columns in the current batch (the rest are padding)
+    int num_layers;
+    Arena* arena;           // Backs the staging and scratch matrices below
+    ThreadPool* pool;       // Optional, borrowed: pipelines the layers of each pass
+    LSTMTape* tapes[LSTM_MAX_LAYERS];   // Layer l > 0 records tapes[l - 1]->h as its inputs
+    LSTMGradients* grads;
+    Matrix** inputs;        // Current batch inputs, set by bptt_load_batch
+    Matrix* targets;        // Current batch targets, set by bptt_load_batch
+    Matrix** batch_inputs;  // [max_steps] staged inputs [I x B]
+    Matrix* batch_targets;  // [O x B] staged targets
+    Matrix** window;        // [max_steps] [I x 1] views into the features (B = 1)
+    Matrix* window_target;  // [O x 1] view into the features (B = 1)
+    Matrix* output;         // [O x B] prediction of the last forward pass
+    Matrix* d_output;       // [O x B] dL/dy
+    Matrix** d_inputs;      // [max_steps] [H x B] dL/dx_t handed from a layer to the one below
+
+    // Backward scratch, per layer
+    Matrix* d_hidden[LSTM_MAX_LAYERS];  // [H x B] dL/dh_t
+    Matrix* d_cell[LSTM_MAX_LAYERS];    // [H x B] dL/dc_t
+    Matrix* d_gates[LSTM_MAX_LAYERS];   // [4H x B] dL/d(gate pre-activations)
+
+    // Transposed staging so batched weight gradients run as GEMMs, per layer
+    Matrix* x_t[LSTM_MAX_LAYERS];           // [B x I]
+    Matrix* h_t[LSTM_MAX_LAYERS];           // [B x H]
+    Matrix* d_gates_t[LSTM_MAX_LAYERS];     // [B x 4H]
+    Matrix* d_hidden_t[LSTM_MAX_LAYERS];    // [B x H]
+} BPTTTrainer;
+
+// Gradients
+LSTMGradients* lstm_gradients_create(LSTMNetwork* network);
+void lstm_gradients_free(LSTMGradients* grads);
+void lstm_gradients_zero(LSTMGradients* grads);
+void lstm_gradients_add(LSTMGradients* dest, LSTMGradients* src);  // dest += src
+void lstm_gradients_apply(LSTMNetwork* network, LSTMGradients* grads, double step);
+
+// Tape
+LSTMTape* lstm_tape_create(LSTMCell* cell, int max_steps, int batch_size);
+void lstm_tape_free(LSTMTape* tape);
+
+// Training engine
+BPTTTrainer* bptt_trainer_create(LSTMNetwork* network, int max_steps, int batch_size);
+void bptt_trainer_free(BPTTTrainer* trainer);
+int bptt_load_batch(BPTTTrainer* trainer, TrainingData* data, int first, int count);
+int bptt_forward(BPTTTrainer* trainer, LSTMNetwork* network, Matrix** sequence, int steps);
+double bptt_backward(BPTTTrainer* trainer, LSTMNetwork* network, Matrix* target, int window);
+
+// One pass over data in trainer->batch_size batches, one SGD step each.
+// Returns the summed loss; batches that fail to load or run are skipped.
+double bptt_train_epoch(BPTTTrainer* trainer, LSTMNetwork* network, TrainingData* data);
+
+#endif // BPTT_H
@@ -0,0 +1,85 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "lstm.h"
+#include "optimizer.h"
+
+// Periodic training checkpoints, written off the training thread.
+//
+// A checkpoint is a model file followed by a training state section. The
+// section holds the epoch reached, the optimizer type and step count, and
+// the optimizer's state block. predict and the model loader ignore the
+// section, so a checkpoint is also a usable model.
+//
+// Taking a checkpoint copies the weights and optimizer state into one of
+// two snapshot buffers and returns right away. A background thread writes
+// that snapshot to a temporary file and renames it over the target, so
+// the target is always a complete checkpoint. While one snapshot is being
+// written, the next one goes into the other buffer, and training never
+// waits for the disk. If a snapshot is still waiting when the next one is
+// taken, the newer one replaces it.
+
+#define CHECKPOINT_MAGIC "WXLSTMCK"
+#define CHECKPOINT_VERSION 1
+
+// Training state section, at lstm_model_extra_offset of the model file and
+// followed by slots x state_size doubles
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t optimizer_type;    // OptimizerType
+    int32_t epoch;              // Epochs completed
+    uint32_t slots;
+    int64_t steps;              // Optimizer updates applied
+    uint64_t state_size;        // Doubles per slot, as in Optimizer.size
+    uint64_t checksum;          // lstm_model_checksum of the state values
+} CheckpointHeader;
+
+typedef struct {
+    LSTMModelHeader model;
+    CheckpointHeader state;
+} CheckpointInfo;
+
+typedef struct {
+    long taken;                 // Snapshots handed to the writer
+    long written;               // Files renamed into place
+    long replaced;              // Snapshots superseded before they were written
+    long failures;
+    double snapshot_seconds;    // Training thread time spent copying
+    double write_seconds;       // Background thread time spent writing
+} CheckpointStats;
+
+typedef struct Checkpointer Checkpointer;
+
+// Checkpoint network and optimizer (which may be NULL) to path every
+// every_epochs epochs and/or every every_seconds seconds; 0 disables either
+// trigger. Starts the writer thread. Returns NULL on failure.
+Checkpointer* checkpointer_create(LSTMNetwork* network, const Optimizer* optimizer, const char* path,
+                                  int every_epochs, double every_seconds);
+
+// Wait for the pending write, then stop the writer
+void checkpointer_free(Checkpointer* checkpointer);
+
+// Snapshot now, as of epoch (epochs completed). Returns 0 on success.
+int checkpointer_save(Checkpointer* checkpointer, LSTMNetwork* network, const Optimizer* optimizer, int epoch);
+
+// Snapshot if a trigger is due after epoch; returns 1 when one was taken,
+// 0 when none was due, -1 on failure
+int checkpointer_epoch(Checkpointer* checkpointer, LSTMNetwork* network, const Optimizer* optimizer, int epoch);
+
+// Block until every snapshot taken so far is on disk. Returns 0 when no
+// write has failed.
+int checkpointer_flush(Checkpointer* checkpointer);
+
+void checkpointer_stats(Checkpointer* checkpointer, CheckpointStats* stats);
+
+// Read the headers of path. Returns 1 for a checkpoint, 0 for a model file
+// without a training state section, and -1 when it is neither.
+int checkpoint_read_info(const char* path, CheckpointInfo* info);
+
+// Copy a checkpoint's optimizer state and step count into optimizer, which
+// must have the checkpoint's type and the network's shape. Sets *epoch to
+// the epochs completed. Returns 0 on success.
+int checkpoint_restore(const char* path, Optimizer* optimizer, int* epoch);
+
+#endif // CHECKPOINT_H
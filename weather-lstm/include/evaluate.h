@@ -0,0 +1,57 @@
+#ifndef EVALUATE_H
+#define EVALUATE_H
+
+#include "lstm.h"
+#include "batch_predict.h"
+#include "thread_pool.h"
+#include <stdio.h>
+
+// Scoring a network on every window of a held-out set.
+//
+// The windows are split into one contiguous range per worker. Each worker
+// runs its range through its own BatchPredictor, so hidden and cell state
+// are never shared and the network's weights are only read. In the same
+// pass, every worker sums absolute and squared errors per feature into its
+// own padded row of partials. The rows are then reduced in worker order.
+// Results for a given thread count are therefore deterministic. An
+// evaluator holds its pool and workspace, so train can score every few
+// epochs without allocating.
+
+#define EVALUATE_PARTIAL_STRIDE 16  // Doubles per worker row: 2 per feature plus the loss, padded
+
+typedef struct {
+    long windows;
+    int raw_units;                          // 1 when mae and rmse are denormalized with norm_params
+    double mae[WEATHER_NUM_FEATURES];       // Mean absolute error per feature
+    double rmse[WEATHER_NUM_FEATURES];      // Root mean squared error per feature
+    double loss;                            // Mean squared error in normalized units, as in training
+    double seconds;
+} EvaluationResult;
+
+typedef struct {
+    int threads;
+    int batch_size;
+    ThreadPool* pool;               // NULL when threads is 1
+    BatchPredictor** predictors;    // [threads] per-worker state
+    double** windows;               // [threads x batch_size] window pointers of the current batch
+    Matrix* partials;               // [threads x EVALUATE_PARTIAL_STRIDE] per-worker sums, a row each
+
+    // Set for the duration of evaluator_run
+    LSTMNetwork* network;
+    TrainingData* data;
+    double scale[WEATHER_NUM_FEATURES];
+    int failures;
+} Evaluator;
+
+// The network must be weather-shaped. Stacked networks are supported; each
+// predictor runs its layers serially. Returns NULL on failure.
+Evaluator* evaluator_create(LSTMNetwork* network, int threads, int batch_size);
+void evaluator_free(Evaluator* evaluator);
+
+// Score network on every window of data. Errors are in raw units when the
+// network has normalization params. Returns 0 on success.
+int evaluator_run(Evaluator* evaluator, LSTMNetwork* network, TrainingData* data, EvaluationResult* result);
+
+void evaluation_print(FILE* out, const EvaluationResult* result);
+
+#endif // EVALUATE_H
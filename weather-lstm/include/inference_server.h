@@ -0,0 +1,60 @@
+#ifndef INFERENCE_SERVER_H
+#define INFERENCE_SERVER_H
+
+#include "lstm.h"
+
+// Stateful inference for many stations.
+//
+// Models stay loaded for the life of the server and every station keeps its
+// own hidden and cell state, so each new observation costs one LSTM step
+// rather than a pass over a whole window. Requests are text lines:
+//
+//   OBS <station> <t>,<p>,<h>,<ws>,<wd>,<pr>   advance the station one step
+//   PREDICT <station>                          repeat the latest prediction
+//   BIND <station> <model>                     pick the station's model (resets it)
+//   RESET <station>                            clear the station's state
+//   STATS                                      request counts and latency
+//   QUIT                                       stop serving
+//
+// Observations and predictions are in raw units; the model's normalization
+// parameters are applied on the way in and out. Replies are one line,
+// starting with OK or ERR. Station ids hold at most 63 characters and model
+// names at most 255; longer fields get ERR rather than being cut short.
+
+typedef struct {
+    char* id;
+    int model;          // Index into the server's models
+    Matrix* hidden;     // [L*H x 1] persistent hidden state of every layer
+    Matrix* cell;       // [L*H x 1] persistent cell state of every layer
+    Matrix* output;     // [O x 1] prediction after the latest observation
+    long steps;         // Observations since the last reset
+} StationState;
+
+typedef struct {
+    LSTMNetwork** models;
+    char** model_names;
+    int num_models;
+    
+    StationState* stations;
+    int num_stations;
+    int station_capacity;
+    int* index;             // Open-addressing table of station indices, -1 when empty
+    int index_capacity;     // Power of two
+    
+    Matrix* x;              // [I x 1] staged observation
+    long requests;
+    double busy_seconds;    // Time spent handling requests
+} InferenceServer;
+
+InferenceServer* inference_server_create(void);
+void inference_server_free(InferenceServer* server);
+
+// Load a model under name; the first model is the default for new stations.
+// Models must take WEATHER_NUM_FEATURES inputs. Returns 0 on success.
+int inference_server_add_model(InferenceServer* server, const char* name, const char* filename);
+
+// Handle one request line and write the reply line to out.
+// Returns 1 after QUIT, 0 otherwise.
+int inference_server_handle(InferenceServer* server, const char* line, FILE* out);
+
+#endif // INFERENCE_SERVER_H
@@ -0,0 +1,80 @@
+#ifndef LARGE_ALLOC_H
+#define LARGE_ALLOC_H
+
+#include "matrix.h"
+
+// Placement of large buffers: hugepages and NUMA nodes.
+//
+// Matrix storage, workspace arenas, dataset points and training window
+// offsets are allocated here. Blocks smaller than min_bytes, and every
+// block under the default policy, come from the aligned heap as before.
+// Larger blocks are mapped directly, which has three effects:
+//
+// - A 2 MB-aligned mapping can use transparent hugepages (LARGE_PAGES_THP,
+//   madvise) or pages from the explicit hugetlb pool (LARGE_PAGES_HUGETLB).
+//   One TLB entry then covers 512 times as much memory.
+// - Mapped pages are zero until written. Unlike calloc, nothing touches
+//   them at allocation, and Linux places each page on the NUMA node of the
+//   thread that writes it first. So per-worker state created on its worker
+//   thread stays local to that worker.
+// - With numa set, shared blocks (large_alloc_shared: dataset points that
+//   every worker reads) are interleaved page by page over the online
+//   nodes, so no node serves the whole scan.
+//
+// When the hugetlb pool is empty, the block falls back to THP, with one
+// warning. On a single-node machine numa changes nothing.
+//
+// Every block remembers how it was made, so large_free and large_realloc
+// work on all of them regardless of the policy in force. Set the policy
+// before allocating; it is read without locking.
+
+typedef enum {
+    LARGE_PAGES_DEFAULT = 0,    // Aligned heap, no placement
+    LARGE_PAGES_THP,            // Transparent hugepages via madvise
+    LARGE_PAGES_HUGETLB,        // Explicit 2 MB hugepages (vm.nr_hugepages)
+    LARGE_PAGES_NUM_MODES
+} LargePages;
+
+typedef struct {
+    LargePages pages;
+    int numa;                   // Interleave shared blocks over the online nodes
+    size_t min_bytes;           // Smaller blocks always use the heap
+} LargeAllocPolicy;
+
+// Where a block's pages are, from the kernel's view
+typedef struct {
+    size_t bytes;               // Bytes inspected
+    size_t huge_bytes;          // Backed by hugepages (THP or hugetlb)
+    long pages_sampled;         // Pages whose node was queried
+    long local_pages;           // On the calling thread's node
+    long remote_pages;          // On another node
+} LargeResidency;
+
+#define LARGE_HUGEPAGE_SIZE ((size_t)2 << 20)
+
+void large_alloc_policy_default(LargeAllocPolicy* policy);
+void large_alloc_set_policy(const LargeAllocPolicy* policy);
+const LargeAllocPolicy* large_alloc_policy(void);
+
+// "default", "thp" or "hugetlb"; returns 0 on success
+int large_pages_parse(const char* name, LargePages* pages);
+const char* large_pages_name(LargePages pages);
+
+// Online NUMA nodes (1 when the system does not say)
+int large_alloc_nodes(void);
+
+// MATRIX_ALIGNMENT-aligned, zero-filled block; NULL on failure. The
+// _shared form is for blocks read by every worker.
+void* large_alloc(size_t bytes);
+void* large_alloc_shared(size_t bytes);
+
+// Resize, keeping the first min(old, new) bytes; the block keeps its
+// shared flag. New bytes are zero. NULL leaves block untouched.
+void* large_realloc(void* block, size_t bytes);
+void large_free(void* block);
+
+// Inspect the pages of [address, address + bytes), sampling at most
+// max_pages of them for their node. Returns 0 on success.
+int large_alloc_residency(const void* address, size_t bytes, long max_pages, LargeResidency* residency);
+
+#endif // LARGE_ALLOC_H
@@ -2,27 +2,38 @@
 #define LSTM_H
 
 #include "matrix.h"
+#include "arena.h"
 #include "weather_data.h"
 
 // LSTM cell structure
+//
+// Gate parameters are stored fused, with the four gates stacked in
+// forget, input, candidate, output order, so each step needs one pass over
+// W and one over U. The per-gate matrices are row views into the fused ones.
 typedef struct {
     // Input dimensions
     int input_size;
     int hidden_size;
     
-    // Weight matrices
+    // Fused gate parameters
+    Matrix* W;    // [4H x I] input weights
+    Matrix* U;    // [4H x H] recurrent weights
+    Matrix* b;    // [4H x 1] biases
+    Matrix* gates; // [4H x 1] gate activations of the last step
+    
+    // Weight matrices (views into W)
     Matrix* W_f;  // Forget gate weights
     Matrix* W_i;  // Input gate weights
     Matrix* W_c;  // Candidate gate weights
     Matrix* W_o;  // Output gate weights
     
-    // Recurrent weight matrices
+    // Recurrent weight matrices (views into U)
     Matrix* U_f;  // Forget gate recurrent weights
     Matrix* U_i;  // Input gate recurrent weights
     Matrix* U_c;  // Candidate gate recurrent weights
     Matrix* U_o;  // Output gate recurrent weights
     
-    // Bias vectors
+    // Bias vectors (views into b)
     Matrix* b_f;  // Forget gate bias
     Matrix* b_i;  // Input gate bias
     Matrix* b_c;  // Candidate gate bias
@@ -32,7 +43,7 @@ typedef struct {
     Matrix* cell_state;
     Matrix* hidden_state;
     
-    // Intermediate computations (for backprop)
+    // Intermediate computations (views into gates, for backprop)
     Matrix* forget_gate;
     Matrix* input_gate;
     Matrix* candidate_gate;
@@ -40,9 +51,35 @@ typedef struct {
     
 } LSTMCell;
 
+// Index of each gate's rows in the fused parameter matrices
+enum {
+    LSTM_GATE_FORGET = 0,
+    LSTM_GATE_INPUT = 1,
+    LSTM_GATE_CANDIDATE = 2,
+    LSTM_GATE_OUTPUT = 3,
+    LSTM_NUM_GATES = 4
+};
+
+// Most layers a network can stack
+#define LSTM_MAX_LAYERS 4
+
+struct LSTMNetwork;
+struct Optimizer;
+
+// Called by lstm_train and lstm_train_parallel after every epoch, with the
+// epoch number counted from 1 (after first_epoch when resuming) and the
+// epoch's average training loss
+typedef void (*LSTMEpochCallback)(struct LSTMNetwork* network, int epoch, double loss, void* context);
+
 // LSTM network structure
-typedef struct {
-    LSTMCell* lstm_layer;
+//
+// num_layers cells are stacked: layer 0 reads the input and layer l > 0
+// reads the hidden state of layer l - 1, so every layer above the first has
+// input size hidden_size. The output layer reads the top layer.
+typedef struct LSTMNetwork {
+    LSTMCell* lstm_layer;  // Bottom layer, the same cell as layers[0]
+    LSTMCell* layers[LSTM_MAX_LAYERS];
+    int num_layers;
     Matrix* W_output;      // Output layer weights
     Matrix* b_output;      // Output layer bias
     
@@ -53,47 +90,156 @@ typedef struct {
     // Training parameters
     double learning_rate;
     int sequence_length;
+    int bptt_window;       // Truncated BPTT window in steps (0 = full sequence)
+    int batch_size;        // Sequences per gradient update
+    int pipeline_threads;  // Threads for the layer wavefront in lstm_train (<= 1 runs it serially)
+    int first_epoch;       // Epochs completed before this run; numbering continues from it
+    struct Optimizer* optimizer;        // Optional, borrowed: update rule (NULL = plain SGD)
+    LSTMEpochCallback epoch_callback;   // Optional, for progress and held-out scoring
+    void* epoch_context;
     
     // Normalization parameters
     NormalizationParams* norm_params;
     
+    // Mapped model file behind the weights, or NULL when they are heap owned
+    void* map_base;
+    size_t map_size;
+    
+    // Scratch for the prediction helpers, released when each call returns
+    Arena* scratch;
+    
 } LSTMNetwork;
 
 // Training data structure
+//
+// A view of sliding windows over one row-major feature buffer, typically a
+// normalized WeatherDataset. Sample s reads rows offsets[s] ..
+// offsets[s] + sequence_length - 1 as inputs and the following row as its
+// target, so building it copies no observations. The buffer is borrowed and
+// must outlive the view.
 typedef struct {
-    Matrix*** inputs;    // Array of input sequences (each sequence is Matrix**)
-    Matrix** targets;    // Array of target outputs
+    double* features;     // [num_rows x feature_size] borrowed feature rows
+    int feature_size;     // Values per row
+    int num_rows;
+    int* offsets;         // [num_sequences] first input row of each sample
     int num_sequences;
     int sequence_length;
 } TrainingData;
 
+// Input row t of sample seq, and the sample's target row
+static inline double* training_data_input(const TrainingData* data, int seq, int t) {
+    return data->features + (size_t)(data->offsets[seq] + t) * data->feature_size;
+}
+
+static inline double* training_data_target(const TrainingData* data, int seq) {
+    return training_data_input(data, seq, data->sequence_length);
+}
+
+// Model file: a fixed header followed by one blob holding every tensor
+// densely row-major in native doubles, each at a MATRIX_ALIGNMENT-aligned
+// offset, so a mapped file is used in place. The checksum covers the blob.
+// Version 2 adds stacked layers: the header's tensor table describes the
+// bottom layer and the output layer, and W, U and b of each layer above it
+// follow the header as LSTM_MODEL_LAYER_TENSORS more LSTMModelTensor
+// entries. Version 1 files always hold one layer.
+#define LSTM_MODEL_MAGIC "WXLSTMMD"
+#define LSTM_MODEL_VERSION 2
+#define LSTM_MODEL_LAYER_TENSORS 3
+#define LSTM_MODEL_BYTE_ORDER 0x01020304u
+#define LSTM_MODEL_DTYPE_F64 1u
+
+typedef enum {
+    LSTM_TENSOR_W = 0,          // [4H x I] fused input weights
+    LSTM_TENSOR_U = 1,          // [4H x H] fused recurrent weights
+    LSTM_TENSOR_B = 2,          // [4H x 1] fused biases
+    LSTM_TENSOR_W_OUTPUT = 3,   // [O x H]
+    LSTM_TENSOR_B_OUTPUT = 4,   // [O x 1]
+    LSTM_MODEL_NUM_TENSORS = 5
+} LSTMModelTensorId;
+
+typedef struct {
+    uint64_t offset;            // Byte offset from the start of the file
+    uint32_t rows;
+    uint32_t cols;
+} LSTMModelTensor;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;        // LSTM_MODEL_BYTE_ORDER as written
+    uint32_t dtype;
+    uint32_t num_tensors;
+    int32_t input_size;
+    int32_t hidden_size;
+    int32_t output_size;
+    int32_t sequence_length;
+    double learning_rate;
+    uint32_t has_norm_params;
+    uint32_t num_layers;        // 0 in version 1 files, meaning one layer
+    NormalizationParams norm_params;
+    uint64_t blob_offset;
+    uint64_t blob_size;
+    uint64_t checksum;          // lstm_model_checksum of the blob
+    LSTMModelTensor tensors[LSTM_MODEL_NUM_TENSORS];
+} LSTMModelHeader;
+
 // Function declarations
 
 // LSTM Cell operations
 LSTMCell* lstm_cell_create(int input_size, int hidden_size);
 void lstm_cell_free(LSTMCell* cell);
 void lstm_cell_reset_state(LSTMCell* cell);
+int lstm_cell_step(LSTMCell* cell, Matrix* input);
+int lstm_cell_step_state(LSTMCell* cell, Matrix* x, Matrix* h_prev, Matrix* c_prev,
+                         Matrix* gates, Matrix* c_out, Matrix* c_tanh, Matrix* h_out);
 Matrix* lstm_cell_forward(LSTMCell* cell, Matrix* input);
 
 // LSTM Network operations
 LSTMNetwork* lstm_network_create(int input_size, int hidden_size, int output_size);
+LSTMNetwork* lstm_network_create_stacked(int input_size, int hidden_size, int output_size, int num_layers);
 void lstm_network_free(LSTMNetwork* network);
+LSTMCell* lstm_network_top(LSTMNetwork* network);         // Layer read by the output layer
+int lstm_network_step(LSTMNetwork* network, Matrix* x);   // One step of every layer, state in place
 Matrix* lstm_network_predict(LSTMNetwork* network, Matrix** sequence, int seq_length);
+int lstm_network_predict_into(LSTMNetwork* network, Matrix** sequence, int seq_length, Matrix* output);
+int lstm_network_predict_window(LSTMNetwork* network, double* window, int steps, Matrix* output);
+// hidden and cell stack every layer's state: [num_layers * H x 1], layer l in
+// rows l * H .. (l + 1) * H - 1
+int lstm_network_step_state(LSTMNetwork* network, Matrix* x, Matrix* hidden, Matrix* cell, Matrix* output);
 void lstm_network_reset(LSTMNetwork* network);
 
 // Training
 TrainingData* create_training_data(WeatherDataset* dataset, int sequence_length);
+TrainingData* training_data_view(double* features, int feature_size, int num_rows, int sequence_length);
 void free_training_data(TrainingData* data);
 void lstm_train(LSTMNetwork* network, TrainingData* data, int epochs);
 double calculate_loss(Matrix* predicted, Matrix* target);
 
+// Switch the network to new normalization params without changing what it
+// predicts in raw units. Min/max normalization is affine per feature, so the
+// change folds into layer 0's input weights and bias and into the output
+// layer. Needs weather-shaped input and output and existing norm_params.
+// Returns 0 on success.
+int lstm_network_renormalize(LSTMNetwork* network, const NormalizationParams* params);
+
 // Model persistence
 int save_lstm_model(LSTMNetwork* network, const char* filename);
 LSTMNetwork* load_lstm_model(const char* filename);
+uint64_t lstm_model_checksum(const void* blob, size_t size);
+
+// Save with extra_size bytes of extra appended at lstm_model_extra_offset.
+// Model readers ignore anything past the blob, so the file still loads as
+// a plain model. Returns 0 on success.
+int save_lstm_model_extra(LSTMNetwork* network, const char* filename, const void* extra, size_t extra_size);
+uint64_t lstm_model_extra_offset(const LSTMModelHeader* header);
 
 // Utility functions
 void initialize_weights(Matrix* m, double scale);
 Matrix* create_sequence_input(WeatherDataset* dataset, int start_idx, int seq_length);
 WeatherPoint lstm_predict_next(LSTMNetwork* network, WeatherDataset* recent_data, int seq_length);
 
+// Predict horizon steps past the end of data (normalized), feeding each
+// prediction back as input. Returns a new dataset of normalized points.
+WeatherDataset* lstm_forecast(LSTMNetwork* network, WeatherDataset* data, int horizon);
+
 #endif // LSTM_H
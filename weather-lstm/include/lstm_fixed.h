@@ -0,0 +1,31 @@
+#ifndef LSTM_FIXED_H
+#define LSTM_FIXED_H
+
+#include "lstm.h"
+
+// Shape-specialized LSTM steps.
+//
+// Every network sees the six WeatherPoint fields as input, and deployments
+// use hidden sizes 32, 64, 128 and 256. For those shapes a step is generated
+// from one macro template with the sizes as compile-time constants: the
+// 6-wide input projection is fully unrolled and fused with the bias, and the
+// state update loops have fixed trip counts. lstm_cell_step_state uses them
+// for single-sequence steps (B = 1) on dense weights and falls back to the
+// generic GEMM path for every other shape.
+
+#define LSTM_FIXED_INPUT_SIZE 6
+
+// One step on raw buffers, with the same contract as lstm_cell_step_state:
+// c_out/h_out may alias c_prev/h_prev and c_tanh may be NULL
+typedef void (*LSTMFixedStep)(const double* W, const double* U, const double* b, const double* x,
+                              const double* h_prev, const double* c_prev, double* gates,
+                              double* c_out, double* c_tanh, double* h_out);
+
+// Specialized step for the shape, or NULL when only the generic path applies
+LSTMFixedStep lstm_fixed_step_lookup(int input_size, int hidden_size);
+
+// Turn the specialized steps on or off (on by default, or as set by
+// WEATHER_LSTM_FIXED=0|1). Returns the previous setting.
+int lstm_fixed_set_enabled(int enabled);
+
+#endif // LSTM_FIXED_H
@@ -6,15 +6,39 @@
 #include <string.h>
 #include <math.h>
 
+// Alignment (in bytes) of every matrix element buffer
+#define MATRIX_ALIGNMENT 64
+
 // Matrix structure
+//
+// Elements live in one contiguous, MATRIX_ALIGNMENT-aligned row-major buffer.
+// Row i starts at storage + i * stride. The data row table points into the
+// same buffer so existing code can keep using m->data[i][j]. A view shares
+// another buffer and leaves it alone when freed. Matrices made in an Arena
+// (arena.h) belong to it, and matrix_free leaves them alone until the arena is
+// released.
 typedef struct {
-    double **data;
+    double **data;      // Row pointers into storage (compatibility path)
+    double *storage;    // Contiguous row-major element buffer
     int rows;
     int cols;
+    int stride;         // Elements between the starts of consecutive rows
+    int owns_storage;   // 0 for views
+    int in_arena;       // Struct and storage belong to an Arena
 } Matrix;
 
+// Stride-based element access
+#define MATRIX_ROW(m, i) ((m)->storage + (size_t)(i) * (size_t)(m)->stride)
+#define MATRIX_AT(m, i, j) (MATRIX_ROW(m, i)[j])
+
 // Matrix operations
 Matrix* matrix_create(int rows, int cols);
+Matrix* matrix_wrap(double* storage, int rows, int cols, int stride);
+Matrix* matrix_view_rows(Matrix* parent, int first_row, int rows);
+int matrix_rebind(Matrix* view, double* storage);  // Point a view at new storage, same shape
+struct Arena;
+Matrix* matrix_create_in(struct Arena* arena, int rows, int cols);  // Heap fallback when full
+Matrix* matrix_wrap_in(struct Arena* arena, double* storage, int rows, int cols, int stride);
 void matrix_free(Matrix* m);
 void matrix_zero(Matrix* m);
 void matrix_random(Matrix* m, double min, double max);
@@ -26,6 +50,23 @@ Matrix* matrix_transpose(Matrix* m);
 void matrix_scale(Matrix* m, double scalar);
 void matrix_print(Matrix* m);
 
+// Output-parameter variants: dest must already have the result shape and is
+// overwritten (or accumulated into). They never allocate and return 0 on
+// success, -1 on a shape mismatch. Elementwise ops may alias dest with an
+// operand; products and transpose may not.
+int matrix_multiply_into(Matrix* dest, Matrix* a, Matrix* b);
+int matrix_add_into(Matrix* dest, Matrix* a, Matrix* b);
+int matrix_subtract_into(Matrix* dest, Matrix* a, Matrix* b);
+int matrix_hadamard_into(Matrix* dest, Matrix* a, Matrix* b);
+int matrix_transpose_into(Matrix* dest, Matrix* m);
+int matrix_multiply_at_into(Matrix* dest, Matrix* a, Matrix* b);                // dest = a^T * b
+int matrix_outer_accumulate(Matrix* dest, Matrix* a, Matrix* b, double scale);  // dest += scale * a * b^T
+int gemv_add_bias_into(Matrix* dest, Matrix* W, Matrix* x, Matrix* bias);      // dest = W * x + bias
+int gemv_accumulate_into(Matrix* dest, Matrix* W, Matrix* x);                  // dest += W * x
+int gemm_add_bias_into(Matrix* dest, Matrix* W, Matrix* X, Matrix* bias);      // dest = W * X + bias (per column)
+int gemm_accumulate_into(Matrix* dest, Matrix* W, Matrix* X);                  // dest += W * X
+int matrix_accumulate_row_sums(Matrix* dest, Matrix* a);                       // dest[i] += sum_j a[i][j]
+
 // Element access
 double matrix_get(Matrix* m, int row, int col);
 void matrix_set(Matrix* m, int row, int col, double value);
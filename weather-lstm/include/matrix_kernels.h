@@ -0,0 +1,66 @@
+#ifndef MATRIX_KERNELS_H
+#define MATRIX_KERNELS_H
+
+#include <stdint.h>
+
+// Low-level dense kernels behind the matrix API.
+//
+// All kernels work on raw row-major buffers with explicit leading dimensions.
+// One implementation table is chosen on first use from the CPU features
+// (AVX-512, AVX2+FMA, NEON, or portable scalar code); setting the
+// WEATHER_LSTM_KERNELS environment variable to a table name overrides it.
+
+typedef struct {
+    const char* name;
+
+    // y = A x (or y += A x when accumulate is set); A is m x n
+    void (*gemv)(int m, int n, const double* A, int lda, const double* x, double* y, int accumulate);
+
+    // C = A B (or C += A B when accumulate is set); A is m x k, B is k x n
+    void (*gemm)(int m, int n, int k, const double* A, int lda, const double* B, int ldb,
+                 double* C, int ldc, int accumulate);
+
+    // Elementwise kernels over n contiguous values
+    void (*add)(int n, const double* a, const double* b, double* out);  // out = a + b
+    void (*axpy)(int n, double alpha, const double* x, double* y);      // y += alpha * x
+    void (*scale)(int n, double alpha, double* x);                      // x *= alpha
+    void (*sigmoid)(int n, double* x);                                  // in place
+    void (*tanh)(int n, double* x);                                     // in place
+
+    // Column statistics and rescaling; n >= 1 for minmax. affine multiplies
+    // and adds without fusing, so every table matches the scalar expression.
+    void (*minmax)(int n, const double* x, double* min, double* max);
+    void (*rescale)(int n, double* x, double shift, double divisor);   // x = (x - shift) / divisor
+    void (*affine)(int n, double* x, double scale, double shift);      // x = x * scale + shift
+
+    // Reduced-precision matrix-vector products for inference, taking the
+    // matrix transposed: At is n x m and y = At^T x, so each x_k is broadcast
+    // against a contiguous row and no horizontal sums are needed. The int8
+    // form computes y_i = scale_i * sum_k At_ki x_k with per-output scales.
+    void (*gemv_f32)(int m, int n, const float* At, int lda, const float* x, float* y, int accumulate);
+    void (*gemv_i8)(int m, int n, const int8_t* At, int lda, const float* scale, const float* x,
+                    float* y, int accumulate);
+
+    // Fused optimizer updates over n contiguous weights w, gradients g and
+    // their state, with the gradient scaled by gscale on the fly. Every
+    // table rounds like the scalar code, so updates are bit-identical.
+    //   momentum: v = mu v + gscale g;  w -= step v
+    //   adam:     m = b1 m + (1 - b1) g';  v = b2 v + (1 - b2) g'^2;
+    //             w -= step m / (sqrt(v * v_correction) + epsilon)
+    void (*momentum)(int n, double step, double gscale, double mu, const double* g, double* v, double* w);
+    void (*adam)(int n, double step, double gscale, double beta1, double beta2, double epsilon,
+                 double v_correction, const double* g, double* m, double* v, double* w);
+    double (*sumsq)(int n, const double* x);                            // sum of x_i^2
+} MatrixKernels;
+
+// Active kernel table
+const MatrixKernels* matrix_kernels(void);
+
+// Force a kernel table by name ("scalar", "avx2", "avx512", "neon").
+// Returns 0 on success, -1 if the table is unknown or unsupported here.
+int matrix_kernels_select(const char* name);
+
+// Non-zero if the named kernel table can run on this CPU
+int matrix_kernels_available(const char* name);
+
+#endif // MATRIX_KERNELS_H
@@ -0,0 +1,49 @@
+#ifndef ONLINE_H
+#define ONLINE_H
+
+#include "lstm.h"
+#include "bptt.h"
+
+// Incremental training on rows as they arrive.
+//
+// Raw rows are buffered behind sequence_length rows of context. Each one is
+// folded into running min/max stats, seeded from the model's own
+// normalization. An update first moves the network to the widened stats
+// with lstm_network_renormalize, so existing weights keep their meaning.
+// It then trains on the windows ending in the buffered rows and keeps the
+// last sequence_length rows as context for the next batch. The cost of an
+// update depends only on the new rows, not on how much history the model
+// has seen.
+
+typedef struct {
+    LSTMNetwork* network;       // Borrowed
+    BPTTTrainer* trainer;
+    NormalizationParams stats;  // Running min/max of every raw row seen
+    int have_stats;
+
+    WeatherPoint* rows;         // Raw rows: context, then pending
+    double* normalized;         // Normalized copy of rows, read by the trainer
+    int count;
+    int capacity;
+    int context;                // Rows kept between updates: sequence_length
+
+    long rows_seen;
+    long windows_trained;
+    int renormalized;           // Updates that widened the normalization
+} OnlineTrainer;
+
+// The network must be weather-shaped, with a positive sequence_length
+OnlineTrainer* online_trainer_create(LSTMNetwork* network);
+void online_trainer_free(OnlineTrainer* online);
+
+// Buffer one raw row; returns 0 on success
+int online_trainer_add(OnlineTrainer* online, const WeatherPoint* raw);
+
+// Windows an update would train on
+int online_trainer_pending(const OnlineTrainer* online);
+
+// Train epochs passes over the pending windows. Returns the average loss of
+// the last pass, 0.0 when nothing was pending, or -1.0 on error.
+double online_trainer_update(OnlineTrainer* online, int epochs);
+
+#endif // ONLINE_H
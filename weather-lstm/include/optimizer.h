@@ -0,0 +1,75 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "lstm.h"
+#include "bptt.h"
+
+// Weight update rules for the BPTT and data-parallel trainers.
+//
+// An optimizer is built for one network. Its per-weight state (velocity
+// for momentum; first and second moments for Adam) lives in one contiguous
+// block, and each tensor's state sits at its own aligned offset in the
+// same row-major order as the weights. A step makes one pass over every
+// tensor. Each pass is a single fused kernel (matrix_kernels.h) that scales
+// the gradient, updates the state and writes the weight in place. With
+// clipping, the global gradient norm is summed first, and the clip factor
+// is folded into the gradient scale of that same pass.
+//
+// Set network->optimizer to use one; training without it keeps the plain
+// SGD of lstm_gradients_apply. The learning rate is network->learning_rate.
+
+#define OPTIMIZER_MAX_TENSORS (3 * LSTM_MAX_LAYERS + 2)
+
+typedef enum {
+    OPTIMIZER_SGD = 0,
+    OPTIMIZER_MOMENTUM,
+    OPTIMIZER_ADAM,
+    OPTIMIZER_NUM_TYPES
+} OptimizerType;
+
+typedef struct {
+    OptimizerType type;
+    double momentum;    // Velocity decay for OPTIMIZER_MOMENTUM
+    double beta1;       // Adam first moment decay
+    double beta2;       // Adam second moment decay
+    double epsilon;     // Adam denominator floor
+    double clip_norm;   // Rescale gradients whose global L2 norm exceeds this (0 = never)
+} OptimizerConfig;
+
+typedef struct Optimizer {
+    OptimizerConfig config;
+    long steps;                 // Updates applied; drives Adam's bias correction
+    int num_tensors;
+    int slots;                  // State values per weight: 0, 1 or 2
+
+    // Every trainable tensor in LSTMGradients order: W, U, b of each layer,
+    // then W_output and b_output
+    size_t offsets[OPTIMIZER_MAX_TENSORS];  // Start of each tensor's state within a slot
+    int rows[OPTIMIZER_MAX_TENSORS];
+    int cols[OPTIMIZER_MAX_TENSORS];
+    size_t size;                // State values per slot, including alignment padding
+
+    Matrix* state;              // [slots x size]; NULL for plain SGD
+    double last_norm;           // Gradient norm of the last step, before clipping (0 when not computed)
+} Optimizer;
+
+void optimizer_config_default(OptimizerConfig* config, OptimizerType type);
+
+// "sgd", "momentum" or "adam"; returns 0 on success
+int optimizer_parse(const char* name, OptimizerType* type);
+const char* optimizer_name(OptimizerType type);
+
+Optimizer* optimizer_create(LSTMNetwork* network, const OptimizerConfig* config);
+void optimizer_free(Optimizer* optimizer);
+
+// Zero the state and the step count
+void optimizer_reset(Optimizer* optimizer);
+
+// Update network from grads, each gradient multiplied by grad_scale first
+// (1 / batch sequences to average). Returns 0 on success.
+int optimizer_step(Optimizer* optimizer, LSTMNetwork* network, LSTMGradients* grads, double grad_scale);
+
+// Global L2 norm of every gradient tensor
+double lstm_gradients_norm(LSTMGradients* grads);
+
+#endif // OPTIMIZER_H
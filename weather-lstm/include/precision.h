@@ -0,0 +1,67 @@
+#ifndef PRECISION_H
+#define PRECISION_H
+
+#include "lstm.h"
+
+// Reduced-precision inference.
+//
+// Training stays in double. For inference a trained network can be copied
+// into float32 weights, or quantized to int8 weights with one float scale per
+// row of W and U (scale = max |w| / 127). Bias and output-layer weights stay
+// float32 in both modes. Matrix-vector
+// products run on the float/int8 kernels; gate nonlinearities and the cell
+// state are evaluated in double through the regular kernels, so only the
+// weights and the hidden vector lose precision.
+
+typedef enum {
+    LSTM_PRECISION_F64 = 0,
+    LSTM_PRECISION_F32 = 1,
+    LSTM_PRECISION_INT8 = 2,
+    LSTM_NUM_PRECISIONS = 3
+} LSTMPrecision;
+
+typedef struct {
+    LSTMPrecision precision;
+    LSTMNetwork* network;   // Source network, borrowed; F64 runs it directly
+    int input_size;
+    int hidden_size;
+    int output_size;
+    
+    // Gate weights: float copies (F32) or quantized rows (INT8), stored
+    // transposed for the reduced gemv kernels
+    float* W;               // [I x 4H]
+    float* U;               // [H x 4H]
+    int8_t* W_q;            // [I x 4H]
+    int8_t* U_q;            // [H x 4H]
+    float* W_scale;         // [4H]
+    float* U_scale;         // [4H]
+    float* b;               // [4H]
+    float* W_output;        // [H x O]
+    float* b_output;        // [O]
+    
+    // Step scratch
+    float* x;               // [I]
+    float* h;               // [H]
+    float* gates_f;         // [4H] pre-activations
+    double* gates;          // [4H]
+    double* c;              // [H]
+    double* c_tanh;         // [H]
+    float* y;               // [O]
+} ReducedModel;
+
+const char* lstm_precision_name(LSTMPrecision precision);
+int lstm_precision_parse(const char* name, LSTMPrecision* precision);   // 0 on success
+
+// Copy (F32) or quantize (INT8) the network's weights. The network must
+// outlive the model. Reduced precision needs a single-layer network.
+ReducedModel* reduced_model_create(LSTMNetwork* network, LSTMPrecision precision);
+void reduced_model_free(ReducedModel* model);
+
+// Predict from steps contiguous rows of input_size values into output [O]
+int reduced_model_predict_window(ReducedModel* model, const double* window, int steps, double* output);
+
+// Run every window of data in each precision and print error against the
+// targets, deviation from double, and time per window. Returns 0 on success.
+int lstm_precision_report(LSTMNetwork* network, TrainingData* data);
+
+#endif // PRECISION_H
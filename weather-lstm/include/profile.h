@@ -0,0 +1,81 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Hot-path instrumentation.
+//
+// Each phase accumulates wall time on the monotonic clock, a call count, and
+// the FLOPs and bytes its work implies. FLOPs and bytes are computed from the
+// tensor shapes, not measured. Heap matrix allocations are counted
+// separately. Counters are updated atomically, so the data-parallel and
+// pipelined trainers can record from every worker. Phase time is then summed
+// over threads and can exceed the wall time.
+//
+// The PROFILE_* macros compile to nothing unless WEATHER_LSTM_PROFILE is
+// defined (make PROFILE=1), so default builds pay nothing on the hot path.
+// The functions below always exist; without the flag the counters simply
+// stay at zero.
+
+typedef enum {
+    PROFILE_LOAD = 0,       // Dataset parsing or mapping, plus normalization
+    PROFILE_SEQUENCES,      // Training window construction
+    PROFILE_GATES,          // Gate GEMV/GEMM of forward steps
+    PROFILE_ACTIVATIONS,    // Gate nonlinearities and the cell state update
+    PROFILE_BACKWARD,       // BPTT gradient pass
+    PROFILE_UPDATE,         // Weight update from accumulated gradients
+    PROFILE_MODEL_IO,       // Model file save and load
+    PROFILE_NUM_PHASES
+} ProfilePhase;
+
+typedef enum {
+    PROFILE_FORMAT_TEXT = 0,
+    PROFILE_FORMAT_JSON
+} ProfileFormat;
+
+typedef struct {
+    uint64_t nanoseconds;
+    uint64_t calls;
+    uint64_t flops;
+    uint64_t bytes;
+} ProfileCounters;
+
+#ifdef WEATHER_LSTM_PROFILE
+#define PROFILE_BEGIN(phase) uint64_t profile_begin_##phase = profile_clock_ns()
+#define PROFILE_END(phase) profile_add_time((phase), profile_begin_##phase)
+#define PROFILE_WORK(phase, flops, bytes) profile_add_work((phase), (uint64_t)(flops), (uint64_t)(bytes))
+#define PROFILE_ALLOC() profile_add_allocation()
+#else
+#define PROFILE_BEGIN(phase) ((void)0)
+#define PROFILE_END(phase) ((void)0)
+#define PROFILE_WORK(phase, flops, bytes) ((void)0)
+#define PROFILE_ALLOC() ((void)0)
+#endif
+
+// Monotonic wall clock, available in every build
+double profile_seconds(void);
+uint64_t profile_clock_ns(void);
+
+// 1 when the PROFILE_* macros are compiled in
+int profile_enabled(void);
+
+// Recording, normally through the macros. add_time counts one call of the
+// phase that started at start_ns.
+void profile_add_time(ProfilePhase phase, uint64_t start_ns);
+void profile_add_work(ProfilePhase phase, uint64_t flops, uint64_t bytes);
+void profile_add_allocation(void);
+
+void profile_reset(void);
+void profile_snapshot(ProfilePhase phase, ProfileCounters* out);
+uint64_t profile_allocations(void);
+const char* profile_phase_name(ProfilePhase phase);
+
+// "text" or "json"; returns 0 on success
+int profile_format_parse(const char* name, ProfileFormat* format);
+
+// Per-phase breakdown plus throughput over wall_seconds: sequences/s, and
+// GFLOP/s of all phases combined. Returns 0 on success.
+int profile_report(FILE* out, ProfileFormat format, double wall_seconds, long sequences);
+
+#endif // PROFILE_H
@@ -0,0 +1,31 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Persistent worker threads for data-parallel loops.
+//
+// A pool of N workers is made of N - 1 pthreads plus the calling thread,
+// which runs as worker 0 inside thread_pool_run. Workers sleep between runs,
+// so a pool can be created once and reused for many parallel phases.
+
+typedef struct ThreadPool ThreadPool;
+
+// Task body: called once on every worker with its index in [0, num_workers)
+typedef void (*ThreadPoolTask)(void* ctx, int worker, int num_workers);
+
+// Create a pool of num_workers workers (including the caller). Returns NULL on failure.
+ThreadPool* thread_pool_create(int num_workers);
+void thread_pool_free(ThreadPool* pool);
+
+int thread_pool_size(ThreadPool* pool);
+
+// Run task on every worker and wait until all of them return
+void thread_pool_run(ThreadPool* pool, ThreadPoolTask task, void* ctx);
+
+// Block until every worker of the current run reaches the barrier.
+// Only valid from inside a task.
+void thread_pool_barrier(ThreadPool* pool);
+
+// Split [0, count) evenly across workers; sets [*first, *last) for worker
+void thread_pool_range(int count, int worker, int num_workers, int* first, int* last);
+
+#endif // THREAD_POOL_H
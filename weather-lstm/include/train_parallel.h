@@ -0,0 +1,46 @@
+#ifndef TRAIN_PARALLEL_H
+#define TRAIN_PARALLEL_H
+
+#include "lstm.h"
+
+// Data-parallel training.
+//
+// Every worker owns a BPTT trainer (tape, hidden/cell state and gradient
+// buffer) and reads the shared weights. Each update step hands one
+// mini-batch of network->batch_size sequences to every worker, so a step
+// covers threads * batch_size sequences. Worker gradients are summed with a
+// fixed-order pairwise tree, which keeps results deterministic for a given
+// thread count, and worker 0 applies the averaged update.
+//
+// With more than one thread, a few batches are first run forward and
+// backward on the calling thread alone, without updating the weights. Their
+// time per sequence is the 1-thread reference for the speedup: busy time
+// summed over workers is not, since workers sharing memory bandwidth each
+// run slower than one thread would.
+
+#define PARALLEL_REFERENCE_BATCHES 8
+
+typedef struct {
+    int threads;
+    long sequences;         // Sequences processed over all epochs
+    double wall_seconds;    // Elapsed time of the whole run
+    double busy_seconds;    // Forward/backward time summed over workers
+    long reference_sequences;   // Sequences in the 1-thread reference (0 = not run)
+    double reference_seconds;   // Forward/backward time of the reference
+    double final_loss;      // Average loss of the last epoch
+} ParallelTrainStats;
+
+// Train with the given number of worker threads. Returns 0 on success.
+// stats may be NULL.
+int lstm_train_parallel(LSTMNetwork* network, TrainingData* data, int epochs, int threads,
+                        ParallelTrainStats* stats);
+
+// Fraction of worker time spent computing rather than waiting (1.0 is ideal)
+double parallel_train_utilization(const ParallelTrainStats* stats);
+
+// Estimated 1-thread time of the run over its wall time, T1 / TN; divide by
+// threads for the scaling efficiency. T1 leaves out the weight updates, so
+// the estimate errs low. 0 when no reference was run.
+double parallel_train_speedup(const ParallelTrainStats* stats);
+
+#endif // TRAIN_PARALLEL_H
@@ -0,0 +1,79 @@
+#ifndef TUNING_H
+#define TUNING_H
+
+#include "lstm.h"
+
+// Hyperparameter sweeps over one shared dataset.
+//
+// The caller loads and normalizes the rows once. Every trial builds
+// read-only training_data_view windows over that buffer, so trials with
+// different sequence lengths share the same rows and nothing is copied.
+// Rows before split_row train; windows whose target is at or after split_row
+// validate. Trials run concurrently, one per worker of a pool sized to the
+// core budget, and each trial owns its network and BPTT trainer.
+//
+// Every eval_every epochs a trial measures its validation loss and records it
+// against that checkpoint. A trial is pruned when its loss is worse than
+// prune_factor times the best loss any trial has reached at the same
+// checkpoint, and stops early once patience evaluations pass without an
+// improvement. Which trials get pruned depends on the order they reach the
+// checkpoints, so with more than one worker it can vary between runs.
+
+typedef enum {
+    SWEEP_PENDING = 0,
+    SWEEP_FINISHED,     // Ran every epoch
+    SWEEP_PLATEAU,      // No improvement for patience evaluations
+    SWEEP_PRUNED,       // Fell behind the best trial at a checkpoint
+    SWEEP_FAILED        // Could not allocate or the data was too short
+} SweepStatus;
+
+typedef struct {
+    // Configuration
+    int hidden_size;
+    int sequence_length;
+    double learning_rate;
+
+    // Results
+    SweepStatus status;
+    double initial_loss;    // Validation loss of the untrained network
+    double best_loss;       // Lowest validation loss seen
+    int best_epoch;         // Epochs trained when best_loss was measured
+    int epochs_run;
+    double seconds;         // Wall time of the trial on its worker
+} SweepTrial;
+
+typedef struct {
+    int epochs;
+    int batch_size;
+    int eval_every;         // Epochs between validation passes
+    int patience;           // Evaluations without improvement before stopping (0 = never)
+    double prune_factor;    // Prune past this multiple of the checkpoint's best loss (0 = never)
+    int cores;              // Trials run at once
+    unsigned int seed;      // Weight initialization seed
+} SweepOptions;
+
+void sweep_options_default(SweepOptions* options);
+
+// Fill trials with the cartesian product of the value lists, hidden size
+// slowest. Returns the number of trials written, or -1 when max is too small.
+int sweep_grid(SweepTrial* trials, int max, const int* hidden, int n_hidden, const int* sequence,
+               int n_sequence, const double* learning_rate, int n_learning_rate);
+
+// Run every trial over rows [num_rows x WEATHER_NUM_FEATURES] of normalized
+// features. Returns 0 when the sweep ran, even if some trials failed.
+int sweep_run(double* features, int num_rows, int split_row, SweepTrial* trials, int count,
+              const SweepOptions* options);
+
+// Validation loss removed per wall-clock second: (initial - best) / seconds
+double sweep_efficiency(const SweepTrial* trial);
+
+// Order trials best first, by efficiency or, when by_loss is set, by best
+// validation loss. Failed trials sort last.
+void sweep_rank(SweepTrial* trials, int count, int by_loss);
+
+const char* sweep_status_name(SweepStatus status);
+
+// Average per-window MSE of the network over data; -1.0 on error
+double lstm_validation_loss(LSTMNetwork* network, TrainingData* data);
+
+#endif // TUNING_H
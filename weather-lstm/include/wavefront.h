@@ -0,0 +1,27 @@
+#ifndef WAVEFRONT_H
+#define WAVEFRONT_H
+
+#include "thread_pool.h"
+
+// Wavefront schedule over a stack of recurrent layers.
+//
+// In a forward pass, step (l, t) needs (l, t - 1) and (l - 1, t), so every
+// step on the anti-diagonal l + t = k is independent: layer l can run step
+// t while layer l + 1 runs step t - 1. Tick k runs those steps, with layers
+// dealt round-robin to the pool's workers and a barrier between ticks, so
+// L layers keep up to L cores busy after an (L - 1)-tick ramp. The reverse
+// schedule serves backward passes: t counts down from steps - 1 and (l, t)
+// needs (l, t + 1) and (l + 1, t).
+//
+// Steps must only touch state owned by their layer, plus the outputs of the
+// neighbouring layer that the dependencies above order before them.
+
+// Body of one step; returns 0 on success
+typedef int (*WavefrontStep)(void* ctx, int layer, int t);
+
+// Run every (layer, t) step with layer < layers and t < steps. pool may be
+// NULL, which runs the same order on the calling thread. A failed step stops
+// its worker's remaining steps. Returns 0, or -1 if any step failed.
+int wavefront_run(ThreadPool* pool, int layers, int steps, int reverse, WavefrontStep step, void* ctx);
+
+#endif // WAVEFRONT_H
@@ -0,0 +1,44 @@
+#ifndef WEATHER_COLUMNS_H
+#define WEATHER_COLUMNS_H
+
+#include "weather_data.h"
+
+// Columnar (struct-of-arrays) weather dataset.
+//
+// Each feature lives in its own contiguous array, in WeatherPoint field
+// order, so statistics and normalization run as one vectorized pass per
+// column instead of walking interleaved records. All columns share one
+// MATRIX_ALIGNMENT-aligned block and every column starts on an aligned
+// boundary. Results match the row-oriented functions in weather_data.h
+// exactly.
+//
+// This is a library API for preprocessing code that keeps its data in
+// columns from load to output, such as feature pipelines that add or
+// rescale features one at a time. The bundled tools do not use it: convert,
+// train and sweep read rows and write rows (binary datasets and training
+// windows are interleaved), and a round trip through columns costs several
+// times what the column passes save.
+typedef struct {
+    double* columns[WEATHER_NUM_FEATURES];
+    double* storage;
+    int size;
+    int capacity;
+} WeatherColumns;
+
+// NormalizationParams is read as WEATHER_NUM_FEATURES (min, max) pairs
+typedef char normalization_params_are_pairs[sizeof(NormalizationParams) == 2 * WEATHER_NUM_FEATURES * sizeof(double) ? 1 : -1];
+
+WeatherColumns* weather_columns_create(int capacity);
+void weather_columns_free(WeatherColumns* columns);
+
+// Conversion to and from the row-oriented dataset; both return new objects
+WeatherColumns* weather_columns_from_dataset(WeatherDataset* dataset);
+WeatherDataset* weather_columns_to_dataset(WeatherColumns* columns);
+
+// Column-wise equivalents of calculate_normalization_params,
+// normalize_dataset and denormalize_point
+NormalizationParams* weather_columns_normalization_params(WeatherColumns* columns);
+void weather_columns_normalize(WeatherColumns* columns, NormalizationParams* params);
+void weather_columns_denormalize(WeatherColumns* columns, NormalizationParams* params);
+
+#endif // WEATHER_COLUMNS_H
@@ -2,6 +2,7 @@
 #define WEATHER_DATA_H
 
 #include "matrix.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,11 +17,24 @@ typedef struct {
     double precipitation;   // Precipitation in inches
 } WeatherPoint;
 
+// Number of features per observation; a WeatherPoint is exactly this many
+// doubles, so a dataset doubles as a row-major [size x WEATHER_NUM_FEATURES]
+// feature buffer
+#define WEATHER_NUM_FEATURES 6
+typedef char weather_point_is_packed[sizeof(WeatherPoint) == WEATHER_NUM_FEATURES * sizeof(double) ? 1 : -1];
+
 // Dataset structure
+//
+// data is either a shared large_alloc block (large_alloc.h) or points into a
+// mapped binary dataset file (map_base non-NULL). Mapped datasets are private
+// copy-on-write mappings, so they can be normalized in place; adding points
+// copies them to a block.
 typedef struct {
     WeatherPoint* data;
     int size;
     int capacity;
+    void* map_base;     // Start of the file mapping, or NULL
+    size_t map_size;
 } WeatherDataset;
 
 // Data normalization parameters
@@ -33,15 +47,65 @@ typedef struct {
     double precip_min, precip_max;
 } NormalizationParams;
 
+// Index over a multi-station dataset: station s owns rows starts[s] ..
+// starts[s + 1] - 1
+typedef struct {
+    char** ids;
+    int* starts;        // [count + 1]
+    int count;
+} WeatherStations;
+
+// Binary dataset file: a fixed header followed by size rows of
+// WEATHER_NUM_FEATURES native doubles at data_offset. Rows are stored
+// interleaved so a mapped file is directly a WeatherDataset.
+#define WEATHER_BINARY_MAGIC "WXLSTMDS"
+#define WEATHER_BINARY_VERSION 1
+#define WEATHER_BINARY_BYTE_ORDER 0x01020304u
+#define WEATHER_BINARY_NORMALIZED 0x1u   // Rows hold normalized values
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;        // WEATHER_BINARY_BYTE_ORDER as written
+    uint32_t num_columns;
+    uint32_t flags;
+    uint64_t rows;
+    uint64_t data_offset;       // Byte offset of the first row, 64-byte aligned
+    char columns[WEATHER_NUM_FEATURES][16];  // Column names in row order
+    NormalizationParams norm_params;         // Min/max of the raw values
+} WeatherBinaryHeader;
+
 // Function declarations
 WeatherDataset* weather_dataset_create(int initial_capacity);
 void weather_dataset_free(WeatherDataset* dataset);
 int weather_dataset_add(WeatherDataset* dataset, WeatherPoint point);
+int weather_dataset_reserve(WeatherDataset* dataset, int capacity);
 int weather_load_csv(const char* filename, WeatherDataset* dataset);
+int weather_load_csv_threads(const char* filename, WeatherDataset* dataset, int threads);
 int weather_save_csv(const char* filename, WeatherDataset* dataset);
 
+// Streaming CSV input, one line at a time (no newline). The header decides
+// the layout; parse_csv_line returns 0 when all six fields were read.
+int weather_csv_header_has_timestamps(const char* header);
+int weather_parse_csv_line(const char* line, size_t length, int has_timestamps, WeatherPoint* point);
+
+// Multi-station CSV: rows are appended to dataset and indexed by station
+WeatherStations* weather_load_stations_csv(const char* filename, WeatherDataset* dataset);
+void weather_stations_free(WeatherStations* stations);
+
+// Binary datasets. params receives the stored normalization parameters and
+// normalized whether the rows are already normalized; either may be NULL.
+int weather_is_binary(const char* filename);
+int weather_save_binary(const char* filename, WeatherDataset* dataset, NormalizationParams* params, int normalized);
+int weather_load_binary(const char* filename, WeatherDataset* dataset, NormalizationParams* params, int* normalized);
+
+// Row-major feature view of the dataset, valid until it is grown or freed
+double* weather_dataset_features(WeatherDataset* dataset);
+
 // Data preprocessing
 NormalizationParams* calculate_normalization_params(WeatherDataset* dataset);
+void normalization_params_init(NormalizationParams* params, const WeatherPoint* point);
+void normalization_params_fold(NormalizationParams* params, const WeatherPoint* point);  // Widen to cover point
 void normalize_dataset(WeatherDataset* dataset, NormalizationParams* params);
 void denormalize_point(WeatherPoint* point, NormalizationParams* params);
 
@@ -137,11 +137,7 @@ def main():
     if existing_model:
         print(f"\n🔄 Continuing training from existing model: {existing_model}")
         
-        # For now, we'll train a new model since our C implementation 
-        # doesn't support incremental training yet
-        # In a full implementation, you'd modify the train program to load existing weights
-        print("Note: Current implementation trains new model (incremental training not yet implemented)")
-        
+        # train --continue keeps the weights and widens the saved normalization
         output_model = "models/continued_model.bin"
     else:
         print("\n🆕 Training new model from scratch")
@@ -150,14 +146,22 @@ def main():
     # Ensure models directory exists
     os.makedirs("models", exist_ok=True)
     
-    # Training command
-    train_cmd = (f"./bin/train "
-                f"--data {training_data} "
-                f"--epochs {args.epochs} "
-                f"--output {output_model} "
-                f"--hidden 64 "
-                f"--sequence 10 "
-                f"--learning-rate 0.001")
+    # Training command; a resumed model brings its own shape
+    if existing_model:
+        train_cmd = (f"./bin/train "
+                    f"--continue {existing_model} "
+                    f"--data {training_data} "
+                    f"--epochs {args.epochs} "
+                    f"--output {output_model} "
+                    f"--learning-rate 0.001")
+    else:
+        train_cmd = (f"./bin/train "
+                    f"--data {training_data} "
+                    f"--epochs {args.epochs} "
+                    f"--output {output_model} "
+                    f"--hidden 64 "
+                    f"--sequence 10 "
+                    f"--learning-rate 0.001")
     
     if not run_command(train_cmd, f"Training LSTM model for {args.epochs} epochs"):
         print("Training failed")
@@ -0,0 +1,76 @@
+#define _POSIX_C_SOURCE 200112L
+#include "../include/arena.h"
+#include "../include/large_alloc.h"
+
+static size_t arena_round(size_t bytes) {
+    return (bytes + MATRIX_ALIGNMENT - 1) & ~((size_t)MATRIX_ALIGNMENT - 1);
+}
+
+Arena* arena_create(size_t capacity) {
+    Arena* arena = calloc(1, sizeof(Arena));
+    if (!arena) return NULL;
+    
+    capacity = arena_round(capacity > 0 ? capacity : MATRIX_ALIGNMENT);
+    // Left untouched until used, so a worker's arena lands on its NUMA node
+    void* base = large_alloc(capacity);
+    if (!base) {
+        free(arena);
+        return NULL;
+    }
+    arena->base = base;
+    arena->capacity = capacity;
+    
+    return arena;
+}
+
+void arena_free(Arena* arena) {
+    if (!arena) return;
+    
+    large_free(arena->base);
+    free(arena);
+}
+
+void* arena_alloc(Arena* arena, size_t bytes) {
+    if (!arena) return NULL;
+    
+    // used stays a multiple of the alignment, so every block starts aligned
+    bytes = arena_round(bytes > 0 ? bytes : 1);
+    if (bytes > arena->capacity - arena->used) return NULL;
+    
+    void* block = arena->base + arena->used;
+    arena->used += bytes;
+    if (arena->used > arena->peak) arena->peak = arena->used;
+    
+    return block;
+}
+
+size_t arena_mark(const Arena* arena) {
+    return arena ? arena->used : 0;
+}
+
+void arena_release(Arena* arena, size_t mark) {
+    if (arena && mark <= arena->used) arena->used = mark;
+}
+
+void arena_reset(Arena* arena) {
+    if (arena) arena->used = 0;
+}
+
+size_t arena_view_bytes(int rows) {
+    return arena_round(sizeof(Matrix) + (size_t)(rows > 0 ? rows : 0) * sizeof(double*));
+}
+
+size_t arena_matrix_bytes(int rows, int cols) {
+    size_t storage = (size_t)(rows > 0 ? rows : 0) * (size_t)(cols > 0 ? cols : 0) * sizeof(double);
+    return arena_view_bytes(rows) + arena_round(storage > 0 ? storage : 1);
+}
+
+void arena_print_usage(const Arena* arena, const char* label) {
+    if (!arena) return;
+    
+    printf("%s: %.1f KB of %.1f KB peak", label, arena->peak / 1024.0, arena->capacity / 1024.0);
+    if (arena->overflows > 0) {
+        printf(", %ld allocations fell back to the heap", arena->overflows);
+    }
+    printf("\n");
+}
@@ -0,0 +1,110 @@
+#include "../include/batch_predict.h"
+#include "../include/wavefront.h"
+
+BatchPredictor* batch_predictor_create(LSTMNetwork* network, int batch_size) {
+    if (!network || batch_size <= 0) return NULL;
+    
+    BatchPredictor* predictor = calloc(1, sizeof(BatchPredictor));
+    if (!predictor) return NULL;
+    
+    int H = network->hidden_size;
+    int G = LSTM_NUM_GATES * H;
+    int L = network->num_layers;
+    predictor->batch_size = batch_size;
+    predictor->num_layers = L;
+    predictor->x = matrix_create(network->input_size, batch_size);
+    predictor->gates = matrix_create(L * G, batch_size);
+    predictor->cell = matrix_create(L * H, batch_size);
+    predictor->hidden = matrix_create(2 * L * H, batch_size);
+    predictor->output = matrix_create(network->output_size, batch_size);
+    
+    if (!predictor->x || !predictor->gates || !predictor->cell || !predictor->hidden ||
+        !predictor->output) {
+        batch_predictor_free(predictor);
+        return NULL;
+    }
+    
+    for (int l = 0; l < L; l++) {
+        predictor->layer_gates[l] = matrix_view_rows(predictor->gates, l * G, G);
+        predictor->layer_cell[l] = matrix_view_rows(predictor->cell, l * H, H);
+        predictor->layer_hidden[l][0] = matrix_view_rows(predictor->hidden, 2 * l * H, H);
+        predictor->layer_hidden[l][1] = matrix_view_rows(predictor->hidden, (2 * l + 1) * H, H);
+        if (!predictor->layer_gates[l] || !predictor->layer_cell[l] ||
+            !predictor->layer_hidden[l][0] || !predictor->layer_hidden[l][1]) {
+            batch_predictor_free(predictor);
+            return NULL;
+        }
+    }
+    
+    return predictor;
+}
+
+void batch_predictor_free(BatchPredictor* predictor) {
+    if (!predictor) return;
+    
+    for (int l = 0; l < predictor->num_layers; l++) {
+        matrix_free(predictor->layer_gates[l]);
+        matrix_free(predictor->layer_cell[l]);
+        matrix_free(predictor->layer_hidden[l][0]);
+        matrix_free(predictor->layer_hidden[l][1]);
+    }
+    matrix_free(predictor->x);
+    matrix_free(predictor->gates);
+    matrix_free(predictor->cell);
+    matrix_free(predictor->hidden);
+    matrix_free(predictor->output);
+    free(predictor);
+}
+
+typedef struct {
+    BatchPredictor* predictor;
+    LSTMNetwork* network;
+    double** windows;
+} BatchPass;
+
+// Step t of layer l. Layer 0 stages row t of every window as one column of
+// x; the layers above read the hidden state the layer below wrote at step t.
+static int batch_step(void* arg, int l, int t) {
+    BatchPass* pass = arg;
+    BatchPredictor* predictor = pass->predictor;
+    
+    Matrix* x = predictor->x;
+    if (l == 0) {
+        int I = pass->network->input_size;
+        for (int b = 0; b < predictor->columns; b++) {
+            const double* row = pass->windows[b] + (size_t)t * I;
+            for (int k = 0; k < I; k++) {
+                MATRIX_AT(x, k, b) = row[k];
+            }
+        }
+    } else {
+        x = predictor->layer_hidden[l - 1][t % 2];
+    }
+    
+    // The cell state is updated in place; h moves to the other buffer
+    Matrix* c = predictor->layer_cell[l];
+    return lstm_cell_step_state(pass->network->layers[l], x, predictor->layer_hidden[l][(t + 1) % 2], c,
+                                predictor->layer_gates[l], c, NULL, predictor->layer_hidden[l][t % 2]);
+}
+
+int batch_predictor_run(BatchPredictor* predictor, LSTMNetwork* network,
+                        double** windows, int count, int steps) {
+    if (!predictor || !network || !windows || count <= 0 || count > predictor->batch_size ||
+        steps <= 0 || network->num_layers != predictor->num_layers) {
+        return -1;
+    }
+    
+    // Padding columns see zero inputs; their outputs are ignored
+    matrix_zero(predictor->x);
+    matrix_zero(predictor->cell);
+    matrix_zero(predictor->hidden);
+    predictor->columns = count;
+    
+    BatchPass pass = {predictor, network, windows};
+    if (wavefront_run(predictor->pool, predictor->num_layers, steps, 0, batch_step, &pass) != 0) {
+        return -1;
+    }
+    
+    Matrix* top = predictor->layer_hidden[predictor->num_layers - 1][(steps - 1) % 2];
+    return gemm_add_bias_into(predictor->output, network->W_output, top, network->b_output);
+}
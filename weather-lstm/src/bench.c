@@ -0,0 +1,642 @@
+#define _POSIX_C_SOURCE 200112L
+#define _DEFAULT_SOURCE     // syscall for perf_event_open
+
+#include "../include/lstm.h"
+#include "../include/weather_data.h"
+#include "../include/matrix_kernels.h"
+#include "../include/profile.h"
+#include "../include/large_alloc.h"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Benchmark suite for the kernels and pipelines the LSTM depends on.
+//
+// Every case is calibrated first: its repetition count doubles until one
+// trial takes at least min_trial_ms, so per-call timings stay well above
+// clock resolution. Then come the warm-up trials and the timed trials.
+// Results are per call, in nanoseconds. Median and p99 are taken over the
+// trials. Track the median for regressions, since one-off stalls do not move
+// it; p99 shows how large those stalls are.
+//
+// The placement cases read random training windows from a large dataset
+// under each hugepage mode of large_alloc.h. After timing, one more trial
+// runs under the dTLB-miss and NUMA-node-miss hardware counters, and the
+// kernel is asked how much of the buffer is on hugepages and which nodes
+// hold it. Counters read n/a where perf events are not permitted.
+
+typedef struct {
+    int trials;             // Timed trials per case
+    int warmup;             // Untimed trials after calibration
+    double min_trial_ms;    // Calibration target for one trial
+    double max_case_s;      // Stop adding trials past this, once 3 are done
+    long max_rows;          // Largest CSV size to generate
+    const char* filter;     // Run only cases whose name contains this
+    const char* dir;        // Scratch directory for generated files
+    long placement_mb;      // Dataset size of the placement cases, 0 to skip them
+    int numa;               // Also run the placement cases with NUMA interleaving
+    int quiet_fd;           // /dev/null while a chatty library call runs, else -1
+    int stdout_fd;          // Saved stdout while quiet_fd is active
+} BenchConfig;
+
+typedef struct {
+    char name[64];
+    long reps;              // Calls per trial
+    int trials;
+    double median_ns;
+    double p99_ns;
+    double min_ns;
+    double mean_ns;
+    double items;           // Items per call (rows, steps), 0 when not meaningful
+
+    // Placement cases only
+    const char* pages;      // large_pages_name of the case, NULL for other cases
+    double tlb_misses;      // dTLB load misses per call, -1 when unavailable
+    double node_misses;     // Loads served by another NUMA node per call, -1 when unavailable
+    size_t huge_bytes;      // Dataset bytes on hugepages
+    long local_pages;       // Sampled dataset pages on the benchmark thread's node
+    long remote_pages;
+} BenchResult;
+
+// Runs the benchmarked operation reps times; returns 0 on success
+typedef int (*BenchBody)(void* ctx, long reps);
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// The loaders report every file they read; route those lines to /dev/null
+// while a trial runs so they neither flood the table nor cost terminal time
+static double bench_trial(const BenchConfig* config, BenchBody body, void* ctx, long reps, int* status) {
+    if (config->quiet_fd >= 0) {
+        fflush(stdout);
+        dup2(config->quiet_fd, STDOUT_FILENO);
+    }
+    double start = profile_seconds();
+    if (body(ctx, reps) != 0) *status = -1;
+    double seconds = profile_seconds() - start;
+    if (config->quiet_fd >= 0) {
+        fflush(stdout);
+        dup2(config->stdout_fd, STDOUT_FILENO);
+    }
+    return seconds;
+}
+
+static int bench_run(const BenchConfig* config, const char* name, double items, BenchBody body, void* ctx,
+                     BenchResult* results, int* count) {
+    if (config->filter && !strstr(name, config->filter)) return 0;
+
+    BenchResult* r = &results[*count];
+    memset(r, 0, sizeof(*r));
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->items = items;
+
+    // Calibrate; the calibration runs double as the first warm-up
+    int status = 0;
+    long reps = 1;
+    while (bench_trial(config, body, ctx, reps, &status) * 1e3 < config->min_trial_ms && status == 0 &&
+           reps < (1L << 30)) {
+        reps *= 2;
+    }
+    for (int w = 0; w < config->warmup && status == 0; w++) {
+        bench_trial(config, body, ctx, reps, &status);
+    }
+
+    double* samples = malloc((size_t)config->trials * sizeof(double));
+    if (!samples) return -1;
+    double elapsed = 0.0;
+    int n = 0;
+    while (n < config->trials && status == 0 && (n < 3 || elapsed < config->max_case_s)) {
+        double seconds = bench_trial(config, body, ctx, reps, &status);
+        samples[n++] = seconds * 1e9 / reps;
+        elapsed += seconds;
+    }
+    if (status != 0 || n == 0) {
+        printf("Error: Benchmark %s failed\n", name);
+        free(samples);
+        return -1;
+    }
+
+    qsort(samples, (size_t)n, sizeof(double), compare_doubles);
+    int p99 = (int)(0.99 * n + 0.999999) - 1;   // Nearest rank
+    r->reps = reps;
+    r->trials = n;
+    r->median_ns = n % 2 ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+    r->p99_ns = samples[p99 < 0 ? 0 : p99];
+    r->min_ns = samples[0];
+    for (int i = 0; i < n; i++) {
+        r->mean_ns += samples[i] / n;
+    }
+    free(samples);
+
+    // "1.23 us" style, three significant digits
+    const char* units[] = {"ns", "us", "ms", "s"};
+    double values[] = {r->median_ns, r->p99_ns};
+    char text[2][32];
+    for (int v = 0; v < 2; v++) {
+        int u = 0;
+        double value = values[v];
+        while (value >= 1000.0 && u < 3) {
+            value /= 1000.0;
+            u++;
+        }
+        snprintf(text[v], sizeof(text[v]), "%.3g %s", value, units[u]);
+    }
+    printf("%-36s %10ld %7d %12s %12s", r->name, r->reps, r->trials, text[0], text[1]);
+    if (items > 0.0) {
+        printf(" %12.3g/s", items * 1e9 / r->median_ns);
+    }
+    printf("\n");
+
+    (*count)++;
+    return 0;
+}
+
+// Matrix products at the gate shapes
+typedef struct {
+    Matrix* a;
+    Matrix* b;
+    Matrix* dest;
+} MultiplyCase;
+
+static int bench_matrix_multiply(void* arg, long reps) {
+    MultiplyCase* c = arg;
+    for (long r = 0; r < reps; r++) {
+        Matrix* product = matrix_multiply(c->a, c->b);
+        if (!product) return -1;
+        matrix_free(product);
+    }
+    return 0;
+}
+
+static int bench_matrix_multiply_into(void* arg, long reps) {
+    MultiplyCase* c = arg;
+    for (long r = 0; r < reps; r++) {
+        if (matrix_multiply_into(c->dest, c->a, c->b) != 0) return -1;
+    }
+    return 0;
+}
+
+// One cell step, or one window through the network
+typedef struct {
+    LSTMNetwork* network;
+    Matrix** sequence;
+    int steps;
+    Matrix* output;
+} NetworkCase;
+
+static int bench_cell_forward(void* arg, long reps) {
+    NetworkCase* c = arg;
+    for (long r = 0; r < reps; r++) {
+        Matrix* hidden = lstm_cell_forward(c->network->lstm_layer, c->sequence[r % c->steps]);
+        if (!hidden) return -1;
+        matrix_free(hidden);
+    }
+    return 0;
+}
+
+static int bench_network_predict(void* arg, long reps) {
+    NetworkCase* c = arg;
+    for (long r = 0; r < reps; r++) {
+        Matrix* prediction = lstm_network_predict(c->network, c->sequence, c->steps);
+        if (!prediction) return -1;
+        matrix_free(prediction);
+    }
+    return 0;
+}
+
+static int bench_network_predict_into(void* arg, long reps) {
+    NetworkCase* c = arg;
+    for (long r = 0; r < reps; r++) {
+        if (lstm_network_predict_into(c->network, c->sequence, c->steps, c->output) != 0) return -1;
+    }
+    return 0;
+}
+
+// Dataset and file pipelines
+typedef struct {
+    WeatherDataset* dataset;
+    const char* path;
+    int sequence_length;
+    LSTMNetwork* network;
+} DataCase;
+
+static int bench_training_data(void* arg, long reps) {
+    DataCase* c = arg;
+    for (long r = 0; r < reps; r++) {
+        TrainingData* data = create_training_data(c->dataset, c->sequence_length);
+        if (!data) return -1;
+        free_training_data(data);
+    }
+    return 0;
+}
+
+static int bench_load_csv(void* arg, long reps) {
+    DataCase* c = arg;
+    for (long r = 0; r < reps; r++) {
+        WeatherDataset* dataset = weather_dataset_create(1000);
+        int status = dataset ? weather_load_csv(c->path, dataset) : -1;
+        weather_dataset_free(dataset);
+        if (status != 0) return -1;
+    }
+    return 0;
+}
+
+static int bench_model_save(void* arg, long reps) {
+    DataCase* c = arg;
+    for (long r = 0; r < reps; r++) {
+        if (save_lstm_model(c->network, c->path) != 0) return -1;
+    }
+    return 0;
+}
+
+static int bench_model_load(void* arg, long reps) {
+    DataCase* c = arg;
+    for (long r = 0; r < reps; r++) {
+        LSTMNetwork* network = load_lstm_model(c->path);
+        if (!network) return -1;
+        lstm_network_free(network);
+    }
+    return 0;
+}
+
+// Synthetic rows with a daily cycle, the same on every run
+static WeatherPoint bench_point(long i) {
+    double day = (double)(i % 24) / 24.0;
+    WeatherPoint point = {0};
+    point.temperature = 50.0 + 15.0 * day + (double)(i % 7);
+    point.pressure = 29.8 + 0.01 * (double)(i % 30);
+    point.humidity = 40.0 + (double)(i % 50);
+    point.wind_speed = (double)(i % 25) * 0.8;
+    point.wind_direction = (double)((i * 37) % 360);
+    point.precipitation = (i % 11 == 0) ? 0.05 : 0.0;
+    return point;
+}
+
+static int write_bench_csv(const char* path, long rows) {
+    FILE* file = fopen(path, "w");
+    if (!file) return -1;
+
+    fprintf(file, "temperature,pressure,humidity,wind_speed,wind_direction,precipitation\n");
+    for (long i = 0; i < rows; i++) {
+        WeatherPoint p = bench_point(i);
+        fprintf(file, "%.1f,%.2f,%.1f,%.1f,%.1f,%.4f\n", p.temperature, p.pressure, p.humidity,
+                p.wind_speed, p.wind_direction, p.precipitation);
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+// Random training windows read from a dataset-sized buffer
+typedef struct {
+    WeatherPoint* points;
+    long rows;
+    int steps;
+    int windows;                // Windows per call
+    unsigned long long state;   // LCG, so every mode reads the same windows
+    double sum;
+} PlacementCase;
+
+static int bench_window_reads(void* arg, long reps) {
+    PlacementCase* c = arg;
+    double sum = 0.0;
+    for (long r = 0; r < reps; r++) {
+        for (int w = 0; w < c->windows; w++) {
+            c->state = c->state * 6364136223846793005ull + 1442695040888963407ull;
+            long first = (long)((c->state >> 17) % (unsigned long long)(c->rows - c->steps));
+            for (int t = 0; t < c->steps; t++) {
+                const WeatherPoint* p = &c->points[first + t];
+                sum += p->temperature + p->humidity + p->pressure + p->wind_speed + p->wind_direction +
+                       p->precipitation;
+            }
+        }
+    }
+    c->sum += sum;
+    return 0;
+}
+
+// User-space hardware cache counter, or -1 when perf events are not permitted
+static int perf_counter_open(unsigned long long cache, unsigned long long op, unsigned long long result) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = cache | (op << 8) | (result << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static double perf_counter_read(int fd) {
+    long long value = 0;
+    if (fd < 0 || read(fd, &value, sizeof(value)) != (ssize_t)sizeof(value)) return -1.0;
+    return (double)value;
+}
+
+// Time one placement case, then count its misses over one more trial
+static int bench_placement(const BenchConfig* config, const char* name, LargePages pages, int numa,
+                           BenchResult* results, int* count) {
+    if (config->filter && !strstr(name, config->filter)) return 0;
+
+    LargeAllocPolicy policy;
+    large_alloc_policy_default(&policy);
+    policy.pages = pages;
+    policy.numa = numa;
+    large_alloc_set_policy(&policy);
+
+    size_t bytes = (size_t)config->placement_mb << 20;
+    PlacementCase c = {large_alloc_shared(bytes), (long)(bytes / sizeof(WeatherPoint)), 10, 256, 12345, 0.0};
+    large_alloc_set_policy(NULL);
+    if (!c.points || c.rows <= c.steps) {
+        large_free(c.points);
+        printf("Error: Could not allocate %ld MB for %s\n", config->placement_mb, name);
+        return -1;
+    }
+    for (long i = 0; i < c.rows; i++) {
+        c.points[i] = bench_point(i);
+    }
+
+    int status = bench_run(config, name, (double)c.windows, bench_window_reads, &c, results, count);
+    if (status == 0 && *count > 0 && strcmp(results[*count - 1].name, name) == 0) {
+        BenchResult* r = &results[*count - 1];
+        r->pages = large_pages_name(pages);
+
+        int tlb = perf_counter_open(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                                    PERF_COUNT_HW_CACHE_RESULT_MISS);
+        int node = perf_counter_open(PERF_COUNT_HW_CACHE_NODE, PERF_COUNT_HW_CACHE_OP_READ,
+                                     PERF_COUNT_HW_CACHE_RESULT_MISS);
+        for (int i = 0; i < 2; i++) {
+            int fd = i == 0 ? tlb : node;
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        bench_window_reads(&c, r->reps);
+        for (int i = 0; i < 2; i++) {
+            int fd = i == 0 ? tlb : node;
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+        double tlb_count = perf_counter_read(tlb);
+        double node_count = perf_counter_read(node);
+        r->tlb_misses = tlb_count >= 0.0 ? tlb_count / r->reps : -1.0;
+        r->node_misses = node_count >= 0.0 ? node_count / r->reps : -1.0;
+        if (tlb >= 0) close(tlb);
+        if (node >= 0) close(node);
+
+        LargeResidency residency;
+        large_alloc_residency(c.points, bytes, 4096, &residency);
+        r->huge_bytes = residency.huge_bytes;
+        r->local_pages = residency.local_pages;
+        r->remote_pages = residency.remote_pages;
+
+        char misses[2][32];
+        for (int i = 0; i < 2; i++) {
+            double value = i == 0 ? r->tlb_misses : r->node_misses;
+            if (value < 0.0) snprintf(misses[i], sizeof(misses[i]), "n/a");
+            else snprintf(misses[i], sizeof(misses[i]), "%.3g", value / c.windows);
+        }
+        printf("%-36s dTLB misses/window %s, remote loads/window %s, %.0f%% on hugepages, "
+               "sampled pages %ld local / %ld remote\n", "", misses[0], misses[1],
+               100.0 * (double)residency.huge_bytes / (double)bytes, residency.local_pages,
+               residency.remote_pages);
+    }
+
+    large_free(c.points);
+    return status;
+}
+
+static void write_json(FILE* out, const BenchConfig* config, const BenchResult* results, int count) {
+    fprintf(out, "{\n  \"kernels\": \"%s\",\n  \"timestamp\": %ld,\n  \"trials\": %d,\n  \"results\": [\n",
+            matrix_kernels()->name, (long)time(NULL), config->trials);
+    for (int i = 0; i < count; i++) {
+        const BenchResult* r = &results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"reps\": %ld, \"trials\": %d, \"median_ns\": %.3f, "
+                "\"p99_ns\": %.3f, \"min_ns\": %.3f, \"mean_ns\": %.3f, \"items_per_second\": %.3f",
+                r->name, r->reps, r->trials, r->median_ns, r->p99_ns, r->min_ns, r->mean_ns,
+                r->items > 0.0 ? r->items * 1e9 / r->median_ns : 0.0);
+        if (r->pages) {
+            // Counters that could not be read are null
+            fprintf(out, ", \"pages\": \"%s\", \"huge_bytes\": %zu, \"local_pages\": %ld, \"remote_pages\": %ld",
+                    r->pages, r->huge_bytes, r->local_pages, r->remote_pages);
+            if (r->tlb_misses >= 0.0) fprintf(out, ", \"dtlb_misses_per_call\": %.3f", r->tlb_misses);
+            else fprintf(out, ", \"dtlb_misses_per_call\": null");
+            if (r->node_misses >= 0.0) fprintf(out, ", \"node_misses_per_call\": %.3f", r->node_misses);
+            else fprintf(out, ", \"node_misses_per_call\": null");
+        }
+        fprintf(out, "}%s\n", i + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+void print_usage(const char* program_name) {
+    printf("Usage: %s [options]\n", program_name);
+    printf("Options:\n");
+    printf("  --trials <n>         Timed trials per case (default: 20)\n");
+    printf("  --warmup <n>         Untimed trials per case after calibration (default: 2)\n");
+    printf("  --min-trial-ms <ms>  Repeat each call until a trial takes this long (default: 10)\n");
+    printf("  --max-rows <n>       Largest CSV loaded, of 1k/100k/10M rows (default: 10000000)\n");
+    printf("  --filter <text>      Run only cases whose name contains text\n");
+    printf("  --dir <path>         Directory for generated files (default: /tmp)\n");
+    printf("  --placement-mb <n>   Dataset size of the hugepage/NUMA placement cases, 0 skips them (default: 256)\n");
+    printf("  --numa               Also run the placement cases with the dataset interleaved over NUMA nodes\n");
+    printf("  --json <file>        Also write results as JSON\n");
+    printf("  --help               Show this help message\n");
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config = {20, 2, 10.0, 10.0, 10000000, NULL, "/tmp", 256, 0, -1, -1};
+    const char* json_file = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trials") == 0 && i + 1 < argc) {
+            config.trials = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            config.warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--min-trial-ms") == 0 && i + 1 < argc) {
+            config.min_trial_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-rows") == 0 && i + 1 < argc) {
+            config.max_rows = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            config.filter = argv[++i];
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            config.dir = argv[++i];
+        } else if (strcmp(argv[i], "--placement-mb") == 0 && i + 1 < argc) {
+            config.placement_mb = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--numa") == 0) {
+            config.numa = 1;
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_file = argv[++i];
+        } else if (strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            printf("Unknown argument: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.trials <= 0 || config.warmup < 0 || config.min_trial_ms < 0.0 || config.placement_mb < 0) {
+        printf("Error: Invalid parameter values\n");
+        return 1;
+    }
+
+    printf("Weather LSTM Benchmarks\n");
+    printf("=======================\n");
+    printf("Matrix kernels: %s\n", matrix_kernels()->name);
+    printf("Trials: %d, warm-up: %d, min trial: %.1f ms\n\n", config.trials, config.warmup, config.min_trial_ms);
+    printf("%-36s %10s %7s %12s %12s %14s\n", "case", "reps", "trials", "median", "p99", "throughput");
+
+    // Fixed seed so every run benchmarks the same weights
+    srand(12345);
+    BenchResult results[32];
+    int count = 0;
+    int status = 0;
+    char name[64];
+
+    // Gate products of the default 6-feature, 64-unit model: W x, U h, and U H for a batch of 32
+    int I = 6, H = 64, G = LSTM_NUM_GATES * H, T = 10;
+    int shapes[][3] = {{G, I, 1}, {G, H, 1}, {G, H, 32}};
+    for (int s = 0; s < 3 && status == 0; s++) {
+        MultiplyCase c = {matrix_create(shapes[s][0], shapes[s][1]), matrix_create(shapes[s][1], shapes[s][2]),
+                          matrix_create(shapes[s][0], shapes[s][2])};
+        if (!c.a || !c.b || !c.dest) {
+            status = -1;
+        } else {
+            matrix_random(c.a, -1.0, 1.0);
+            matrix_random(c.b, -1.0, 1.0);
+            snprintf(name, sizeof(name), "matrix_multiply %dx%d*%dx%d", shapes[s][0], shapes[s][1],
+                     shapes[s][1], shapes[s][2]);
+            status |= bench_run(&config, name, 0.0, bench_matrix_multiply, &c, results, &count);
+            snprintf(name, sizeof(name), "matrix_multiply_into %dx%d*%dx%d", shapes[s][0], shapes[s][1],
+                     shapes[s][1], shapes[s][2]);
+            status |= bench_run(&config, name, 0.0, bench_matrix_multiply_into, &c, results, &count);
+        }
+        matrix_free(c.a);
+        matrix_free(c.b);
+        matrix_free(c.dest);
+    }
+
+    // Per-step and per-window inference at two hidden sizes; 50 has no fixed-shape kernel
+    int hidden_sizes[] = {64, 50};
+    for (int s = 0; s < 2 && status == 0; s++) {
+        NetworkCase c = {lstm_network_create(I, hidden_sizes[s], I), calloc((size_t)T, sizeof(Matrix*)), T,
+                         matrix_create(I, 1)};
+        int ok = c.network && c.sequence && c.output;
+        for (int t = 0; ok && t < T; t++) {
+            c.sequence[t] = matrix_create(I, 1);
+            ok = c.sequence[t] != NULL;
+            if (ok) matrix_random(c.sequence[t], 0.0, 1.0);
+        }
+        if (!ok) {
+            status = -1;
+        } else {
+            snprintf(name, sizeof(name), "lstm_cell_forward h%d", hidden_sizes[s]);
+            status |= bench_run(&config, name, 1.0, bench_cell_forward, &c, results, &count);
+            snprintf(name, sizeof(name), "lstm_network_predict h%d t%d", hidden_sizes[s], T);
+            status |= bench_run(&config, name, (double)T, bench_network_predict, &c, results, &count);
+            snprintf(name, sizeof(name), "lstm_network_predict_into h%d t%d", hidden_sizes[s], T);
+            status |= bench_run(&config, name, (double)T, bench_network_predict_into, &c, results, &count);
+        }
+        for (int t = 0; c.sequence && t < T; t++) {
+            matrix_free(c.sequence[t]);
+        }
+        free(c.sequence);
+        matrix_free(c.output);
+        lstm_network_free(c.network);
+    }
+
+    // Sliding windows over 100k rows
+    if (status == 0) {
+        DataCase c = {weather_dataset_create(100000), NULL, T, NULL};
+        for (long i = 0; c.dataset && i < 100000; i++) {
+            weather_dataset_add(c.dataset, bench_point(i));
+        }
+        if (!c.dataset || c.dataset->size != 100000) {
+            status = -1;
+        } else {
+            status |= bench_run(&config, "create_training_data 100k", 100000.0, bench_training_data, &c,
+                                results, &count);
+        }
+        weather_dataset_free(c.dataset);
+    }
+
+    // CSV parsing; files are generated once per size and removed afterwards
+    long row_counts[] = {1000, 100000, 10000000};
+    const char* row_names[] = {"1k", "100k", "10M"};
+    char path[512];
+    for (int s = 0; s < 3 && status == 0; s++) {
+        snprintf(name, sizeof(name), "weather_load_csv %s", row_names[s]);
+        if (row_counts[s] > config.max_rows || (config.filter && !strstr(name, config.filter))) continue;
+        snprintf(path, sizeof(path), "%s/weather_bench_%s.csv", config.dir, row_names[s]);
+        if (write_bench_csv(path, row_counts[s]) != 0) {
+            printf("Error: Could not write %s\n", path);
+            status = -1;
+            break;
+        }
+        DataCase c = {NULL, path, T, NULL};
+        config.quiet_fd = open("/dev/null", O_WRONLY);
+        config.stdout_fd = config.quiet_fd >= 0 ? dup(STDOUT_FILENO) : -1;
+        if (config.stdout_fd < 0 && config.quiet_fd >= 0) {
+            close(config.quiet_fd);
+            config.quiet_fd = -1;
+        }
+        status |= bench_run(&config, name, (double)row_counts[s], bench_load_csv, &c, results, &count);
+        if (config.quiet_fd >= 0) {
+            close(config.quiet_fd);
+            close(config.stdout_fd);
+            config.quiet_fd = -1;
+        }
+        remove(path);
+    }
+
+    // Model files of the default model
+    if (status == 0) {
+        snprintf(path, sizeof(path), "%s/weather_bench_model.bin", config.dir);
+        DataCase c = {NULL, path, T, lstm_network_create(I, H, I)};
+        if (!c.network) {
+            status = -1;
+        } else {
+            status |= bench_run(&config, "save_lstm_model h64", 0.0, bench_model_save, &c, results, &count);
+            if (save_lstm_model(c.network, path) != 0) {
+                status = -1;
+            } else {
+                status |= bench_run(&config, "load_lstm_model h64", 0.0, bench_model_load, &c, results, &count);
+            }
+        }
+        remove(path);
+        lstm_network_free(c.network);
+    }
+
+    // Random window reads from a large dataset under each page mode; with a
+    // single node the NUMA variant would repeat the thp case, so it needs --numa
+    for (int mode = 0; mode < LARGE_PAGES_NUM_MODES && config.placement_mb > 0 && status == 0; mode++) {
+        for (int numa = 0; numa <= config.numa && status == 0; numa++) {
+            snprintf(name, sizeof(name), "window_reads %ldMB %s%s", config.placement_mb,
+                     large_pages_name((LargePages)mode), numa ? " numa" : "");
+            status |= bench_placement(&config, name, (LargePages)mode, numa, results, &count);
+        }
+    }
+    if (config.placement_mb > 0 && large_alloc_nodes() == 1) {
+        printf("(1 NUMA node: every page is local, and remote loads stay at zero)\n");
+    }
+
+    if (json_file) {
+        FILE* out = fopen(json_file, "w");
+        if (!out) {
+            printf("Error: Could not create file %s\n", json_file);
+            return 1;
+        }
+        write_json(out, &config, results, count);
+        if (fclose(out) != 0) status = -1;
+        else printf("\nWrote %d results to %s\n", count, json_file);
+    }
+
+    return status == 0 ? 0 : 1;
+}
@@ -0,0 +1,590 @@
+#include "../include/bptt.h"
+#include "../include/optimizer.h"
+#include "../include/wavefront.h"
+#include "../include/profile.h"
+
+// Create gradient buffers shaped like the network parameters
+LSTMGradients* lstm_gradients_create(LSTMNetwork* network) {
+    if (!network) return NULL;
+
+    LSTMGradients* grads = calloc(1, sizeof(LSTMGradients));
+    if (!grads) return NULL;
+
+    grads->num_layers = network->num_layers;
+    int ok = 1;
+    for (int l = 0; l < network->num_layers; l++) {
+        LSTMCell* cell = network->layers[l];
+        grads->dW[l] = matrix_create(cell->W->rows, cell->W->cols);
+        grads->dU[l] = matrix_create(cell->U->rows, cell->U->cols);
+        grads->db[l] = matrix_create(cell->b->rows, 1);
+        ok = ok && grads->dW[l] && grads->dU[l] && grads->db[l];
+    }
+    grads->dW_output = matrix_create(network->output_size, network->hidden_size);
+    grads->db_output = matrix_create(network->output_size, 1);
+
+    if (!ok || !grads->dW_output || !grads->db_output) {
+        lstm_gradients_free(grads);
+        return NULL;
+    }
+
+    return grads;
+}
+
+// Free gradient buffers
+void lstm_gradients_free(LSTMGradients* grads) {
+    if (!grads) return;
+
+    for (int l = 0; l < grads->num_layers; l++) {
+        matrix_free(grads->dW[l]);
+        matrix_free(grads->dU[l]);
+        matrix_free(grads->db[l]);
+    }
+    matrix_free(grads->dW_output);
+    matrix_free(grads->db_output);
+    free(grads);
+}
+
+// Reset accumulated gradients
+void lstm_gradients_zero(LSTMGradients* grads) {
+    if (!grads) return;
+
+    for (int l = 0; l < grads->num_layers; l++) {
+        matrix_zero(grads->dW[l]);
+        matrix_zero(grads->dU[l]);
+        matrix_zero(grads->db[l]);
+    }
+    matrix_zero(grads->dW_output);
+    matrix_zero(grads->db_output);
+}
+
+// Sum src into dest, tensor by tensor
+void lstm_gradients_add(LSTMGradients* dest, LSTMGradients* src) {
+    if (!dest || !src || dest->num_layers != src->num_layers) return;
+
+    for (int l = 0; l < dest->num_layers; l++) {
+        matrix_add_into(dest->dW[l], dest->dW[l], src->dW[l]);
+        matrix_add_into(dest->dU[l], dest->dU[l], src->dU[l]);
+        matrix_add_into(dest->db[l], dest->db[l], src->db[l]);
+    }
+    matrix_add_into(dest->dW_output, dest->dW_output, src->dW_output);
+    matrix_add_into(dest->db_output, dest->db_output, src->db_output);
+}
+
+// param -= step * grad, row by row
+static void gradient_step(Matrix* param, Matrix* delta, double step) {
+    // One multiply-add per weight; reads weight and gradient, writes weight
+    PROFILE_WORK(PROFILE_UPDATE, 2.0 * param->rows * param->cols,
+                 3.0 * sizeof(double) * param->rows * param->cols);
+    for (int i = 0; i < param->rows; i++) {
+        double* w = MATRIX_ROW(param, i);
+        const double* d = MATRIX_ROW(delta, i);
+        for (int j = 0; j < param->cols; j++) {
+            w[j] -= step * d[j];
+        }
+    }
+}
+
+// Gradient descent step: param -= step * grad for every tensor
+void lstm_gradients_apply(LSTMNetwork* network, LSTMGradients* grads, double step) {
+    if (!network || !grads || grads->num_layers != network->num_layers) return;
+
+    PROFILE_BEGIN(PROFILE_UPDATE);
+    for (int l = 0; l < network->num_layers; l++) {
+        LSTMCell* cell = network->layers[l];
+        gradient_step(cell->W, grads->dW[l], step);
+        gradient_step(cell->U, grads->dU[l], step);
+        gradient_step(cell->b, grads->db[l], step);
+    }
+    gradient_step(network->W_output, grads->dW_output, step);
+    gradient_step(network->b_output, grads->db_output, step);
+    PROFILE_END(PROFILE_UPDATE);
+}
+
+// Create a tape with room for max_steps timesteps of batch_size columns
+LSTMTape* lstm_tape_create(LSTMCell* cell, int max_steps, int batch_size) {
+    if (!cell || max_steps <= 0 || batch_size <= 0) return NULL;
+
+    LSTMTape* tape = calloc(1, sizeof(LSTMTape));
+    if (!tape) return NULL;
+
+    int H = cell->hidden_size;
+    int G = LSTM_NUM_GATES * H;
+    int B = batch_size;
+    tape->max_steps = max_steps;
+    tape->batch_size = batch_size;
+
+    // gates and c_tanh per step, plus c and h for every step and the initial state
+    size_t per_step = ((size_t)G + (size_t)H) * (size_t)B;
+    size_t total = per_step * (size_t)max_steps + 2 * (size_t)H * (size_t)B * (size_t)(max_steps + 1);
+    tape->block = matrix_create((int)total, 1);
+    tape->x = calloc((size_t)max_steps, sizeof(Matrix*));
+    tape->gates = calloc((size_t)max_steps, sizeof(Matrix*));
+    tape->c_tanh = calloc((size_t)max_steps, sizeof(Matrix*));
+    tape->c = calloc((size_t)max_steps + 1, sizeof(Matrix*));
+    tape->h = calloc((size_t)max_steps + 1, sizeof(Matrix*));
+    if (!tape->block || !tape->x || !tape->gates || !tape->c_tanh || !tape->c || !tape->h) {
+        lstm_tape_free(tape);
+        return NULL;
+    }
+
+    double* next = tape->block->storage;
+    for (int t = 0; t < max_steps; t++) {
+        tape->gates[t] = matrix_wrap(next, G, B, B);
+        next += (size_t)G * B;
+        tape->c_tanh[t] = matrix_wrap(next, H, B, B);
+        next += (size_t)H * B;
+    }
+    for (int t = 0; t <= max_steps; t++) {
+        tape->c[t] = matrix_wrap(next, H, B, B);
+        next += (size_t)H * B;
+        tape->h[t] = matrix_wrap(next, H, B, B);
+        next += (size_t)H * B;
+    }
+
+    for (int t = 0; t < max_steps; t++) {
+        if (!tape->gates[t] || !tape->c_tanh[t] || !tape->c[t] || !tape->h[t]) {
+            lstm_tape_free(tape);
+            return NULL;
+        }
+    }
+    if (!tape->c[max_steps] || !tape->h[max_steps]) {
+        lstm_tape_free(tape);
+        return NULL;
+    }
+
+    return tape;
+}
+
+// Free tape
+void lstm_tape_free(LSTMTape* tape) {
+    if (!tape) return;
+
+    for (int t = 0; t < tape->max_steps; t++) {
+        if (tape->gates) matrix_free(tape->gates[t]);
+        if (tape->c_tanh) matrix_free(tape->c_tanh[t]);
+    }
+    for (int t = 0; t <= tape->max_steps; t++) {
+        if (tape->c) matrix_free(tape->c[t]);
+        if (tape->h) matrix_free(tape->h[t]);
+    }
+
+    free(tape->x);
+    free(tape->gates);
+    free(tape->c_tanh);
+    free(tape->c);
+    free(tape->h);
+    matrix_free(tape->block);
+    free(tape);
+}
+
+// Arena bytes for every trainer matrix created below
+static size_t bptt_workspace_bytes(LSTMNetwork* network, int max_steps, int B) {
+    int I = network->input_size;
+    int H = network->hidden_size;
+    int O = network->output_size;
+    size_t bytes = 3 * arena_matrix_bytes(O, B) + (size_t)max_steps * arena_matrix_bytes(I, B);
+    for (int l = 0; l < network->num_layers; l++) {
+        bytes += 2 * arena_matrix_bytes(H, B) + arena_matrix_bytes(LSTM_NUM_GATES * H, B) +
+                 arena_matrix_bytes(B, l == 0 ? I : H) + 2 * arena_matrix_bytes(B, H) +
+                 arena_matrix_bytes(B, LSTM_NUM_GATES * H);
+    }
+    if (network->num_layers > 1) {
+        bytes += (size_t)max_steps * arena_matrix_bytes(H, B);
+    }
+    if (B == 1) {
+        bytes += arena_view_bytes(O) + (size_t)max_steps * arena_view_bytes(I);
+    }
+    return bytes;
+}
+
+// Create a BPTT trainer for batches of up to batch_size sequences of up to
+// max_steps each. Its staging and backward scratch share one arena, so every
+// worker's workspace is a single block.
+BPTTTrainer* bptt_trainer_create(LSTMNetwork* network, int max_steps, int batch_size) {
+    if (!network || max_steps <= 0 || batch_size <= 0) return NULL;
+
+    BPTTTrainer* trainer = calloc(1, sizeof(BPTTTrainer));
+    if (!trainer) return NULL;
+
+    int H = network->hidden_size;
+    int B = batch_size;
+    int L = network->num_layers;
+    trainer->batch_size = batch_size;
+    trainer->columns = batch_size;
+    trainer->num_layers = L;
+    trainer->arena = arena_create(bptt_workspace_bytes(network, max_steps, B));
+    if (!trainer->arena) {
+        free(trainer);
+        return NULL;
+    }
+    
+    Arena* arena = trainer->arena;
+    int ok = 1;
+    for (int l = 0; l < L; l++) {
+        int in = l == 0 ? network->input_size : H;
+        trainer->tapes[l] = lstm_tape_create(network->layers[l], max_steps, batch_size);
+        trainer->d_hidden[l] = matrix_create_in(arena, H, B);
+        trainer->d_cell[l] = matrix_create_in(arena, H, B);
+        trainer->d_gates[l] = matrix_create_in(arena, LSTM_NUM_GATES * H, B);
+        trainer->x_t[l] = matrix_create_in(arena, B, in);
+        trainer->h_t[l] = matrix_create_in(arena, B, H);
+        trainer->d_gates_t[l] = matrix_create_in(arena, B, LSTM_NUM_GATES * H);
+        trainer->d_hidden_t[l] = matrix_create_in(arena, B, H);
+        ok = ok && trainer->tapes[l] && trainer->d_hidden[l] && trainer->d_cell[l] && trainer->d_gates[l] &&
+             trainer->x_t[l] && trainer->h_t[l] && trainer->d_gates_t[l] && trainer->d_hidden_t[l];
+    }
+    trainer->grads = lstm_gradients_create(network);
+    trainer->batch_inputs = calloc((size_t)max_steps, sizeof(Matrix*));
+    trainer->batch_targets = matrix_create_in(arena, network->output_size, B);
+    trainer->output = matrix_create_in(arena, network->output_size, B);
+    trainer->d_output = matrix_create_in(arena, network->output_size, B);
+
+    if (!ok || !trainer->grads || !trainer->batch_inputs || !trainer->batch_targets ||
+        !trainer->output || !trainer->d_output) {
+        bptt_trainer_free(trainer);
+        return NULL;
+    }
+
+    for (int t = 0; t < max_steps; t++) {
+        trainer->batch_inputs[t] = matrix_create_in(arena, network->input_size, B);
+        if (!trainer->batch_inputs[t]) {
+            bptt_trainer_free(trainer);
+            return NULL;
+        }
+    }
+    trainer->inputs = trainer->batch_inputs;
+    trainer->targets = trainer->batch_targets;
+
+    // Stacked layers hand input gradients down one step at a time
+    if (L > 1) {
+        trainer->d_inputs = calloc((size_t)max_steps, sizeof(Matrix*));
+        for (int t = 0; trainer->d_inputs && t < max_steps; t++) {
+            trainer->d_inputs[t] = matrix_create_in(arena, H, B);
+            if (!trainer->d_inputs[t]) {
+                bptt_trainer_free(trainer);
+                return NULL;
+            }
+        }
+        if (!trainer->d_inputs) {
+            bptt_trainer_free(trainer);
+            return NULL;
+        }
+    }
+
+    // Single sequences are read in place: the views are rebound per sample
+    if (B == 1) {
+        trainer->window = calloc((size_t)max_steps, sizeof(Matrix*));
+        trainer->window_target = matrix_wrap_in(arena, trainer->batch_targets->storage,
+                                                network->output_size, 1, 1);
+        if (!trainer->window || !trainer->window_target) {
+            bptt_trainer_free(trainer);
+            return NULL;
+        }
+        for (int t = 0; t < max_steps; t++) {
+            trainer->window[t] = matrix_wrap_in(arena, trainer->batch_inputs[t]->storage,
+                                                network->input_size, 1, 1);
+            if (!trainer->window[t]) {
+                bptt_trainer_free(trainer);
+                return NULL;
+            }
+        }
+    }
+
+    return trainer;
+}
+
+// Free BPTT trainer. Arena matrices are no-ops for matrix_free; the calls
+// release any that fell back to the heap.
+void bptt_trainer_free(BPTTTrainer* trainer) {
+    if (!trainer) return;
+
+    int max_steps = trainer->tapes[0] ? trainer->tapes[0]->max_steps : 0;
+    for (int t = 0; t < max_steps; t++) {
+        if (trainer->batch_inputs) matrix_free(trainer->batch_inputs[t]);
+        if (trainer->window) matrix_free(trainer->window[t]);
+        if (trainer->d_inputs) matrix_free(trainer->d_inputs[t]);
+    }
+    free(trainer->batch_inputs);
+    free(trainer->window);
+    free(trainer->d_inputs);
+    matrix_free(trainer->window_target);
+    matrix_free(trainer->batch_targets);
+    for (int l = 0; l < trainer->num_layers; l++) {
+        lstm_tape_free(trainer->tapes[l]);
+        matrix_free(trainer->d_hidden[l]);
+        matrix_free(trainer->d_cell[l]);
+        matrix_free(trainer->d_gates[l]);
+        matrix_free(trainer->x_t[l]);
+        matrix_free(trainer->h_t[l]);
+        matrix_free(trainer->d_gates_t[l]);
+        matrix_free(trainer->d_hidden_t[l]);
+    }
+    lstm_gradients_free(trainer->grads);
+    matrix_free(trainer->output);
+    matrix_free(trainer->d_output);
+    arena_free(trainer->arena);
+    free(trainer);
+}
+
+// Select count samples starting at first as the current batch. A single
+// sequence is read in place through the window views. Larger batches are
+// gathered one sample per column into the staging buffers; unused columns
+// repeat the last sample so every column stays finite, and bptt_backward
+// gives them zero weight.
+int bptt_load_batch(BPTTTrainer* trainer, TrainingData* data, int first, int count) {
+    if (!trainer || !data || first < 0 || count <= 0 || count > trainer->batch_size ||
+        first + count > data->num_sequences || data->sequence_length > trainer->tapes[0]->max_steps ||
+        data->feature_size < trainer->batch_inputs[0]->rows ||
+        data->feature_size < trainer->batch_targets->rows) {
+        return -1;
+    }
+
+    trainer->columns = count;
+
+    if (trainer->window) {
+        for (int t = 0; t < data->sequence_length; t++) {
+            matrix_rebind(trainer->window[t], training_data_input(data, first, t));
+        }
+        matrix_rebind(trainer->window_target, training_data_target(data, first));
+        trainer->inputs = trainer->window;
+        trainer->targets = trainer->window_target;
+        return 0;
+    }
+
+    int B = trainer->batch_size;
+    for (int k = 0; k < B; k++) {
+        int seq = first + (k < count ? k : count - 1);
+        for (int t = 0; t < data->sequence_length; t++) {
+            const double* src = training_data_input(data, seq, t);
+            Matrix* dst = trainer->batch_inputs[t];
+            for (int i = 0; i < dst->rows; i++) {
+                MATRIX_AT(dst, i, k) = src[i];
+            }
+        }
+        const double* target = training_data_target(data, seq);
+        for (int i = 0; i < trainer->batch_targets->rows; i++) {
+            MATRIX_AT(trainer->batch_targets, i, k) = target[i];
+        }
+    }
+    trainer->inputs = trainer->batch_inputs;
+    trainer->targets = trainer->batch_targets;
+
+    return 0;
+}
+
+// State shared by the per-layer steps of one forward or backward pass
+typedef struct {
+    BPTTTrainer* trainer;
+    LSTMNetwork* network;
+    Matrix** sequence;
+    int first;          // Backward: earliest unrolled step
+} BPTTPass;
+
+// Forward step t of layer l: layer 0 reads the sequence, every layer above
+// reads the hidden states the layer below recorded
+static int bptt_forward_step(void* arg, int l, int t) {
+    BPTTPass* pass = arg;
+    LSTMTape* tape = pass->trainer->tapes[l];
+    Matrix* x = l == 0 ? pass->sequence[t] : pass->trainer->tapes[l - 1]->h[t + 1];
+
+    tape->x[t] = x;
+    return lstm_cell_step_state(pass->network->layers[l], x, tape->h[t], tape->c[t],
+                                tape->gates[t], tape->c[t + 1], tape->c_tanh[t], tape->h[t + 1]);
+}
+
+// Forward pass from a zero state, recording every step on the tapes. Each
+// sequence[t] holds one input column per batch entry. The prediction is left
+// in trainer->output; the cells' own state is not touched.
+int bptt_forward(BPTTTrainer* trainer, LSTMNetwork* network, Matrix** sequence, int steps) {
+    if (!trainer || !network || !sequence || steps <= 0 || steps > trainer->tapes[0]->max_steps ||
+        network->num_layers != trainer->num_layers) {
+        return -1;
+    }
+
+    int L = network->num_layers;
+    for (int l = 0; l < L; l++) {
+        matrix_zero(trainer->tapes[l]->c[0]);
+        matrix_zero(trainer->tapes[l]->h[0]);
+    }
+
+    BPTTPass pass = {trainer, network, sequence, 0};
+    if (wavefront_run(trainer->pool, L, steps, 0, bptt_forward_step, &pass) != 0) return -1;
+    for (int l = 0; l < L; l++) {
+        trainer->tapes[l]->steps = steps;
+    }
+
+    return gemm_add_bias_into(trainer->output, network->W_output, trainer->tapes[L - 1]->h[steps],
+                              network->b_output);
+}
+
+// dest += a * b^T. Single columns use the outer-product kernel; batches stage
+// b^T in scratch so the product is one GEMM with a contiguous inner dimension.
+static int bptt_accumulate_outer(Matrix* dest, Matrix* a, Matrix* b, Matrix* b_t) {
+    if (a->cols == 1) {
+        return matrix_outer_accumulate(dest, a, b, 1.0);
+    }
+    if (matrix_transpose_into(b_t, b) != 0) return -1;
+    return gemm_accumulate_into(dest, a, b_t);
+}
+
+// dest = W^T * d. Batches compute (d^T W)^T so the GEMM streams rows of W.
+static int bptt_backprop_into(Matrix* dest, Matrix* W, Matrix* d, Matrix* d_t, Matrix* dest_t) {
+    if (d->cols == 1) {
+        return matrix_multiply_at_into(dest, W, d);
+    }
+    if (matrix_transpose_into(d_t, d) != 0 || matrix_multiply_into(dest_t, d_t, W) != 0) return -1;
+    return matrix_transpose_into(dest, dest_t);
+}
+
+// Backward step t of layer l. dL/dh_t arrives from step t + 1 of the same
+// layer and, below the top, from the input gradient the layer above left in
+// d_inputs[t]; this layer then leaves its own input gradient there.
+static int bptt_backward_step(void* arg, int l, int j) {
+    BPTTPass* pass = arg;
+    BPTTTrainer* trainer = pass->trainer;
+    LSTMCell* cell = pass->network->layers[l];
+    LSTMTape* tape = trainer->tapes[l];
+    LSTMGradients* grads = trainer->grads;
+    int t = pass->first + j;
+    int n = cell->hidden_size * trainer->batch_size;
+    double* dh = trainer->d_hidden[l]->storage;
+    double* dc = trainer->d_cell[l]->storage;
+    double* da = trainer->d_gates[l]->storage;
+
+    if (l + 1 < trainer->num_layers) {
+        const double* from_above = trainer->d_inputs[t]->storage;
+        for (int i = 0; i < n; i++) {
+            dh[i] += from_above[i];
+        }
+    }
+
+    // Each gate is a dense [H x B] block, so the batch is one flat loop
+    const double* gt = tape->gates[t]->storage;
+    const double* f = gt + (size_t)LSTM_GATE_FORGET * n;
+    const double* in = gt + (size_t)LSTM_GATE_INPUT * n;
+    const double* g = gt + (size_t)LSTM_GATE_CANDIDATE * n;
+    const double* o = gt + (size_t)LSTM_GATE_OUTPUT * n;
+    const double* c_prev = tape->c[t]->storage;
+    const double* tc = tape->c_tanh[t]->storage;
+
+    double* da_f = da + (size_t)LSTM_GATE_FORGET * n;
+    double* da_i = da + (size_t)LSTM_GATE_INPUT * n;
+    double* da_g = da + (size_t)LSTM_GATE_CANDIDATE * n;
+    double* da_o = da + (size_t)LSTM_GATE_OUTPUT * n;
+
+    // Gate pre-activation gradients; dc carries dL/dc_t into dL/dc_{t-1}
+    for (int i = 0; i < n; i++) {
+        double dci = dc[i] + dh[i] * o[i] * (1.0 - tc[i] * tc[i]);
+        da_o[i] = dh[i] * tc[i] * o[i] * (1.0 - o[i]);
+        da_f[i] = dci * c_prev[i] * f[i] * (1.0 - f[i]);
+        da_i[i] = dci * g[i] * in[i] * (1.0 - in[i]);
+        da_g[i] = dci * in[i] * (1.0 - g[i] * g[i]);
+        dc[i] = dci * f[i];
+    }
+
+    // Parameter gradients summed over the batch, dL/dh_{t-1} = U^T da and,
+    // for the layer below, dL/dx_t = W^T da
+    int status = bptt_accumulate_outer(grads->dW[l], trainer->d_gates[l], tape->x[t], trainer->x_t[l]) |
+                 bptt_accumulate_outer(grads->dU[l], trainer->d_gates[l], tape->h[t], trainer->h_t[l]) |
+                 matrix_accumulate_row_sums(grads->db[l], trainer->d_gates[l]);
+    if (t > pass->first) {
+        status |= bptt_backprop_into(trainer->d_hidden[l], cell->U, trainer->d_gates[l],
+                                     trainer->d_gates_t[l], trainer->d_hidden_t[l]);
+    }
+    if (l > 0) {
+        status |= bptt_backprop_into(trainer->d_inputs[t], cell->W, trainer->d_gates[l],
+                                     trainer->d_gates_t[l], trainer->d_hidden_t[l]);
+    }
+
+    // Gradient GEMMs at 2 FLOPs per weight and column, plus the gate loop;
+    // bytes count the weights and gradients each GEMM touches
+    int I = cell->input_size, H = cell->hidden_size, G = LSTM_NUM_GATES * H;
+    double weights = (double)G * (I + H) + (t > pass->first ? (double)G * H : 0.0) +
+                     (l > 0 ? (double)G * I : 0.0);
+    PROFILE_WORK(PROFILE_BACKWARD, 2.0 * weights * trainer->batch_size + 20.0 * n,
+                 sizeof(double) * (2.0 * weights + 12.0 * n));
+    (void)weights;
+    return status != 0 ? -1 : 0;
+}
+
+// Backward pass for the last forward pass against target [O x B], with MSE
+// loss on the final output. Gradients are accumulated into trainer->grads, so
+// several batches can be summed before one update. Only the first
+// trainer->columns columns contribute; padding columns get zero gradient.
+// Only the last window steps are unrolled (window <= 0 unrolls the whole
+// sequence), in every layer. Returns the loss summed over the live columns.
+double bptt_backward(BPTTTrainer* trainer, LSTMNetwork* network, Matrix* target, int window) {
+    if (!trainer || !network || !target || network->num_layers != trainer->num_layers) return -1.0;
+
+    int L = network->num_layers;
+    LSTMTape* top = trainer->tapes[L - 1];
+    LSTMGradients* grads = trainer->grads;
+    int T = top->steps;
+    int O = network->output_size;
+    int B = trainer->batch_size;
+
+    if (target->rows != O || target->cols != B) return -1.0;
+
+    // Output layer: y = W_out h_T + b_out, dL/dy = 2 (y - target) / O per column
+    PROFILE_BEGIN(PROFILE_BACKWARD);
+    double loss = 0.0;
+    for (int k = 0; k < O; k++) {
+        double* dy = MATRIX_ROW(trainer->d_output, k);
+        const double* y = MATRIX_ROW(trainer->output, k);
+        const double* tk = MATRIX_ROW(target, k);
+        for (int col = 0; col < B; col++) {
+            if (col < trainer->columns) {
+                double diff = y[col] - tk[col];
+                loss += diff * diff;
+                dy[col] = 2.0 * diff / O;
+            } else {
+                dy[col] = 0.0;
+            }
+        }
+    }
+    loss /= O;
+
+    matrix_outer_accumulate(grads->dW_output, trainer->d_output, top->h[T], 1.0);
+    matrix_accumulate_row_sums(grads->db_output, trainer->d_output);
+    matrix_multiply_at_into(trainer->d_hidden[L - 1], network->W_output, trainer->d_output);
+    for (int l = 0; l < L; l++) {
+        matrix_zero(trainer->d_cell[l]);
+        if (l < L - 1) matrix_zero(trainer->d_hidden[l]);
+    }
+
+    int first = (window > 0 && window < T) ? T - window : 0;
+    BPTTPass pass = {trainer, network, NULL, first};
+    if (wavefront_run(trainer->pool, L, T - first, 1, bptt_backward_step, &pass) != 0) return -1.0;
+    PROFILE_END(PROFILE_BACKWARD);
+
+    return loss;
+}
+
+double bptt_train_epoch(BPTTTrainer* trainer, LSTMNetwork* network, TrainingData* data) {
+    if (!trainer || !network || !data) return 0.0;
+
+    // One update per batch, averaging the summed gradient over its sequences
+    double total_loss = 0.0;
+    for (int first = 0; first < data->num_sequences; first += trainer->batch_size) {
+        int count = data->num_sequences - first;
+        if (count > trainer->batch_size) count = trainer->batch_size;
+
+        if (bptt_load_batch(trainer, data, first, count) != 0 ||
+            bptt_forward(trainer, network, trainer->inputs, data->sequence_length) != 0) {
+            continue;
+        }
+
+        lstm_gradients_zero(trainer->grads);
+        double loss = bptt_backward(trainer, network, trainer->targets, network->bptt_window);
+        if (loss < 0.0) continue;
+        total_loss += loss;
+
+        if (network->optimizer) {
+            optimizer_step(network->optimizer, network, trainer->grads, 1.0 / count);
+        } else {
+            lstm_gradients_apply(network, trainer->grads, network->learning_rate / count);
+        }
+    }
+
+    return total_loss;
+}
@@ -0,0 +1,338 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "../include/checkpoint.h"
+#include "../include/profile.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+
+// One snapshot buffer: a private network holding copies of the weights,
+// and the training state section as it will be written
+typedef struct {
+    LSTMNetwork* network;
+    NormalizationParams norm_params;
+    unsigned char* section;     // CheckpointHeader, then the state values
+    size_t section_size;
+} CheckpointSnapshot;
+
+struct Checkpointer {
+    char* path;
+    int every_epochs;
+    double every_seconds;
+    double last_seconds;        // When the last snapshot was taken
+    size_t state_values;        // slots x size of the optimizer
+
+    CheckpointSnapshot snapshots[2];
+    int ready;                  // Snapshot waiting for the writer, or -1
+    int writing;                // Snapshot the writer holds, or -1
+    int shutdown;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;        // Signals a ready snapshot (or shutdown)
+    pthread_cond_t idle;        // Signals that a write finished
+    CheckpointStats stats;
+};
+
+static double* checkpoint_values(unsigned char* section) {
+    return (double*)(section + sizeof(CheckpointHeader));
+}
+
+// The weight tensors of a network, in the same order for every shape
+static int checkpoint_tensors(LSTMNetwork* network, Matrix** tensors) {
+    int count = 0;
+    for (int l = 0; l < network->num_layers; l++) {
+        tensors[count++] = network->layers[l]->W;
+        tensors[count++] = network->layers[l]->U;
+        tensors[count++] = network->layers[l]->b;
+    }
+    tensors[count++] = network->W_output;
+    tensors[count++] = network->b_output;
+    return count;
+}
+
+static void checkpoint_snapshot_free(CheckpointSnapshot* snapshot) {
+    if (snapshot->network) {
+        snapshot->network->norm_params = NULL;  // Points into the snapshot
+        lstm_network_free(snapshot->network);
+    }
+    free(snapshot->section);
+}
+
+// Runs on the writer thread: take the ready snapshot, write it, repeat
+static void* checkpoint_writer(void* arg) {
+    Checkpointer* checkpointer = arg;
+
+    pthread_mutex_lock(&checkpointer->lock);
+    for (;;) {
+        while (checkpointer->ready < 0 && !checkpointer->shutdown) {
+            pthread_cond_wait(&checkpointer->wake, &checkpointer->lock);
+        }
+        if (checkpointer->ready < 0) break;
+
+        int slot = checkpointer->ready;
+        checkpointer->ready = -1;
+        checkpointer->writing = slot;
+        pthread_mutex_unlock(&checkpointer->lock);
+
+        // The trainer never touches the slot being written, so no lock is held
+        CheckpointSnapshot* snapshot = &checkpointer->snapshots[slot];
+        CheckpointHeader* header = (CheckpointHeader*)snapshot->section;
+        double start = profile_seconds();
+        header->checksum = lstm_model_checksum(checkpoint_values(snapshot->section),
+                                               checkpointer->state_values * sizeof(double));
+        int status = save_lstm_model_extra(snapshot->network, checkpointer->path, snapshot->section,
+                                           snapshot->section_size);
+        double seconds = profile_seconds() - start;
+
+        pthread_mutex_lock(&checkpointer->lock);
+        checkpointer->writing = -1;
+        checkpointer->stats.write_seconds += seconds;
+        if (status == 0) {
+            checkpointer->stats.written++;
+        } else {
+            checkpointer->stats.failures++;
+        }
+        pthread_cond_broadcast(&checkpointer->idle);
+    }
+    pthread_mutex_unlock(&checkpointer->lock);
+
+    return NULL;
+}
+
+Checkpointer* checkpointer_create(LSTMNetwork* network, const Optimizer* optimizer, const char* path,
+                                  int every_epochs, double every_seconds) {
+    if (!network || !path || every_epochs < 0 || every_seconds < 0.0) return NULL;
+
+    Checkpointer* checkpointer = calloc(1, sizeof(Checkpointer));
+    if (!checkpointer) return NULL;
+
+    checkpointer->every_epochs = every_epochs;
+    checkpointer->every_seconds = every_seconds;
+    checkpointer->last_seconds = profile_seconds();
+    checkpointer->ready = -1;
+    checkpointer->writing = -1;
+    checkpointer->state_values = optimizer ? (size_t)optimizer->slots * optimizer->size : 0;
+
+    size_t length = strlen(path);
+    checkpointer->path = malloc(length + 1);
+    int ok = checkpointer->path != NULL;
+    if (ok) memcpy(checkpointer->path, path, length + 1);
+
+    for (int s = 0; ok && s < 2; s++) {
+        CheckpointSnapshot* snapshot = &checkpointer->snapshots[s];
+        snapshot->network = lstm_network_create_stacked(network->input_size, network->hidden_size,
+                                                        network->output_size, network->num_layers);
+        snapshot->section_size = sizeof(CheckpointHeader) + checkpointer->state_values * sizeof(double);
+        snapshot->section = calloc(1, snapshot->section_size);
+        ok = snapshot->network && snapshot->section;
+    }
+
+    if (ok && pthread_mutex_init(&checkpointer->lock, NULL) != 0) ok = 0;
+    if (ok && pthread_cond_init(&checkpointer->wake, NULL) != 0) {
+        pthread_mutex_destroy(&checkpointer->lock);
+        ok = 0;
+    }
+    if (ok && pthread_cond_init(&checkpointer->idle, NULL) != 0) {
+        pthread_cond_destroy(&checkpointer->wake);
+        pthread_mutex_destroy(&checkpointer->lock);
+        ok = 0;
+    }
+    if (ok && pthread_create(&checkpointer->thread, NULL, checkpoint_writer, checkpointer) != 0) {
+        pthread_cond_destroy(&checkpointer->idle);
+        pthread_cond_destroy(&checkpointer->wake);
+        pthread_mutex_destroy(&checkpointer->lock);
+        ok = 0;
+    }
+
+    if (!ok) {
+        for (int s = 0; s < 2; s++) checkpoint_snapshot_free(&checkpointer->snapshots[s]);
+        free(checkpointer->path);
+        free(checkpointer);
+        return NULL;
+    }
+
+    return checkpointer;
+}
+
+void checkpointer_free(Checkpointer* checkpointer) {
+    if (!checkpointer) return;
+
+    checkpointer_flush(checkpointer);
+    pthread_mutex_lock(&checkpointer->lock);
+    checkpointer->shutdown = 1;
+    pthread_cond_signal(&checkpointer->wake);
+    pthread_mutex_unlock(&checkpointer->lock);
+    pthread_join(checkpointer->thread, NULL);
+
+    pthread_cond_destroy(&checkpointer->idle);
+    pthread_cond_destroy(&checkpointer->wake);
+    pthread_mutex_destroy(&checkpointer->lock);
+    for (int s = 0; s < 2; s++) checkpoint_snapshot_free(&checkpointer->snapshots[s]);
+    free(checkpointer->path);
+    free(checkpointer);
+}
+
+int checkpointer_save(Checkpointer* checkpointer, LSTMNetwork* network, const Optimizer* optimizer, int epoch) {
+    if (!checkpointer || !network) return -1;
+
+    size_t values = optimizer ? (size_t)optimizer->slots * optimizer->size : 0;
+    CheckpointSnapshot* first = &checkpointer->snapshots[0];
+    if (values != checkpointer->state_values || network->num_layers != first->network->num_layers ||
+        network->input_size != first->network->input_size || network->hidden_size != first->network->hidden_size ||
+        network->output_size != first->network->output_size) {
+        return -1;
+    }
+
+    // Fill whichever buffer the writer is not holding. A snapshot still
+    // waiting there is taken back and replaced by this newer one.
+    pthread_mutex_lock(&checkpointer->lock);
+    int slot = checkpointer->writing == 0 ? 1 : 0;
+    if (checkpointer->ready == slot) {
+        checkpointer->ready = -1;
+        checkpointer->stats.replaced++;
+    }
+    pthread_mutex_unlock(&checkpointer->lock);
+
+    double start = profile_seconds();
+    CheckpointSnapshot* snapshot = &checkpointer->snapshots[slot];
+    Matrix* src[OPTIMIZER_MAX_TENSORS];
+    Matrix* dst[OPTIMIZER_MAX_TENSORS];
+    int count = checkpoint_tensors(network, src);
+    checkpoint_tensors(snapshot->network, dst);
+    for (int t = 0; t < count; t++) {
+        matrix_copy(dst[t], src[t]);
+    }
+    snapshot->network->learning_rate = network->learning_rate;
+    snapshot->network->sequence_length = network->sequence_length;
+    snapshot->network->norm_params = NULL;
+    if (network->norm_params) {
+        snapshot->norm_params = *network->norm_params;
+        snapshot->network->norm_params = &snapshot->norm_params;
+    }
+
+    CheckpointHeader* header = (CheckpointHeader*)snapshot->section;
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic));
+    header->version = CHECKPOINT_VERSION;
+    header->optimizer_type = optimizer ? (uint32_t)optimizer->config.type : (uint32_t)OPTIMIZER_SGD;
+    header->epoch = epoch;
+    header->slots = optimizer ? (uint32_t)optimizer->slots : 0;
+    header->steps = optimizer ? optimizer->steps : 0;
+    header->state_size = optimizer ? optimizer->size : 0;
+    if (values > 0) {
+        memcpy(checkpoint_values(snapshot->section), optimizer->state->storage, values * sizeof(double));
+    }
+    double now = profile_seconds();
+
+    pthread_mutex_lock(&checkpointer->lock);
+    if (checkpointer->ready >= 0) checkpointer->stats.replaced++;  // The writer never got to it
+    checkpointer->ready = slot;
+    checkpointer->last_seconds = now;
+    checkpointer->stats.taken++;
+    checkpointer->stats.snapshot_seconds += now - start;
+    pthread_cond_signal(&checkpointer->wake);
+    pthread_mutex_unlock(&checkpointer->lock);
+
+    return 0;
+}
+
+int checkpointer_epoch(Checkpointer* checkpointer, LSTMNetwork* network, const Optimizer* optimizer, int epoch) {
+    if (!checkpointer) return -1;
+
+    int due = (checkpointer->every_epochs > 0 && epoch % checkpointer->every_epochs == 0) ||
+              (checkpointer->every_seconds > 0.0 &&
+               profile_seconds() - checkpointer->last_seconds >= checkpointer->every_seconds);
+    if (!due) return 0;
+    return checkpointer_save(checkpointer, network, optimizer, epoch) == 0 ? 1 : -1;
+}
+
+int checkpointer_flush(Checkpointer* checkpointer) {
+    if (!checkpointer) return -1;
+
+    pthread_mutex_lock(&checkpointer->lock);
+    while (checkpointer->ready >= 0 || checkpointer->writing >= 0) {
+        pthread_cond_wait(&checkpointer->idle, &checkpointer->lock);
+    }
+    int status = checkpointer->stats.failures > 0 ? -1 : 0;
+    pthread_mutex_unlock(&checkpointer->lock);
+
+    return status;
+}
+
+void checkpointer_stats(Checkpointer* checkpointer, CheckpointStats* stats) {
+    if (!checkpointer || !stats) return;
+
+    pthread_mutex_lock(&checkpointer->lock);
+    *stats = checkpointer->stats;
+    pthread_mutex_unlock(&checkpointer->lock);
+}
+
+// Leaves file positioned at the state values of a checkpoint
+static int checkpoint_read_headers(FILE* file, CheckpointInfo* info) {
+    memset(info, 0, sizeof(*info));
+    if (fread(&info->model, sizeof(info->model), 1, file) != 1 ||
+        memcmp(info->model.magic, LSTM_MODEL_MAGIC, sizeof(info->model.magic)) != 0) {
+        return 0;
+    }
+
+    uint64_t offset = lstm_model_extra_offset(&info->model);
+    if (offset > (uint64_t)LONG_MAX || fseek(file, (long)offset, SEEK_SET) != 0 ||
+        fread(&info->state, sizeof(info->state), 1, file) != 1 ||
+        memcmp(info->state.magic, CHECKPOINT_MAGIC, sizeof(info->state.magic)) != 0) {
+        return 0;
+    }
+    if (info->state.version != CHECKPOINT_VERSION) {
+        printf("Error: Unsupported checkpoint version %u\n", info->state.version);
+        return -1;
+    }
+    return 1;
+}
+
+int checkpoint_read_info(const char* path, CheckpointInfo* info) {
+    if (!path || !info) return -1;
+
+    FILE* file = fopen(path, "rb");
+    if (!file) return -1;
+    int status = checkpoint_read_headers(file, info);
+    fclose(file);
+    return status;
+}
+
+int checkpoint_restore(const char* path, Optimizer* optimizer, int* epoch) {
+    if (!path || !optimizer || !epoch) return -1;
+
+    FILE* file = fopen(path, "rb");
+    if (!file) return -1;
+
+    CheckpointInfo info;
+    if (checkpoint_read_headers(file, &info) != 1) {
+        fclose(file);
+        return -1;
+    }
+    const CheckpointHeader* header = &info.state;
+    if (header->optimizer_type != (uint32_t)optimizer->config.type || header->slots != (uint32_t)optimizer->slots ||
+        header->state_size != optimizer->size || header->steps < 0 || header->epoch < 0) {
+        printf("Error: Checkpoint %s holds %s state that does not fit this optimizer and network\n", path,
+               optimizer_name((OptimizerType)header->optimizer_type));
+        fclose(file);
+        return -1;
+    }
+
+    size_t values = (size_t)optimizer->slots * optimizer->size;
+    int ok = values == 0 || fread(optimizer->state->storage, sizeof(double), values, file) == values;
+    fclose(file);
+    if (!ok || (values > 0 && lstm_model_checksum(optimizer->state->storage, values * sizeof(double)) !=
+                              header->checksum)) {
+        printf("Error: Checkpoint %s failed its checksum\n", path);
+        optimizer_reset(optimizer);
+        return -1;
+    }
+
+    optimizer->steps = header->steps;
+    optimizer->last_norm = 0.0;
+    *epoch = header->epoch;
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include "../include/weather_data.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void print_usage(const char* program_name) {
+    printf("Usage: %s --input <csv_file> --output <dataset_file> [options]\n", program_name);
+    printf("Options:\n");
+    printf("  --input <file>       Weather data CSV file to convert\n");
+    printf("  --output <file>      Binary dataset file to write\n");
+    printf("  --normalize          Store normalized rows (training only; predict needs raw rows)\n");
+    printf("  --help               Show this help message\n");
+}
+
+int main(int argc, char* argv[]) {
+    char* input_file = NULL;
+    char* output_file = NULL;
+    int normalize = 0;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            input_file = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output_file = argv[++i];
+        } else if (strcmp(argv[i], "--normalize") == 0) {
+            normalize = 1;
+        } else if (strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            printf("Unknown argument: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!input_file || !output_file) {
+        printf("Error: Missing required arguments\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    printf("Weather Dataset Conversion\n");
+    printf("==========================\n");
+    printf("Input file: %s\n", input_file);
+    printf("Output file: %s\n", output_file);
+    printf("\n");
+
+    WeatherDataset* dataset = weather_dataset_create(1000);
+    if (!dataset) {
+        printf("Error: Could not create dataset\n");
+        return 1;
+    }
+
+    if (weather_load_csv(input_file, dataset) != 0 || dataset->size == 0) {
+        printf("Error: Could not load weather data from %s\n", input_file);
+        weather_dataset_free(dataset);
+        return 1;
+    }
+
+    // Normalization parameters always describe the raw values
+    NormalizationParams* norm_params = calculate_normalization_params(dataset);
+    if (!norm_params) {
+        printf("Error: Could not calculate normalization parameters\n");
+        weather_dataset_free(dataset);
+        return 1;
+    }
+    print_normalization_params(norm_params);
+
+    if (normalize) {
+        printf("Normalizing rows...\n");
+        normalize_dataset(dataset, norm_params);
+    }
+
+    int status = weather_save_binary(output_file, dataset, norm_params, normalize);
+    if (status != 0) {
+        printf("Error: Could not write %s\n", output_file);
+    } else {
+        printf("\nConversion completed successfully!\n");
+    }
+
+    free(norm_params);
+    weather_dataset_free(dataset);
+    return status == 0 ? 0 : 1;
+}
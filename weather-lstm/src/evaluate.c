@@ -0,0 +1,166 @@
+#include "../include/evaluate.h"
+#include "../include/profile.h"
+#include <math.h>
+
+static const char* const evaluate_feature_names[WEATHER_NUM_FEATURES] = {
+    "temperature", "pressure", "humidity", "wind_speed", "wind_direction", "precipitation"
+};
+
+Evaluator* evaluator_create(LSTMNetwork* network, int threads, int batch_size) {
+    if (!network || threads <= 0 || batch_size <= 0 || network->input_size != WEATHER_NUM_FEATURES ||
+        network->output_size != WEATHER_NUM_FEATURES) {
+        return NULL;
+    }
+
+    Evaluator* evaluator = calloc(1, sizeof(Evaluator));
+    if (!evaluator) return NULL;
+
+    evaluator->threads = threads;
+    evaluator->batch_size = batch_size;
+    evaluator->predictors = calloc((size_t)threads, sizeof(BatchPredictor*));
+    evaluator->windows = calloc((size_t)threads * batch_size, sizeof(double*));
+    evaluator->partials = matrix_create(threads, EVALUATE_PARTIAL_STRIDE);
+    if (!evaluator->predictors || !evaluator->windows || !evaluator->partials) {
+        evaluator_free(evaluator);
+        return NULL;
+    }
+
+    for (int w = 0; w < threads; w++) {
+        evaluator->predictors[w] = batch_predictor_create(network, batch_size);
+        if (!evaluator->predictors[w]) {
+            evaluator_free(evaluator);
+            return NULL;
+        }
+    }
+
+    if (threads > 1) {
+        evaluator->pool = thread_pool_create(threads);
+        if (!evaluator->pool) {
+            evaluator_free(evaluator);
+            return NULL;
+        }
+    }
+
+    return evaluator;
+}
+
+void evaluator_free(Evaluator* evaluator) {
+    if (!evaluator) return;
+
+    if (evaluator->predictors) {
+        for (int w = 0; w < evaluator->threads; w++) {
+            batch_predictor_free(evaluator->predictors[w]);
+        }
+    }
+    thread_pool_free(evaluator->pool);
+    free(evaluator->predictors);
+    free(evaluator->windows);
+    matrix_free(evaluator->partials);
+    free(evaluator);
+}
+
+// Each worker predicts its range batch by batch and sums |e| and e^2 per
+// feature, plus the squared normalized error behind the loss
+static void evaluate_worker(void* arg, int worker, int num_workers) {
+    Evaluator* evaluator = arg;
+    LSTMNetwork* network = evaluator->network;
+    TrainingData* data = evaluator->data;
+    BatchPredictor* predictor = evaluator->predictors[worker];
+    double** windows = evaluator->windows + (size_t)worker * evaluator->batch_size;
+    double* sums = MATRIX_ROW(evaluator->partials, worker);
+    memset(sums, 0, EVALUATE_PARTIAL_STRIDE * sizeof(double));
+
+    int first, last;
+    thread_pool_range(data->num_sequences, worker, num_workers, &first, &last);
+
+    for (int base = first; base < last; base += evaluator->batch_size) {
+        int count = last - base;
+        if (count > evaluator->batch_size) count = evaluator->batch_size;
+        for (int b = 0; b < count; b++) {
+            windows[b] = training_data_input(data, base + b, 0);
+        }
+
+        if (batch_predictor_run(predictor, network, windows, count, data->sequence_length) != 0) {
+            __atomic_fetch_add(&evaluator->failures, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        Matrix* output = predictor->output;
+        for (int b = 0; b < count; b++) {
+            const double* target = training_data_target(data, base + b);
+            for (int k = 0; k < WEATHER_NUM_FEATURES; k++) {
+                double error = MATRIX_AT(output, k, b) - target[k];
+                double raw = error * evaluator->scale[k];
+                sums[2 * k] += fabs(raw);
+                sums[2 * k + 1] += raw * raw;
+                sums[2 * WEATHER_NUM_FEATURES] += error * error;
+            }
+        }
+    }
+}
+
+int evaluator_run(Evaluator* evaluator, LSTMNetwork* network, TrainingData* data, EvaluationResult* result) {
+    if (!evaluator || !network || !data || !result || data->num_sequences <= 0 ||
+        data->feature_size != WEATHER_NUM_FEATURES || network->num_layers != evaluator->predictors[0]->num_layers) {
+        return -1;
+    }
+
+    double start = profile_seconds();
+    memset(result, 0, sizeof(*result));
+
+    // Normalized errors scale by each feature's range; a feature without
+    // one denormalizes to a constant, so it has no error in raw units
+    const double* pairs = (const double*)network->norm_params;
+    for (int k = 0; k < WEATHER_NUM_FEATURES; k++) {
+        double range = pairs ? pairs[2 * k + 1] - pairs[2 * k] : 1.0;
+        evaluator->scale[k] = range > 0.0 ? range : 0.0;
+    }
+    result->raw_units = pairs != NULL;
+
+    evaluator->network = network;
+    evaluator->data = data;
+    evaluator->failures = 0;
+
+    // Workers past the last window get an empty range and zero sums
+    int workers = evaluator->pool ? evaluator->threads : 1;
+    if (evaluator->pool) {
+        thread_pool_run(evaluator->pool, evaluate_worker, evaluator);
+    } else {
+        evaluate_worker(evaluator, 0, 1);
+    }
+
+    evaluator->network = NULL;
+    evaluator->data = NULL;
+    if (evaluator->failures > 0) return -1;
+
+    double totals[EVALUATE_PARTIAL_STRIDE] = {0.0};
+    for (int w = 0; w < workers; w++) {
+        const double* sums = MATRIX_ROW(evaluator->partials, w);
+        for (int i = 0; i <= 2 * WEATHER_NUM_FEATURES; i++) {
+            totals[i] += sums[i];
+        }
+    }
+
+    double n = (double)data->num_sequences;
+    result->windows = data->num_sequences;
+    for (int k = 0; k < WEATHER_NUM_FEATURES; k++) {
+        result->mae[k] = totals[2 * k] / n;
+        result->rmse[k] = sqrt(totals[2 * k + 1] / n);
+    }
+    result->loss = totals[2 * WEATHER_NUM_FEATURES] / (n * WEATHER_NUM_FEATURES);
+    result->seconds = profile_seconds() - start;
+
+    return 0;
+}
+
+void evaluation_print(FILE* out, const EvaluationResult* result) {
+    if (!out || !result) return;
+
+    fprintf(out, "Evaluated %ld windows in %.3f s (%.0f windows/s)\n", result->windows, result->seconds,
+            result->seconds > 0.0 ? result->windows / result->seconds : 0.0);
+    fprintf(out, "%-16s %12s %12s\n", result->raw_units ? "feature (raw)" : "feature (norm)", "MAE", "RMSE");
+    for (int k = 0; k < WEATHER_NUM_FEATURES; k++) {
+        fprintf(out, "%-16s %12.4f %12.4f\n", evaluate_feature_names[k], result->mae[k], result->rmse[k]);
+    }
+    fprintf(out, "Loss (normalized MSE): %.6f\n", result->loss);
+}
@@ -0,0 +1,317 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "../include/inference_server.h"
+#include <time.h>
+
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static char* copy_string(const char* s) {
+    size_t length = strlen(s);
+    char* copy = malloc(length + 1);
+    if (copy) memcpy(copy, s, length + 1);
+    return copy;
+}
+
+// FNV-1a
+static unsigned int station_hash(const char* id) {
+    unsigned int hash = 2166136261u;
+    for (; *id; id++) {
+        hash = (hash ^ (unsigned char)*id) * 16777619u;
+    }
+    return hash;
+}
+
+InferenceServer* inference_server_create(void) {
+    InferenceServer* server = calloc(1, sizeof(InferenceServer));
+    if (!server) return NULL;
+    
+    server->index_capacity = 64;
+    server->index = malloc((size_t)server->index_capacity * sizeof(int));
+    if (!server->index) {
+        free(server);
+        return NULL;
+    }
+    for (int i = 0; i < server->index_capacity; i++) {
+        server->index[i] = -1;
+    }
+    
+    return server;
+}
+
+static void station_free(StationState* station) {
+    free(station->id);
+    matrix_free(station->hidden);
+    matrix_free(station->cell);
+    matrix_free(station->output);
+}
+
+void inference_server_free(InferenceServer* server) {
+    if (!server) return;
+    
+    for (int s = 0; s < server->num_stations; s++) {
+        station_free(&server->stations[s]);
+    }
+    for (int m = 0; m < server->num_models; m++) {
+        lstm_network_free(server->models[m]);
+        free(server->model_names[m]);
+    }
+    free(server->stations);
+    free(server->index);
+    free(server->models);
+    free(server->model_names);
+    matrix_free(server->x);
+    free(server);
+}
+
+int inference_server_add_model(InferenceServer* server, const char* name, const char* filename) {
+    if (!server || !name || !filename) return -1;
+    
+    for (int m = 0; m < server->num_models; m++) {
+        if (strcmp(server->model_names[m], name) == 0) {
+            printf("Error: Model %s is already loaded\n", name);
+            return -1;
+        }
+    }
+    
+    LSTMNetwork* network = load_lstm_model(filename);
+    if (!network) {
+        printf("Error: Could not load model from %s\n", filename);
+        return -1;
+    }
+    if (network->input_size != WEATHER_NUM_FEATURES) {
+        printf("Error: Model %s takes %d inputs, expected %d\n", name, network->input_size,
+               WEATHER_NUM_FEATURES);
+        lstm_network_free(network);
+        return -1;
+    }
+    
+    LSTMNetwork** models = realloc(server->models, (size_t)(server->num_models + 1) * sizeof(LSTMNetwork*));
+    if (models) server->models = models;
+    char** names = realloc(server->model_names, (size_t)(server->num_models + 1) * sizeof(char*));
+    if (names) server->model_names = names;
+    char* copy = copy_string(name);
+    if (!server->x) server->x = matrix_create(network->input_size, 1);
+    if (!models || !names || !copy || !server->x) {
+        free(copy);
+        lstm_network_free(network);
+        return -1;
+    }
+    
+    server->models[server->num_models] = network;
+    server->model_names[server->num_models] = copy;
+    server->num_models++;
+    
+    return 0;
+}
+
+static int find_model(InferenceServer* server, const char* name) {
+    for (int m = 0; m < server->num_models; m++) {
+        if (strcmp(server->model_names[m], name) == 0) return m;
+    }
+    return -1;
+}
+
+static int index_slot(InferenceServer* server, const char* id) {
+    unsigned int mask = (unsigned int)server->index_capacity - 1;
+    unsigned int slot = station_hash(id) & mask;
+    while (server->index[slot] >= 0 && strcmp(server->stations[server->index[slot]].id, id) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return (int)slot;
+}
+
+// Double the table once it is half full
+static int index_grow(InferenceServer* server) {
+    int capacity = server->index_capacity * 2;
+    int* index = malloc((size_t)capacity * sizeof(int));
+    if (!index) return -1;
+    
+    free(server->index);
+    server->index = index;
+    server->index_capacity = capacity;
+    for (int i = 0; i < capacity; i++) {
+        index[i] = -1;
+    }
+    for (int s = 0; s < server->num_stations; s++) {
+        index[index_slot(server, server->stations[s].id)] = s;
+    }
+    
+    return 0;
+}
+
+static int station_reset(InferenceServer* server, StationState* station, int model) {
+    LSTMNetwork* network = server->models[model];
+    if (station->model != model || !station->hidden) {
+        matrix_free(station->hidden);
+        matrix_free(station->cell);
+        matrix_free(station->output);
+        station->hidden = matrix_create(network->num_layers * network->hidden_size, 1);
+        station->cell = matrix_create(network->num_layers * network->hidden_size, 1);
+        station->output = matrix_create(network->output_size, 1);
+        if (!station->hidden || !station->cell || !station->output) return -1;
+    }
+    station->model = model;
+    station->steps = 0;
+    matrix_zero(station->hidden);
+    matrix_zero(station->cell);
+    matrix_zero(station->output);
+    
+    return 0;
+}
+
+// Look up a station, creating it on the default model when create is set
+static StationState* find_station(InferenceServer* server, const char* id, int create) {
+    int slot = index_slot(server, id);
+    if (server->index[slot] >= 0) return &server->stations[server->index[slot]];
+    if (!create) return NULL;
+    
+    if (2 * (server->num_stations + 1) > server->index_capacity) {
+        if (index_grow(server) != 0) return NULL;
+        slot = index_slot(server, id);
+    }
+    if (server->num_stations == server->station_capacity) {
+        int capacity = server->station_capacity ? server->station_capacity * 2 : 64;
+        StationState* grown = realloc(server->stations, (size_t)capacity * sizeof(StationState));
+        if (!grown) return NULL;
+        server->stations = grown;
+        server->station_capacity = capacity;
+    }
+    
+    StationState* station = &server->stations[server->num_stations];
+    memset(station, 0, sizeof(StationState));
+    station->id = copy_string(id);
+    if (!station->id || station_reset(server, station, 0) != 0) {
+        station_free(station);
+        return NULL;
+    }
+    server->index[slot] = server->num_stations++;
+    
+    return station;
+}
+
+static void reply_prediction(InferenceServer* server, StationState* station, FILE* out) {
+    LSTMNetwork* network = server->models[station->model];
+    WeatherPoint point = matrix_to_weather_point(station->output);
+    if (network->norm_params) {
+        denormalize_point(&point, network->norm_params);
+    }
+    fprintf(out, "OK %s %ld %.2f,%.2f,%.2f,%.2f,%.2f,%.4f\n", station->id, station->steps,
+            point.temperature, point.pressure, point.humidity,
+            point.wind_speed, point.wind_direction, point.precipitation);
+}
+
+static void handle_observation(InferenceServer* server, const char* id, const char* values, FILE* out) {
+    WeatherPoint point;
+    if (!values || sscanf(values, "%lf,%lf,%lf,%lf,%lf,%lf", &point.temperature, &point.pressure,
+                          &point.humidity, &point.wind_speed, &point.wind_direction,
+                          &point.precipitation) != WEATHER_NUM_FEATURES) {
+        fprintf(out, "ERR expected OBS <station> <six comma-separated values>\n");
+        return;
+    }
+    
+    StationState* station = find_station(server, id, 1);
+    if (!station) {
+        fprintf(out, "ERR out of memory\n");
+        return;
+    }
+    
+    LSTMNetwork* network = server->models[station->model];
+    if (network->norm_params) {
+        WeatherDataset single = {&point, 1, 1, NULL, 0};
+        normalize_dataset(&single, network->norm_params);
+    }
+    memcpy(server->x->storage, &point, sizeof(point));
+    
+    if (lstm_network_step_state(network, server->x, station->hidden, station->cell, station->output) != 0) {
+        fprintf(out, "ERR prediction failed\n");
+        return;
+    }
+    station->steps++;
+    reply_prediction(server, station, out);
+}
+
+// Copy the next whitespace-separated field of *line into field and step
+// past it. Returns its length, 0 at the end of the line, or -1 when it does
+// not fit: a truncated station id could alias another station.
+static int next_field(const char** line, char* field, size_t size) {
+    const char* start = *line + strspn(*line, " \t\r\n\v\f");
+    size_t length = strcspn(start, " \t\r\n\v\f");
+    *line = start + length;
+    if (length >= size) return -1;
+    memcpy(field, start, length);
+    field[length] = '\0';
+    return (int)length;
+}
+
+int inference_server_handle(InferenceServer* server, const char* line, FILE* out) {
+    if (!server || !line || !out) return 0;
+    if (server->num_models == 0) {
+        fprintf(out, "ERR no model loaded\n");
+        return 0;
+    }
+    
+    double start = monotonic_seconds();
+    char command[16], id[64], arg[256];
+    char* const slots[3] = {command, id, arg};
+    const size_t sizes[3] = {sizeof(command), sizeof(id), sizeof(arg)};
+    const char* rest = line;
+    int fields = 0, too_long = 0;
+    while (fields < 3) {
+        int length = next_field(&rest, slots[fields], sizes[fields]);
+        if (length < 0) too_long = 1;
+        if (length <= 0) break;
+        fields++;
+    }
+    int quit = 0;
+    
+    if (too_long) {
+        fields = 1;
+        fprintf(out, "ERR field too long (command %zu, station %zu, argument %zu characters at most)\n",
+                sizeof(command) - 1, sizeof(id) - 1, sizeof(arg) - 1);
+    } else if (fields == 0) {
+        // Blank line: nothing to answer
+    } else if (strcmp(command, "OBS") == 0 && fields >= 2) {
+        handle_observation(server, id, fields == 3 ? arg : NULL, out);
+    } else if (strcmp(command, "PREDICT") == 0 && fields == 2) {
+        StationState* station = find_station(server, id, 0);
+        if (station && station->steps > 0) {
+            reply_prediction(server, station, out);
+        } else {
+            fprintf(out, "ERR no observations for station %s\n", id);
+        }
+    } else if (strcmp(command, "BIND") == 0 && fields == 3) {
+        int model = find_model(server, arg);
+        StationState* station = model >= 0 ? find_station(server, id, 1) : NULL;
+        if (model < 0) {
+            fprintf(out, "ERR unknown model %s\n", arg);
+        } else if (!station || station_reset(server, station, model) != 0) {
+            fprintf(out, "ERR out of memory\n");
+        } else {
+            fprintf(out, "OK %s %s\n", id, arg);
+        }
+    } else if (strcmp(command, "RESET") == 0 && fields == 2) {
+        StationState* station = find_station(server, id, 0);
+        if (station) station_reset(server, station, station->model);
+        fprintf(out, "OK %s\n", id);
+    } else if (strcmp(command, "STATS") == 0) {
+        fprintf(out, "OK models=%d stations=%d requests=%ld mean_latency_us=%.2f\n",
+                server->num_models, server->num_stations, server->requests,
+                server->requests > 0 ? 1e6 * server->busy_seconds / server->requests : 0.0);
+    } else if (strcmp(command, "QUIT") == 0) {
+        fprintf(out, "OK bye\n");
+        quit = 1;
+    } else {
+        fprintf(out, "ERR unknown request: %s", line);
+        if (line[0] && line[strlen(line) - 1] != '\n') fputc('\n', out);
+    }
+    
+    if (fields > 0) {
+        server->requests++;
+        server->busy_seconds += monotonic_seconds() - start;
+    }
+    return quit;
+}
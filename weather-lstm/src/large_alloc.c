@@ -0,0 +1,294 @@
+// mbind, move_pages and getcpu have no libc wrappers without libnuma, and
+// MAP_HUGETLB and MADV_HUGEPAGE are Linux extensions
+#define _GNU_SOURCE
+#include "../include/large_alloc.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define LARGE_MAGIC 0x434f4c4c4147524cull     // "LRGALLOC"
+#define LARGE_HEADER_BYTES ((size_t)MATRIX_ALIGNMENT)
+#define LARGE_MAX_NODES 1024
+#define LARGE_MPOL_INTERLEAVE 3                // MPOL_INTERLEAVE of linux/mempolicy.h
+
+typedef enum {
+    LARGE_KIND_HEAP = 0,
+    LARGE_KIND_MAPPED,
+    LARGE_KIND_HUGETLB
+} LargeKind;
+
+// Sits in the MATRIX_ALIGNMENT bytes before every block
+typedef struct {
+    uint64_t magic;
+    uint64_t bytes;             // Bytes after the header: allocated (heap) or in use (mapped)
+    uint64_t map_bytes;         // Length of the mapping; 0 for heap blocks
+    uint32_t kind;              // LargeKind
+    uint32_t shared;
+} LargeHeader;
+
+static const char* const large_pages_names[LARGE_PAGES_NUM_MODES] = {"default", "thp", "hugetlb"};
+
+static LargeAllocPolicy large_policy = {LARGE_PAGES_DEFAULT, 0, LARGE_HUGEPAGE_SIZE};
+
+static pthread_once_t large_nodes_once = PTHREAD_ONCE_INIT;
+static int large_num_nodes = 1;
+static unsigned long large_node_mask[LARGE_MAX_NODES / (8 * sizeof(unsigned long))];
+static pthread_once_t large_hugetlb_once = PTHREAD_ONCE_INIT;
+
+void large_alloc_policy_default(LargeAllocPolicy* policy) {
+    if (!policy) return;
+
+    policy->pages = LARGE_PAGES_DEFAULT;
+    policy->numa = 0;
+    policy->min_bytes = LARGE_HUGEPAGE_SIZE;
+}
+
+void large_alloc_set_policy(const LargeAllocPolicy* policy) {
+    if (policy) large_policy = *policy;
+    else large_alloc_policy_default(&large_policy);
+}
+
+const LargeAllocPolicy* large_alloc_policy(void) {
+    return &large_policy;
+}
+
+int large_pages_parse(const char* name, LargePages* pages) {
+    if (!name || !pages) return -1;
+
+    for (int p = 0; p < LARGE_PAGES_NUM_MODES; p++) {
+        if (strcmp(name, large_pages_names[p]) == 0) {
+            *pages = (LargePages)p;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* large_pages_name(LargePages pages) {
+    return pages >= 0 && pages < LARGE_PAGES_NUM_MODES ? large_pages_names[pages] : "unknown";
+}
+
+// Parse /sys/devices/system/node/online ("0", "0-3", "0-1,4") into the mask
+static void large_read_nodes(void) {
+    FILE* file = fopen("/sys/devices/system/node/online", "r");
+    if (!file) return;
+
+    char line[256];
+    int count = 0;
+    if (fgets(line, sizeof(line), file)) {
+        char* p = line;
+        while (*p && *p != '\n') {
+            char* end;
+            long first = strtol(p, &end, 10);
+            if (end == p) break;
+            long last = first;
+            p = end;
+            if (*p == '-') {
+                last = strtol(p + 1, &end, 10);
+                p = end;
+            }
+            for (long n = first; n <= last && n >= 0 && n < LARGE_MAX_NODES; n++) {
+                large_node_mask[n / (8 * sizeof(unsigned long))] |= 1ul << (n % (8 * sizeof(unsigned long)));
+                count++;
+            }
+            if (*p == ',') p++;
+        }
+    }
+    fclose(file);
+    if (count > 0) large_num_nodes = count;
+}
+
+int large_alloc_nodes(void) {
+    pthread_once(&large_nodes_once, large_read_nodes);
+    return large_num_nodes;
+}
+
+static void large_warn_hugetlb(void) {
+    printf("Warning: No explicit hugepages available (vm.nr_hugepages); using transparent hugepages\n");
+}
+
+static LargeHeader* large_header(void* block) {
+    return (LargeHeader*)((unsigned char*)block - LARGE_HEADER_BYTES);
+}
+
+// Anonymous mapping of at least bytes, starting on a 2 MB boundary so THP
+// can back all of it. Returns MAP_FAILED on failure.
+static void* large_map_aligned(size_t bytes) {
+    size_t slack = LARGE_HUGEPAGE_SIZE;
+    unsigned char* raw = mmap(NULL, bytes + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return MAP_FAILED;
+
+    uintptr_t start = ((uintptr_t)raw + slack - 1) & ~(uintptr_t)(slack - 1);
+    size_t head = start - (uintptr_t)raw;
+    if (head > 0) munmap(raw, head);
+    if (slack - head > 0) munmap((unsigned char*)start + bytes, slack - head);
+    return (void*)start;
+}
+
+static void* large_alloc_block(size_t bytes, int shared) {
+    const LargeAllocPolicy* policy = &large_policy;
+    size_t total = LARGE_HEADER_BYTES + bytes;
+    if (total < bytes) return NULL;
+
+    int mapped = bytes >= policy->min_bytes && (policy->pages != LARGE_PAGES_DEFAULT || policy->numa);
+    if (!mapped) {
+        void* base = NULL;
+        if (posix_memalign(&base, MATRIX_ALIGNMENT, total) != 0) return NULL;
+        memset(base, 0, total);
+        LargeHeader* header = base;
+        header->magic = LARGE_MAGIC;
+        header->bytes = bytes;
+        header->kind = LARGE_KIND_HEAP;
+        header->shared = (uint32_t)shared;
+        return (unsigned char*)base + LARGE_HEADER_BYTES;
+    }
+
+    // Whole hugepages, so the tail of the block is not left on small pages
+    size_t map_bytes = (total + LARGE_HUGEPAGE_SIZE - 1) & ~(LARGE_HUGEPAGE_SIZE - 1);
+    void* base = MAP_FAILED;
+    LargeKind kind = LARGE_KIND_MAPPED;
+    if (policy->pages == LARGE_PAGES_HUGETLB) {
+        base = mmap(NULL, map_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED) kind = LARGE_KIND_HUGETLB;
+        else pthread_once(&large_hugetlb_once, large_warn_hugetlb);
+    }
+    if (base == MAP_FAILED) {
+        base = large_map_aligned(map_bytes);
+        if (base == MAP_FAILED) return NULL;
+        if (policy->pages != LARGE_PAGES_DEFAULT) madvise(base, map_bytes, MADV_HUGEPAGE);
+    }
+
+    // The policy applies to pages not yet touched, which is all of them
+    if (shared && policy->numa && large_alloc_nodes() > 1) {
+        syscall(SYS_mbind, base, map_bytes, LARGE_MPOL_INTERLEAVE, large_node_mask,
+                (unsigned long)LARGE_MAX_NODES, 0u);
+    }
+
+    // Writing the header places only the block's first page
+    LargeHeader* header = base;
+    header->magic = LARGE_MAGIC;
+    header->bytes = bytes;
+    header->map_bytes = map_bytes;
+    header->kind = kind;
+    header->shared = (uint32_t)shared;
+    return (unsigned char*)base + LARGE_HEADER_BYTES;
+}
+
+void* large_alloc(size_t bytes) {
+    return large_alloc_block(bytes, 0);
+}
+
+void* large_alloc_shared(size_t bytes) {
+    return large_alloc_block(bytes, 1);
+}
+
+void* large_realloc(void* block, size_t bytes) {
+    if (!block) return large_alloc(bytes);
+
+    LargeHeader* header = large_header(block);
+    if (header->magic != LARGE_MAGIC) return NULL;
+    if (header->kind == LARGE_KIND_HEAP && bytes <= header->bytes) {
+        memset((unsigned char*)block + bytes, 0, header->bytes - bytes);
+        return block;
+    }
+
+    // A mapping already holds whole pages past the end; grow into them
+    if (header->kind != LARGE_KIND_HEAP && LARGE_HEADER_BYTES + bytes <= header->map_bytes) {
+        if (bytes < header->bytes) {
+            memset((unsigned char*)block + bytes, 0, header->bytes - bytes);
+        }
+        header->bytes = bytes;
+        return block;
+    }
+
+    void* grown = large_alloc_block(bytes, (int)header->shared);
+    if (!grown) return NULL;
+    memcpy(grown, block, header->bytes < bytes ? header->bytes : bytes);
+    large_free(block);
+    return grown;
+}
+
+void large_free(void* block) {
+    if (!block) return;
+
+    LargeHeader* header = large_header(block);
+    if (header->kind == LARGE_KIND_HEAP) {
+        free(header);
+    } else {
+        munmap(header, header->map_bytes);
+    }
+}
+
+// Sum of the hugepage-backed bytes that smaps reports for the mappings
+// overlapping [first, last)
+static size_t large_huge_bytes(uintptr_t first, uintptr_t last) {
+    FILE* file = fopen("/proc/self/smaps", "r");
+    if (!file) return 0;
+
+    char line[512];
+    size_t huge = 0;
+    size_t overlap = 0;
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long start, end;
+        unsigned long kb;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            uintptr_t lo = start > first ? start : first;
+            uintptr_t hi = end < last ? end : last;
+            overlap = hi > lo ? hi - lo : 0;
+        } else if (overlap > 0 && (sscanf(line, "AnonHugePages: %lu kB", &kb) == 1 ||
+                                   sscanf(line, "Private_Hugetlb: %lu kB", &kb) == 1)) {
+            size_t bytes = (size_t)kb << 10;
+            huge += bytes < overlap ? bytes : overlap;
+        }
+    }
+    fclose(file);
+    return huge;
+}
+
+int large_alloc_residency(const void* address, size_t bytes, long max_pages, LargeResidency* residency) {
+    if (!address || !residency) return -1;
+
+    memset(residency, 0, sizeof(*residency));
+    residency->bytes = bytes;
+    residency->huge_bytes = large_huge_bytes((uintptr_t)address, (uintptr_t)address + bytes);
+    if (max_pages <= 0 || bytes == 0) return 0;
+
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) page = 4096;
+    uintptr_t first = (uintptr_t)address & ~(uintptr_t)(page - 1);
+    long pages = (long)(((uintptr_t)address + bytes - first + (size_t)page - 1) / (size_t)page);
+    long samples = pages < max_pages ? pages : max_pages;
+
+    void** addresses = malloc((size_t)samples * sizeof(void*));
+    int* status = malloc((size_t)samples * sizeof(int));
+    if (!addresses || !status) {
+        free(addresses);
+        free(status);
+        return -1;
+    }
+    for (long i = 0; i < samples; i++) {
+        long p = samples > 1 ? (long)((double)i * (double)(pages - 1) / (double)(samples - 1)) : 0;
+        addresses[i] = (void*)(first + (uintptr_t)p * (uintptr_t)page);
+    }
+
+    // With no target nodes, move_pages only reports where each page is
+    unsigned cpu = 0, node = 0;
+    int result = -1;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0 &&
+        syscall(SYS_move_pages, 0, (unsigned long)samples, addresses, NULL, status, 0) == 0) {
+        for (long i = 0; i < samples; i++) {
+            if (status[i] < 0) continue;  // Not touched yet
+            if ((unsigned)status[i] == node) residency->local_pages++;
+            else residency->remote_pages++;
+        }
+        residency->pages_sampled = samples;
+        result = 0;
+    }
+
+    free(addresses);
+    free(status);
+    return result;
+}
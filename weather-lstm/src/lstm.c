@@ -1,5 +1,15 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include "../include/lstm.h"
+#include "../include/matrix_kernels.h"
+#include "../include/bptt.h"
+#include "../include/lstm_fixed.h"
+#include "../include/profile.h"
+#include "../include/large_alloc.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
 // Initialize weights with Xavier initialization
 void initialize_weights(Matrix* m, double scale) {
@@ -9,41 +19,57 @@ void initialize_weights(Matrix* m, double scale) {
     matrix_random(m, -limit, limit);
 }
 
-// Create LSTM cell
-LSTMCell* lstm_cell_create(int input_size, int hidden_size) {
-    LSTMCell* cell = malloc(sizeof(LSTMCell));
-    if (!cell) return NULL;
+// Build a cell around fused parameters W [4H x I], U [4H x H] and b [4H x 1],
+// which may be owned matrices or views into a mapped model file. The cell
+// takes ownership of them, also on failure.
+static LSTMCell* lstm_cell_assemble(int input_size, int hidden_size, Matrix* W, Matrix* U, Matrix* b) {
+    LSTMCell* cell = calloc(1, sizeof(LSTMCell));
+    if (!cell) {
+        matrix_free(W);
+        matrix_free(U);
+        matrix_free(b);
+        return NULL;
+    }
     
     cell->input_size = input_size;
     cell->hidden_size = hidden_size;
     
-    // Initialize weight matrices
-    cell->W_f = matrix_create(hidden_size, input_size);
-    cell->W_i = matrix_create(hidden_size, input_size);
-    cell->W_c = matrix_create(hidden_size, input_size);
-    cell->W_o = matrix_create(hidden_size, input_size);
+    // Fused gate parameters and activations
+    int H = hidden_size;
+    cell->W = W;
+    cell->U = U;
+    cell->b = b;
+    cell->gates = matrix_create(LSTM_NUM_GATES * H, 1);
+    if (!cell->W || !cell->U || !cell->b || !cell->gates) {
+        lstm_cell_free(cell);
+        return NULL;
+    }
     
-    cell->U_f = matrix_create(hidden_size, hidden_size);
-    cell->U_i = matrix_create(hidden_size, hidden_size);
-    cell->U_c = matrix_create(hidden_size, hidden_size);
-    cell->U_o = matrix_create(hidden_size, hidden_size);
+    // Per-gate views
+    cell->W_f = matrix_view_rows(cell->W, LSTM_GATE_FORGET * H, H);
+    cell->W_i = matrix_view_rows(cell->W, LSTM_GATE_INPUT * H, H);
+    cell->W_c = matrix_view_rows(cell->W, LSTM_GATE_CANDIDATE * H, H);
+    cell->W_o = matrix_view_rows(cell->W, LSTM_GATE_OUTPUT * H, H);
     
-    // Initialize bias vectors
-    cell->b_f = matrix_create(hidden_size, 1);
-    cell->b_i = matrix_create(hidden_size, 1);
-    cell->b_c = matrix_create(hidden_size, 1);
-    cell->b_o = matrix_create(hidden_size, 1);
+    cell->U_f = matrix_view_rows(cell->U, LSTM_GATE_FORGET * H, H);
+    cell->U_i = matrix_view_rows(cell->U, LSTM_GATE_INPUT * H, H);
+    cell->U_c = matrix_view_rows(cell->U, LSTM_GATE_CANDIDATE * H, H);
+    cell->U_o = matrix_view_rows(cell->U, LSTM_GATE_OUTPUT * H, H);
+    
+    cell->b_f = matrix_view_rows(cell->b, LSTM_GATE_FORGET * H, H);
+    cell->b_i = matrix_view_rows(cell->b, LSTM_GATE_INPUT * H, H);
+    cell->b_c = matrix_view_rows(cell->b, LSTM_GATE_CANDIDATE * H, H);
+    cell->b_o = matrix_view_rows(cell->b, LSTM_GATE_OUTPUT * H, H);
+    
+    cell->forget_gate = matrix_view_rows(cell->gates, LSTM_GATE_FORGET * H, H);
+    cell->input_gate = matrix_view_rows(cell->gates, LSTM_GATE_INPUT * H, H);
+    cell->candidate_gate = matrix_view_rows(cell->gates, LSTM_GATE_CANDIDATE * H, H);
+    cell->output_gate = matrix_view_rows(cell->gates, LSTM_GATE_OUTPUT * H, H);
     
     // Initialize states
     cell->cell_state = matrix_create(hidden_size, 1);
     cell->hidden_state = matrix_create(hidden_size, 1);
     
-    // Initialize intermediate matrices
-    cell->forget_gate = matrix_create(hidden_size, 1);
-    cell->input_gate = matrix_create(hidden_size, 1);
-    cell->candidate_gate = matrix_create(hidden_size, 1);
-    cell->output_gate = matrix_create(hidden_size, 1);
-    
     // Check if all allocations succeeded
     if (!cell->W_f || !cell->W_i || !cell->W_c || !cell->W_o ||
         !cell->U_f || !cell->U_i || !cell->U_c || !cell->U_o ||
@@ -54,7 +80,23 @@ LSTMCell* lstm_cell_create(int input_size, int hidden_size) {
         return NULL;
     }
     
-    // Initialize weights
+    // Initialize states to zero
+    matrix_zero(cell->cell_state);
+    matrix_zero(cell->hidden_state);
+    
+    return cell;
+}
+
+// Create LSTM cell
+LSTMCell* lstm_cell_create(int input_size, int hidden_size) {
+    int H = hidden_size;
+    LSTMCell* cell = lstm_cell_assemble(input_size, hidden_size,
+                                        matrix_create(LSTM_NUM_GATES * H, input_size),
+                                        matrix_create(LSTM_NUM_GATES * H, hidden_size),
+                                        matrix_create(LSTM_NUM_GATES * H, 1));
+    if (!cell) return NULL;
+    
+    // Initialize weights (per gate, so each keeps its own Xavier range)
     initialize_weights(cell->W_f, 1.0);
     initialize_weights(cell->W_i, 1.0);
     initialize_weights(cell->W_c, 1.0);
@@ -66,17 +108,10 @@ LSTMCell* lstm_cell_create(int input_size, int hidden_size) {
     initialize_weights(cell->U_o, 1.0);
     
     // Initialize biases (forget gate bias to 1.0 for better gradient flow)
-    matrix_zero(cell->b_f);
+    matrix_zero(cell->b);
     for (int i = 0; i < hidden_size; i++) {
-        cell->b_f->data[i][0] = 1.0;
+        MATRIX_AT(cell->b_f, i, 0) = 1.0;
     }
-    matrix_zero(cell->b_i);
-    matrix_zero(cell->b_c);
-    matrix_zero(cell->b_o);
-    
-    // Initialize states to zero
-    matrix_zero(cell->cell_state);
-    matrix_zero(cell->hidden_state);
     
     return cell;
 }
@@ -100,14 +135,19 @@ void lstm_cell_free(LSTMCell* cell) {
     matrix_free(cell->b_c);
     matrix_free(cell->b_o);
     
-    matrix_free(cell->cell_state);
-    matrix_free(cell->hidden_state);
-    
     matrix_free(cell->forget_gate);
     matrix_free(cell->input_gate);
     matrix_free(cell->candidate_gate);
     matrix_free(cell->output_gate);
     
+    matrix_free(cell->W);
+    matrix_free(cell->U);
+    matrix_free(cell->b);
+    matrix_free(cell->gates);
+    
+    matrix_free(cell->cell_state);
+    matrix_free(cell->hidden_state);
+    
     free(cell);
 }
 
@@ -119,99 +159,174 @@ void lstm_cell_reset_state(LSTMCell* cell) {
     matrix_zero(cell->hidden_state);
 }
 
-// LSTM cell forward pass
+// Non-NULL matrices must be rows x cols with rows stored back to back
+static int lstm_dense_shape(Matrix* m, int rows, int cols) {
+    return !m || (m->rows == rows && m->cols == cols && (m->stride == cols || rows <= 1));
+}
+
+// One LSTM forward step on explicitly supplied state for B sequences at
+// once, one per column. Reads x [I x B], h_prev and c_prev [H x B]; writes
+// the activated gates [4H x B], c_out and h_out, plus tanh(c_out) when c_tanh
+// is non-NULL. c_out/h_out may alias c_prev/h_prev. Gate pre-activations come
+// from one GEMM (GEMV for B = 1) over W and one over U into the fused gate
+// buffer, followed by vectorized activations and one elementwise state
+// update, so a step performs no heap allocation. Single-sequence steps of the
+// common deployment shapes run a specialized kernel from lstm_fixed.h.
+int lstm_cell_step_state(LSTMCell* cell, Matrix* x, Matrix* h_prev, Matrix* c_prev,
+                         Matrix* gates, Matrix* c_out, Matrix* c_tanh, Matrix* h_out) {
+    if (!cell || !x || !h_prev || !c_prev || !gates || !c_out || !h_out) return -1;
+    
+    int H = cell->hidden_size;
+    int B = x->cols;
+    if (x->rows != cell->input_size || !lstm_dense_shape(gates, LSTM_NUM_GATES * H, B) ||
+        !lstm_dense_shape(h_prev, H, B) || !lstm_dense_shape(c_prev, H, B) ||
+        !lstm_dense_shape(c_out, H, B) || !lstm_dense_shape(h_out, H, B) ||
+        !lstm_dense_shape(c_tanh, H, B)) {
+        return -1;
+    }
+    
+    // Gate GEMM: 2 FLOPs per weight and column; weights, inputs and gates move
+    PROFILE_BEGIN(PROFILE_GATES);
+    PROFILE_WORK(PROFILE_GATES, 2.0 * gates->rows * (x->rows + H) * B,
+                 sizeof(double) * ((double)gates->rows * (x->rows + H + 1) + (double)(x->rows + H + gates->rows) * B));
+    
+    LSTMFixedStep fixed = B == 1 ? lstm_fixed_step_lookup(x->rows, H) : NULL;
+    if (fixed && cell->W->stride == cell->W->cols && cell->U->stride == cell->U->cols) {
+        // The fused kernel's activations are counted as gate time
+        fixed(cell->W->storage, cell->U->storage, cell->b->storage, x->storage, h_prev->storage,
+              c_prev->storage, gates->storage, c_out->storage, c_tanh ? c_tanh->storage : NULL,
+              h_out->storage);
+        PROFILE_END(PROFILE_GATES);
+        return 0;
+    }
+    
+    // gates = W x + b + U h_{t-1}; every gate reads h_{t-1} before h_out is written
+    if (gemm_add_bias_into(gates, cell->W, x, cell->b) != 0 ||
+        gemm_accumulate_into(gates, cell->U, h_prev) != 0) {
+        return -1;
+    }
+    PROFILE_END(PROFILE_GATES);
+    PROFILE_BEGIN(PROFILE_ACTIVATIONS);
+    
+    // Each gate is a contiguous [H x B] block of the fused buffer
+    int n = H * B;
+    double* f = gates->storage + LSTM_GATE_FORGET * n;
+    double* in = gates->storage + LSTM_GATE_INPUT * n;
+    double* g = gates->storage + LSTM_GATE_CANDIDATE * n;
+    double* o = gates->storage + LSTM_GATE_OUTPUT * n;
+    double* c = c_out->storage;
+    double* h = h_out->storage;
+    double* t = c_tanh ? c_tanh->storage : h;
+    const double* cp = c_prev->storage;
+    
+    // Gate activations: forget and input gates are adjacent in the fused buffer
+    const MatrixKernels* k = matrix_kernels();
+    k->sigmoid(2 * n, f);
+    k->tanh(n, g);
+    k->sigmoid(n, o);
+    
+    // C_t = f_t * C_{t-1} + i_t * tilde{C_t};  h_t = o_t * tanh(C_t)
+    for (int i = 0; i < n; i++) {
+        c[i] = f[i] * cp[i] + in[i] * g[i];
+        t[i] = c[i];
+    }
+    k->tanh(n, t);
+    for (int i = 0; i < n; i++) {
+        h[i] = o[i] * t[i];
+    }
+    
+    // Five activations and five state FLOPs per unit; gates and state move
+    PROFILE_WORK(PROFILE_ACTIVATIONS, 10.0 * n, sizeof(double) * 9.0 * n);
+    PROFILE_END(PROFILE_ACTIVATIONS);
+    return 0;
+}
+
+// LSTM cell forward step, updating cell_state and hidden_state in place
+int lstm_cell_step(LSTMCell* cell, Matrix* input) {
+    if (!cell) return -1;
+    
+    return lstm_cell_step_state(cell, input, cell->hidden_state, cell->cell_state,
+                                cell->gates, cell->cell_state, NULL, cell->hidden_state);
+}
+
+// LSTM cell forward pass, returning a copy of the new hidden state
 Matrix* lstm_cell_forward(LSTMCell* cell, Matrix* input) {
-    if (!cell || !input) return NULL;
-    
-    // Temporary matrices for computations
-    Matrix* W_x_f = matrix_multiply(cell->W_f, input);
-    Matrix* U_h_f = matrix_multiply(cell->U_f, cell->hidden_state);
-    Matrix* f_temp = matrix_add(W_x_f, U_h_f);
-    Matrix* f_temp2 = matrix_add(f_temp, cell->b_f);
-    matrix_copy(cell->forget_gate, f_temp2);
-    apply_sigmoid(cell->forget_gate);
-    
-    Matrix* W_x_i = matrix_multiply(cell->W_i, input);
-    Matrix* U_h_i = matrix_multiply(cell->U_i, cell->hidden_state);
-    Matrix* i_temp = matrix_add(W_x_i, U_h_i);
-    Matrix* i_temp2 = matrix_add(i_temp, cell->b_i);
-    matrix_copy(cell->input_gate, i_temp2);
-    apply_sigmoid(cell->input_gate);
-    
-    Matrix* W_x_c = matrix_multiply(cell->W_c, input);
-    Matrix* U_h_c = matrix_multiply(cell->U_c, cell->hidden_state);
-    Matrix* c_temp = matrix_add(W_x_c, U_h_c);
-    Matrix* c_temp2 = matrix_add(c_temp, cell->b_c);
-    matrix_copy(cell->candidate_gate, c_temp2);
-    apply_tanh(cell->candidate_gate);
-    
-    Matrix* W_x_o = matrix_multiply(cell->W_o, input);
-    Matrix* U_h_o = matrix_multiply(cell->U_o, cell->hidden_state);
-    Matrix* o_temp = matrix_add(W_x_o, U_h_o);
-    Matrix* o_temp2 = matrix_add(o_temp, cell->b_o);
-    matrix_copy(cell->output_gate, o_temp2);
-    apply_sigmoid(cell->output_gate);
-    
-    // Update cell state: C_t = f_t * C_{t-1} + i_t * tilde{C_t}
-    Matrix* forget_cell = matrix_create(cell->hidden_size, 1);
-    Matrix* input_candidate = matrix_create(cell->hidden_size, 1);
-    
-    for (int i = 0; i < cell->hidden_size; i++) {
-        forget_cell->data[i][0] = cell->forget_gate->data[i][0] * cell->cell_state->data[i][0];
-        input_candidate->data[i][0] = cell->input_gate->data[i][0] * cell->candidate_gate->data[i][0];
-        cell->cell_state->data[i][0] = forget_cell->data[i][0] + input_candidate->data[i][0];
-    }
-    
-    // Update hidden state: h_t = o_t * tanh(C_t)
-    Matrix* cell_tanh = matrix_create(cell->hidden_size, 1);
-    matrix_copy(cell_tanh, cell->cell_state);
-    apply_tanh(cell_tanh);
-    
-    for (int i = 0; i < cell->hidden_size; i++) {
-        cell->hidden_state->data[i][0] = cell->output_gate->data[i][0] * cell_tanh->data[i][0];
-    }
-    
-    // Clean up temporary matrices
-    matrix_free(W_x_f); matrix_free(U_h_f); matrix_free(f_temp); matrix_free(f_temp2);
-    matrix_free(W_x_i); matrix_free(U_h_i); matrix_free(i_temp); matrix_free(i_temp2);
-    matrix_free(W_x_c); matrix_free(U_h_c); matrix_free(c_temp); matrix_free(c_temp2);
-    matrix_free(W_x_o); matrix_free(U_h_o); matrix_free(o_temp); matrix_free(o_temp2);
-    matrix_free(forget_cell); matrix_free(input_candidate); matrix_free(cell_tanh);
-    
-    // Return copy of hidden state
+    if (lstm_cell_step(cell, input) != 0) return NULL;
+    
     Matrix* output = matrix_create(cell->hidden_size, 1);
+    if (!output) return NULL;
     matrix_copy(output, cell->hidden_state);
     return output;
 }
 
-// Create LSTM network
-LSTMNetwork* lstm_network_create(int input_size, int hidden_size, int output_size) {
-    LSTMNetwork* network = malloc(sizeof(LSTMNetwork));
-    if (!network) return NULL;
-    
-    network->lstm_layer = lstm_cell_create(input_size, hidden_size);
-    if (!network->lstm_layer) {
+// Build a network around num_layers stacked cells and an output layer,
+// taking ownership of all of them, also on failure. Training settings get
+// their defaults.
+static LSTMNetwork* lstm_network_assemble(LSTMCell** cells, int num_layers, Matrix* W_output,
+                                          Matrix* b_output, int input_size, int hidden_size,
+                                          int output_size) {
+    LSTMNetwork* network = calloc(1, sizeof(LSTMNetwork));
+    int ok = network && W_output && b_output && num_layers >= 1 && num_layers <= LSTM_MAX_LAYERS;
+    for (int l = 0; l < num_layers && l < LSTM_MAX_LAYERS; l++) {
+        if (!cells[l]) ok = 0;
+    }
+    if (!ok) {
+        for (int l = 0; l < num_layers && l < LSTM_MAX_LAYERS; l++) {
+            lstm_cell_free(cells[l]);
+        }
+        matrix_free(W_output);
+        matrix_free(b_output);
         free(network);
         return NULL;
     }
     
-    network->W_output = matrix_create(output_size, hidden_size);
-    network->b_output = matrix_create(output_size, 1);
-    
-    if (!network->W_output || !network->b_output) {
-        lstm_cell_free(network->lstm_layer);
-        matrix_free(network->W_output);
-        matrix_free(network->b_output);
-        free(network);
-        return NULL;
+    for (int l = 0; l < num_layers; l++) {
+        network->layers[l] = cells[l];
     }
+    network->num_layers = num_layers;
+    network->lstm_layer = cells[0];
+    network->W_output = W_output;
+    network->b_output = b_output;
     
     network->input_size = input_size;
     network->hidden_size = hidden_size;
     network->output_size = output_size;
     network->learning_rate = 0.001;
     network->sequence_length = 10;
+    network->bptt_window = 0;
+    network->batch_size = 1;
+    network->pipeline_threads = 1;
+    network->first_epoch = 0;
     network->norm_params = NULL;
+    network->map_base = NULL;
+    network->map_size = 0;
+    
+    // Room for the views and output matrix of lstm_forecast and
+    // lstm_predict_next, plus two state views per layer for step_state
+    int widest = input_size > output_size ? input_size : output_size;
+    if (hidden_size > widest) widest = hidden_size;
+    network->scratch = arena_create((size_t)(3 + 2 * num_layers) * arena_view_bytes(widest) +
+                                    arena_matrix_bytes(output_size, 1));
+    if (!network->scratch) {
+        lstm_network_free(network);
+        return NULL;
+    }
+    
+    return network;
+}
+
+// Create a network of num_layers stacked LSTM layers
+LSTMNetwork* lstm_network_create_stacked(int input_size, int hidden_size, int output_size, int num_layers) {
+    if (num_layers < 1 || num_layers > LSTM_MAX_LAYERS) return NULL;
+    
+    LSTMCell* cells[LSTM_MAX_LAYERS];
+    for (int l = 0; l < num_layers; l++) {
+        cells[l] = lstm_cell_create(l == 0 ? input_size : hidden_size, hidden_size);
+    }
+    LSTMNetwork* network = lstm_network_assemble(cells, num_layers, matrix_create(output_size, hidden_size),
+                                                 matrix_create(output_size, 1),
+                                                 input_size, hidden_size, output_size);
+    if (!network) return NULL;
     
     // Initialize output weights
     initialize_weights(network->W_output, 1.0);
@@ -220,11 +335,18 @@ LSTMNetwork* lstm_network_create(int input_size, int hidden_size, int output_siz
     return network;
 }
 
+// Create LSTM network
+LSTMNetwork* lstm_network_create(int input_size, int hidden_size, int output_size) {
+    return lstm_network_create_stacked(input_size, hidden_size, output_size, 1);
+}
+
 // Free LSTM network
 void lstm_network_free(LSTMNetwork* network) {
     if (!network) return;
     
-    lstm_cell_free(network->lstm_layer);
+    for (int l = 0; l < network->num_layers; l++) {
+        lstm_cell_free(network->layers[l]);
+    }
     matrix_free(network->W_output);
     matrix_free(network->b_output);
     
@@ -232,108 +354,225 @@ void lstm_network_free(LSTMNetwork* network) {
         free(network->norm_params);
     }
     
+    // Mapped models: the weights above were views into this mapping
+    if (network->map_base) {
+        munmap(network->map_base, network->map_size);
+    }
+    
+    arena_free(network->scratch);
     free(network);
 }
 
+LSTMCell* lstm_network_top(LSTMNetwork* network) {
+    return network ? network->layers[network->num_layers - 1] : NULL;
+}
+
+// Step every layer once: layer 0 reads x, each layer above reads the new
+// hidden state of the one below
+int lstm_network_step(LSTMNetwork* network, Matrix* x) {
+    if (!network || !x) return -1;
+    
+    for (int l = 0; l < network->num_layers; l++) {
+        Matrix* input = l == 0 ? x : network->layers[l - 1]->hidden_state;
+        if (lstm_cell_step(network->layers[l], input) != 0) return -1;
+    }
+    return 0;
+}
+
 // Reset network state
 void lstm_network_reset(LSTMNetwork* network) {
     if (!network) return;
     
-    lstm_cell_reset_state(network->lstm_layer);
+    for (int l = 0; l < network->num_layers; l++) {
+        lstm_cell_reset_state(network->layers[l]);
+    }
 }
 
-// Network prediction
-Matrix* lstm_network_predict(LSTMNetwork* network, Matrix** sequence, int seq_length) {
-    if (!network || !sequence) return NULL;
+// Network prediction into a caller-provided [output_size x 1] matrix
+int lstm_network_predict_into(LSTMNetwork* network, Matrix** sequence, int seq_length, Matrix* output) {
+    if (!network || !sequence || !output || seq_length <= 0) return -1;
     
     lstm_network_reset(network);
     
     // Process sequence
-    Matrix* hidden_output = NULL;
     for (int t = 0; t < seq_length; t++) {
-        if (hidden_output) {
-            matrix_free(hidden_output);
-        }
-        hidden_output = lstm_cell_forward(network->lstm_layer, sequence[t]);
+        if (lstm_network_step(network, sequence[t]) != 0) return -1;
     }
     
-    if (!hidden_output) return NULL;
-    
     // Generate output
-    Matrix* output_temp = matrix_multiply(network->W_output, hidden_output);
-    Matrix* output = matrix_add(output_temp, network->b_output);
+    return gemv_add_bias_into(output, network->W_output, lstm_network_top(network)->hidden_state,
+                              network->b_output);
+}
+
+// Network prediction
+Matrix* lstm_network_predict(LSTMNetwork* network, Matrix** sequence, int seq_length) {
+    if (!network || !sequence) return NULL;
     
-    matrix_free(hidden_output);
-    matrix_free(output_temp);
+    Matrix* output = matrix_create(network->output_size, 1);
+    if (!output) return NULL;
+    
+    if (lstm_network_predict_into(network, sequence, seq_length, output) != 0) {
+        matrix_free(output);
+        return NULL;
+    }
     
     return output;
 }
 
-// Create training data from weather dataset
-TrainingData* create_training_data(WeatherDataset* dataset, int sequence_length) {
-    if (!dataset || sequence_length <= 0 || dataset->size <= sequence_length) {
+// Forward pass over steps contiguous rows of input_size values, read in
+// place through one view that is moved along the window
+int lstm_network_predict_window(LSTMNetwork* network, double* window, int steps, Matrix* output) {
+    if (!network || !window || !output || steps <= 0) return -1;
+    
+    size_t mark = arena_mark(network->scratch);
+    Matrix* x = matrix_wrap_in(network->scratch, window, network->input_size, 1, 1);
+    if (!x) return -1;
+    
+    lstm_network_reset(network);
+    
+    int status = 0;
+    for (int t = 0; t < steps && status == 0; t++) {
+        matrix_rebind(x, window + (size_t)t * network->input_size);
+        status = lstm_network_step(network, x);
+    }
+    matrix_free(x);
+    arena_release(network->scratch, mark);
+    if (status != 0) return -1;
+    
+    return gemv_add_bias_into(output, network->W_output, lstm_network_top(network)->hidden_state,
+                              network->b_output);
+}
+
+// One step from caller-owned [H x 1] state, updated in place, followed by
+// the output layer. Lets callers keep many independent sequences alive
+// without re-running their windows.
+int lstm_network_step_state(LSTMNetwork* network, Matrix* x, Matrix* hidden, Matrix* cell, Matrix* output) {
+    if (!network || !x || !hidden || !cell || !output) return -1;
+    
+    int L = network->num_layers;
+    int H = network->hidden_size;
+    if (L == 1) {
+        LSTMCell* layer = network->lstm_layer;
+        if (lstm_cell_step_state(layer, x, hidden, cell, layer->gates, cell, NULL, hidden) != 0) return -1;
+        return gemv_add_bias_into(output, network->W_output, hidden, network->b_output);
+    }
+    if (hidden->rows != L * H || cell->rows != L * H || hidden->cols != 1 || cell->cols != 1) return -1;
+    
+    // Per-layer views of the stacked state, dropped again on return
+    size_t mark = arena_mark(network->scratch);
+    Matrix* below = NULL;
+    int status = 0;
+    for (int l = 0; l < L && status == 0; l++) {
+        LSTMCell* layer = network->layers[l];
+        Matrix* h = matrix_wrap_in(network->scratch, hidden->storage + (size_t)l * H, H, 1, 1);
+        Matrix* c = matrix_wrap_in(network->scratch, cell->storage + (size_t)l * H, H, 1, 1);
+        Matrix* input = l == 0 ? x : below;
+        status = h && c ? lstm_cell_step_state(layer, input, h, c, layer->gates, c, NULL, h) : -1;
+        matrix_free(below);
+        matrix_free(c);
+        below = h;
+    }
+    if (status == 0) {
+        status = gemv_add_bias_into(output, network->W_output, below, network->b_output);
+    }
+    matrix_free(below);
+    arena_release(network->scratch, mark);
+    
+    return status;
+}
+
+// Autoregressive rollout: run the most recent window once, then feed each
+// prediction back as the next input, continuing from the cell's state.
+// Predictions are written straight into the returned dataset, whose rows
+// double as the next step's input, so the loop allocates nothing.
+WeatherDataset* lstm_forecast(LSTMNetwork* network, WeatherDataset* data, int horizon) {
+    if (!network || !data || horizon <= 0 || data->size < network->sequence_length ||
+        network->input_size != WEATHER_NUM_FEATURES || network->output_size != WEATHER_NUM_FEATURES) {
+        return NULL;
+    }
+    
+    WeatherDataset* forecast = weather_dataset_create(horizon);
+    if (!forecast) return NULL;
+    
+    double* rows = weather_dataset_features(forecast);
+    size_t mark = arena_mark(network->scratch);
+    Matrix* x = matrix_wrap_in(network->scratch, rows, WEATHER_NUM_FEATURES, 1, 1);
+    Matrix* y = matrix_wrap_in(network->scratch, rows, WEATHER_NUM_FEATURES, 1, 1);
+    if (!x || !y) {
+        matrix_free(x);
+        matrix_free(y);
+        arena_release(network->scratch, mark);
+        weather_dataset_free(forecast);
+        return NULL;
+    }
+    
+    int T = network->sequence_length;
+    double* window = weather_dataset_features(data) + (size_t)(data->size - T) * WEATHER_NUM_FEATURES;
+    int status = lstm_network_predict_window(network, window, T, y);
+    
+    for (int h = 1; h < horizon && status == 0; h++) {
+        matrix_rebind(x, rows + (size_t)(h - 1) * WEATHER_NUM_FEATURES);
+        matrix_rebind(y, rows + (size_t)h * WEATHER_NUM_FEATURES);
+        status = lstm_network_step(network, x);
+        if (status == 0) {
+            status = gemv_add_bias_into(y, network->W_output, lstm_network_top(network)->hidden_state,
+                                        network->b_output);
+        }
+    }
+    matrix_free(x);
+    matrix_free(y);
+    arena_release(network->scratch, mark);
+    
+    if (status != 0) {
+        weather_dataset_free(forecast);
+        return NULL;
+    }
+    forecast->size = horizon;
+    
+    return forecast;
+}
+
+// Create a sliding-window view over num_rows feature rows; sample s starts at row s
+TrainingData* training_data_view(double* features, int feature_size, int num_rows, int sequence_length) {
+    if (!features || feature_size <= 0 || sequence_length <= 0 || num_rows <= sequence_length) {
         return NULL;
     }
     
     TrainingData* data = malloc(sizeof(TrainingData));
     if (!data) return NULL;
     
-    data->num_sequences = dataset->size - sequence_length;
+    data->features = features;
+    data->feature_size = feature_size;
+    data->num_rows = num_rows;
+    data->num_sequences = num_rows - sequence_length;
     data->sequence_length = sequence_length;
-    
-    data->inputs = malloc(data->num_sequences * sizeof(Matrix**));
-    data->targets = malloc(data->num_sequences * sizeof(Matrix*));
-    
-    if (!data->inputs || !data->targets) {
-        free(data->inputs);
-        free(data->targets);
+    data->offsets = large_alloc((size_t)data->num_sequences * sizeof(int));
+    if (!data->offsets) {
         free(data);
         return NULL;
     }
     
-    // Create sequences
     for (int i = 0; i < data->num_sequences; i++) {
-        data->inputs[i] = malloc(sequence_length * sizeof(Matrix*));
-        if (!data->inputs[i]) {
-            // Clean up on failure
-            for (int j = 0; j < i; j++) {
-                for (int k = 0; k < sequence_length; k++) {
-                    matrix_free(data->inputs[j][k]);
-                }
-                free(data->inputs[j]);
-            }
-            free(data->inputs);
-            free(data->targets);
-            free(data);
-            return NULL;
-        }
-        
-        // Create input sequence
-        for (int t = 0; t < sequence_length; t++) {
-            data->inputs[i][t] = weather_point_to_matrix(&dataset->data[i + t]);
-        }
-        
-        // Create target (next weather point)
-        data->targets[i] = weather_point_to_matrix(&dataset->data[i + sequence_length]);
+        data->offsets[i] = i;
     }
     
     return data;
 }
 
-// Free training data
+// Create training data from weather dataset. The view borrows the dataset's
+// points, which must not be grown or freed while it is in use.
+TrainingData* create_training_data(WeatherDataset* dataset, int sequence_length) {
+    if (!dataset) return NULL;
+    
+    return training_data_view(weather_dataset_features(dataset), WEATHER_NUM_FEATURES,
+                              dataset->size, sequence_length);
+}
+
+// Free training data (the feature buffer belongs to the caller)
 void free_training_data(TrainingData* data) {
     if (!data) return;
     
-    for (int i = 0; i < data->num_sequences; i++) {
-        for (int t = 0; t < data->sequence_length; t++) {
-            matrix_free(data->inputs[i][t]);
-        }
-        free(data->inputs[i]);
-        matrix_free(data->targets[i]);
-    }
-    
-    free(data->inputs);
-    free(data->targets);
+    large_free(data->offsets);
     free(data);
 }
 
@@ -356,93 +595,114 @@ double calculate_loss(Matrix* predicted, Matrix* target) {
     return loss / total_elements;
 }
 
-// Simple training function (simplified backpropagation)
+// Train with full backpropagation through time, one SGD step per sequence
 void lstm_train(LSTMNetwork* network, TrainingData* data, int epochs) {
     if (!network || !data) return;
     
     printf("Starting training for %d epochs...\n", epochs);
+    if (network->bptt_window > 0 && network->bptt_window < data->sequence_length) {
+        printf("Truncated BPTT window: %d steps\n", network->bptt_window);
+    }
     
-    for (int epoch = 0; epoch < epochs; epoch++) {
-        double total_loss = 0.0;
-        
-        for (int seq = 0; seq < data->num_sequences; seq++) {
-            // Forward pass
-            Matrix* prediction = lstm_network_predict(network, data->inputs[seq], data->sequence_length);
-            if (!prediction) continue;
-            
-            // Calculate loss
-            double loss = calculate_loss(prediction, data->targets[seq]);
-            total_loss += loss;
-            
-            // Simple gradient update (simplified for demonstration)
-            // In a full implementation, you would compute gradients through backpropagation
-            Matrix* error = matrix_subtract(data->targets[seq], prediction);
-            matrix_scale(error, network->learning_rate);
-            
-            // Update output weights (simplified)
-            Matrix* hidden_transpose = matrix_transpose(network->lstm_layer->hidden_state);
-            Matrix* weight_update = matrix_multiply(error, hidden_transpose);
-            Matrix* new_weights = matrix_add(network->W_output, weight_update);
-            matrix_copy(network->W_output, new_weights);
-            
-            matrix_free(prediction);
-            matrix_free(error);
-            matrix_free(hidden_transpose);
-            matrix_free(weight_update);
-            matrix_free(new_weights);
+    int batch_size = network->batch_size > 0 ? network->batch_size : 1;
+    if (batch_size > data->num_sequences) batch_size = data->num_sequences;
+    if (batch_size > 1) {
+        printf("Mini-batch size: %d sequences\n", batch_size);
+    }
+    
+    // Tape, gradients and scratch are allocated once for the whole run
+    BPTTTrainer* trainer = bptt_trainer_create(network, data->sequence_length, batch_size);
+    if (!trainer) {
+        printf("Error: Could not allocate training workspace\n");
+        return;
+    }
+    
+    // Stacked layers run as a wavefront, one worker per layer at most
+    int pipeline = network->pipeline_threads;
+    if (pipeline > network->num_layers) pipeline = network->num_layers;
+    if (pipeline > 1) {
+        trainer->pool = thread_pool_create(pipeline);
+        if (trainer->pool) {
+            printf("Layer pipeline: %d threads\n", pipeline);
         }
-        
-        double avg_loss = total_loss / data->num_sequences;
+    }
+    
+    int total_epochs = network->first_epoch + epochs;
+    for (int epoch = network->first_epoch; epoch < total_epochs; epoch++) {
+        double avg_loss = bptt_train_epoch(trainer, network, data) / data->num_sequences;
         if (epoch % 10 == 0) {
-            printf("Epoch %d: Average Loss = %.6f\n", epoch + 1, avg_loss);
+            printf("Epoch %d/%d: Average Loss = %.6f\n", epoch + 1, total_epochs, avg_loss);
+        }
+        if (network->epoch_callback) {
+            network->epoch_callback(network, epoch + 1, avg_loss, network->epoch_context);
         }
     }
     
+    arena_print_usage(trainer->arena, "Workspace arena");
+    thread_pool_free(trainer->pool);
+    bptt_trainer_free(trainer);
+    
     printf("Training completed.\n");
 }
 
-// Save model to file
-int save_lstm_model(LSTMNetwork* network, const char* filename) {
-    if (!network || !filename) return -1;
-    
-    FILE* file = fopen(filename, "wb");
-    if (!file) return -1;
-    
-    // Write network dimensions
-    fwrite(&network->input_size, sizeof(int), 1, file);
-    fwrite(&network->hidden_size, sizeof(int), 1, file);
-    fwrite(&network->output_size, sizeof(int), 1, file);
-    fwrite(&network->learning_rate, sizeof(double), 1, file);
-    fwrite(&network->sequence_length, sizeof(int), 1, file);
-    
-    // Write LSTM weights (simplified - would need full implementation)
-    // For demonstration, just write output layer
-    for (int i = 0; i < network->output_size; i++) {
-        fwrite(network->W_output->data[i], sizeof(double), network->hidden_size, file);
+// Per-feature affine map between two normalizations, x_from = scale * x_to +
+// offset. A feature with no range normalizes to the constant 0.5 on input
+// and denormalizes to its min on output.
+static void normalization_map(double from_min, double from_range, double to_min, double to_range,
+                              double* scale, double* offset) {
+    if (from_range > 0.0) {
+        *scale = to_range / from_range;
+        *offset = (to_min - from_min) / from_range;
+    } else {
+        *scale = 0.0;
+        *offset = 0.5;
     }
-    
-    for (int i = 0; i < network->output_size; i++) {
-        fwrite(&network->b_output->data[i][0], sizeof(double), 1, file);
+}
+
+int lstm_network_renormalize(LSTMNetwork* network, const NormalizationParams* params) {
+    if (!network || !params || !network->norm_params || network->input_size != WEATHER_NUM_FEATURES ||
+        network->output_size != WEATHER_NUM_FEATURES) {
+        return -1;
     }
     
-    // Write normalization parameters if available
-    int has_norm = (network->norm_params != NULL);
-    fwrite(&has_norm, sizeof(int), 1, file);
-    if (has_norm) {
-        fwrite(network->norm_params, sizeof(NormalizationParams), 1, file);
+    // Min/max pairs are stored in feature order
+    const double* from = (const double*)network->norm_params;
+    const double* to = (const double*)params;
+    Matrix* W = network->layers[0]->W;
+    Matrix* b = network->layers[0]->b;
+    
+    for (int j = 0; j < WEATHER_NUM_FEATURES; j++) {
+        double from_min = from[2 * j], from_range = from[2 * j + 1] - from[2 * j];
+        double to_min = to[2 * j], to_range = to[2 * j + 1] - to[2 * j];
+        
+        // Input: W x_from + b = (W scale) x_to + (b + W offset)
+        double scale, offset;
+        normalization_map(from_min, from_range, to_min, to_range, &scale, &offset);
+        for (int r = 0; r < W->rows; r++) {
+            MATRIX_AT(b, r, 0) += MATRIX_AT(W, r, j) * offset;
+            MATRIX_AT(W, r, j) *= scale;
+        }
+        
+        // Output: y_to = (y_from * from_range + from_min - to_min) / to_range
+        if (to_range > 0.0) {
+            double out_scale = from_range / to_range;
+            double out_offset = (from_min - to_min) / to_range;
+            double* row = MATRIX_ROW(network->W_output, j);
+            for (int k = 0; k < network->W_output->cols; k++) {
+                row[k] *= out_scale;
+            }
+            MATRIX_AT(network->b_output, j, 0) = MATRIX_AT(network->b_output, j, 0) * out_scale + out_offset;
+        }
     }
     
-    fclose(file);
+    *network->norm_params = *params;
     return 0;
 }
 
-// Load model from file
-LSTMNetwork* load_lstm_model(const char* filename) {
-    if (!filename) return NULL;
-    
-    FILE* file = fopen(filename, "rb");
-    if (!file) return NULL;
-    
+// Legacy model file: dimensions, output layer and normalization only. The
+// gate weights were never stored, so they come back freshly initialized.
+// The caller closes file.
+static LSTMNetwork* load_lstm_model_legacy(FILE* file) {
     int input_size, hidden_size, output_size, sequence_length;
     double learning_rate;
     
@@ -452,26 +712,24 @@ LSTMNetwork* load_lstm_model(const char* filename) {
         fread(&output_size, sizeof(int), 1, file) != 1 ||
         fread(&learning_rate, sizeof(double), 1, file) != 1 ||
         fread(&sequence_length, sizeof(int), 1, file) != 1) {
-        fclose(file);
         return NULL;
     }
     
     LSTMNetwork* network = lstm_network_create(input_size, hidden_size, output_size);
     if (!network) {
-        fclose(file);
         return NULL;
     }
     
     network->learning_rate = learning_rate;
     network->sequence_length = sequence_length;
+    printf("Warning: Legacy model file without gate weights; re-save it to keep them\n");
     
     // Read weights (simplified)
     for (int i = 0; i < output_size; i++) {
         if (fread(network->W_output->data[i], sizeof(double), (size_t)hidden_size, file) != (size_t)hidden_size) {
             printf("Error reading output weights\n");
             lstm_network_free(network);
-            fclose(file);
-            return NULL;
+                return NULL;
         }
     }
     
@@ -479,8 +737,7 @@ LSTMNetwork* load_lstm_model(const char* filename) {
         if (fread(&network->b_output->data[i][0], sizeof(double), 1, file) != 1) {
             printf("Error reading output bias\n");
             lstm_network_free(network);
-            fclose(file);
-            return NULL;
+                return NULL;
         }
     }
     
@@ -493,12 +750,334 @@ LSTMNetwork* load_lstm_model(const char* filename) {
             free(network->norm_params);
             network->norm_params = NULL;
             lstm_network_free(network);
-            fclose(file);
-            return NULL;
+                return NULL;
+        }
+    }
+    
+    return network;
+}
+
+
+// Round a file offset up to MATRIX_ALIGNMENT
+static uint64_t model_align(uint64_t offset) {
+    return (offset + MATRIX_ALIGNMENT - 1) & ~(uint64_t)(MATRIX_ALIGNMENT - 1);
+}
+
+// 64-bit FNV-1a over the blob, one 8-byte word at a time
+uint64_t lstm_model_checksum(const void* blob, size_t size) {
+    const unsigned char* bytes = blob;
+    uint64_t hash = 14695981039346656037ull;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Number of tensors stored for a network of num_layers layers
+static int model_num_tensors(int num_layers) {
+    return LSTM_MODEL_NUM_TENSORS + LSTM_MODEL_LAYER_TENSORS * (num_layers - 1);
+}
+
+// The tensors of a network in file order: the header table (bottom layer
+// and output layer, in LSTMModelTensor order), then W, U and b of each
+// layer above the bottom one
+static void model_tensors(LSTMNetwork* network, Matrix** tensors) {
+    tensors[LSTM_TENSOR_W] = network->lstm_layer->W;
+    tensors[LSTM_TENSOR_U] = network->lstm_layer->U;
+    tensors[LSTM_TENSOR_B] = network->lstm_layer->b;
+    tensors[LSTM_TENSOR_W_OUTPUT] = network->W_output;
+    tensors[LSTM_TENSOR_B_OUTPUT] = network->b_output;
+    for (int l = 1; l < network->num_layers; l++) {
+        Matrix** layer = tensors + LSTM_MODEL_NUM_TENSORS + LSTM_MODEL_LAYER_TENSORS * (l - 1);
+        layer[0] = network->layers[l]->W;
+        layer[1] = network->layers[l]->U;
+        layer[2] = network->layers[l]->b;
+    }
+}
+
+// Save model to file: header and layer table, then every tensor densely
+// packed at an aligned offset inside one checksummed blob, then any extra
+// section at the next aligned offset
+static int save_model_file(LSTMNetwork* network, const char* filename, const void* section,
+                           size_t section_size) {
+    if (!network || !filename) return -1;
+    
+    int num_tensors = model_num_tensors(network->num_layers);
+    int extra = num_tensors - LSTM_MODEL_NUM_TENSORS;
+    LSTMModelHeader header;
+    LSTMModelTensor table[LSTM_MODEL_LAYER_TENSORS * (LSTM_MAX_LAYERS - 1) + 1];
+    LSTMModelTensor* entries[LSTM_MODEL_NUM_TENSORS + LSTM_MODEL_LAYER_TENSORS * (LSTM_MAX_LAYERS - 1)];
+    memset(&header, 0, sizeof(header));
+    memset(table, 0, sizeof(table));
+    memcpy(header.magic, LSTM_MODEL_MAGIC, sizeof(header.magic));
+    header.version = LSTM_MODEL_VERSION;
+    header.byte_order = LSTM_MODEL_BYTE_ORDER;
+    header.dtype = LSTM_MODEL_DTYPE_F64;
+    header.num_tensors = (uint32_t)num_tensors;
+    header.num_layers = (uint32_t)network->num_layers;
+    header.input_size = network->input_size;
+    header.hidden_size = network->hidden_size;
+    header.output_size = network->output_size;
+    header.sequence_length = network->sequence_length;
+    header.learning_rate = network->learning_rate;
+    if (network->norm_params) {
+        header.has_norm_params = 1;
+        header.norm_params = *network->norm_params;
+    }
+    
+    Matrix* tensors[LSTM_MODEL_NUM_TENSORS + LSTM_MODEL_LAYER_TENSORS * (LSTM_MAX_LAYERS - 1)];
+    model_tensors(network, tensors);
+    for (int k = 0; k < num_tensors; k++) {
+        entries[k] = k < LSTM_MODEL_NUM_TENSORS ? &header.tensors[k] : &table[k - LSTM_MODEL_NUM_TENSORS];
+    }
+    size_t table_bytes = (size_t)extra * sizeof(LSTMModelTensor);
+    header.blob_offset = model_align(sizeof(header) + table_bytes);
+    uint64_t offset = header.blob_offset;
+    for (int k = 0; k < num_tensors; k++) {
+        entries[k]->offset = offset;
+        entries[k]->rows = (uint32_t)tensors[k]->rows;
+        entries[k]->cols = (uint32_t)tensors[k]->cols;
+        offset = model_align(offset + (uint64_t)tensors[k]->rows * tensors[k]->cols * sizeof(double));
+    }
+    header.blob_size = offset - header.blob_offset;
+    
+    // Stage the blob so the checksum covers exactly the bytes written
+    unsigned char* blob = calloc(1, (size_t)header.blob_size);
+    if (!blob) return -1;
+    for (int k = 0; k < num_tensors; k++) {
+        double* dst = (double*)(blob + (entries[k]->offset - header.blob_offset));
+        for (int i = 0; i < tensors[k]->rows; i++) {
+            memcpy(dst + (size_t)i * tensors[k]->cols, MATRIX_ROW(tensors[k], i),
+                   (size_t)tensors[k]->cols * sizeof(double));
+        }
+    }
+    header.checksum = lstm_model_checksum(blob, (size_t)header.blob_size);
+    
+    // Write a temporary file and rename it over the target, so a network
+    // still mapped from the old file keeps reading intact pages. The data
+    // reaches the disk before the rename, so after a crash the target is
+    // the old file or the new one, never a partial one.
+    size_t name_length = strlen(filename);
+    char* temp_name = malloc(name_length + 5);
+    if (!temp_name) {
+        free(blob);
+        return -1;
+    }
+    memcpy(temp_name, filename, name_length);
+    memcpy(temp_name + name_length, ".tmp", 5);
+    
+    FILE* file = fopen(temp_name, "wb");
+    if (!file) {
+        free(temp_name);
+        free(blob);
+        return -1;
+    }
+    
+    static const char padding[MATRIX_ALIGNMENT] = {0};
+    size_t pad = (size_t)header.blob_offset - sizeof(header) - table_bytes;
+    size_t section_pad = (size_t)(lstm_model_extra_offset(&header) - header.blob_offset - header.blob_size);
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(table, 1, table_bytes, file) == table_bytes &&
+             fwrite(padding, 1, pad, file) == pad &&
+             fwrite(blob, 1, (size_t)header.blob_size, file) == (size_t)header.blob_size;
+    if (ok && section_size > 0) {
+        ok = fwrite(padding, 1, section_pad, file) == section_pad &&
+             fwrite(section, 1, section_size, file) == section_size;
+    }
+    if (ok && (fflush(file) != 0 || fsync(fileno(file)) != 0)) ok = 0;
+    if (fclose(file) != 0) ok = 0;
+    if (ok && rename(temp_name, filename) != 0) ok = 0;
+    if (!ok) remove(temp_name);
+    free(temp_name);
+    free(blob);
+    
+    return ok ? 0 : -1;
+}
+
+uint64_t lstm_model_extra_offset(const LSTMModelHeader* header) {
+    return model_align(header->blob_offset + header->blob_size);
+}
+
+// Layers stored in a validated header
+static int model_num_layers(const LSTMModelHeader* header) {
+    return header->version == 1 ? 1 : (int)header->num_layers;
+}
+
+// Entry k of a mapped file's tensor table: the header's five, then the
+// layer table that follows the header
+static const LSTMModelTensor* model_entry(const LSTMModelHeader* header, int k) {
+    if (k < LSTM_MODEL_NUM_TENSORS) return &header->tensors[k];
+    return (const LSTMModelTensor*)(header + 1) + (k - LSTM_MODEL_NUM_TENSORS);
+}
+
+// Check a mapped header against the file it came from
+static int model_header_valid(const LSTMModelHeader* header, size_t file_size) {
+    if (header->version != 1 && header->version != LSTM_MODEL_VERSION) {
+        printf("Error: Unsupported model file version %u\n", header->version);
+        return 0;
+    }
+    int layers = model_num_layers(header);
+    if (layers < 1 || layers > LSTM_MAX_LAYERS) {
+        printf("Error: Model file has %d layers, at most %d are supported\n", layers, LSTM_MAX_LAYERS);
+        return 0;
+    }
+    if (header->byte_order != LSTM_MODEL_BYTE_ORDER || header->dtype != LSTM_MODEL_DTYPE_F64) {
+        printf("Error: Model file was written for another byte order or data type\n");
+        return 0;
+    }
+    if (header->num_tensors != (uint32_t)model_num_tensors(layers)) {
+        printf("Error: Corrupt model file tensor table\n");
+        return 0;
+    }
+    size_t table_end = sizeof(*header) + (size_t)(layers - 1) * LSTM_MODEL_LAYER_TENSORS * sizeof(LSTMModelTensor);
+    if (header->input_size <= 0 || header->hidden_size <= 0 || header->output_size <= 0 ||
+        header->sequence_length <= 0 || header->blob_offset % MATRIX_ALIGNMENT != 0 || header->blob_offset < table_end ||
+        header->blob_offset > file_size || header->blob_size > file_size - header->blob_offset) {
+        printf("Error: Corrupt model file header\n");
+        return 0;
+    }
+    
+    uint32_t G = (uint32_t)(LSTM_NUM_GATES * header->hidden_size);
+    uint32_t H = (uint32_t)header->hidden_size;
+    uint32_t O = (uint32_t)header->output_size;
+    uint64_t blob_end = header->blob_offset + header->blob_size;
+    for (int k = 0; k < (int)header->num_tensors; k++) {
+        // Header table: bottom layer and output layer; then W, U, b per upper layer
+        uint32_t rows = G, cols = 1;
+        if (k == LSTM_TENSOR_W) cols = (uint32_t)header->input_size;
+        else if (k == LSTM_TENSOR_U) cols = H;
+        else if (k == LSTM_TENSOR_W_OUTPUT) rows = O, cols = H;
+        else if (k == LSTM_TENSOR_B_OUTPUT) rows = O;
+        else if (k >= LSTM_MODEL_NUM_TENSORS && (k - LSTM_MODEL_NUM_TENSORS) % LSTM_MODEL_LAYER_TENSORS < 2) cols = H;
+        
+        const LSTMModelTensor* t = model_entry(header, k);
+        uint64_t bytes = (uint64_t)t->rows * t->cols * sizeof(double);
+        if (t->rows != rows || t->cols != cols || t->offset % MATRIX_ALIGNMENT != 0 ||
+            t->offset < header->blob_offset || t->offset > blob_end || bytes > blob_end - t->offset) {
+            printf("Error: Corrupt model file tensor table\n");
+            return 0;
         }
     }
     
+    return 1;
+}
+
+// Load model from file. Versioned files are mapped privately and the
+// weights used in place: pages are shared with other processes until a
+// training step writes to them. Legacy files are read the old way.
+static LSTMNetwork* load_model_file(const char* filename) {
+    if (!filename) return NULL;
+    
+    FILE* file = fopen(filename, "rb");
+    if (!file) return NULL;
+    
+    char magic[8];
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+        memcmp(magic, LSTM_MODEL_MAGIC, sizeof(magic)) != 0) {
+        rewind(file);
+        LSTMNetwork* network = load_lstm_model_legacy(file);
+        fclose(file);
+        return network;
+    }
+    
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0 || (size_t)st.st_size < sizeof(LSTMModelHeader)) {
+        printf("Error: Truncated model file %s\n", filename);
+        fclose(file);
+        return NULL;
+    }
+    size_t size = (size_t)st.st_size;
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(file), 0);
     fclose(file);
+    if (base == MAP_FAILED) {
+        printf("Error: Could not map model file %s\n", filename);
+        return NULL;
+    }
+    
+    const LSTMModelHeader* header = base;
+    if (!model_header_valid(header, size)) {
+        munmap(base, size);
+        return NULL;
+    }
+    unsigned char* bytes = base;
+    if (lstm_model_checksum(bytes + header->blob_offset, (size_t)header->blob_size) != header->checksum) {
+        printf("Error: Model file %s failed its checksum\n", filename);
+        munmap(base, size);
+        return NULL;
+    }
+    
+    // Every tensor is a dense view into the mapping
+    int layers = model_num_layers(header);
+    Matrix* tensors[LSTM_MODEL_NUM_TENSORS + LSTM_MODEL_LAYER_TENSORS * (LSTM_MAX_LAYERS - 1)];
+    for (int k = 0; k < (int)header->num_tensors; k++) {
+        const LSTMModelTensor* t = model_entry(header, k);
+        tensors[k] = matrix_wrap((double*)(bytes + t->offset), (int)t->rows, (int)t->cols, (int)t->cols);
+    }
+    LSTMCell* cells[LSTM_MAX_LAYERS];
+    cells[0] = lstm_cell_assemble(header->input_size, header->hidden_size, tensors[LSTM_TENSOR_W],
+                                  tensors[LSTM_TENSOR_U], tensors[LSTM_TENSOR_B]);
+    for (int l = 1; l < layers; l++) {
+        Matrix** layer = tensors + LSTM_MODEL_NUM_TENSORS + LSTM_MODEL_LAYER_TENSORS * (l - 1);
+        cells[l] = lstm_cell_assemble(header->hidden_size, header->hidden_size, layer[0], layer[1], layer[2]);
+    }
+    LSTMNetwork* network = lstm_network_assemble(cells, layers, tensors[LSTM_TENSOR_W_OUTPUT],
+                                                 tensors[LSTM_TENSOR_B_OUTPUT], header->input_size,
+                                                 header->hidden_size, header->output_size);
+    if (!network) {
+        munmap(base, size);
+        return NULL;
+    }
+    
+    network->learning_rate = header->learning_rate;
+    network->sequence_length = header->sequence_length;
+    if (header->has_norm_params) {
+        network->norm_params = malloc(sizeof(NormalizationParams));
+        if (!network->norm_params) {
+            lstm_network_free(network);
+            munmap(base, size);
+            return NULL;
+        }
+        *network->norm_params = header->norm_params;
+    }
+    network->map_base = base;
+    network->map_size = size;
+    
+    return network;
+}
+
+#ifdef WEATHER_LSTM_PROFILE
+// Model I/O moves the whole file
+static uint64_t model_file_bytes(const char* filename) {
+    struct stat st;
+    return stat(filename, &st) == 0 ? (uint64_t)st.st_size : 0;
+}
+#endif
+
+int save_lstm_model(LSTMNetwork* network, const char* filename) {
+    return save_lstm_model_extra(network, filename, NULL, 0);
+}
+
+int save_lstm_model_extra(LSTMNetwork* network, const char* filename, const void* extra, size_t extra_size) {
+    if (extra_size > 0 && !extra) return -1;
+    
+    PROFILE_BEGIN(PROFILE_MODEL_IO);
+    int status = save_model_file(network, filename, extra, extra_size);
+    PROFILE_WORK(PROFILE_MODEL_IO, 0, status == 0 ? model_file_bytes(filename) : 0);
+    PROFILE_END(PROFILE_MODEL_IO);
+    return status;
+}
+
+LSTMNetwork* load_lstm_model(const char* filename) {
+    PROFILE_BEGIN(PROFILE_MODEL_IO);
+    LSTMNetwork* network = load_model_file(filename);
+    PROFILE_WORK(PROFILE_MODEL_IO, 0, network ? model_file_bytes(filename) : 0);
+    PROFILE_END(PROFILE_MODEL_IO);
     return network;
 }
 
@@ -510,27 +1089,18 @@ WeatherPoint lstm_predict_next(LSTMNetwork* network, WeatherDataset* recent_data
         return result;
     }
     
-    // Create input sequence from most recent data
-    Matrix** sequence = malloc(seq_length * sizeof(Matrix*));
-    if (!sequence) return result;
+    size_t mark = arena_mark(network->scratch);
+    Matrix* prediction = matrix_create_in(network->scratch, network->output_size, 1);
+    if (!prediction) return result;
     
-    int start_idx = recent_data->size - seq_length;
-    for (int i = 0; i < seq_length; i++) {
-        sequence[i] = weather_point_to_matrix(&recent_data->data[start_idx + i]);
-    }
-    
-    // Make prediction
-    Matrix* prediction = lstm_network_predict(network, sequence, seq_length);
-    if (prediction) {
+    // Read the most recent window in place
+    double* window = weather_dataset_features(recent_data) +
+                     (size_t)(recent_data->size - seq_length) * WEATHER_NUM_FEATURES;
+    if (lstm_network_predict_window(network, window, seq_length, prediction) == 0) {
         result = matrix_to_weather_point(prediction);
-        matrix_free(prediction);
-    }
-    
-    // Clean up
-    for (int i = 0; i < seq_length; i++) {
-        matrix_free(sequence[i]);
     }
-    free(sequence);
+    matrix_free(prediction);
+    arena_release(network->scratch, mark);
     
     return result;
 }
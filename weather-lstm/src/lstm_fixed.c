@@ -0,0 +1,73 @@
+#include "../include/lstm_fixed.h"
+#include "../include/matrix_kernels.h"
+
+// Generates lstm_fixed_step_6x<HS>. W is [4H x 6], U [4H x H], both with
+// rows back to back.
+#define LSTM_FIXED_STEP(HS)                                                                     \
+static void lstm_fixed_step_6x##HS(const double* W, const double* U, const double* b,            \
+                                   const double* x, const double* h_prev, const double* c_prev,  \
+                                   double* gates, double* c_out, double* c_tanh,                 \
+                                   double* h_out) {                                              \
+    enum { H = HS, G = LSTM_NUM_GATES * HS };                                                    \
+    const double x0 = x[0], x1 = x[1], x2 = x[2], x3 = x[3], x4 = x[4], x5 = x[5];               \
+                                                                                                 \
+    /* gates = W x + b, two partial sums per row to halve the dependency chain */                \
+    for (int r = 0; r < G; r++) {                                                                \
+        const double* w = W + r * LSTM_FIXED_INPUT_SIZE;                                         \
+        double even = b[r] + w[0] * x0 + w[2] * x2 + w[4] * x4;                                  \
+        double odd = w[1] * x1 + w[3] * x3 + w[5] * x5;                                          \
+        gates[r] = even + odd;                                                                   \
+    }                                                                                            \
+                                                                                                 \
+    /* gates += U h_{t-1} before any state is written */                                         \
+    const MatrixKernels* k = matrix_kernels();                                                   \
+    k->gemv(G, H, U, H, h_prev, gates, 1);                                                       \
+                                                                                                 \
+    double* f = gates + LSTM_GATE_FORGET * H;                                                    \
+    double* in = gates + LSTM_GATE_INPUT * H;                                                    \
+    double* g = gates + LSTM_GATE_CANDIDATE * H;                                                 \
+    double* o = gates + LSTM_GATE_OUTPUT * H;                                                    \
+    double* t = c_tanh ? c_tanh : h_out;                                                         \
+    k->sigmoid(2 * H, f);                                                                        \
+    k->tanh(H, g);                                                                               \
+    k->sigmoid(H, o);                                                                            \
+                                                                                                 \
+    for (int i = 0; i < H; i++) {                                                                \
+        double c = f[i] * c_prev[i] + in[i] * g[i];                                              \
+        c_out[i] = c;                                                                            \
+        t[i] = c;                                                                                \
+    }                                                                                            \
+    k->tanh(H, t);                                                                               \
+    for (int i = 0; i < H; i++) {                                                                \
+        h_out[i] = o[i] * t[i];                                                                  \
+    }                                                                                            \
+}
+
+LSTM_FIXED_STEP(32)
+LSTM_FIXED_STEP(64)
+LSTM_FIXED_STEP(128)
+LSTM_FIXED_STEP(256)
+
+static int fixed_enabled = -1;   // -1 until the environment has been read
+
+int lstm_fixed_set_enabled(int enabled) {
+    int previous = lstm_fixed_step_lookup(LSTM_FIXED_INPUT_SIZE, 32) != NULL;
+    fixed_enabled = enabled ? 1 : 0;
+    return previous;
+}
+
+LSTMFixedStep lstm_fixed_step_lookup(int input_size, int hidden_size) {
+    if (fixed_enabled < 0) {
+        const char* env = getenv("WEATHER_LSTM_FIXED");
+        fixed_enabled = !(env && strcmp(env, "0") == 0);
+    }
+    if (!fixed_enabled || input_size != LSTM_FIXED_INPUT_SIZE) return NULL;
+    
+    switch (hidden_size) {
+        case 32:  return lstm_fixed_step_6x32;
+        case 64:  return lstm_fixed_step_6x64;
+        case 128: return lstm_fixed_step_6x128;
+        case 256: return lstm_fixed_step_6x256;
+        default:  return NULL;
+    }
+}
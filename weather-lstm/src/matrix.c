@@ -1,42 +1,154 @@
+#define _POSIX_C_SOURCE 200112L
 #include "../include/matrix.h"
+#include "../include/matrix_kernels.h"
+#include "../include/arena.h"
+#include "../include/large_alloc.h"
+#include "../include/profile.h"
+
+// Bytes needed for a rows x stride element buffer, rounded up to the alignment
+static size_t matrix_storage_bytes(int rows, int stride) {
+    size_t bytes = (size_t)rows * (size_t)stride * sizeof(double);
+    size_t rounded = (bytes + MATRIX_ALIGNMENT - 1) & ~((size_t)MATRIX_ALIGNMENT - 1);
+    return rounded > 0 ? rounded : MATRIX_ALIGNMENT;
+}
+
+// Rows follow each other without padding, so the elements are one flat run
+static int matrix_is_dense(const Matrix* m) {
+    return m->stride == m->cols || m->rows <= 1;
+}
 
 // Create a new matrix
 Matrix* matrix_create(int rows, int cols) {
-    Matrix* m = malloc(sizeof(Matrix));
+    if (rows < 0 || cols < 0) return NULL;
+    
+    // Struct and row table share one block; elements get their own aligned block
+    Matrix* m = malloc(sizeof(Matrix) + (size_t)rows * sizeof(double*));
     if (!m) return NULL;
+    PROFILE_ALLOC();
     
     m->rows = rows;
     m->cols = cols;
-    m->data = malloc(rows * sizeof(double*));
-    if (!m->data) {
+    m->stride = cols;
+    m->owns_storage = 1;
+    m->in_arena = 0;
+    m->data = (double**)(m + 1);
+    
+    // Zero-filled; large buffers are not touched until first use (large_alloc.h)
+    void* storage = large_alloc(matrix_storage_bytes(rows, m->stride));
+    if (!storage) {
         free(m);
         return NULL;
     }
+    m->storage = storage;
     
     for (int i = 0; i < rows; i++) {
-        m->data[i] = calloc(cols, sizeof(double));
-        if (!m->data[i]) {
-            // Clean up on failure
-            for (int j = 0; j < i; j++) {
-                free(m->data[j]);
-            }
-            free(m->data);
-            free(m);
-            return NULL;
-        }
+        m->data[i] = MATRIX_ROW(m, i);
+    }
+    
+    return m;
+}
+
+// Create a view over existing row-major storage; the view does not own it
+Matrix* matrix_wrap(double* storage, int rows, int cols, int stride) {
+    if (!storage || rows < 0 || cols < 0 || stride < cols) return NULL;
+    
+    Matrix* m = malloc(sizeof(Matrix) + (size_t)rows * sizeof(double*));
+    if (!m) return NULL;
+    PROFILE_ALLOC();
+    
+    m->rows = rows;
+    m->cols = cols;
+    m->stride = stride;
+    m->owns_storage = 0;
+    m->in_arena = 0;
+    m->storage = storage;
+    m->data = (double**)(m + 1);
+    
+    for (int i = 0; i < rows; i++) {
+        m->data[i] = MATRIX_ROW(m, i);
+    }
+    
+    return m;
+}
+
+// Struct and row table from the arena, laid out as in matrix_create
+static Matrix* matrix_header_in(Arena* arena, double* storage, int rows, int cols, int stride) {
+    Matrix* m = arena_alloc(arena, arena_view_bytes(rows));
+    if (!m) return NULL;
+    
+    m->rows = rows;
+    m->cols = cols;
+    m->stride = stride;
+    m->owns_storage = 0;
+    m->in_arena = 1;
+    m->storage = storage;
+    m->data = (double**)(m + 1);
+    for (int i = 0; i < rows; i++) {
+        m->data[i] = MATRIX_ROW(m, i);
+    }
+    
+    return m;
+}
+
+// Zeroed matrix whose struct and elements come from the arena
+Matrix* matrix_create_in(Arena* arena, int rows, int cols) {
+    if (rows < 0 || cols < 0) return NULL;
+    if (!arena) return matrix_create(rows, cols);
+    
+    size_t mark = arena_mark(arena);
+    size_t bytes = (size_t)rows * (size_t)cols * sizeof(double);
+    double* storage = arena_alloc(arena, bytes);
+    Matrix* m = storage ? matrix_header_in(arena, storage, rows, cols, cols) : NULL;
+    if (!m) {
+        arena_release(arena, mark);
+        arena->overflows++;
+        return matrix_create(rows, cols);
+    }
+    memset(storage, 0, bytes);
+    
+    return m;
+}
+
+// View whose struct comes from the arena
+Matrix* matrix_wrap_in(Arena* arena, double* storage, int rows, int cols, int stride) {
+    if (!storage || rows < 0 || cols < 0 || stride < cols) return NULL;
+    if (!arena) return matrix_wrap(storage, rows, cols, stride);
+    
+    Matrix* m = matrix_header_in(arena, storage, rows, cols, stride);
+    if (!m) {
+        arena->overflows++;
+        return matrix_wrap(storage, rows, cols, stride);
     }
     
     return m;
 }
 
+// Create a view of rows [first_row, first_row + rows) of parent
+Matrix* matrix_view_rows(Matrix* parent, int first_row, int rows) {
+    if (!parent || first_row < 0 || rows < 0 || first_row + rows > parent->rows) return NULL;
+    
+    return matrix_wrap(MATRIX_ROW(parent, first_row), rows, parent->cols, parent->stride);
+}
+
+// Repoint a view at another buffer of the same shape, without allocating
+int matrix_rebind(Matrix* view, double* storage) {
+    if (!view || !storage || view->owns_storage) return -1;
+    
+    view->storage = storage;
+    for (int i = 0; i < view->rows; i++) {
+        view->data[i] = MATRIX_ROW(view, i);
+    }
+    
+    return 0;
+}
+
 // Free matrix memory
 void matrix_free(Matrix* m) {
-    if (!m) return;
+    if (!m || m->in_arena) return;
     
-    for (int i = 0; i < m->rows; i++) {
-        free(m->data[i]);
+    if (m->owns_storage) {
+        large_free(m->storage);
     }
-    free(m->data);
     free(m);
 }
 
@@ -45,9 +157,7 @@ void matrix_zero(Matrix* m) {
     if (!m) return;
     
     for (int i = 0; i < m->rows; i++) {
-        for (int j = 0; j < m->cols; j++) {
-            m->data[i][j] = 0.0;
-        }
+        memset(MATRIX_ROW(m, i), 0, (size_t)m->cols * sizeof(double));
     }
 }
 
@@ -56,9 +166,10 @@ void matrix_random(Matrix* m, double min, double max) {
     if (!m) return;
     
     for (int i = 0; i < m->rows; i++) {
+        double* row = MATRIX_ROW(m, i);
         for (int j = 0; j < m->cols; j++) {
             double random = (double)rand() / RAND_MAX;
-            m->data[i][j] = min + random * (max - min);
+            row[j] = min + random * (max - min);
         }
     }
 }
@@ -70,9 +181,7 @@ void matrix_copy(Matrix* dest, Matrix* src) {
     }
     
     for (int i = 0; i < src->rows; i++) {
-        for (int j = 0; j < src->cols; j++) {
-            dest->data[i][j] = src->data[i][j];
-        }
+        memcpy(MATRIX_ROW(dest, i), MATRIX_ROW(src, i), (size_t)src->cols * sizeof(double));
     }
 }
 
@@ -85,16 +194,7 @@ Matrix* matrix_multiply(Matrix* a, Matrix* b) {
     Matrix* result = matrix_create(a->rows, b->cols);
     if (!result) return NULL;
     
-    for (int i = 0; i < a->rows; i++) {
-        for (int j = 0; j < b->cols; j++) {
-            double sum = 0.0;
-            for (int k = 0; k < a->cols; k++) {
-                sum += a->data[i][k] * b->data[k][j];
-            }
-            result->data[i][j] = sum;
-        }
-    }
-    
+    matrix_multiply_into(result, a, b);
     return result;
 }
 
@@ -107,12 +207,7 @@ Matrix* matrix_add(Matrix* a, Matrix* b) {
     Matrix* result = matrix_create(a->rows, a->cols);
     if (!result) return NULL;
     
-    for (int i = 0; i < a->rows; i++) {
-        for (int j = 0; j < a->cols; j++) {
-            result->data[i][j] = a->data[i][j] + b->data[i][j];
-        }
-    }
-    
+    matrix_add_into(result, a, b);
     return result;
 }
 
@@ -125,12 +220,7 @@ Matrix* matrix_subtract(Matrix* a, Matrix* b) {
     Matrix* result = matrix_create(a->rows, a->cols);
     if (!result) return NULL;
     
-    for (int i = 0; i < a->rows; i++) {
-        for (int j = 0; j < a->cols; j++) {
-            result->data[i][j] = a->data[i][j] - b->data[i][j];
-        }
-    }
-    
+    matrix_subtract_into(result, a, b);
     return result;
 }
 
@@ -141,23 +231,277 @@ Matrix* matrix_transpose(Matrix* m) {
     Matrix* result = matrix_create(m->cols, m->rows);
     if (!result) return NULL;
     
+    matrix_transpose_into(result, m);
+    return result;
+}
+
+// dest = a * b
+int matrix_multiply_into(Matrix* dest, Matrix* a, Matrix* b) {
+    if (!dest || !a || !b || a->cols != b->rows ||
+        dest->rows != a->rows || dest->cols != b->cols || dest == a || dest == b) {
+        return -1;
+    }
+    
+    const MatrixKernels* k = matrix_kernels();
+    if (b->cols == 1 && b->stride == 1 && dest->stride == 1) {
+        k->gemv(a->rows, a->cols, a->storage, a->stride, b->storage, dest->storage, 0);
+    } else {
+        k->gemm(a->rows, b->cols, a->cols, a->storage, a->stride, b->storage, b->stride,
+                dest->storage, dest->stride, 0);
+    }
+    
+    return 0;
+}
+
+// dest = a + b
+int matrix_add_into(Matrix* dest, Matrix* a, Matrix* b) {
+    if (!dest || !a || !b || a->rows != b->rows || a->cols != b->cols ||
+        dest->rows != a->rows || dest->cols != a->cols) {
+        return -1;
+    }
+    
+    const MatrixKernels* k = matrix_kernels();
+    if (matrix_is_dense(dest) && matrix_is_dense(a) && matrix_is_dense(b)) {
+        k->add(a->rows * a->cols, a->storage, b->storage, dest->storage);
+        return 0;
+    }
+    
+    for (int i = 0; i < a->rows; i++) {
+        k->add(a->cols, MATRIX_ROW(a, i), MATRIX_ROW(b, i), MATRIX_ROW(dest, i));
+    }
+    
+    return 0;
+}
+
+// dest = a - b
+int matrix_subtract_into(Matrix* dest, Matrix* a, Matrix* b) {
+    if (!dest || !a || !b || a->rows != b->rows || a->cols != b->cols ||
+        dest->rows != a->rows || dest->cols != a->cols) {
+        return -1;
+    }
+    
+    for (int i = 0; i < a->rows; i++) {
+        const double* a_row = MATRIX_ROW(a, i);
+        const double* b_row = MATRIX_ROW(b, i);
+        double* d_row = MATRIX_ROW(dest, i);
+        for (int j = 0; j < a->cols; j++) {
+            d_row[j] = a_row[j] - b_row[j];
+        }
+    }
+    
+    return 0;
+}
+
+// dest = a .* b (elementwise product)
+int matrix_hadamard_into(Matrix* dest, Matrix* a, Matrix* b) {
+    if (!dest || !a || !b || a->rows != b->rows || a->cols != b->cols ||
+        dest->rows != a->rows || dest->cols != a->cols) {
+        return -1;
+    }
+    
+    for (int i = 0; i < a->rows; i++) {
+        const double* a_row = MATRIX_ROW(a, i);
+        const double* b_row = MATRIX_ROW(b, i);
+        double* d_row = MATRIX_ROW(dest, i);
+        for (int j = 0; j < a->cols; j++) {
+            d_row[j] = a_row[j] * b_row[j];
+        }
+    }
+    
+    return 0;
+}
+
+// dest = m^T
+int matrix_transpose_into(Matrix* dest, Matrix* m) {
+    if (!dest || !m || dest->rows != m->cols || dest->cols != m->rows || dest == m) {
+        return -1;
+    }
+    
     for (int i = 0; i < m->rows; i++) {
+        const double* m_row = MATRIX_ROW(m, i);
         for (int j = 0; j < m->cols; j++) {
-            result->data[j][i] = m->data[i][j];
+            MATRIX_AT(dest, j, i) = m_row[j];
         }
     }
     
-    return result;
+    return 0;
+}
+
+// dest = a^T * b, without materializing a^T
+int matrix_multiply_at_into(Matrix* dest, Matrix* a, Matrix* b) {
+    if (!dest || !a || !b || a->rows != b->rows ||
+        dest->rows != a->cols || dest->cols != b->cols || dest == a || dest == b) {
+        return -1;
+    }
+    
+    matrix_zero(dest);
+    
+    // Row r of a scatters into dest weighted by row r of b
+    const MatrixKernels* k = matrix_kernels();
+    if (b->cols == 1 && b->stride == 1 && dest->stride == 1) {
+        for (int r = 0; r < a->rows; r++) {
+            k->axpy(a->cols, b->storage[r], MATRIX_ROW(a, r), dest->storage);
+        }
+        return 0;
+    }
+    
+    for (int r = 0; r < a->rows; r++) {
+        const double* a_row = MATRIX_ROW(a, r);
+        const double* b_row = MATRIX_ROW(b, r);
+        for (int j = 0; j < a->cols; j++) {
+            k->axpy(b->cols, a_row[j], b_row, MATRIX_ROW(dest, j));
+        }
+    }
+    
+    return 0;
+}
+
+// dest += scale * a * b^T, without materializing b^T
+int matrix_outer_accumulate(Matrix* dest, Matrix* a, Matrix* b, double scale) {
+    if (!dest || !a || !b || a->cols != b->cols ||
+        dest->rows != a->rows || dest->cols != b->rows) {
+        return -1;
+    }
+    
+    const MatrixKernels* kernels = matrix_kernels();
+    
+    for (int i = 0; i < a->rows; i++) {
+        const double* a_row = MATRIX_ROW(a, i);
+        double* d_row = MATRIX_ROW(dest, i);
+        for (int k = 0; k < a->cols; k++) {
+            double a_ik = scale * a_row[k];
+            if (b->cols == 1 && b->stride == 1) {
+                kernels->axpy(b->rows, a_ik, b->storage, d_row);
+            } else {
+                for (int j = 0; j < b->rows; j++) {
+                    d_row[j] += a_ik * MATRIX_AT(b, j, k);
+                }
+            }
+        }
+    }
+    
+    return 0;
+}
+
+// dest = W * x + bias for a column vector x
+int gemv_add_bias_into(Matrix* dest, Matrix* W, Matrix* x, Matrix* bias) {
+    if (!dest || !W || !x || !bias || x->cols != 1 || W->cols != x->rows ||
+        dest->rows != W->rows || dest->cols != 1 ||
+        bias->rows != W->rows || bias->cols != 1 || dest == x) {
+        return -1;
+    }
+    
+    if (x->stride == 1 && dest->stride == 1 && bias->stride == 1) {
+        memcpy(dest->storage, bias->storage, (size_t)W->rows * sizeof(double));
+        matrix_kernels()->gemv(W->rows, W->cols, W->storage, W->stride, x->storage, dest->storage, 1);
+        return 0;
+    }
+    
+    for (int i = 0; i < W->rows; i++) {
+        const double* w_row = MATRIX_ROW(W, i);
+        double sum = MATRIX_AT(bias, i, 0);
+        for (int k = 0; k < W->cols; k++) {
+            sum += w_row[k] * MATRIX_AT(x, k, 0);
+        }
+        MATRIX_AT(dest, i, 0) = sum;
+    }
+    
+    return 0;
+}
+
+// dest += W * x for a column vector x
+int gemv_accumulate_into(Matrix* dest, Matrix* W, Matrix* x) {
+    if (!dest || !W || !x || x->cols != 1 || W->cols != x->rows ||
+        dest->rows != W->rows || dest->cols != 1 || dest == x) {
+        return -1;
+    }
+    
+    if (x->stride == 1 && dest->stride == 1) {
+        matrix_kernels()->gemv(W->rows, W->cols, W->storage, W->stride, x->storage, dest->storage, 1);
+        return 0;
+    }
+    
+    for (int i = 0; i < W->rows; i++) {
+        const double* w_row = MATRIX_ROW(W, i);
+        double sum = 0.0;
+        for (int k = 0; k < W->cols; k++) {
+            sum += w_row[k] * MATRIX_AT(x, k, 0);
+        }
+        MATRIX_AT(dest, i, 0) += sum;
+    }
+    
+    return 0;
+}
+
+// dest = W * X + bias, with the bias column added to every column of X
+int gemm_add_bias_into(Matrix* dest, Matrix* W, Matrix* X, Matrix* bias) {
+    if (!dest || !W || !X || !bias || W->cols != X->rows || dest->rows != W->rows ||
+        dest->cols != X->cols || bias->rows != W->rows || bias->cols != 1 || dest == X) {
+        return -1;
+    }
+    
+    if (X->cols == 1) {
+        return gemv_add_bias_into(dest, W, X, bias);
+    }
+    
+    for (int i = 0; i < dest->rows; i++) {
+        double b_i = MATRIX_AT(bias, i, 0);
+        double* d_row = MATRIX_ROW(dest, i);
+        for (int j = 0; j < dest->cols; j++) {
+            d_row[j] = b_i;
+        }
+    }
+    matrix_kernels()->gemm(W->rows, X->cols, W->cols, W->storage, W->stride, X->storage, X->stride,
+                           dest->storage, dest->stride, 1);
+    return 0;
+}
+
+// dest += W * X
+int gemm_accumulate_into(Matrix* dest, Matrix* W, Matrix* X) {
+    if (!dest || !W || !X || W->cols != X->rows || dest->rows != W->rows ||
+        dest->cols != X->cols || dest == X) {
+        return -1;
+    }
+    
+    if (X->cols == 1) {
+        return gemv_accumulate_into(dest, W, X);
+    }
+    
+    matrix_kernels()->gemm(W->rows, X->cols, W->cols, W->storage, W->stride, X->storage, X->stride,
+                           dest->storage, dest->stride, 1);
+    return 0;
+}
+
+// dest[i] += sum of row i of a
+int matrix_accumulate_row_sums(Matrix* dest, Matrix* a) {
+    if (!dest || !a || dest->rows != a->rows || dest->cols != 1) {
+        return -1;
+    }
+    
+    for (int i = 0; i < a->rows; i++) {
+        const double* a_row = MATRIX_ROW(a, i);
+        double sum = 0.0;
+        for (int j = 0; j < a->cols; j++) {
+            sum += a_row[j];
+        }
+        MATRIX_AT(dest, i, 0) += sum;
+    }
+    
+    return 0;
 }
 
 // Scale matrix by scalar
 void matrix_scale(Matrix* m, double scalar) {
     if (!m) return;
     
+    const MatrixKernels* k = matrix_kernels();
+    if (matrix_is_dense(m)) {
+        k->scale(m->rows * m->cols, scalar, m->storage);
+        return;
+    }
+    
     for (int i = 0; i < m->rows; i++) {
-        for (int j = 0; j < m->cols; j++) {
-            m->data[i][j] *= scalar;
-        }
+        k->scale(m->cols, scalar, MATRIX_ROW(m, i));
     }
 }
 
@@ -171,7 +515,7 @@ void matrix_print(Matrix* m) {
     printf("Matrix %dx%d:\n", m->rows, m->cols);
     for (int i = 0; i < m->rows; i++) {
         for (int j = 0; j < m->cols; j++) {
-            printf("%8.4f ", m->data[i][j]);
+            printf("%8.4f ", MATRIX_AT(m, i, j));
         }
         printf("\n");
     }
@@ -182,7 +526,7 @@ double matrix_get(Matrix* m, int row, int col) {
     if (!m || row < 0 || row >= m->rows || col < 0 || col >= m->cols) {
         return 0.0;
     }
-    return m->data[row][col];
+    return MATRIX_AT(m, row, col);
 }
 
 // Set element
@@ -190,7 +534,7 @@ void matrix_set(Matrix* m, int row, int col, double value) {
     if (!m || row < 0 || row >= m->rows || col < 0 || col >= m->cols) {
         return;
     }
-    m->data[row][col] = value;
+    MATRIX_AT(m, row, col) = value;
 }
 
 // Activation functions
@@ -210,20 +554,28 @@ double relu(double x) {
 void apply_sigmoid(Matrix* m) {
     if (!m) return;
     
+    const MatrixKernels* k = matrix_kernels();
+    if (matrix_is_dense(m)) {
+        k->sigmoid(m->rows * m->cols, m->storage);
+        return;
+    }
+    
     for (int i = 0; i < m->rows; i++) {
-        for (int j = 0; j < m->cols; j++) {
-            m->data[i][j] = sigmoid(m->data[i][j]);
-        }
+        k->sigmoid(m->cols, MATRIX_ROW(m, i));
     }
 }
 
 void apply_tanh(Matrix* m) {
     if (!m) return;
     
+    const MatrixKernels* k = matrix_kernels();
+    if (matrix_is_dense(m)) {
+        k->tanh(m->rows * m->cols, m->storage);
+        return;
+    }
+    
     for (int i = 0; i < m->rows; i++) {
-        for (int j = 0; j < m->cols; j++) {
-            m->data[i][j] = tanh_activation(m->data[i][j]);
-        }
+        k->tanh(m->cols, MATRIX_ROW(m, i));
     }
 }
 
@@ -231,8 +583,9 @@ void apply_relu(Matrix* m) {
     if (!m) return;
     
     for (int i = 0; i < m->rows; i++) {
+        double* row = MATRIX_ROW(m, i);
         for (int j = 0; j < m->cols; j++) {
-            m->data[i][j] = relu(m->data[i][j]);
+            row[j] = relu(row[j]);
         }
     }
 }
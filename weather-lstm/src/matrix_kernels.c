@@ -0,0 +1,1340 @@
+#include "../include/matrix_kernels.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MATRIX_KERNELS_X86 1
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define MATRIX_KERNELS_NEON 1
+#endif
+
+// exp(x) = 2^k * exp(r) with |r| <= ln(2)/2 and a degree-11 polynomial for
+// exp(r); the truncation error is below 1e-14 relative. Inputs are clamped
+// so 2^k stays a normal double.
+#define EXP_LO -708.0
+#define EXP_HI 709.0
+#define LOG2E 1.44269504088896338700e+00
+#define LN2_HI 6.93147180369123816490e-01
+#define LN2_LO 1.90821492927058770002e-10
+#define EXP_C2 5.00000000000000000000e-01
+#define EXP_C3 1.66666666666666666667e-01
+#define EXP_C4 4.16666666666666666667e-02
+#define EXP_C5 8.33333333333333333333e-03
+#define EXP_C6 1.38888888888888888889e-03
+#define EXP_C7 1.98412698412698412698e-04
+#define EXP_C8 2.48015873015873015873e-05
+#define EXP_C9 2.75573192239858906526e-06
+#define EXP_C10 2.75573192239858906526e-07
+#define EXP_C11 2.50521083854417187751e-08
+
+// ---------------------------------------------------------------------------
+// Portable scalar kernels
+// ---------------------------------------------------------------------------
+
+static void scalar_gemv(int m, int n, const double* A, int lda, const double* x, double* y, int accumulate) {
+    for (int i = 0; i < m; i++) {
+        const double* a = A + (size_t)i * lda;
+        double sum = 0.0;
+        for (int k = 0; k < n; k++) {
+            sum += a[k] * x[k];
+        }
+        y[i] = accumulate ? y[i] + sum : sum;
+    }
+}
+
+static void scalar_gemm(int m, int n, int k, const double* A, int lda, const double* B, int ldb,
+                        double* C, int ldc, int accumulate) {
+    for (int i = 0; i < m; i++) {
+        const double* a = A + (size_t)i * lda;
+        double* c = C + (size_t)i * ldc;
+        if (!accumulate) {
+            memset(c, 0, (size_t)n * sizeof(double));
+        }
+        for (int kk = 0; kk < k; kk++) {
+            double a_ik = a[kk];
+            const double* b = B + (size_t)kk * ldb;
+            for (int j = 0; j < n; j++) {
+                c[j] += a_ik * b[j];
+            }
+        }
+    }
+}
+
+static void scalar_add(int n, const double* a, const double* b, double* out) {
+    for (int i = 0; i < n; i++) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+static void scalar_axpy(int n, double alpha, const double* x, double* y) {
+    for (int i = 0; i < n; i++) {
+        y[i] += alpha * x[i];
+    }
+}
+
+static void scalar_scale(int n, double alpha, double* x) {
+    for (int i = 0; i < n; i++) {
+        x[i] *= alpha;
+    }
+}
+
+static void scalar_sigmoid(int n, double* x) {
+    for (int i = 0; i < n; i++) {
+        x[i] = 1.0 / (1.0 + exp(-x[i]));
+    }
+}
+
+static void scalar_tanh(int n, double* x) {
+    for (int i = 0; i < n; i++) {
+        x[i] = tanh(x[i]);
+    }
+}
+
+static void scalar_minmax(int n, const double* x, double* min, double* max) {
+    double lo = x[0], hi = x[0];
+    for (int i = 1; i < n; i++) {
+        if (x[i] < lo) lo = x[i];
+        if (x[i] > hi) hi = x[i];
+    }
+    *min = lo;
+    *max = hi;
+}
+
+static void scalar_rescale(int n, double* x, double shift, double divisor) {
+    for (int i = 0; i < n; i++) {
+        x[i] = (x[i] - shift) / divisor;
+    }
+}
+
+static void scalar_affine(int n, double* x, double scale, double shift) {
+    for (int i = 0; i < n; i++) {
+        x[i] = x[i] * scale + shift;
+    }
+}
+
+static void scalar_gemv_f32(int m, int n, const float* At, int lda, const float* x, float* y, int accumulate) {
+    if (!accumulate) memset(y, 0, (size_t)m * sizeof(float));
+    for (int k = 0; k < n; k++) {
+        const float* a = At + (size_t)k * lda;
+        for (int i = 0; i < m; i++) {
+            y[i] += a[i] * x[k];
+        }
+    }
+}
+
+static void scalar_gemv_i8(int m, int n, const int8_t* At, int lda, const float* scale, const float* x,
+                           float* y, int accumulate) {
+    for (int i = 0; i < m; i++) {
+        float sum = 0.0f;
+        for (int k = 0; k < n; k++) {
+            sum += (float)At[(size_t)k * lda + i] * x[k];
+        }
+        sum *= scale[i];
+        y[i] = accumulate ? y[i] + sum : sum;
+    }
+}
+
+static void scalar_momentum(int n, double step, double gscale, double mu, const double* g, double* v, double* w) {
+    for (int i = 0; i < n; i++) {
+        v[i] = mu * v[i] + gscale * g[i];
+        w[i] -= step * v[i];
+    }
+}
+
+static void scalar_adam(int n, double step, double gscale, double beta1, double beta2, double epsilon,
+                        double v_correction, const double* g, double* m, double* v, double* w) {
+    double c1 = 1.0 - beta1, c2 = 1.0 - beta2;
+    for (int i = 0; i < n; i++) {
+        double gi = gscale * g[i];
+        m[i] = beta1 * m[i] + c1 * gi;
+        v[i] = beta2 * v[i] + c2 * (gi * gi);
+        w[i] -= step * m[i] / (sqrt(v[i] * v_correction) + epsilon);
+    }
+}
+
+static double scalar_sumsq(int n, const double* x) {
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        sum += x[i] * x[i];
+    }
+    return sum;
+}
+
+static const MatrixKernels scalar_kernels = {
+    "scalar",
+    scalar_gemv,
+    scalar_gemm,
+    scalar_add,
+    scalar_axpy,
+    scalar_scale,
+    scalar_sigmoid,
+    scalar_tanh,
+    scalar_minmax,
+    scalar_rescale,
+    scalar_affine,
+    scalar_gemv_f32,
+    scalar_gemv_i8,
+    scalar_momentum,
+    scalar_adam,
+    scalar_sumsq
+};
+
+#ifdef MATRIX_KERNELS_X86
+
+// ---------------------------------------------------------------------------
+// AVX2 + FMA kernels (4 doubles per vector)
+// ---------------------------------------------------------------------------
+
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+
+AVX2_TARGET static inline double avx2_hsum(__m256d v) {
+    __m128d lo = _mm256_castpd256_pd128(v);
+    __m128d hi = _mm256_extractf128_pd(v, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+AVX2_TARGET static inline __m256d avx2_exp(__m256d x) {
+    x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(EXP_LO)), _mm256_set1_pd(EXP_HI));
+    __m256d k = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(LOG2E)),
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(LN2_HI), x);
+    r = _mm256_fnmadd_pd(k, _mm256_set1_pd(LN2_LO), r);
+
+    __m256d p = _mm256_set1_pd(EXP_C11);
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_C10));
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_C9));
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_C8));
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_C7));
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_C6));
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_C5));
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_C4));
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_C3));
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_C2));
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0));
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0));
+
+    // 2^k: adding 1.5 * 2^52 leaves k + 1023 in the low mantissa bits,
+    // and shifting those into the exponent field builds the scale factor
+    __m256d biased = _mm256_add_pd(k, _mm256_set1_pd(6755399441055744.0 + 1023.0));
+    __m256i bits = _mm256_slli_epi64(_mm256_castpd_si256(biased), 52);
+    return _mm256_mul_pd(p, _mm256_castsi256_pd(bits));
+}
+
+AVX2_TARGET static inline __m256d avx2_sigmoid_vec(__m256d v) {
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d e = avx2_exp(_mm256_sub_pd(_mm256_setzero_pd(), v));
+    return _mm256_div_pd(one, _mm256_add_pd(one, e));
+}
+
+AVX2_TARGET static inline __m256d avx2_tanh_vec(__m256d v) {
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d e = avx2_exp(_mm256_add_pd(v, v));
+    return _mm256_sub_pd(one, _mm256_div_pd(_mm256_set1_pd(2.0), _mm256_add_pd(e, one)));
+}
+
+AVX2_TARGET static void avx2_gemv(int m, int n, const double* A, int lda, const double* x, double* y, int accumulate) {
+    int i = 0;
+
+    // Four rows at a time share every load of x
+    for (; i + 4 <= m; i += 4) {
+        const double* a0 = A + (size_t)i * lda;
+        const double* a1 = a0 + lda;
+        const double* a2 = a1 + lda;
+        const double* a3 = a2 + lda;
+        __m256d acc0 = _mm256_setzero_pd();
+        __m256d acc1 = _mm256_setzero_pd();
+        __m256d acc2 = _mm256_setzero_pd();
+        __m256d acc3 = _mm256_setzero_pd();
+
+        int k = 0;
+        for (; k + 4 <= n; k += 4) {
+            __m256d xv = _mm256_loadu_pd(x + k);
+            acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a0 + k), xv, acc0);
+            acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a1 + k), xv, acc1);
+            acc2 = _mm256_fmadd_pd(_mm256_loadu_pd(a2 + k), xv, acc2);
+            acc3 = _mm256_fmadd_pd(_mm256_loadu_pd(a3 + k), xv, acc3);
+        }
+
+        // Transpose-reduce the four accumulators into [r0, r1, r2, r3]
+        __m256d s01 = _mm256_hadd_pd(acc0, acc1);
+        __m256d s23 = _mm256_hadd_pd(acc2, acc3);
+        __m256d sum = _mm256_add_pd(_mm256_permute2f128_pd(s01, s23, 0x20),
+                                    _mm256_permute2f128_pd(s01, s23, 0x31));
+        double r[4];
+        _mm256_storeu_pd(r, sum);
+
+        for (; k < n; k++) {
+            r[0] += a0[k] * x[k];
+            r[1] += a1[k] * x[k];
+            r[2] += a2[k] * x[k];
+            r[3] += a3[k] * x[k];
+        }
+
+        for (int j = 0; j < 4; j++) {
+            y[i + j] = accumulate ? y[i + j] + r[j] : r[j];
+        }
+    }
+
+    for (; i < m; i++) {
+        const double* a = A + (size_t)i * lda;
+        __m256d acc = _mm256_setzero_pd();
+        int k = 0;
+        for (; k + 4 <= n; k += 4) {
+            acc = _mm256_fmadd_pd(_mm256_loadu_pd(a + k), _mm256_loadu_pd(x + k), acc);
+        }
+        double sum = avx2_hsum(acc);
+        for (; k < n; k++) {
+            sum += a[k] * x[k];
+        }
+        y[i] = accumulate ? y[i] + sum : sum;
+    }
+}
+
+AVX2_TARGET static void avx2_gemm(int m, int n, int k, const double* A, int lda, const double* B, int ldb,
+                                  double* C, int ldc, int accumulate) {
+    for (int i = 0; i < m; i++) {
+        const double* a = A + (size_t)i * lda;
+        double* c = C + (size_t)i * ldc;
+        int j = 0;
+
+        // 16-column tiles stay in registers across the whole k loop
+        for (; j + 16 <= n; j += 16) {
+            __m256d c0 = accumulate ? _mm256_loadu_pd(c + j) : _mm256_setzero_pd();
+            __m256d c1 = accumulate ? _mm256_loadu_pd(c + j + 4) : _mm256_setzero_pd();
+            __m256d c2 = accumulate ? _mm256_loadu_pd(c + j + 8) : _mm256_setzero_pd();
+            __m256d c3 = accumulate ? _mm256_loadu_pd(c + j + 12) : _mm256_setzero_pd();
+            for (int kk = 0; kk < k; kk++) {
+                __m256d av = _mm256_broadcast_sd(a + kk);
+                const double* b = B + (size_t)kk * ldb + j;
+                c0 = _mm256_fmadd_pd(av, _mm256_loadu_pd(b), c0);
+                c1 = _mm256_fmadd_pd(av, _mm256_loadu_pd(b + 4), c1);
+                c2 = _mm256_fmadd_pd(av, _mm256_loadu_pd(b + 8), c2);
+                c3 = _mm256_fmadd_pd(av, _mm256_loadu_pd(b + 12), c3);
+            }
+            _mm256_storeu_pd(c + j, c0);
+            _mm256_storeu_pd(c + j + 4, c1);
+            _mm256_storeu_pd(c + j + 8, c2);
+            _mm256_storeu_pd(c + j + 12, c3);
+        }
+
+        // Narrow tiles (small batches) split k over two chains to hide FMA latency
+        for (; j + 4 <= n; j += 4) {
+            __m256d c0 = accumulate ? _mm256_loadu_pd(c + j) : _mm256_setzero_pd();
+            __m256d c1 = _mm256_setzero_pd();
+            int kk = 0;
+            for (; kk + 2 <= k; kk += 2) {
+                c0 = _mm256_fmadd_pd(_mm256_broadcast_sd(a + kk), _mm256_loadu_pd(B + (size_t)kk * ldb + j), c0);
+                c1 = _mm256_fmadd_pd(_mm256_broadcast_sd(a + kk + 1),
+                                     _mm256_loadu_pd(B + (size_t)(kk + 1) * ldb + j), c1);
+            }
+            for (; kk < k; kk++) {
+                c0 = _mm256_fmadd_pd(_mm256_broadcast_sd(a + kk), _mm256_loadu_pd(B + (size_t)kk * ldb + j), c0);
+            }
+            _mm256_storeu_pd(c + j, _mm256_add_pd(c0, c1));
+        }
+
+        for (; j < n; j++) {
+            double sum = accumulate ? c[j] : 0.0;
+            for (int kk = 0; kk < k; kk++) {
+                sum += a[kk] * B[(size_t)kk * ldb + j];
+            }
+            c[j] = sum;
+        }
+    }
+}
+
+AVX2_TARGET static void avx2_add(int n, const double* a, const double* b, double* out) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    for (; i < n; i++) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+AVX2_TARGET static void avx2_axpy(int n, double alpha, const double* x, double* y) {
+    __m256d av = _mm256_set1_pd(alpha);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(y + i, _mm256_fmadd_pd(av, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    }
+    for (; i < n; i++) {
+        y[i] += alpha * x[i];
+    }
+}
+
+AVX2_TARGET static void avx2_scale(int n, double alpha, double* x) {
+    __m256d av = _mm256_set1_pd(alpha);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(x + i, _mm256_mul_pd(av, _mm256_loadu_pd(x + i)));
+    }
+    for (; i < n; i++) {
+        x[i] *= alpha;
+    }
+}
+
+// Tails go through a padded vector so every element sees the same approximation
+AVX2_TARGET static void avx2_sigmoid(int n, double* x) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(x + i, avx2_sigmoid_vec(_mm256_loadu_pd(x + i)));
+    }
+    if (i < n) {
+        double tail[4] = {0.0, 0.0, 0.0, 0.0};
+        memcpy(tail, x + i, (size_t)(n - i) * sizeof(double));
+        _mm256_storeu_pd(tail, avx2_sigmoid_vec(_mm256_loadu_pd(tail)));
+        memcpy(x + i, tail, (size_t)(n - i) * sizeof(double));
+    }
+}
+
+AVX2_TARGET static void avx2_tanh(int n, double* x) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(x + i, avx2_tanh_vec(_mm256_loadu_pd(x + i)));
+    }
+    if (i < n) {
+        double tail[4] = {0.0, 0.0, 0.0, 0.0};
+        memcpy(tail, x + i, (size_t)(n - i) * sizeof(double));
+        _mm256_storeu_pd(tail, avx2_tanh_vec(_mm256_loadu_pd(tail)));
+        memcpy(x + i, tail, (size_t)(n - i) * sizeof(double));
+    }
+}
+
+AVX2_TARGET static void avx2_minmax(int n, const double* x, double* min, double* max) {
+    __m256d lo = _mm256_set1_pd(x[0]);
+    __m256d hi = lo;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(x + i);
+        lo = _mm256_min_pd(lo, v);
+        hi = _mm256_max_pd(hi, v);
+    }
+    double lanes_lo[4], lanes_hi[4];
+    _mm256_storeu_pd(lanes_lo, lo);
+    _mm256_storeu_pd(lanes_hi, hi);
+    double l = lanes_lo[0], h = lanes_hi[0];
+    for (int j = 1; j < 4; j++) {
+        if (lanes_lo[j] < l) l = lanes_lo[j];
+        if (lanes_hi[j] > h) h = lanes_hi[j];
+    }
+    for (; i < n; i++) {
+        if (x[i] < l) l = x[i];
+        if (x[i] > h) h = x[i];
+    }
+    *min = l;
+    *max = h;
+}
+
+AVX2_TARGET static void avx2_rescale(int n, double* x, double shift, double divisor) {
+    __m256d sv = _mm256_set1_pd(shift);
+    __m256d dv = _mm256_set1_pd(divisor);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(x + i, _mm256_div_pd(_mm256_sub_pd(_mm256_loadu_pd(x + i), sv), dv));
+    }
+    for (; i < n; i++) {
+        x[i] = (x[i] - shift) / divisor;
+    }
+}
+
+AVX2_TARGET static void avx2_affine(int n, double* x, double scale, double shift) {
+    __m256d av = _mm256_set1_pd(scale);
+    __m256d sv = _mm256_set1_pd(shift);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(x + i, _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(x + i), av), sv));
+    }
+    for (; i < n; i++) {
+        x[i] = x[i] * scale + shift;
+    }
+}
+
+// 32 outputs stay in registers while every x_k is broadcast against a row of At
+AVX2_TARGET static void avx2_gemv_f32(int m, int n, const float* At, int lda, const float* x, float* y,
+                                      int accumulate) {
+    int i = 0;
+    for (; i + 32 <= m; i += 32) {
+        __m256 y0 = accumulate ? _mm256_loadu_ps(y + i) : _mm256_setzero_ps();
+        __m256 y1 = accumulate ? _mm256_loadu_ps(y + i + 8) : _mm256_setzero_ps();
+        __m256 y2 = accumulate ? _mm256_loadu_ps(y + i + 16) : _mm256_setzero_ps();
+        __m256 y3 = accumulate ? _mm256_loadu_ps(y + i + 24) : _mm256_setzero_ps();
+        for (int k = 0; k < n; k++) {
+            const float* a = At + (size_t)k * lda + i;
+            __m256 xv = _mm256_set1_ps(x[k]);
+            y0 = _mm256_fmadd_ps(_mm256_loadu_ps(a), xv, y0);
+            y1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + 8), xv, y1);
+            y2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + 16), xv, y2);
+            y3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + 24), xv, y3);
+        }
+        _mm256_storeu_ps(y + i, y0);
+        _mm256_storeu_ps(y + i + 8, y1);
+        _mm256_storeu_ps(y + i + 16, y2);
+        _mm256_storeu_ps(y + i + 24, y3);
+    }
+    for (; i + 8 <= m; i += 8) {
+        __m256 acc = accumulate ? _mm256_loadu_ps(y + i) : _mm256_setzero_ps();
+        for (int k = 0; k < n; k++) {
+            acc = _mm256_fmadd_ps(_mm256_loadu_ps(At + (size_t)k * lda + i), _mm256_set1_ps(x[k]), acc);
+        }
+        _mm256_storeu_ps(y + i, acc);
+    }
+    for (; i < m; i++) {
+        float sum = 0.0f;
+        for (int k = 0; k < n; k++) {
+            sum += At[(size_t)k * lda + i] * x[k];
+        }
+        y[i] = accumulate ? y[i] + sum : sum;
+    }
+}
+
+// int8 rows of At widen to floats eight at a time; scales apply once at the end
+AVX2_TARGET static void avx2_gemv_i8(int m, int n, const int8_t* At, int lda, const float* scale,
+                                     const float* x, float* y, int accumulate) {
+    int i = 0;
+    for (; i + 16 <= m; i += 16) {
+        __m256 y0 = _mm256_setzero_ps();
+        __m256 y1 = _mm256_setzero_ps();
+        for (int k = 0; k < n; k++) {
+            const int8_t* a = At + (size_t)k * lda + i;
+            __m256 xv = _mm256_set1_ps(x[k]);
+            y0 = _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)a))), xv, y0);
+            y1 = _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)(a + 8)))), xv, y1);
+        }
+        y0 = _mm256_mul_ps(y0, _mm256_loadu_ps(scale + i));
+        y1 = _mm256_mul_ps(y1, _mm256_loadu_ps(scale + i + 8));
+        if (accumulate) {
+            y0 = _mm256_add_ps(y0, _mm256_loadu_ps(y + i));
+            y1 = _mm256_add_ps(y1, _mm256_loadu_ps(y + i + 8));
+        }
+        _mm256_storeu_ps(y + i, y0);
+        _mm256_storeu_ps(y + i + 8, y1);
+    }
+    for (; i < m; i++) {
+        float sum = 0.0f;
+        for (int k = 0; k < n; k++) {
+            sum += (float)At[(size_t)k * lda + i] * x[k];
+        }
+        sum *= scale[i];
+        y[i] = accumulate ? y[i] + sum : sum;
+    }
+}
+
+AVX2_TARGET static void avx2_momentum(int n, double step, double gscale, double mu, const double* g, double* v,
+                                      double* w) {
+    __m256d sv = _mm256_set1_pd(step);
+    __m256d gv = _mm256_set1_pd(gscale);
+    __m256d mv = _mm256_set1_pd(mu);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d vel = _mm256_add_pd(_mm256_mul_pd(mv, _mm256_loadu_pd(v + i)),
+                                    _mm256_mul_pd(gv, _mm256_loadu_pd(g + i)));
+        _mm256_storeu_pd(v + i, vel);
+        _mm256_storeu_pd(w + i, _mm256_sub_pd(_mm256_loadu_pd(w + i), _mm256_mul_pd(sv, vel)));
+    }
+    for (; i < n; i++) {
+        v[i] = mu * v[i] + gscale * g[i];
+        w[i] -= step * v[i];
+    }
+}
+
+AVX2_TARGET static void avx2_adam(int n, double step, double gscale, double beta1, double beta2, double epsilon,
+                                  double v_correction, const double* g, double* m, double* v, double* w) {
+    double c1 = 1.0 - beta1, c2 = 1.0 - beta2;
+    __m256d sv = _mm256_set1_pd(step);
+    __m256d gv = _mm256_set1_pd(gscale);
+    __m256d b1 = _mm256_set1_pd(beta1);
+    __m256d b2 = _mm256_set1_pd(beta2);
+    __m256d c1v = _mm256_set1_pd(c1);
+    __m256d c2v = _mm256_set1_pd(c2);
+    __m256d ev = _mm256_set1_pd(epsilon);
+    __m256d vc = _mm256_set1_pd(v_correction);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d gi = _mm256_mul_pd(gv, _mm256_loadu_pd(g + i));
+        __m256d mi = _mm256_add_pd(_mm256_mul_pd(b1, _mm256_loadu_pd(m + i)), _mm256_mul_pd(c1v, gi));
+        __m256d vi = _mm256_add_pd(_mm256_mul_pd(b2, _mm256_loadu_pd(v + i)),
+                                   _mm256_mul_pd(c2v, _mm256_mul_pd(gi, gi)));
+        __m256d denom = _mm256_add_pd(_mm256_sqrt_pd(_mm256_mul_pd(vi, vc)), ev);
+        _mm256_storeu_pd(m + i, mi);
+        _mm256_storeu_pd(v + i, vi);
+        _mm256_storeu_pd(w + i, _mm256_sub_pd(_mm256_loadu_pd(w + i), _mm256_div_pd(_mm256_mul_pd(sv, mi), denom)));
+    }
+    for (; i < n; i++) {
+        double gi = gscale * g[i];
+        m[i] = beta1 * m[i] + c1 * gi;
+        v[i] = beta2 * v[i] + c2 * (gi * gi);
+        w[i] -= step * m[i] / (sqrt(v[i] * v_correction) + epsilon);
+    }
+}
+
+AVX2_TARGET static double avx2_sumsq(int n, const double* x) {
+    __m256d acc = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(x + i);
+        acc = _mm256_fmadd_pd(v, v, acc);
+    }
+    double sum = avx2_hsum(acc);
+    for (; i < n; i++) {
+        sum += x[i] * x[i];
+    }
+    return sum;
+}
+
+static const MatrixKernels avx2_kernels = {
+    "avx2",
+    avx2_gemv,
+    avx2_gemm,
+    avx2_add,
+    avx2_axpy,
+    avx2_scale,
+    avx2_sigmoid,
+    avx2_tanh,
+    avx2_minmax,
+    avx2_rescale,
+    avx2_affine,
+    avx2_gemv_f32,
+    avx2_gemv_i8,
+    avx2_momentum,
+    avx2_adam,
+    avx2_sumsq
+};
+
+// ---------------------------------------------------------------------------
+// AVX-512F kernels (8 doubles per vector, masked tails)
+// ---------------------------------------------------------------------------
+
+#define AVX512_TARGET __attribute__((target("avx512f")))
+
+AVX512_TARGET static inline __mmask8 avx512_tail_mask(int remaining) {
+    return (__mmask8)((1u << remaining) - 1u);
+}
+
+AVX512_TARGET static inline __m512d avx512_exp(__m512d x) {
+    x = _mm512_min_pd(_mm512_max_pd(x, _mm512_set1_pd(EXP_LO)), _mm512_set1_pd(EXP_HI));
+    __m512d k = _mm512_roundscale_pd(_mm512_mul_pd(x, _mm512_set1_pd(LOG2E)),
+                                     _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512d r = _mm512_fnmadd_pd(k, _mm512_set1_pd(LN2_HI), x);
+    r = _mm512_fnmadd_pd(k, _mm512_set1_pd(LN2_LO), r);
+
+    __m512d p = _mm512_set1_pd(EXP_C11);
+    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_C10));
+    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_C9));
+    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_C8));
+    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_C7));
+    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_C6));
+    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_C5));
+    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_C4));
+    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_C3));
+    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_C2));
+    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0));
+    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0));
+
+    __m512d biased = _mm512_add_pd(k, _mm512_set1_pd(6755399441055744.0 + 1023.0));
+    __m512i bits = _mm512_slli_epi64(_mm512_castpd_si512(biased), 52);
+    return _mm512_mul_pd(p, _mm512_castsi512_pd(bits));
+}
+
+AVX512_TARGET static inline __m512d avx512_sigmoid_vec(__m512d v) {
+    __m512d one = _mm512_set1_pd(1.0);
+    __m512d e = avx512_exp(_mm512_sub_pd(_mm512_setzero_pd(), v));
+    return _mm512_div_pd(one, _mm512_add_pd(one, e));
+}
+
+AVX512_TARGET static inline __m512d avx512_tanh_vec(__m512d v) {
+    __m512d one = _mm512_set1_pd(1.0);
+    __m512d e = avx512_exp(_mm512_add_pd(v, v));
+    return _mm512_sub_pd(one, _mm512_div_pd(_mm512_set1_pd(2.0), _mm512_add_pd(e, one)));
+}
+
+AVX512_TARGET static void avx512_gemv(int m, int n, const double* A, int lda, const double* x, double* y, int accumulate) {
+    int tail = n % 8;
+    int full = n - tail;
+    __mmask8 mask = avx512_tail_mask(tail);
+    int i = 0;
+
+    for (; i + 4 <= m; i += 4) {
+        const double* a0 = A + (size_t)i * lda;
+        const double* a1 = a0 + lda;
+        const double* a2 = a1 + lda;
+        const double* a3 = a2 + lda;
+        __m512d acc0 = _mm512_setzero_pd();
+        __m512d acc1 = _mm512_setzero_pd();
+        __m512d acc2 = _mm512_setzero_pd();
+        __m512d acc3 = _mm512_setzero_pd();
+
+        for (int k = 0; k < full; k += 8) {
+            __m512d xv = _mm512_loadu_pd(x + k);
+            acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a0 + k), xv, acc0);
+            acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(a1 + k), xv, acc1);
+            acc2 = _mm512_fmadd_pd(_mm512_loadu_pd(a2 + k), xv, acc2);
+            acc3 = _mm512_fmadd_pd(_mm512_loadu_pd(a3 + k), xv, acc3);
+        }
+        if (tail) {
+            __m512d xv = _mm512_maskz_loadu_pd(mask, x + full);
+            acc0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a0 + full), xv, acc0);
+            acc1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a1 + full), xv, acc1);
+            acc2 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a2 + full), xv, acc2);
+            acc3 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a3 + full), xv, acc3);
+        }
+
+        double r[4] = {
+            _mm512_reduce_add_pd(acc0), _mm512_reduce_add_pd(acc1),
+            _mm512_reduce_add_pd(acc2), _mm512_reduce_add_pd(acc3)
+        };
+        for (int j = 0; j < 4; j++) {
+            y[i + j] = accumulate ? y[i + j] + r[j] : r[j];
+        }
+    }
+
+    for (; i < m; i++) {
+        const double* a = A + (size_t)i * lda;
+        __m512d acc = _mm512_setzero_pd();
+        for (int k = 0; k < full; k += 8) {
+            acc = _mm512_fmadd_pd(_mm512_loadu_pd(a + k), _mm512_loadu_pd(x + k), acc);
+        }
+        if (tail) {
+            acc = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a + full),
+                                  _mm512_maskz_loadu_pd(mask, x + full), acc);
+        }
+        double sum = _mm512_reduce_add_pd(acc);
+        y[i] = accumulate ? y[i] + sum : sum;
+    }
+}
+
+AVX512_TARGET static void avx512_gemm(int m, int n, int k, const double* A, int lda, const double* B, int ldb,
+                                      double* C, int ldc, int accumulate) {
+    for (int i = 0; i < m; i++) {
+        const double* a = A + (size_t)i * lda;
+        double* c = C + (size_t)i * ldc;
+        int j = 0;
+
+        // 32-column tiles stay in registers across the whole k loop
+        for (; j + 32 <= n; j += 32) {
+            __m512d c0 = accumulate ? _mm512_loadu_pd(c + j) : _mm512_setzero_pd();
+            __m512d c1 = accumulate ? _mm512_loadu_pd(c + j + 8) : _mm512_setzero_pd();
+            __m512d c2 = accumulate ? _mm512_loadu_pd(c + j + 16) : _mm512_setzero_pd();
+            __m512d c3 = accumulate ? _mm512_loadu_pd(c + j + 24) : _mm512_setzero_pd();
+            for (int kk = 0; kk < k; kk++) {
+                __m512d av = _mm512_set1_pd(a[kk]);
+                const double* b = B + (size_t)kk * ldb + j;
+                c0 = _mm512_fmadd_pd(av, _mm512_loadu_pd(b), c0);
+                c1 = _mm512_fmadd_pd(av, _mm512_loadu_pd(b + 8), c1);
+                c2 = _mm512_fmadd_pd(av, _mm512_loadu_pd(b + 16), c2);
+                c3 = _mm512_fmadd_pd(av, _mm512_loadu_pd(b + 24), c3);
+            }
+            _mm512_storeu_pd(c + j, c0);
+            _mm512_storeu_pd(c + j + 8, c1);
+            _mm512_storeu_pd(c + j + 16, c2);
+            _mm512_storeu_pd(c + j + 24, c3);
+        }
+
+        // Narrow tiles (small batches) split k over two chains to hide FMA latency
+        for (; j < n; j += 8) {
+            __mmask8 mask = avx512_tail_mask(n - j < 8 ? n - j : 8);
+            __m512d c0 = accumulate ? _mm512_maskz_loadu_pd(mask, c + j) : _mm512_setzero_pd();
+            __m512d c1 = _mm512_setzero_pd();
+            int kk = 0;
+            for (; kk + 2 <= k; kk += 2) {
+                c0 = _mm512_fmadd_pd(_mm512_set1_pd(a[kk]),
+                                     _mm512_maskz_loadu_pd(mask, B + (size_t)kk * ldb + j), c0);
+                c1 = _mm512_fmadd_pd(_mm512_set1_pd(a[kk + 1]),
+                                     _mm512_maskz_loadu_pd(mask, B + (size_t)(kk + 1) * ldb + j), c1);
+            }
+            for (; kk < k; kk++) {
+                c0 = _mm512_fmadd_pd(_mm512_set1_pd(a[kk]),
+                                     _mm512_maskz_loadu_pd(mask, B + (size_t)kk * ldb + j), c0);
+            }
+            _mm512_mask_storeu_pd(c + j, mask, _mm512_add_pd(c0, c1));
+        }
+    }
+}
+
+AVX512_TARGET static void avx512_add(int n, const double* a, const double* b, double* out) {
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 mask = avx512_tail_mask(n - i < 8 ? n - i : 8);
+        __m512d v = _mm512_add_pd(_mm512_maskz_loadu_pd(mask, a + i), _mm512_maskz_loadu_pd(mask, b + i));
+        _mm512_mask_storeu_pd(out + i, mask, v);
+    }
+}
+
+AVX512_TARGET static void avx512_axpy(int n, double alpha, const double* x, double* y) {
+    __m512d av = _mm512_set1_pd(alpha);
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 mask = avx512_tail_mask(n - i < 8 ? n - i : 8);
+        __m512d v = _mm512_fmadd_pd(av, _mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i));
+        _mm512_mask_storeu_pd(y + i, mask, v);
+    }
+}
+
+AVX512_TARGET static void avx512_scale(int n, double alpha, double* x) {
+    __m512d av = _mm512_set1_pd(alpha);
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 mask = avx512_tail_mask(n - i < 8 ? n - i : 8);
+        _mm512_mask_storeu_pd(x + i, mask, _mm512_mul_pd(av, _mm512_maskz_loadu_pd(mask, x + i)));
+    }
+}
+
+AVX512_TARGET static void avx512_sigmoid(int n, double* x) {
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 mask = avx512_tail_mask(n - i < 8 ? n - i : 8);
+        _mm512_mask_storeu_pd(x + i, mask, avx512_sigmoid_vec(_mm512_maskz_loadu_pd(mask, x + i)));
+    }
+}
+
+AVX512_TARGET static void avx512_tanh(int n, double* x) {
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 mask = avx512_tail_mask(n - i < 8 ? n - i : 8);
+        _mm512_mask_storeu_pd(x + i, mask, avx512_tanh_vec(_mm512_maskz_loadu_pd(mask, x + i)));
+    }
+}
+
+AVX512_TARGET static void avx512_minmax(int n, const double* x, double* min, double* max) {
+    __m512d lo = _mm512_set1_pd(x[0]);
+    __m512d hi = lo;
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 mask = avx512_tail_mask(n - i < 8 ? n - i : 8);
+        __m512d v = _mm512_mask_loadu_pd(lo, mask, x + i);  // Masked lanes keep x[0]
+        lo = _mm512_min_pd(lo, v);
+        hi = _mm512_max_pd(hi, v);
+    }
+    *min = _mm512_reduce_min_pd(lo);
+    *max = _mm512_reduce_max_pd(hi);
+}
+
+AVX512_TARGET static void avx512_rescale(int n, double* x, double shift, double divisor) {
+    __m512d sv = _mm512_set1_pd(shift);
+    __m512d dv = _mm512_set1_pd(divisor);
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 mask = avx512_tail_mask(n - i < 8 ? n - i : 8);
+        __m512d v = _mm512_maskz_loadu_pd(mask, x + i);
+        _mm512_mask_storeu_pd(x + i, mask, _mm512_div_pd(_mm512_sub_pd(v, sv), dv));
+    }
+}
+
+AVX512_TARGET static void avx512_affine(int n, double* x, double scale, double shift) {
+    __m512d av = _mm512_set1_pd(scale);
+    __m512d sv = _mm512_set1_pd(shift);
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 mask = avx512_tail_mask(n - i < 8 ? n - i : 8);
+        __m512d v = _mm512_maskz_loadu_pd(mask, x + i);
+        _mm512_mask_storeu_pd(x + i, mask, _mm512_add_pd(_mm512_mul_pd(v, av), sv));
+    }
+}
+
+AVX512_TARGET static void avx512_gemv_f32(int m, int n, const float* At, int lda, const float* x, float* y,
+                                          int accumulate) {
+    int i = 0;
+    for (; i + 64 <= m; i += 64) {
+        __m512 y0 = accumulate ? _mm512_loadu_ps(y + i) : _mm512_setzero_ps();
+        __m512 y1 = accumulate ? _mm512_loadu_ps(y + i + 16) : _mm512_setzero_ps();
+        __m512 y2 = accumulate ? _mm512_loadu_ps(y + i + 32) : _mm512_setzero_ps();
+        __m512 y3 = accumulate ? _mm512_loadu_ps(y + i + 48) : _mm512_setzero_ps();
+        for (int k = 0; k < n; k++) {
+            const float* a = At + (size_t)k * lda + i;
+            __m512 xv = _mm512_set1_ps(x[k]);
+            y0 = _mm512_fmadd_ps(_mm512_loadu_ps(a), xv, y0);
+            y1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + 16), xv, y1);
+            y2 = _mm512_fmadd_ps(_mm512_loadu_ps(a + 32), xv, y2);
+            y3 = _mm512_fmadd_ps(_mm512_loadu_ps(a + 48), xv, y3);
+        }
+        _mm512_storeu_ps(y + i, y0);
+        _mm512_storeu_ps(y + i + 16, y1);
+        _mm512_storeu_ps(y + i + 32, y2);
+        _mm512_storeu_ps(y + i + 48, y3);
+    }
+    for (; i < m; i += 16) {
+        __mmask16 mask = (__mmask16)((m - i >= 16) ? 0xFFFF : ((1u << (m - i)) - 1));
+        __m512 acc = accumulate ? _mm512_maskz_loadu_ps(mask, y + i) : _mm512_setzero_ps();
+        for (int k = 0; k < n; k++) {
+            acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, At + (size_t)k * lda + i), _mm512_set1_ps(x[k]), acc);
+        }
+        _mm512_mask_storeu_ps(y + i, mask, acc);
+    }
+}
+
+AVX512_TARGET static void avx512_gemv_i8(int m, int n, const int8_t* At, int lda, const float* scale,
+                                         const float* x, float* y, int accumulate) {
+    int i = 0;
+    for (; i + 32 <= m; i += 32) {
+        __m512 y0 = _mm512_setzero_ps();
+        __m512 y1 = _mm512_setzero_ps();
+        for (int k = 0; k < n; k++) {
+            const int8_t* a = At + (size_t)k * lda + i;
+            __m512 xv = _mm512_set1_ps(x[k]);
+            y0 = _mm512_fmadd_ps(_mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i*)a))), xv, y0);
+            y1 = _mm512_fmadd_ps(_mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i*)(a + 16)))), xv, y1);
+        }
+        y0 = _mm512_mul_ps(y0, _mm512_loadu_ps(scale + i));
+        y1 = _mm512_mul_ps(y1, _mm512_loadu_ps(scale + i + 16));
+        if (accumulate) {
+            y0 = _mm512_add_ps(y0, _mm512_loadu_ps(y + i));
+            y1 = _mm512_add_ps(y1, _mm512_loadu_ps(y + i + 16));
+        }
+        _mm512_storeu_ps(y + i, y0);
+        _mm512_storeu_ps(y + i + 16, y1);
+    }
+    // Byte-masked loads need AVX512BW, so the remaining outputs run scalar
+    for (; i < m; i++) {
+        float sum = 0.0f;
+        for (int k = 0; k < n; k++) {
+            sum += (float)At[(size_t)k * lda + i] * x[k];
+        }
+        sum *= scale[i];
+        y[i] = accumulate ? y[i] + sum : sum;
+    }
+}
+
+AVX512_TARGET static void avx512_momentum(int n, double step, double gscale, double mu, const double* g, double* v,
+                                          double* w) {
+    __m512d sv = _mm512_set1_pd(step);
+    __m512d gv = _mm512_set1_pd(gscale);
+    __m512d mv = _mm512_set1_pd(mu);
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 mask = avx512_tail_mask(n - i < 8 ? n - i : 8);
+        __m512d vel = _mm512_add_pd(_mm512_mul_pd(mv, _mm512_maskz_loadu_pd(mask, v + i)),
+                                    _mm512_mul_pd(gv, _mm512_maskz_loadu_pd(mask, g + i)));
+        _mm512_mask_storeu_pd(v + i, mask, vel);
+        __m512d wi = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, w + i), _mm512_mul_pd(sv, vel));
+        _mm512_mask_storeu_pd(w + i, mask, wi);
+    }
+}
+
+AVX512_TARGET static void avx512_adam(int n, double step, double gscale, double beta1, double beta2,
+                                      double epsilon, double v_correction, const double* g, double* m, double* v,
+                                      double* w) {
+    __m512d sv = _mm512_set1_pd(step);
+    __m512d gv = _mm512_set1_pd(gscale);
+    __m512d b1 = _mm512_set1_pd(beta1);
+    __m512d b2 = _mm512_set1_pd(beta2);
+    __m512d c1 = _mm512_set1_pd(1.0 - beta1);
+    __m512d c2 = _mm512_set1_pd(1.0 - beta2);
+    __m512d ev = _mm512_set1_pd(epsilon);
+    __m512d vc = _mm512_set1_pd(v_correction);
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 mask = avx512_tail_mask(n - i < 8 ? n - i : 8);
+        __m512d gi = _mm512_mul_pd(gv, _mm512_maskz_loadu_pd(mask, g + i));
+        __m512d mi = _mm512_add_pd(_mm512_mul_pd(b1, _mm512_maskz_loadu_pd(mask, m + i)), _mm512_mul_pd(c1, gi));
+        __m512d vi = _mm512_add_pd(_mm512_mul_pd(b2, _mm512_maskz_loadu_pd(mask, v + i)),
+                                   _mm512_mul_pd(c2, _mm512_mul_pd(gi, gi)));
+        __m512d denom = _mm512_add_pd(_mm512_sqrt_pd(_mm512_mul_pd(vi, vc)), ev);
+        _mm512_mask_storeu_pd(m + i, mask, mi);
+        _mm512_mask_storeu_pd(v + i, mask, vi);
+        __m512d wi = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, w + i), _mm512_div_pd(_mm512_mul_pd(sv, mi), denom));
+        _mm512_mask_storeu_pd(w + i, mask, wi);
+    }
+}
+
+AVX512_TARGET static double avx512_sumsq(int n, const double* x) {
+    __m512d acc = _mm512_setzero_pd();
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 mask = avx512_tail_mask(n - i < 8 ? n - i : 8);
+        __m512d v = _mm512_maskz_loadu_pd(mask, x + i);
+        acc = _mm512_fmadd_pd(v, v, acc);
+    }
+    return _mm512_reduce_add_pd(acc);
+}
+
+static const MatrixKernels avx512_kernels = {
+    "avx512",
+    avx512_gemv,
+    avx512_gemm,
+    avx512_add,
+    avx512_axpy,
+    avx512_scale,
+    avx512_sigmoid,
+    avx512_tanh,
+    avx512_minmax,
+    avx512_rescale,
+    avx512_affine,
+    avx512_gemv_f32,
+    avx512_gemv_i8,
+    avx512_momentum,
+    avx512_adam,
+    avx512_sumsq
+};
+
+#endif // MATRIX_KERNELS_X86
+
+#ifdef MATRIX_KERNELS_NEON
+
+// ---------------------------------------------------------------------------
+// AArch64 NEON kernels (2 doubles per vector)
+// ---------------------------------------------------------------------------
+
+static inline float64x2_t neon_exp(float64x2_t x) {
+    x = vminq_f64(vmaxq_f64(x, vdupq_n_f64(EXP_LO)), vdupq_n_f64(EXP_HI));
+    float64x2_t k = vrndnq_f64(vmulq_f64(x, vdupq_n_f64(LOG2E)));
+    float64x2_t r = vfmsq_f64(x, k, vdupq_n_f64(LN2_HI));
+    r = vfmsq_f64(r, k, vdupq_n_f64(LN2_LO));
+
+    float64x2_t p = vdupq_n_f64(EXP_C11);
+    p = vfmaq_f64(vdupq_n_f64(EXP_C10), p, r);
+    p = vfmaq_f64(vdupq_n_f64(EXP_C9), p, r);
+    p = vfmaq_f64(vdupq_n_f64(EXP_C8), p, r);
+    p = vfmaq_f64(vdupq_n_f64(EXP_C7), p, r);
+    p = vfmaq_f64(vdupq_n_f64(EXP_C6), p, r);
+    p = vfmaq_f64(vdupq_n_f64(EXP_C5), p, r);
+    p = vfmaq_f64(vdupq_n_f64(EXP_C4), p, r);
+    p = vfmaq_f64(vdupq_n_f64(EXP_C3), p, r);
+    p = vfmaq_f64(vdupq_n_f64(EXP_C2), p, r);
+    p = vfmaq_f64(vdupq_n_f64(1.0), p, r);
+    p = vfmaq_f64(vdupq_n_f64(1.0), p, r);
+
+    int64x2_t bits = vshlq_n_s64(vaddq_s64(vcvtq_s64_f64(k), vdupq_n_s64(1023)), 52);
+    return vmulq_f64(p, vreinterpretq_f64_s64(bits));
+}
+
+static inline float64x2_t neon_sigmoid_vec(float64x2_t v) {
+    float64x2_t one = vdupq_n_f64(1.0);
+    return vdivq_f64(one, vaddq_f64(one, neon_exp(vnegq_f64(v))));
+}
+
+static inline float64x2_t neon_tanh_vec(float64x2_t v) {
+    float64x2_t one = vdupq_n_f64(1.0);
+    float64x2_t e = neon_exp(vaddq_f64(v, v));
+    return vsubq_f64(one, vdivq_f64(vdupq_n_f64(2.0), vaddq_f64(e, one)));
+}
+
+static void neon_gemv(int m, int n, const double* A, int lda, const double* x, double* y, int accumulate) {
+    for (int i = 0; i < m; i++) {
+        const double* a = A + (size_t)i * lda;
+        float64x2_t acc0 = vdupq_n_f64(0.0);
+        float64x2_t acc1 = vdupq_n_f64(0.0);
+        int k = 0;
+        for (; k + 4 <= n; k += 4) {
+            acc0 = vfmaq_f64(acc0, vld1q_f64(a + k), vld1q_f64(x + k));
+            acc1 = vfmaq_f64(acc1, vld1q_f64(a + k + 2), vld1q_f64(x + k + 2));
+        }
+        double sum = vaddvq_f64(vaddq_f64(acc0, acc1));
+        for (; k < n; k++) {
+            sum += a[k] * x[k];
+        }
+        y[i] = accumulate ? y[i] + sum : sum;
+    }
+}
+
+static void neon_gemm(int m, int n, int k, const double* A, int lda, const double* B, int ldb,
+                      double* C, int ldc, int accumulate) {
+    for (int i = 0; i < m; i++) {
+        const double* a = A + (size_t)i * lda;
+        double* c = C + (size_t)i * ldc;
+        int j = 0;
+        for (; j + 8 <= n; j += 8) {
+            float64x2_t c0 = accumulate ? vld1q_f64(c + j) : vdupq_n_f64(0.0);
+            float64x2_t c1 = accumulate ? vld1q_f64(c + j + 2) : vdupq_n_f64(0.0);
+            float64x2_t c2 = accumulate ? vld1q_f64(c + j + 4) : vdupq_n_f64(0.0);
+            float64x2_t c3 = accumulate ? vld1q_f64(c + j + 6) : vdupq_n_f64(0.0);
+            for (int kk = 0; kk < k; kk++) {
+                float64x2_t av = vdupq_n_f64(a[kk]);
+                const double* b = B + (size_t)kk * ldb + j;
+                c0 = vfmaq_f64(c0, av, vld1q_f64(b));
+                c1 = vfmaq_f64(c1, av, vld1q_f64(b + 2));
+                c2 = vfmaq_f64(c2, av, vld1q_f64(b + 4));
+                c3 = vfmaq_f64(c3, av, vld1q_f64(b + 6));
+            }
+            vst1q_f64(c + j, c0);
+            vst1q_f64(c + j + 2, c1);
+            vst1q_f64(c + j + 4, c2);
+            vst1q_f64(c + j + 6, c3);
+        }
+        for (; j < n; j++) {
+            double sum = accumulate ? c[j] : 0.0;
+            for (int kk = 0; kk < k; kk++) {
+                sum += a[kk] * B[(size_t)kk * ldb + j];
+            }
+            c[j] = sum;
+        }
+    }
+}
+
+static void neon_add(int n, const double* a, const double* b, double* out) {
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(out + i, vaddq_f64(vld1q_f64(a + i), vld1q_f64(b + i)));
+    }
+    for (; i < n; i++) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+static void neon_axpy(int n, double alpha, const double* x, double* y) {
+    float64x2_t av = vdupq_n_f64(alpha);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(y + i, vfmaq_f64(vld1q_f64(y + i), av, vld1q_f64(x + i)));
+    }
+    for (; i < n; i++) {
+        y[i] += alpha * x[i];
+    }
+}
+
+static void neon_scale(int n, double alpha, double* x) {
+    float64x2_t av = vdupq_n_f64(alpha);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(x + i, vmulq_f64(av, vld1q_f64(x + i)));
+    }
+    for (; i < n; i++) {
+        x[i] *= alpha;
+    }
+}
+
+static void neon_sigmoid(int n, double* x) {
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(x + i, neon_sigmoid_vec(vld1q_f64(x + i)));
+    }
+    if (i < n) {
+        double tail[2] = {x[i], 0.0};
+        vst1q_f64(tail, neon_sigmoid_vec(vld1q_f64(tail)));
+        x[i] = tail[0];
+    }
+}
+
+static void neon_tanh(int n, double* x) {
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(x + i, neon_tanh_vec(vld1q_f64(x + i)));
+    }
+    if (i < n) {
+        double tail[2] = {x[i], 0.0};
+        vst1q_f64(tail, neon_tanh_vec(vld1q_f64(tail)));
+        x[i] = tail[0];
+    }
+}
+
+static void neon_minmax(int n, const double* x, double* min, double* max) {
+    float64x2_t lo = vdupq_n_f64(x[0]);
+    float64x2_t hi = lo;
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t v = vld1q_f64(x + i);
+        lo = vminq_f64(lo, v);
+        hi = vmaxq_f64(hi, v);
+    }
+    double l = vminvq_f64(lo), h = vmaxvq_f64(hi);
+    for (; i < n; i++) {
+        if (x[i] < l) l = x[i];
+        if (x[i] > h) h = x[i];
+    }
+    *min = l;
+    *max = h;
+}
+
+static void neon_rescale(int n, double* x, double shift, double divisor) {
+    float64x2_t sv = vdupq_n_f64(shift);
+    float64x2_t dv = vdupq_n_f64(divisor);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(x + i, vdivq_f64(vsubq_f64(vld1q_f64(x + i), sv), dv));
+    }
+    for (; i < n; i++) {
+        x[i] = (x[i] - shift) / divisor;
+    }
+}
+
+static void neon_affine(int n, double* x, double scale, double shift) {
+    float64x2_t av = vdupq_n_f64(scale);
+    float64x2_t sv = vdupq_n_f64(shift);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(x + i, vaddq_f64(vmulq_f64(vld1q_f64(x + i), av), sv));
+    }
+    for (; i < n; i++) {
+        x[i] = x[i] * scale + shift;
+    }
+}
+
+static void neon_gemv_f32(int m, int n, const float* At, int lda, const float* x, float* y, int accumulate) {
+    int i = 0;
+    for (; i + 8 <= m; i += 8) {
+        float32x4_t y0 = accumulate ? vld1q_f32(y + i) : vdupq_n_f32(0.0f);
+        float32x4_t y1 = accumulate ? vld1q_f32(y + i + 4) : vdupq_n_f32(0.0f);
+        for (int k = 0; k < n; k++) {
+            const float* a = At + (size_t)k * lda + i;
+            y0 = vfmaq_n_f32(y0, vld1q_f32(a), x[k]);
+            y1 = vfmaq_n_f32(y1, vld1q_f32(a + 4), x[k]);
+        }
+        vst1q_f32(y + i, y0);
+        vst1q_f32(y + i + 4, y1);
+    }
+    for (; i < m; i++) {
+        float sum = 0.0f;
+        for (int k = 0; k < n; k++) {
+            sum += At[(size_t)k * lda + i] * x[k];
+        }
+        y[i] = accumulate ? y[i] + sum : sum;
+    }
+}
+
+static void neon_gemv_i8(int m, int n, const int8_t* At, int lda, const float* scale, const float* x,
+                         float* y, int accumulate) {
+    int i = 0;
+    for (; i + 8 <= m; i += 8) {
+        float32x4_t y0 = vdupq_n_f32(0.0f);
+        float32x4_t y1 = vdupq_n_f32(0.0f);
+        for (int k = 0; k < n; k++) {
+            int16x8_t wide = vmovl_s8(vld1_s8(At + (size_t)k * lda + i));
+            y0 = vfmaq_n_f32(y0, vcvtq_f32_s32(vmovl_s16(vget_low_s16(wide))), x[k]);
+            y1 = vfmaq_n_f32(y1, vcvtq_f32_s32(vmovl_s16(vget_high_s16(wide))), x[k]);
+        }
+        y0 = vmulq_f32(y0, vld1q_f32(scale + i));
+        y1 = vmulq_f32(y1, vld1q_f32(scale + i + 4));
+        if (accumulate) {
+            y0 = vaddq_f32(y0, vld1q_f32(y + i));
+            y1 = vaddq_f32(y1, vld1q_f32(y + i + 4));
+        }
+        vst1q_f32(y + i, y0);
+        vst1q_f32(y + i + 4, y1);
+    }
+    for (; i < m; i++) {
+        float sum = 0.0f;
+        for (int k = 0; k < n; k++) {
+            sum += (float)At[(size_t)k * lda + i] * x[k];
+        }
+        sum *= scale[i];
+        y[i] = accumulate ? y[i] + sum : sum;
+    }
+}
+
+static void neon_momentum(int n, double step, double gscale, double mu, const double* g, double* v, double* w) {
+    float64x2_t sv = vdupq_n_f64(step);
+    float64x2_t gv = vdupq_n_f64(gscale);
+    float64x2_t mv = vdupq_n_f64(mu);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t vel = vaddq_f64(vmulq_f64(mv, vld1q_f64(v + i)), vmulq_f64(gv, vld1q_f64(g + i)));
+        vst1q_f64(v + i, vel);
+        vst1q_f64(w + i, vsubq_f64(vld1q_f64(w + i), vmulq_f64(sv, vel)));
+    }
+    for (; i < n; i++) {
+        v[i] = mu * v[i] + gscale * g[i];
+        w[i] -= step * v[i];
+    }
+}
+
+static void neon_adam(int n, double step, double gscale, double beta1, double beta2, double epsilon,
+                      double v_correction, const double* g, double* m, double* v, double* w) {
+    double c1 = 1.0 - beta1, c2 = 1.0 - beta2;
+    float64x2_t sv = vdupq_n_f64(step);
+    float64x2_t gv = vdupq_n_f64(gscale);
+    float64x2_t b1 = vdupq_n_f64(beta1);
+    float64x2_t b2 = vdupq_n_f64(beta2);
+    float64x2_t c1v = vdupq_n_f64(c1);
+    float64x2_t c2v = vdupq_n_f64(c2);
+    float64x2_t ev = vdupq_n_f64(epsilon);
+    float64x2_t vc = vdupq_n_f64(v_correction);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t gi = vmulq_f64(gv, vld1q_f64(g + i));
+        float64x2_t mi = vaddq_f64(vmulq_f64(b1, vld1q_f64(m + i)), vmulq_f64(c1v, gi));
+        float64x2_t vi = vaddq_f64(vmulq_f64(b2, vld1q_f64(v + i)), vmulq_f64(c2v, vmulq_f64(gi, gi)));
+        float64x2_t denom = vaddq_f64(vsqrtq_f64(vmulq_f64(vi, vc)), ev);
+        vst1q_f64(m + i, mi);
+        vst1q_f64(v + i, vi);
+        vst1q_f64(w + i, vsubq_f64(vld1q_f64(w + i), vdivq_f64(vmulq_f64(sv, mi), denom)));
+    }
+    for (; i < n; i++) {
+        double gi = gscale * g[i];
+        m[i] = beta1 * m[i] + c1 * gi;
+        v[i] = beta2 * v[i] + c2 * (gi * gi);
+        w[i] -= step * m[i] / (sqrt(v[i] * v_correction) + epsilon);
+    }
+}
+
+static double neon_sumsq(int n, const double* x) {
+    float64x2_t acc = vdupq_n_f64(0.0);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t v = vld1q_f64(x + i);
+        acc = vfmaq_f64(acc, v, v);
+    }
+    double sum = vaddvq_f64(acc);
+    for (; i < n; i++) {
+        sum += x[i] * x[i];
+    }
+    return sum;
+}
+
+static const MatrixKernels neon_kernels = {
+    "neon",
+    neon_gemv,
+    neon_gemm,
+    neon_add,
+    neon_axpy,
+    neon_scale,
+    neon_sigmoid,
+    neon_tanh,
+    neon_minmax,
+    neon_rescale,
+    neon_affine,
+    neon_gemv_f32,
+    neon_gemv_i8,
+    neon_momentum,
+    neon_adam,
+    neon_sumsq
+};
+
+#endif // MATRIX_KERNELS_NEON
+
+// ---------------------------------------------------------------------------
+// Runtime selection
+// ---------------------------------------------------------------------------
+
+static const MatrixKernels* active_kernels = NULL;
+
+// Look up a kernel table by name, or NULL if it cannot run on this CPU
+static const MatrixKernels* find_kernels(const char* name) {
+    if (!name) return NULL;
+
+    if (strcmp(name, "scalar") == 0) return &scalar_kernels;
+#ifdef MATRIX_KERNELS_X86
+    if (strcmp(name, "avx512") == 0 && __builtin_cpu_supports("avx512f")) return &avx512_kernels;
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return &avx2_kernels;
+    }
+#endif
+#ifdef MATRIX_KERNELS_NEON
+    if (strcmp(name, "neon") == 0) return &neon_kernels;
+#endif
+    return NULL;
+}
+
+// Widest table the CPU supports
+static const MatrixKernels* best_kernels(void) {
+    static const char* preference[] = {"avx512", "avx2", "neon"};
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+        const MatrixKernels* k = find_kernels(preference[i]);
+        if (k) return k;
+    }
+    return &scalar_kernels;
+}
+
+const MatrixKernels* matrix_kernels(void) {
+    if (!active_kernels) {
+        const MatrixKernels* forced = find_kernels(getenv("WEATHER_LSTM_KERNELS"));
+        active_kernels = forced ? forced : best_kernels();
+    }
+    return active_kernels;
+}
+
+int matrix_kernels_select(const char* name) {
+    const MatrixKernels* k = find_kernels(name);
+    if (!k) return -1;
+
+    active_kernels = k;
+    return 0;
+}
+
+int matrix_kernels_available(const char* name) {
+    return find_kernels(name) != NULL;
+}
@@ -0,0 +1,109 @@
+#include "../include/online.h"
+
+OnlineTrainer* online_trainer_create(LSTMNetwork* network) {
+    if (!network || network->sequence_length <= 0 || network->input_size != WEATHER_NUM_FEATURES ||
+        network->output_size != WEATHER_NUM_FEATURES) {
+        return NULL;
+    }
+
+    OnlineTrainer* online = calloc(1, sizeof(OnlineTrainer));
+    if (!online) return NULL;
+
+    int batch_size = network->batch_size > 0 ? network->batch_size : 1;
+    online->network = network;
+    online->context = network->sequence_length;
+    online->trainer = bptt_trainer_create(network, network->sequence_length, batch_size);
+    if (!online->trainer) {
+        free(online);
+        return NULL;
+    }
+
+    // Stats continue from the model's normalization when it has one
+    if (network->norm_params) {
+        online->stats = *network->norm_params;
+        online->have_stats = 1;
+    }
+
+    return online;
+}
+
+void online_trainer_free(OnlineTrainer* online) {
+    if (!online) return;
+
+    bptt_trainer_free(online->trainer);
+    free(online->rows);
+    free(online->normalized);
+    free(online);
+}
+
+int online_trainer_add(OnlineTrainer* online, const WeatherPoint* raw) {
+    if (!online || !raw) return -1;
+
+    if (online->count == online->capacity) {
+        int capacity = online->capacity ? online->capacity * 2 : 2 * online->context + 64;
+        WeatherPoint* rows = realloc(online->rows, (size_t)capacity * sizeof(WeatherPoint));
+        if (!rows) return -1;
+        online->rows = rows;
+        double* normalized = realloc(online->normalized, (size_t)capacity * sizeof(WeatherPoint));
+        if (!normalized) return -1;
+        online->normalized = normalized;
+        online->capacity = capacity;
+    }
+
+    if (online->have_stats) {
+        normalization_params_fold(&online->stats, raw);
+    } else {
+        normalization_params_init(&online->stats, raw);
+        online->have_stats = 1;
+    }
+    online->rows[online->count++] = *raw;
+    online->rows_seen++;
+
+    return 0;
+}
+
+int online_trainer_pending(const OnlineTrainer* online) {
+    if (!online || online->count <= online->context) return 0;
+
+    return online->count - online->context;
+}
+
+double online_trainer_update(OnlineTrainer* online, int epochs) {
+    if (!online || epochs <= 0) return -1.0;
+
+    int windows = online_trainer_pending(online);
+    if (windows == 0) return 0.0;
+
+    // Move the weights to the widened normalization before training under it
+    LSTMNetwork* network = online->network;
+    if (!network->norm_params) {
+        network->norm_params = malloc(sizeof(NormalizationParams));
+        if (!network->norm_params) return -1.0;
+        *network->norm_params = online->stats;
+    } else if (memcmp(network->norm_params, &online->stats, sizeof(NormalizationParams)) != 0) {
+        if (lstm_network_renormalize(network, &online->stats) != 0) return -1.0;
+        online->renormalized++;
+    }
+
+    // Context and new rows, normalized under the current stats
+    memcpy(online->normalized, online->rows, (size_t)online->count * sizeof(WeatherPoint));
+    WeatherDataset staged = {(WeatherPoint*)online->normalized, online->count, online->count, NULL, 0};
+    normalize_dataset(&staged, network->norm_params);
+
+    TrainingData* data = training_data_view(online->normalized, WEATHER_NUM_FEATURES, online->count,
+                                            online->context);
+    if (!data) return -1.0;
+
+    double loss = 0.0;
+    for (int epoch = 0; epoch < epochs; epoch++) {
+        loss = bptt_train_epoch(online->trainer, network, data) / windows;
+    }
+    free_training_data(data);
+    online->windows_trained += windows;
+
+    // The newest rows become the next update's context
+    memmove(online->rows, online->rows + windows, (size_t)online->context * sizeof(WeatherPoint));
+    online->count = online->context;
+
+    return loss;
+}
@@ -0,0 +1,226 @@
+#include "../include/optimizer.h"
+#include "../include/matrix_kernels.h"
+#include "../include/profile.h"
+#include <math.h>
+
+// State offsets are rounded to this many doubles, one MATRIX_ALIGNMENT line
+#define OPTIMIZER_ALIGN_DOUBLES (MATRIX_ALIGNMENT / sizeof(double))
+
+static const char* const optimizer_names[OPTIMIZER_NUM_TYPES] = {"sgd", "momentum", "adam"};
+
+void optimizer_config_default(OptimizerConfig* config, OptimizerType type) {
+    if (!config) return;
+
+    config->type = type;
+    config->momentum = 0.9;
+    config->beta1 = 0.9;
+    config->beta2 = 0.999;
+    config->epsilon = 1e-8;
+    config->clip_norm = 0.0;
+}
+
+int optimizer_parse(const char* name, OptimizerType* type) {
+    if (!name || !type) return -1;
+
+    for (int t = 0; t < OPTIMIZER_NUM_TYPES; t++) {
+        if (strcmp(name, optimizer_names[t]) == 0) {
+            *type = (OptimizerType)t;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* optimizer_name(OptimizerType type) {
+    return type >= 0 && type < OPTIMIZER_NUM_TYPES ? optimizer_names[type] : "unknown";
+}
+
+// Weights and gradients of every tensor, in the order the state is laid out
+static int optimizer_tensors(LSTMNetwork* network, LSTMGradients* grads, Matrix** params, Matrix** deltas) {
+    int count = 0;
+    for (int l = 0; l < network->num_layers; l++) {
+        LSTMCell* cell = network->layers[l];
+        params[count] = cell->W;
+        deltas[count++] = grads ? grads->dW[l] : NULL;
+        params[count] = cell->U;
+        deltas[count++] = grads ? grads->dU[l] : NULL;
+        params[count] = cell->b;
+        deltas[count++] = grads ? grads->db[l] : NULL;
+    }
+    params[count] = network->W_output;
+    deltas[count++] = grads ? grads->dW_output : NULL;
+    params[count] = network->b_output;
+    deltas[count++] = grads ? grads->db_output : NULL;
+
+    return count;
+}
+
+Optimizer* optimizer_create(LSTMNetwork* network, const OptimizerConfig* config) {
+    if (!network || !config || config->type < 0 || config->type >= OPTIMIZER_NUM_TYPES ||
+        config->clip_norm < 0.0) {
+        return NULL;
+    }
+    if (config->type == OPTIMIZER_MOMENTUM && (config->momentum < 0.0 || config->momentum >= 1.0)) return NULL;
+    if (config->type == OPTIMIZER_ADAM && (config->beta1 < 0.0 || config->beta1 >= 1.0 || config->beta2 < 0.0 ||
+                                           config->beta2 >= 1.0 || config->epsilon <= 0.0)) {
+        return NULL;
+    }
+
+    Optimizer* optimizer = calloc(1, sizeof(Optimizer));
+    if (!optimizer) return NULL;
+
+    optimizer->config = *config;
+    optimizer->slots = config->type == OPTIMIZER_ADAM ? 2 : config->type == OPTIMIZER_MOMENTUM ? 1 : 0;
+
+    Matrix* params[OPTIMIZER_MAX_TENSORS];
+    Matrix* unused[OPTIMIZER_MAX_TENSORS];
+    optimizer->num_tensors = optimizer_tensors(network, NULL, params, unused);
+    for (int t = 0; t < optimizer->num_tensors; t++) {
+        optimizer->rows[t] = params[t]->rows;
+        optimizer->cols[t] = params[t]->cols;
+        optimizer->offsets[t] = optimizer->size;
+        size_t count = (size_t)params[t]->rows * (size_t)params[t]->cols;
+        optimizer->size += (count + OPTIMIZER_ALIGN_DOUBLES - 1) / OPTIMIZER_ALIGN_DOUBLES * OPTIMIZER_ALIGN_DOUBLES;
+    }
+
+    if (optimizer->slots > 0) {
+        optimizer->state = matrix_create(optimizer->slots, (int)optimizer->size);
+        if (!optimizer->state) {
+            free(optimizer);
+            return NULL;
+        }
+    }
+
+    return optimizer;
+}
+
+void optimizer_free(Optimizer* optimizer) {
+    if (!optimizer) return;
+
+    matrix_free(optimizer->state);
+    free(optimizer);
+}
+
+void optimizer_reset(Optimizer* optimizer) {
+    if (!optimizer) return;
+
+    if (optimizer->state) matrix_zero(optimizer->state);
+    optimizer->steps = 0;
+    optimizer->last_norm = 0.0;
+}
+
+static int optimizer_dense(const Matrix* m) {
+    return m->stride == m->cols || m->rows <= 1;
+}
+
+double lstm_gradients_norm(LSTMGradients* grads) {
+    if (!grads) return 0.0;
+
+    const MatrixKernels* k = matrix_kernels();
+    Matrix* deltas[OPTIMIZER_MAX_TENSORS];
+    int count = 0;
+    for (int l = 0; l < grads->num_layers; l++) {
+        deltas[count++] = grads->dW[l];
+        deltas[count++] = grads->dU[l];
+        deltas[count++] = grads->db[l];
+    }
+    deltas[count++] = grads->dW_output;
+    deltas[count++] = grads->db_output;
+
+    double sum = 0.0;
+    for (int t = 0; t < count; t++) {
+        Matrix* d = deltas[t];
+        if (optimizer_dense(d)) {
+            sum += k->sumsq(d->rows * d->cols, d->storage);
+        } else {
+            for (int i = 0; i < d->rows; i++) {
+                sum += k->sumsq(d->cols, MATRIX_ROW(d, i));
+            }
+        }
+    }
+    return sqrt(sum);
+}
+
+// One fused update of n contiguous weights
+static void optimizer_update(const Optimizer* optimizer, const MatrixKernels* k, int n, double step,
+                             double gscale, double v_correction, const double* g, double* m, double* v,
+                             double* w) {
+    const OptimizerConfig* c = &optimizer->config;
+    switch (c->type) {
+        case OPTIMIZER_SGD:
+            k->axpy(n, -step * gscale, g, w);
+            break;
+        case OPTIMIZER_MOMENTUM:
+            k->momentum(n, step, gscale, c->momentum, g, m, w);
+            break;
+        case OPTIMIZER_ADAM:
+            k->adam(n, step, gscale, c->beta1, c->beta2, c->epsilon, v_correction, g, m, v, w);
+            break;
+        default:
+            break;
+    }
+}
+
+int optimizer_step(Optimizer* optimizer, LSTMNetwork* network, LSTMGradients* grads, double grad_scale) {
+    if (!optimizer || !network || !grads || grads->num_layers != network->num_layers) return -1;
+
+    Matrix* params[OPTIMIZER_MAX_TENSORS];
+    Matrix* deltas[OPTIMIZER_MAX_TENSORS];
+    int count = optimizer_tensors(network, grads, params, deltas);
+    if (count != optimizer->num_tensors) return -1;
+    for (int t = 0; t < count; t++) {
+        if (params[t]->rows != optimizer->rows[t] || params[t]->cols != optimizer->cols[t] ||
+            deltas[t]->rows != params[t]->rows || deltas[t]->cols != params[t]->cols) {
+            return -1;
+        }
+    }
+
+    PROFILE_BEGIN(PROFILE_UPDATE);
+    const MatrixKernels* k = matrix_kernels();
+    const OptimizerConfig* c = &optimizer->config;
+
+    // Clipping folds into the gradient scale, so the update stays one pass
+    double gscale = grad_scale;
+    optimizer->last_norm = 0.0;
+    if (c->clip_norm > 0.0) {
+        double norm = fabs(grad_scale) * lstm_gradients_norm(grads);
+        optimizer->last_norm = norm;
+        if (norm > c->clip_norm) gscale *= c->clip_norm / norm;
+    }
+
+    optimizer->steps++;
+    double step = network->learning_rate;
+    double v_correction = 1.0;
+    if (c->type == OPTIMIZER_ADAM) {
+        step /= 1.0 - pow(c->beta1, (double)optimizer->steps);
+        v_correction = 1.0 / (1.0 - pow(c->beta2, (double)optimizer->steps));
+    }
+
+    size_t weights = 0;
+    for (int t = 0; t < count; t++) {
+        Matrix* w = params[t];
+        Matrix* g = deltas[t];
+        double* m = optimizer->slots > 0 ? MATRIX_ROW(optimizer->state, 0) + optimizer->offsets[t] : NULL;
+        double* v = optimizer->slots > 1 ? MATRIX_ROW(optimizer->state, 1) + optimizer->offsets[t] : NULL;
+        weights += (size_t)w->rows * w->cols;
+
+        if (optimizer_dense(w) && optimizer_dense(g)) {
+            optimizer_update(optimizer, k, w->rows * w->cols, step, gscale, v_correction, g->storage, m, v,
+                             w->storage);
+            continue;
+        }
+        for (int i = 0; i < w->rows; i++) {
+            size_t row = (size_t)i * w->cols;
+            optimizer_update(optimizer, k, w->cols, step, gscale, v_correction, MATRIX_ROW(g, i),
+                             m ? m + row : NULL, v ? v + row : NULL, MATRIX_ROW(w, i));
+        }
+    }
+
+    // Per weight: read weight, gradient and each state slot, write them back
+    PROFILE_WORK(PROFILE_UPDATE, (c->type == OPTIMIZER_ADAM ? 12.0 : 2.0 + 2.0 * optimizer->slots) * weights,
+                 (3.0 + 2.0 * optimizer->slots) * sizeof(double) * weights);
+    PROFILE_END(PROFILE_UPDATE);
+    (void)weights;
+
+    return 0;
+}
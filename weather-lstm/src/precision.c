@@ -0,0 +1,286 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "../include/precision.h"
+#include "../include/matrix_kernels.h"
+#include <math.h>
+#include <time.h>
+
+static const char* precision_names[LSTM_NUM_PRECISIONS] = {"f64", "f32", "int8"};
+
+const char* lstm_precision_name(LSTMPrecision precision) {
+    return precision >= 0 && precision < LSTM_NUM_PRECISIONS ? precision_names[precision] : "unknown";
+}
+
+int lstm_precision_parse(const char* name, LSTMPrecision* precision) {
+    if (!name || !precision) return -1;
+    
+    for (int p = 0; p < LSTM_NUM_PRECISIONS; p++) {
+        if (strcmp(name, precision_names[p]) == 0) {
+            *precision = (LSTMPrecision)p;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static void* aligned_buffer(size_t bytes) {
+    void* buffer = NULL;
+    size_t rounded = (bytes + MATRIX_ALIGNMENT - 1) & ~((size_t)MATRIX_ALIGNMENT - 1);
+    if (posix_memalign(&buffer, MATRIX_ALIGNMENT, rounded > 0 ? rounded : MATRIX_ALIGNMENT) != 0) return NULL;
+    return buffer;
+}
+
+// The reduced kernels take weights transposed, so dst is [cols x rows]
+static void copy_to_float(float* dst, Matrix* src) {
+    for (int i = 0; i < src->rows; i++) {
+        const double* row = MATRIX_ROW(src, i);
+        for (int j = 0; j < src->cols; j++) {
+            dst[(size_t)j * src->rows + i] = (float)row[j];
+        }
+    }
+}
+
+// Symmetric per-row quantization: q = round(w / scale), scale = max |w| / 127.
+// Stored transposed like copy_to_float, one scale per output.
+static void quantize_rows(int8_t* dst, float* scale, Matrix* src) {
+    for (int i = 0; i < src->rows; i++) {
+        const double* row = MATRIX_ROW(src, i);
+        double max_abs = 0.0;
+        for (int j = 0; j < src->cols; j++) {
+            if (fabs(row[j]) > max_abs) max_abs = fabs(row[j]);
+        }
+        double s = max_abs > 0.0 ? max_abs / 127.0 : 1.0;
+        scale[i] = (float)s;
+        for (int j = 0; j < src->cols; j++) {
+            long q = lround(row[j] / s);
+            if (q > 127) q = 127;
+            if (q < -127) q = -127;
+            dst[(size_t)j * src->rows + i] = (int8_t)q;
+        }
+    }
+}
+
+ReducedModel* reduced_model_create(LSTMNetwork* network, LSTMPrecision precision) {
+    if (!network || precision < 0 || precision >= LSTM_NUM_PRECISIONS) return NULL;
+    if (network->num_layers != 1 && precision != LSTM_PRECISION_F64) return NULL;
+    
+    ReducedModel* model = calloc(1, sizeof(ReducedModel));
+    if (!model) return NULL;
+    
+    int I = network->input_size;
+    int H = network->hidden_size;
+    int O = network->output_size;
+    int G = LSTM_NUM_GATES * H;
+    model->precision = precision;
+    model->network = network;
+    model->input_size = I;
+    model->hidden_size = H;
+    model->output_size = O;
+    if (precision == LSTM_PRECISION_F64) return model;
+    
+    int ok;
+    if (precision == LSTM_PRECISION_F32) {
+        model->W = aligned_buffer((size_t)G * I * sizeof(float));
+        model->U = aligned_buffer((size_t)G * H * sizeof(float));
+        ok = model->W && model->U;
+    } else {
+        model->W_q = aligned_buffer((size_t)G * I);
+        model->U_q = aligned_buffer((size_t)G * H);
+        model->W_scale = aligned_buffer((size_t)G * sizeof(float));
+        model->U_scale = aligned_buffer((size_t)G * sizeof(float));
+        ok = model->W_q && model->U_q && model->W_scale && model->U_scale;
+    }
+    model->b = aligned_buffer((size_t)G * sizeof(float));
+    model->W_output = aligned_buffer((size_t)O * H * sizeof(float));
+    model->b_output = aligned_buffer((size_t)O * sizeof(float));
+    model->x = aligned_buffer((size_t)I * sizeof(float));
+    model->h = aligned_buffer((size_t)H * sizeof(float));
+    model->gates_f = aligned_buffer((size_t)G * sizeof(float));
+    model->gates = aligned_buffer((size_t)G * sizeof(double));
+    model->c = aligned_buffer((size_t)H * sizeof(double));
+    model->c_tanh = aligned_buffer((size_t)H * sizeof(double));
+    model->y = aligned_buffer((size_t)O * sizeof(float));
+    if (!ok || !model->b || !model->W_output || !model->b_output || !model->x || !model->h ||
+        !model->gates_f || !model->gates || !model->c || !model->c_tanh || !model->y) {
+        reduced_model_free(model);
+        return NULL;
+    }
+    
+    LSTMCell* cell = network->lstm_layer;
+    if (precision == LSTM_PRECISION_F32) {
+        copy_to_float(model->W, cell->W);
+        copy_to_float(model->U, cell->U);
+    } else {
+        quantize_rows(model->W_q, model->W_scale, cell->W);
+        quantize_rows(model->U_q, model->U_scale, cell->U);
+    }
+    copy_to_float(model->b, cell->b);
+    copy_to_float(model->W_output, network->W_output);
+    copy_to_float(model->b_output, network->b_output);
+    
+    return model;
+}
+
+void reduced_model_free(ReducedModel* model) {
+    if (!model) return;
+    
+    free(model->W);
+    free(model->U);
+    free(model->W_q);
+    free(model->U_q);
+    free(model->W_scale);
+    free(model->U_scale);
+    free(model->b);
+    free(model->W_output);
+    free(model->b_output);
+    free(model->x);
+    free(model->h);
+    free(model->gates_f);
+    free(model->gates);
+    free(model->c);
+    free(model->c_tanh);
+    free(model->y);
+    free(model);
+}
+
+int reduced_model_predict_window(ReducedModel* model, const double* window, int steps, double* output) {
+    if (!model || !window || !output || steps <= 0) return -1;
+    
+    int I = model->input_size;
+    int H = model->hidden_size;
+    int O = model->output_size;
+    int G = LSTM_NUM_GATES * H;
+    
+    if (model->precision == LSTM_PRECISION_F64) {
+        Matrix* y = matrix_wrap(output, O, 1, 1);
+        if (!y) return -1;
+        int status = lstm_network_predict_window(model->network, (double*)window, steps, y);
+        matrix_free(y);
+        return status;
+    }
+    
+    const MatrixKernels* k = matrix_kernels();
+    memset(model->h, 0, (size_t)H * sizeof(float));
+    memset(model->c, 0, (size_t)H * sizeof(double));
+    
+    double* f = model->gates + LSTM_GATE_FORGET * H;
+    double* in = model->gates + LSTM_GATE_INPUT * H;
+    double* g = model->gates + LSTM_GATE_CANDIDATE * H;
+    double* o = model->gates + LSTM_GATE_OUTPUT * H;
+    
+    for (int t = 0; t < steps; t++) {
+        const double* row = window + (size_t)t * I;
+        for (int i = 0; i < I; i++) {
+            model->x[i] = (float)row[i];
+        }
+        
+        // gates = W x + U h_{t-1} + b
+        if (model->precision == LSTM_PRECISION_F32) {
+            k->gemv_f32(G, I, model->W, G, model->x, model->gates_f, 0);
+            k->gemv_f32(G, H, model->U, G, model->h, model->gates_f, 1);
+        } else {
+            k->gemv_i8(G, I, model->W_q, G, model->W_scale, model->x, model->gates_f, 0);
+            k->gemv_i8(G, H, model->U_q, G, model->U_scale, model->h, model->gates_f, 1);
+        }
+        for (int i = 0; i < G; i++) {
+            model->gates[i] = (double)(model->gates_f[i] + model->b[i]);
+        }
+        
+        k->sigmoid(2 * H, f);
+        k->tanh(H, g);
+        k->sigmoid(H, o);
+        for (int i = 0; i < H; i++) {
+            model->c[i] = f[i] * model->c[i] + in[i] * g[i];
+            model->c_tanh[i] = model->c[i];
+        }
+        k->tanh(H, model->c_tanh);
+        for (int i = 0; i < H; i++) {
+            model->h[i] = (float)(o[i] * model->c_tanh[i]);
+        }
+    }
+    
+    k->gemv_f32(O, H, model->W_output, O, model->h, model->y, 0);
+    for (int i = 0; i < O; i++) {
+        output[i] = (double)(model->y[i] + model->b_output[i]);
+    }
+    
+    return 0;
+}
+
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int lstm_precision_report(LSTMNetwork* network, TrainingData* data) {
+    if (!network || !data || data->num_sequences <= 0 ||
+        data->feature_size < network->input_size || data->feature_size < network->output_size) {
+        return -1;
+    }
+    
+    int N = data->num_sequences;
+    int O = network->output_size;
+    double* reference = malloc((size_t)N * O * sizeof(double));
+    double* output = malloc((size_t)O * sizeof(double));
+    if (!reference || !output) {
+        free(reference);
+        free(output);
+        return -1;
+    }
+    
+    printf("\nPrecision report (%d windows of %d steps, normalized units)\n", N, data->sequence_length);
+    printf("%-6s %12s %12s %14s %12s %9s\n", "type", "mae", "rmse", "max_vs_f64", "us/window", "speedup");
+    
+    int status = 0;
+    double f64_time = 0.0;
+    for (int p = 0; p < LSTM_NUM_PRECISIONS && status == 0; p++) {
+        ReducedModel* model = reduced_model_create(network, (LSTMPrecision)p);
+        if (!model) {
+            status = -1;
+            break;
+        }
+        
+        // Accuracy pass; F64 fills the reference the others are compared to
+        double abs_error = 0.0, sq_error = 0.0, max_dev = 0.0;
+        for (int s = 0; s < N && status == 0; s++) {
+            status = reduced_model_predict_window(model, training_data_input(data, s, 0),
+                                                  data->sequence_length, output);
+            const double* target = training_data_target(data, s);
+            for (int i = 0; i < O; i++) {
+                double err = output[i] - target[i];
+                abs_error += fabs(err);
+                sq_error += err * err;
+                if (p == LSTM_PRECISION_F64) {
+                    reference[(size_t)s * O + i] = output[i];
+                } else if (fabs(output[i] - reference[(size_t)s * O + i]) > max_dev) {
+                    max_dev = fabs(output[i] - reference[(size_t)s * O + i]);
+                }
+            }
+        }
+        
+        // Timing pass: repeat the windows for at least 0.2 s
+        long runs = 0;
+        double start = monotonic_seconds(), elapsed = 0.0;
+        while (status == 0 && (elapsed < 0.2 || runs < N)) {
+            status = reduced_model_predict_window(model, training_data_input(data, (int)(runs % N), 0),
+                                                  data->sequence_length, output);
+            runs++;
+            if (runs % 64 == 0 || runs == N) elapsed = monotonic_seconds() - start;
+        }
+        elapsed = monotonic_seconds() - start;
+        double per_window = elapsed / runs;
+        if (p == LSTM_PRECISION_F64) f64_time = per_window;
+        
+        if (status == 0) {
+            printf("%-6s %12.6f %12.6f %14.3e %12.2f %8.2fx\n", lstm_precision_name((LSTMPrecision)p),
+                   abs_error / ((double)N * O), sqrt(sq_error / ((double)N * O)), max_dev,
+                   per_window * 1e6, per_window > 0.0 ? f64_time / per_window : 0.0);
+        }
+        reduced_model_free(model);
+    }
+    
+    free(reference);
+    free(output);
+    return status;
+}
@@ -1,22 +1,290 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include "../include/lstm.h"
 #include "../include/weather_data.h"
+#include "../include/batch_predict.h"
+#include "../include/precision.h"
+#include "../include/profile.h"
+#include "../include/evaluate.h"
+#include "../include/large_alloc.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 void print_usage(const char* program_name) {
     printf("Usage: %s --model <model_file> --input <csv_file> [options]\n", program_name);
     printf("Options:\n");
     printf("  --model <file>       Path to trained model file\n");
-    printf("  --input <file>       Path to input weather data CSV file\n");
+    printf("  --input <file>       Path to input weather data CSV or binary dataset file\n");
     printf("  --output <file>      Output predictions to CSV file (optional)\n");
+    printf("  --horizon <steps>    Forecast this many steps ahead, feeding predictions back (default: 1)\n");
+    printf("  --precision <type>   Inference weights: f64, f32 or int8 (default: f64)\n");
+    printf("  --precision-report   Compare accuracy and speed of every precision on the input windows\n");
+    printf("  --evaluate           Score every window of the input: per-feature MAE and RMSE\n");
+    printf("  --threads <n>        Threads for --evaluate (default: 1)\n");
+    printf("  --profile <format>   Print a per-phase timing report: text or json (build with make PROFILE=1)\n");
+    printf("  --hugepages <mode>   Pages for buffers of 2 MB and up: default, thp or hugetlb (default: default)\n");
+    printf("  --numa               Interleave the dataset over NUMA nodes; workers build their state locally\n");
+    printf("\nBatch mode (one prediction per input, requires --output):\n");
+    printf("  --batch <file>       Manifest listing one input file per line\n");
+    printf("  --stations <file>    Multi-station CSV with a leading station column\n");
+    printf("  --batch-size <n>     Windows predicted together per GEMM (default: 64)\n");
+    printf("  --pipeline <n>       Threads running stacked layers as a wavefront (default: 1)\n");
     printf("  --help               Show this help message\n");
 }
 
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    LSTMNetwork* network;
+    BatchPredictor* predictor;
+    FILE* out;
+    double** windows;       // [batch_size] windows of the pending group
+    char** labels;          // [batch_size] station ids or file names, borrowed
+    int pending;
+    long predictions;
+    double model_seconds;   // Time spent inside batch_predictor_run
+} BatchJob;
+
+// Predict the pending windows and append one CSV row per window
+static int batch_flush(BatchJob* job) {
+    if (job->pending == 0) return 0;
+    
+    double start = monotonic_seconds();
+    int status = batch_predictor_run(job->predictor, job->network, job->windows, job->pending,
+                                     job->network->sequence_length);
+    job->model_seconds += monotonic_seconds() - start;
+    if (status != 0) {
+        printf("Error: Batch prediction failed\n");
+        return -1;
+    }
+    
+    Matrix* output = job->predictor->output;
+    for (int b = 0; b < job->pending; b++) {
+        WeatherPoint point = {MATRIX_AT(output, 0, b), MATRIX_AT(output, 1, b), MATRIX_AT(output, 2, b),
+                              MATRIX_AT(output, 3, b), MATRIX_AT(output, 4, b), MATRIX_AT(output, 5, b)};
+        if (job->network->norm_params) {
+            denormalize_point(&point, job->network->norm_params);
+        }
+        fprintf(job->out, "%s,%.2f,%.2f,%.2f,%.2f,%.2f,%.4f\n", job->labels[b],
+                point.temperature, point.pressure, point.humidity,
+                point.wind_speed, point.wind_direction, point.precipitation);
+    }
+    job->predictions += job->pending;
+    job->pending = 0;
+    
+    return 0;
+}
+
+// Multi-station file: every station's last window is read in place
+static int predict_stations(BatchJob* job, const char* filename) {
+    PROFILE_BEGIN(PROFILE_LOAD);
+    WeatherDataset* dataset = weather_dataset_create(1000);
+    WeatherStations* stations = dataset ? weather_load_stations_csv(filename, dataset) : NULL;
+    if (!stations) {
+        weather_dataset_free(dataset);
+        PROFILE_END(PROFILE_LOAD);
+        return -1;
+    }
+    
+    if (job->network->norm_params) {
+        normalize_dataset(dataset, job->network->norm_params);
+    }
+    PROFILE_WORK(PROFILE_LOAD, 0, (size_t)dataset->size * sizeof(WeatherPoint));
+    PROFILE_END(PROFILE_LOAD);
+    
+    int T = job->network->sequence_length;
+    int status = 0;
+    for (int s = 0; s < stations->count && status == 0; s++) {
+        int rows = stations->starts[s + 1] - stations->starts[s];
+        if (rows < T) {
+            printf("Warning: Station %s has %d data points, need %d; skipped\n", stations->ids[s], rows, T);
+            continue;
+        }
+        job->windows[job->pending] = weather_dataset_features(dataset) +
+                                     (size_t)(stations->starts[s + 1] - T) * WEATHER_NUM_FEATURES;
+        job->labels[job->pending] = stations->ids[s];
+        if (++job->pending == job->predictor->batch_size) {
+            status = batch_flush(job);
+        }
+    }
+    if (status == 0) status = batch_flush(job);
+    
+    weather_stations_free(stations);
+    weather_dataset_free(dataset);
+    return status;
+}
+
+// Manifest of input files: files are loaded one group at a time and their
+// last windows copied into a staging buffer, so memory stays bounded
+static int predict_manifest(BatchJob* job, const char* filename) {
+    FILE* manifest = fopen(filename, "r");
+    if (!manifest) {
+        printf("Error: Could not open manifest %s\n", filename);
+        return -1;
+    }
+    
+    int T = job->network->sequence_length;
+    int B = job->predictor->batch_size;
+    size_t window_size = (size_t)T * WEATHER_NUM_FEATURES;
+    double* staging = malloc((size_t)B * window_size * sizeof(double));
+    char** names = calloc((size_t)B, sizeof(char*));
+    if (!staging || !names) {
+        printf("Error: Could not allocate batch workspace\n");
+        free(staging);
+        free(names);
+        fclose(manifest);
+        return -1;
+    }
+    
+    int status = 0;
+    char line[4096];
+    while (status == 0 && fgets(line, sizeof(line), manifest)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+        
+        PROFILE_BEGIN(PROFILE_LOAD);
+        WeatherDataset* input = weather_dataset_create(1000);
+        int prenormalized = 0;
+        int loaded = input && (weather_is_binary(line)
+                                   ? weather_load_binary(line, input, NULL, &prenormalized)
+                                   : weather_load_csv(line, input)) == 0;
+        if (!loaded || prenormalized || input->size < T) {
+            printf("Warning: Skipping %s (%s)\n", line,
+                   !loaded ? "could not load" : prenormalized ? "normalized rows" : "too few data points");
+            weather_dataset_free(input);
+            PROFILE_END(PROFILE_LOAD);
+            continue;
+        }
+        
+        int b = job->pending;
+        double* window = staging + (size_t)b * window_size;
+        memcpy(window, weather_dataset_features(input) + (size_t)(input->size - T) * WEATHER_NUM_FEATURES,
+               window_size * sizeof(double));
+        weather_dataset_free(input);
+        
+        // Only the staged window needs normalizing, not the whole file
+        if (job->network->norm_params) {
+            WeatherDataset staged = {(WeatherPoint*)window, T, T, NULL, 0};
+            normalize_dataset(&staged, job->network->norm_params);
+        }
+        PROFILE_WORK(PROFILE_LOAD, 0, window_size * sizeof(double));
+        PROFILE_END(PROFILE_LOAD);
+        
+        free(names[b]);
+        names[b] = malloc(strlen(line) + 1);
+        if (!names[b]) {
+            status = -1;
+            break;
+        }
+        strcpy(names[b], line);
+        job->windows[b] = window;
+        job->labels[b] = names[b];
+        
+        if (++job->pending == B) {
+            status = batch_flush(job);
+        }
+    }
+    
+    if (status == 0) status = batch_flush(job);
+    
+    for (int b = 0; b < B; b++) {
+        free(names[b]);
+    }
+    free(names);
+    free(staging);
+    fclose(manifest);
+    return status;
+}
+
+// Batch mode: load the model once and stream one prediction per station.
+// profile is NULL unless a timing report was requested.
+static int predict_batch(const char* model_file, const char* manifest_file, const char* stations_file,
+                         const char* output_file, int batch_size, int pipeline, const ProfileFormat* profile) {
+    printf("Weather LSTM Batch Prediction\n");
+    printf("=============================\n");
+    printf("Model file: %s\n", model_file);
+    printf("%s: %s\n", manifest_file ? "Manifest" : "Stations file", manifest_file ? manifest_file : stations_file);
+    printf("Output file: %s\n", output_file);
+    printf("Batch size: %d\n\n", batch_size);
+    
+    double start = monotonic_seconds();
+    LSTMNetwork* network = load_lstm_model(model_file);
+    if (!network) {
+        printf("Error: Could not load model from %s\n", model_file);
+        return 1;
+    }
+    if (!network->norm_params) {
+        printf("Warning: No normalization parameters found in model\n");
+    }
+    
+    BatchJob job = {0};
+    job.network = network;
+    job.predictor = batch_predictor_create(network, batch_size);
+    
+    // One worker per layer at most; the predictor borrows the pool
+    ThreadPool* pool = NULL;
+    if (pipeline > network->num_layers) pipeline = network->num_layers;
+    if (job.predictor && pipeline > 1) {
+        pool = thread_pool_create(pipeline);
+        job.predictor->pool = pool;
+        if (pool) printf("Layer pipeline: %d threads\n", pipeline);
+    }
+    job.windows = calloc((size_t)batch_size, sizeof(double*));
+    job.labels = calloc((size_t)batch_size, sizeof(char*));
+    job.out = fopen(output_file, "w");
+    
+    int status = -1;
+    if (!job.predictor || !job.windows || !job.labels) {
+        printf("Error: Could not allocate batch workspace\n");
+    } else if (!job.out) {
+        printf("Error: Could not create file %s\n", output_file);
+    } else {
+        fprintf(job.out, "station,temperature,pressure,humidity,wind_speed,wind_direction,precipitation\n");
+        status = manifest_file ? predict_manifest(&job, manifest_file) : predict_stations(&job, stations_file);
+        if (fclose(job.out) != 0) status = -1;
+    }
+    double elapsed = monotonic_seconds() - start;
+    
+    if (status == 0) {
+        printf("\nWrote %ld predictions to %s\n", job.predictions, output_file);
+        printf("Total time: %.3f s (%.0f predictions/s)\n", elapsed,
+               elapsed > 0.0 ? job.predictions / elapsed : 0.0);
+        printf("Model time: %.3f s (%.0f predictions/s per core)\n", job.model_seconds,
+               job.model_seconds > 0.0 ? job.predictions / job.model_seconds : 0.0);
+        if (profile) profile_report(stdout, *profile, elapsed, job.predictions);
+    }
+    
+    batch_predictor_free(job.predictor);
+    thread_pool_free(pool);
+    free(job.windows);
+    free(job.labels);
+    lstm_network_free(network);
+    return status == 0 ? 0 : 1;
+}
+
 int main(int argc, char* argv[]) {
     char* model_file = NULL;
     char* input_file = NULL;
     char* output_file = NULL;
+    char* manifest_file = NULL;
+    char* stations_file = NULL;
+    int batch_size = 64;
+    int horizon = 1;
+    int pipeline = 1;
+    int profile = 0;
+    ProfileFormat profile_format = PROFILE_FORMAT_TEXT;
+    LSTMPrecision precision = LSTM_PRECISION_F64;
+    int precision_report = 0;
+    int evaluate = 0;
+    int threads = 1;
+    LargeAllocPolicy memory_policy;
+    large_alloc_policy_default(&memory_policy);
     
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -26,6 +294,40 @@ int main(int argc, char* argv[]) {
             input_file = argv[++i];
         } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
             output_file = argv[++i];
+        } else if (strcmp(argv[i], "--horizon") == 0 && i + 1 < argc) {
+            horizon = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc) {
+            if (lstm_precision_parse(argv[++i], &precision) != 0) {
+                printf("Error: Unknown precision %s (use f64, f32 or int8)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--precision-report") == 0) {
+            precision_report = 1;
+        } else if (strcmp(argv[i], "--evaluate") == 0) {
+            evaluate = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            manifest_file = argv[++i];
+        } else if (strcmp(argv[i], "--stations") == 0 && i + 1 < argc) {
+            stations_file = argv[++i];
+        } else if (strcmp(argv[i], "--batch-size") == 0 && i + 1 < argc) {
+            batch_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc) {
+            pipeline = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            if (profile_format_parse(argv[++i], &profile_format) != 0) {
+                printf("Error: Unknown profile format %s (use text or json)\n", argv[i]);
+                return 1;
+            }
+            profile = 1;
+        } else if (strcmp(argv[i], "--hugepages") == 0 && i + 1 < argc) {
+            if (large_pages_parse(argv[++i], &memory_policy.pages) != 0) {
+                printf("Error: Unknown hugepage mode %s (use default, thp or hugetlb)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--numa") == 0) {
+            memory_policy.numa = 1;
         } else if (strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return 0;
@@ -37,15 +339,46 @@ int main(int argc, char* argv[]) {
     }
     
     // Validate required arguments
-    if (!model_file || !input_file) {
+    int batch_mode = manifest_file || stations_file;
+    if (!model_file || (!input_file && !batch_mode)) {
         printf("Error: Missing required arguments\n");
         print_usage(argv[0]);
         return 1;
     }
+    if (batch_mode && (input_file || (manifest_file && stations_file) || !output_file)) {
+        printf("Error: Batch mode takes exactly one of --batch or --stations, plus --output\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (batch_size <= 0 || horizon <= 0 || pipeline <= 0 || threads <= 0) {
+        printf("Error: Batch size, horizon and thread counts must be positive\n");
+        return 1;
+    }
+    if (evaluate && batch_mode) {
+        printf("Error: --evaluate scores a single --input\n");
+        return 1;
+    }
+    
+    if (precision != LSTM_PRECISION_F64 && (horizon > 1 || batch_mode)) {
+        printf("Error: --precision %s supports single-step predictions only\n", lstm_precision_name(precision));
+        return 1;
+    }
+    
+    // Before the first allocation, so the input and weights follow it
+    large_alloc_set_policy(&memory_policy);
+    
+    if (batch_mode) {
+        return predict_batch(model_file, manifest_file, stations_file, output_file, batch_size, pipeline,
+                             profile ? &profile_format : NULL);
+    }
     
     printf("Weather LSTM Prediction\n");
     printf("======================\n");
     printf("Model file: %s\n", model_file);
+    if (memory_policy.pages != LARGE_PAGES_DEFAULT || memory_policy.numa) {
+        printf("Memory: %s pages, %s\n", large_pages_name(memory_policy.pages),
+               memory_policy.numa ? "NUMA placement" : "no NUMA placement");
+    }
     printf("Input file: %s\n", input_file);
     if (output_file) {
         printf("Output file: %s\n", output_file);
@@ -53,6 +386,7 @@ int main(int argc, char* argv[]) {
     printf("\n");
     
     // Load the trained model
+    double run_start = profile_seconds();
     printf("Loading trained model...\n");
     LSTMNetwork* network = load_lstm_model(model_file);
     if (!network) {
@@ -61,8 +395,14 @@ int main(int argc, char* argv[]) {
     }
     
     printf("Model loaded successfully\n");
-    printf("Input size: %d, Hidden size: %d, Output size: %d\n",
-           network->input_size, network->hidden_size, network->output_size);
+    printf("Input size: %d, Hidden size: %d, Output size: %d, Layers: %d\n",
+           network->input_size, network->hidden_size, network->output_size, network->num_layers);
+    
+    if (network->num_layers > 1 && (precision != LSTM_PRECISION_F64 || precision_report)) {
+        printf("Error: Reduced precision supports single-layer models only\n");
+        lstm_network_free(network);
+        return 1;
+    }
     printf("Sequence length: %d\n", network->sequence_length);
     
     // Load input weather data
@@ -74,8 +414,19 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    if (weather_load_csv(input_file, input_data) != 0) {
+    PROFILE_BEGIN(PROFILE_LOAD);
+    int prenormalized = 0;
+    int load_status = weather_is_binary(input_file)
+                          ? weather_load_binary(input_file, input_data, NULL, &prenormalized)
+                          : weather_load_csv(input_file, input_data);
+    if (load_status == 0 && prenormalized) {
+        printf("Error: %s holds normalized rows; convert it without --normalize for prediction\n",
+               input_file);
+        load_status = -1;
+    }
+    if (load_status != 0) {
         printf("Error: Could not load input data from %s\n", input_file);
+        PROFILE_END(PROFILE_LOAD);
         weather_dataset_free(input_data);
         lstm_network_free(network);
         return 1;
@@ -84,6 +435,7 @@ int main(int argc, char* argv[]) {
     if (input_data->size < network->sequence_length) {
         printf("Error: Input data too small. Need at least %d data points, got %d\n",
                network->sequence_length, input_data->size);
+        PROFILE_END(PROFILE_LOAD);
         weather_dataset_free(input_data);
         lstm_network_free(network);
         return 1;
@@ -96,21 +448,81 @@ int main(int argc, char* argv[]) {
     } else {
         printf("Warning: No normalization parameters found in model\n");
     }
+    PROFILE_WORK(PROFILE_LOAD, 0, (size_t)input_data->size * sizeof(WeatherPoint));
+    PROFILE_END(PROFILE_LOAD);
+    
+    // Compare precisions on every window of the input before predicting
+    if (precision_report) {
+        TrainingData* windows = create_training_data(input_data, network->sequence_length);
+        if (!windows || lstm_precision_report(network, windows) != 0) {
+            printf("Error: Precision report needs more than %d data points\n", network->sequence_length);
+        }
+        free_training_data(windows);
+    }
+    
+    // Score the model on every window of the input, not just the last one
+    if (evaluate) {
+        printf("\nEvaluating every window on %d threads...\n", threads);
+        TrainingData* windows = create_training_data(input_data, network->sequence_length);
+        Evaluator* evaluator = windows ? evaluator_create(network, threads, batch_size) : NULL;
+        EvaluationResult result;
+        if (!evaluator || evaluator_run(evaluator, network, windows, &result) != 0) {
+            printf("Error: Evaluation needs more than %d data points\n", network->sequence_length);
+        } else {
+            evaluation_print(stdout, &result);
+        }
+        evaluator_free(evaluator);
+        free_training_data(windows);
+    }
     
     // Make prediction using the most recent sequence
-    printf("\nMaking prediction...\n");
-    WeatherPoint prediction = lstm_predict_next(network, input_data, network->sequence_length);
+    printf("\nMaking prediction (%s)...\n", lstm_precision_name(precision));
+    WeatherDataset* forecast = NULL;
+    if (precision == LSTM_PRECISION_F64) {
+        forecast = lstm_forecast(network, input_data, horizon);
+    } else {
+        ReducedModel* reduced = reduced_model_create(network, precision);
+        forecast = reduced ? weather_dataset_create(1) : NULL;
+        double* window = weather_dataset_features(input_data) +
+                         (size_t)(input_data->size - network->sequence_length) * WEATHER_NUM_FEATURES;
+        if (forecast && reduced_model_predict_window(reduced, window, network->sequence_length,
+                                                     weather_dataset_features(forecast)) == 0) {
+            forecast->size = 1;
+        } else {
+            weather_dataset_free(forecast);
+            forecast = NULL;
+        }
+        reduced_model_free(reduced);
+    }
+    if (!forecast) {
+        printf("Error: Prediction failed\n");
+        weather_dataset_free(input_data);
+        lstm_network_free(network);
+        return 1;
+    }
     
-    // Denormalize prediction if parameters are available
+    // Denormalize predictions if parameters are available
     if (network->norm_params) {
-        denormalize_point(&prediction, network->norm_params);
+        for (int h = 0; h < forecast->size; h++) {
+            denormalize_point(&forecast->data[h], network->norm_params);
+        }
     }
+    WeatherPoint prediction = forecast->data[0];
     
     // Display prediction
     printf("\nPredicted next weather conditions:\n");
     printf("==================================\n");
     print_weather_point(&prediction);
     
+    if (horizon > 1) {
+        printf("\nForecast for the next %d steps:\n", horizon);
+        printf("==================================\n");
+        for (int h = 0; h < forecast->size; h++) {
+            printf("Step +%d: ", h + 1);
+            print_weather_point(&forecast->data[h]);
+        }
+    }
+    
     // If we have at least one more data point, compare with actual
     int actual_idx = input_data->size - 1;
     if (actual_idx >= network->sequence_length) {
@@ -149,19 +561,12 @@ int main(int argc, char* argv[]) {
     
     // Save predictions to output file if specified
     if (output_file) {
-        printf("\nSaving prediction to %s...\n", output_file);
+        printf("\nSaving %s to %s...\n", horizon > 1 ? "forecast" : "prediction", output_file);
         
-        WeatherDataset* output_data = weather_dataset_create(1);
-        if (output_data) {
-            weather_dataset_add(output_data, prediction);
-            
-            if (weather_save_csv(output_file, output_data) == 0) {
-                printf("Prediction saved successfully\n");
-            } else {
-                printf("Error: Could not save prediction\n");
-            }
-            
-            weather_dataset_free(output_data);
+        if (weather_save_csv(output_file, forecast) == 0) {
+            printf("Prediction saved successfully\n");
+        } else {
+            printf("Error: Could not save prediction\n");
         }
     }
     
@@ -178,7 +583,14 @@ int main(int argc, char* argv[]) {
         print_weather_point(&point);
     }
     
+    printf("\n");
+    arena_print_usage(network->scratch, "Scratch arena");
+    if (profile) {
+        profile_report(stdout, profile_format, profile_seconds() - run_start, horizon);
+    }
+    
     // Clean up
+    weather_dataset_free(forecast);
     weather_dataset_free(input_data);
     lstm_network_free(network);
     
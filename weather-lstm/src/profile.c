@@ -0,0 +1,146 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "../include/profile.h"
+#include <string.h>
+#include <time.h>
+
+static ProfileCounters profile_totals[PROFILE_NUM_PHASES];
+static uint64_t profile_allocation_count;
+
+static const char* const profile_names[PROFILE_NUM_PHASES] = {
+    "load", "sequences", "gates", "activations", "backward", "update", "model_io"
+};
+
+double profile_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+uint64_t profile_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+int profile_enabled(void) {
+#ifdef WEATHER_LSTM_PROFILE
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void profile_add_time(ProfilePhase phase, uint64_t start_ns) {
+    if (phase < 0 || phase >= PROFILE_NUM_PHASES) return;
+
+    uint64_t elapsed = profile_clock_ns() - start_ns;
+    __atomic_fetch_add(&profile_totals[phase].nanoseconds, elapsed, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&profile_totals[phase].calls, 1, __ATOMIC_RELAXED);
+}
+
+void profile_add_work(ProfilePhase phase, uint64_t flops, uint64_t bytes) {
+    if (phase < 0 || phase >= PROFILE_NUM_PHASES) return;
+
+    __atomic_fetch_add(&profile_totals[phase].flops, flops, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&profile_totals[phase].bytes, bytes, __ATOMIC_RELAXED);
+}
+
+void profile_add_allocation(void) {
+    __atomic_fetch_add(&profile_allocation_count, 1, __ATOMIC_RELAXED);
+}
+
+void profile_reset(void) {
+    for (int p = 0; p < PROFILE_NUM_PHASES; p++) {
+        __atomic_store_n(&profile_totals[p].nanoseconds, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&profile_totals[p].calls, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&profile_totals[p].flops, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&profile_totals[p].bytes, 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&profile_allocation_count, 0, __ATOMIC_RELAXED);
+}
+
+void profile_snapshot(ProfilePhase phase, ProfileCounters* out) {
+    if (!out) return;
+
+    memset(out, 0, sizeof(*out));
+    if (phase < 0 || phase >= PROFILE_NUM_PHASES) return;
+    out->nanoseconds = __atomic_load_n(&profile_totals[phase].nanoseconds, __ATOMIC_RELAXED);
+    out->calls = __atomic_load_n(&profile_totals[phase].calls, __ATOMIC_RELAXED);
+    out->flops = __atomic_load_n(&profile_totals[phase].flops, __ATOMIC_RELAXED);
+    out->bytes = __atomic_load_n(&profile_totals[phase].bytes, __ATOMIC_RELAXED);
+}
+
+uint64_t profile_allocations(void) {
+    return __atomic_load_n(&profile_allocation_count, __ATOMIC_RELAXED);
+}
+
+const char* profile_phase_name(ProfilePhase phase) {
+    if (phase < 0 || phase >= PROFILE_NUM_PHASES) return "unknown";
+    return profile_names[phase];
+}
+
+int profile_format_parse(const char* name, ProfileFormat* format) {
+    if (!name || !format) return -1;
+
+    if (strcmp(name, "text") == 0) {
+        *format = PROFILE_FORMAT_TEXT;
+    } else if (strcmp(name, "json") == 0) {
+        *format = PROFILE_FORMAT_JSON;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static double profile_rate(double amount, double seconds) {
+    return seconds > 0.0 ? amount / seconds : 0.0;
+}
+
+int profile_report(FILE* out, ProfileFormat format, double wall_seconds, long sequences) {
+    if (!out) return -1;
+
+    ProfileCounters phases[PROFILE_NUM_PHASES];
+    double total_flops = 0.0;
+    for (int p = 0; p < PROFILE_NUM_PHASES; p++) {
+        profile_snapshot((ProfilePhase)p, &phases[p]);
+        total_flops += (double)phases[p].flops;
+    }
+
+    if (format == PROFILE_FORMAT_JSON) {
+        fprintf(out, "{\"enabled\": %s, \"wall_seconds\": %.6f, \"sequences\": %ld, "
+                "\"sequences_per_second\": %.3f, \"gflops_per_second\": %.4f, \"allocations\": %llu, "
+                "\"phases\": [",
+                profile_enabled() ? "true" : "false", wall_seconds, sequences,
+                profile_rate((double)sequences, wall_seconds), profile_rate(total_flops, wall_seconds) * 1e-9,
+                (unsigned long long)profile_allocations());
+        for (int p = 0; p < PROFILE_NUM_PHASES; p++) {
+            fprintf(out, "%s{\"name\": \"%s\", \"seconds\": %.6f, \"calls\": %llu, \"flops\": %llu, \"bytes\": %llu}",
+                    p > 0 ? ", " : "", profile_names[p], phases[p].nanoseconds * 1e-9,
+                    (unsigned long long)phases[p].calls, (unsigned long long)phases[p].flops,
+                    (unsigned long long)phases[p].bytes);
+        }
+        fprintf(out, "]}\n");
+        return ferror(out) ? -1 : 0;
+    }
+
+    fprintf(out, "\nProfile (%.3f s wall, %ld sequences)\n", wall_seconds, sequences);
+    if (!profile_enabled()) {
+        fprintf(out, "Phase timers are compiled out; rebuild with make clean && make PROFILE=1\n");
+    } else {
+        fprintf(out, "%-12s %10s %7s %12s %10s %9s %10s\n",
+                "phase", "seconds", "share", "calls", "GFLOP", "GFLOP/s", "MB");
+        for (int p = 0; p < PROFILE_NUM_PHASES; p++) {
+            double seconds = phases[p].nanoseconds * 1e-9;
+            fprintf(out, "%-12s %10.4f %6.1f%% %12llu %10.3f %9.2f %10.1f\n",
+                    profile_names[p], seconds, 100.0 * profile_rate(seconds, wall_seconds),
+                    (unsigned long long)phases[p].calls, phases[p].flops * 1e-9,
+                    profile_rate((double)phases[p].flops, seconds) * 1e-9, phases[p].bytes / 1e6);
+        }
+        fprintf(out, "Heap matrix allocations: %llu\n", (unsigned long long)profile_allocations());
+    }
+    fprintf(out, "Throughput: %.1f sequences/s, %.2f GFLOP/s\n",
+            profile_rate((double)sequences, wall_seconds), profile_rate(total_flops, wall_seconds) * 1e-9);
+
+    return ferror(out) ? -1 : 0;
+}
@@ -0,0 +1,91 @@
+#include "../include/inference_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void print_usage(const char* program_name) {
+    printf("Usage: %s --model [name=]<model_file> [--model ...] [options]\n", program_name);
+    printf("Options:\n");
+    printf("  --model [name=]<file>  Load a model, optionally under a name (default: \"default\");\n");
+    printf("                         the first model serves stations that are not bound\n");
+    printf("  --quiet                Skip the startup banner\n");
+    printf("  --help                 Show this help message\n");
+    printf("\nRequests are read from stdin, one per line; replies go to stdout:\n");
+    printf("  OBS <station> <t>,<p>,<h>,<ws>,<wd>,<pr>   Add an observation, reply with the next prediction\n");
+    printf("  PREDICT <station>                          Repeat the latest prediction\n");
+    printf("  BIND <station> <model>                     Serve the station with another model\n");
+    printf("  RESET <station>                            Clear the station's hidden and cell state\n");
+    printf("  STATS                                      Show request counts and latency\n");
+    printf("  QUIT                                       Stop the server\n");
+}
+
+int main(int argc, char* argv[]) {
+    InferenceServer* server = inference_server_create();
+    if (!server) {
+        printf("Error: Could not create server\n");
+        return 1;
+    }
+    
+    int quiet = 0;
+    
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+            char* spec = argv[++i];
+            char* equals = strchr(spec, '=');
+            const char* name = "default";
+            const char* path = spec;
+            if (equals) {
+                *equals = '\0';
+                name = spec;
+                path = equals + 1;
+            }
+            if (inference_server_add_model(server, name, path) != 0) {
+                inference_server_free(server);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = 1;
+        } else if (strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            inference_server_free(server);
+            return 0;
+        } else {
+            printf("Unknown argument: %s\n", argv[i]);
+            print_usage(argv[0]);
+            inference_server_free(server);
+            return 1;
+        }
+    }
+    
+    if (server->num_models == 0) {
+        printf("Error: Missing required arguments\n");
+        print_usage(argv[0]);
+        inference_server_free(server);
+        return 1;
+    }
+    
+    // Model loading reports on stdout; the banner marks where replies begin
+    if (!quiet) {
+        printf("Weather LSTM Server\n");
+        printf("===================\n");
+        for (int m = 0; m < server->num_models; m++) {
+            LSTMNetwork* network = server->models[m];
+            printf("Model %s: hidden size %d, sequence length %d\n", server->model_names[m],
+                   network->hidden_size, network->sequence_length);
+        }
+        printf("READY\n");
+    }
+    fflush(stdout);
+    
+    // Flush after every reply so clients on a pipe see it immediately
+    char line[1024];
+    while (fgets(line, sizeof(line), stdin)) {
+        int quit = inference_server_handle(server, line, stdout);
+        fflush(stdout);
+        if (quit) break;
+    }
+    
+    inference_server_free(server);
+    return 0;
+}
@@ -0,0 +1,257 @@
+#include "../include/lstm.h"
+#include "../include/weather_data.h"
+#include "../include/matrix_kernels.h"
+#include "../include/profile.h"
+#include "../include/tuning.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SWEEP_MAX_VALUES 16
+#define SWEEP_MAX_TRIALS (SWEEP_MAX_VALUES * SWEEP_MAX_VALUES * SWEEP_MAX_VALUES)
+
+void print_usage(const char* program_name) {
+    printf("Usage: %s --data <file> [options]\n", program_name);
+    printf("Trains every combination of the listed values on one shared copy of the data.\n");
+    printf("Options:\n");
+    printf("  --data <file>          Weather data CSV or binary dataset file\n");
+    printf("  --hidden <list>        Hidden sizes, comma separated (default: 32,64)\n");
+    printf("  --sequence <list>      Sequence lengths (default: 10)\n");
+    printf("  --learning-rate <list> Learning rates (default: 0.01,0.001)\n");
+    printf("  --epochs <n>           Epochs per trial (default: 50)\n");
+    printf("  --batch-size <n>       Sequences per gradient update (default: 8)\n");
+    printf("  --validation <frac>    Fraction of rows, from the end, held out (default: 0.2)\n");
+    printf("  --cores <n>            Trials trained at once (default: 1)\n");
+    printf("  --eval-every <n>       Epochs between validation passes (default: 5)\n");
+    printf("  --patience <n>         Stop after n evaluations without improvement, 0 = never (default: 4)\n");
+    printf("  --prune-factor <x>     Stop trials worse than x times the best at a checkpoint, 0 = never (default: 1.5)\n");
+    printf("  --rank <order>         efficiency (loss removed per second) or loss (default: efficiency)\n");
+    printf("  --seed <n>             Weight initialization seed (default: 42)\n");
+    printf("  --output <file>        Also write the ranked results as CSV\n");
+    printf("  --help                 Show this help message\n");
+}
+
+// Comma separated positive integers; returns the count or -1
+static int parse_int_list(const char* text, int* values, int max) {
+    int count = 0;
+    const char* p = text;
+    while (*p) {
+        char* end;
+        long value = strtol(p, &end, 10);
+        if (end == p || value <= 0 || count == max || (*end != ',' && *end != '\0')) return -1;
+        values[count++] = (int)value;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return count > 0 ? count : -1;
+}
+
+static int parse_double_list(const char* text, double* values, int max) {
+    int count = 0;
+    const char* p = text;
+    while (*p) {
+        char* end;
+        double value = strtod(p, &end);
+        if (end == p || value <= 0.0 || count == max || (*end != ',' && *end != '\0')) return -1;
+        values[count++] = value;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return count > 0 ? count : -1;
+}
+
+static int write_results_csv(const char* path, const SweepTrial* trials, int count) {
+    FILE* file = fopen(path, "w");
+    if (!file) return -1;
+
+    fprintf(file, "rank,hidden,sequence,learning_rate,status,epochs,best_epoch,initial_loss,best_loss,seconds,"
+            "loss_per_second\n");
+    for (int i = 0; i < count; i++) {
+        const SweepTrial* t = &trials[i];
+        fprintf(file, "%d,%d,%d,%g,%s,%d,%d,%.8f,%.8f,%.4f,%.8f\n", i + 1, t->hidden_size, t->sequence_length,
+                t->learning_rate, sweep_status_name(t->status), t->epochs_run, t->best_epoch, t->initial_loss,
+                t->best_loss, t->seconds, sweep_efficiency(t));
+    }
+
+    int status = ferror(file) ? -1 : 0;
+    if (fclose(file) != 0) status = -1;
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    char* data_file = NULL;
+    char* output_file = NULL;
+    int hidden[SWEEP_MAX_VALUES] = {32, 64};
+    int n_hidden = 2;
+    int sequence[SWEEP_MAX_VALUES] = {10};
+    int n_sequence = 1;
+    double learning_rate[SWEEP_MAX_VALUES] = {0.01, 0.001};
+    int n_learning_rate = 2;
+    double validation = 0.2;
+    int by_loss = 0;
+    SweepOptions options;
+    sweep_options_default(&options);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--data") == 0 && i + 1 < argc) {
+            data_file = argv[++i];
+        } else if (strcmp(argv[i], "--hidden") == 0 && i + 1 < argc) {
+            n_hidden = parse_int_list(argv[++i], hidden, SWEEP_MAX_VALUES);
+        } else if (strcmp(argv[i], "--sequence") == 0 && i + 1 < argc) {
+            n_sequence = parse_int_list(argv[++i], sequence, SWEEP_MAX_VALUES);
+        } else if (strcmp(argv[i], "--learning-rate") == 0 && i + 1 < argc) {
+            n_learning_rate = parse_double_list(argv[++i], learning_rate, SWEEP_MAX_VALUES);
+        } else if (strcmp(argv[i], "--epochs") == 0 && i + 1 < argc) {
+            options.epochs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch-size") == 0 && i + 1 < argc) {
+            options.batch_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--validation") == 0 && i + 1 < argc) {
+            validation = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--cores") == 0 && i + 1 < argc) {
+            options.cores = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--eval-every") == 0 && i + 1 < argc) {
+            options.eval_every = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--patience") == 0 && i + 1 < argc) {
+            options.patience = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--prune-factor") == 0 && i + 1 < argc) {
+            options.prune_factor = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--rank") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "loss") == 0) {
+                by_loss = 1;
+            } else if (strcmp(argv[i], "efficiency") == 0) {
+                by_loss = 0;
+            } else {
+                printf("Error: Unknown rank order %s (use efficiency or loss)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output_file = argv[++i];
+        } else if (strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            printf("Unknown argument: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!data_file) {
+        printf("Error: Missing required arguments\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (n_hidden < 0 || n_sequence < 0 || n_learning_rate < 0) {
+        printf("Error: Value lists must hold 1 to %d positive numbers\n", SWEEP_MAX_VALUES);
+        return 1;
+    }
+
+    if (options.epochs <= 0 || options.batch_size <= 0 || options.cores <= 0 || options.eval_every <= 0 ||
+        options.patience < 0 || options.prune_factor < 0.0 || validation <= 0.0 || validation >= 1.0) {
+        printf("Error: Invalid parameter values\n");
+        return 1;
+    }
+
+    SweepTrial* trials = malloc(SWEEP_MAX_TRIALS * sizeof(SweepTrial));
+    int count = trials ? sweep_grid(trials, SWEEP_MAX_TRIALS, hidden, n_hidden, sequence, n_sequence,
+                                    learning_rate, n_learning_rate) : -1;
+    if (count <= 0) {
+        printf("Error: Could not build the trial grid\n");
+        free(trials);
+        return 1;
+    }
+
+    printf("Weather LSTM Hyperparameter Sweep\n");
+    printf("=================================\n");
+    printf("Data file: %s\n", data_file);
+    printf("Trials: %d (%d hidden x %d sequence x %d learning rate)\n", count, n_hidden, n_sequence,
+           n_learning_rate);
+    printf("Epochs per trial: %d\n", options.epochs);
+    printf("Cores: %d\n", options.cores);
+    printf("Matrix kernels: %s\n", matrix_kernels()->name);
+    printf("\n");
+
+    // Loaded and normalized once; every trial reads these rows in place
+    double run_start = profile_seconds();
+    WeatherDataset* dataset = weather_dataset_create(1000);
+    if (!dataset) {
+        printf("Error: Could not create dataset\n");
+        free(trials);
+        return 1;
+    }
+
+    int binary = weather_is_binary(data_file);
+    int prenormalized = 0;
+    NormalizationParams file_params;
+    int load_status = binary ? weather_load_binary(data_file, dataset, &file_params, &prenormalized)
+                             : weather_load_csv(data_file, dataset);
+    if (load_status != 0) {
+        printf("Error: Could not load weather data from %s\n", data_file);
+        weather_dataset_free(dataset);
+        free(trials);
+        return 1;
+    }
+
+    if (!prenormalized) {
+        NormalizationParams* norm_params = NULL;
+        if (binary) {
+            norm_params = malloc(sizeof(NormalizationParams));
+            if (norm_params) *norm_params = file_params;
+        } else {
+            norm_params = calculate_normalization_params(dataset);
+        }
+        if (!norm_params) {
+            printf("Error: Could not calculate normalization parameters\n");
+            weather_dataset_free(dataset);
+            free(trials);
+            return 1;
+        }
+        normalize_dataset(dataset, norm_params);
+        free(norm_params);
+    }
+
+    int split_row = (int)(dataset->size * (1.0 - validation));
+    printf("Loaded %d rows in %.2f s: %d train, %d validation\n\n", dataset->size, profile_seconds() - run_start,
+           split_row, dataset->size - split_row);
+
+    double sweep_start = profile_seconds();
+    if (sweep_run((double*)dataset->data, dataset->size, split_row, trials, count, &options) != 0) {
+        printf("Error: Dataset too small or invalid sweep options\n");
+        weather_dataset_free(dataset);
+        free(trials);
+        return 1;
+    }
+    double sweep_seconds = profile_seconds() - sweep_start;
+
+    sweep_rank(trials, count, by_loss);
+
+    double trial_seconds = 0.0;
+    printf("\nRanked by %s\n", by_loss ? "best validation loss" : "validation loss removed per second");
+    printf("%4s %6s %8s %10s %9s %6s %12s %9s %12s\n", "rank", "hidden", "sequence", "lr", "status", "epochs",
+           "best loss", "seconds", "loss/s");
+    for (int i = 0; i < count; i++) {
+        const SweepTrial* t = &trials[i];
+        printf("%4d %6d %8d %10g %9s %6d %12.6f %9.2f %12.6f\n", i + 1, t->hidden_size, t->sequence_length,
+               t->learning_rate, sweep_status_name(t->status), t->epochs_run, t->best_loss, t->seconds,
+               sweep_efficiency(t));
+        trial_seconds += t->seconds;
+    }
+    printf("\nSweep wall time: %.2f s for %.2f s of trials (%.2fx)\n", sweep_seconds, trial_seconds,
+           sweep_seconds > 0.0 ? trial_seconds / sweep_seconds : 0.0);
+
+    int status = 0;
+    if (output_file) {
+        if (write_results_csv(output_file, trials, count) != 0) {
+            printf("Error: Could not write results to %s\n", output_file);
+            status = 1;
+        } else {
+            printf("Results written to %s\n", output_file);
+        }
+    }
+
+    weather_dataset_free(dataset);
+    free(trials);
+    return status;
+}
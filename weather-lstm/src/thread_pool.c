@@ -0,0 +1,155 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "../include/thread_pool.h"
+#include "../include/matrix_kernels.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+struct ThreadPool {
+    int num_workers;
+    pthread_t* threads;         // [num_workers - 1]; worker 0 is the caller
+    pthread_mutex_t lock;
+    pthread_cond_t start;       // Signals a new generation (or shutdown)
+    pthread_cond_t done;        // Signals the last worker finished a run
+    pthread_barrier_t barrier;
+    ThreadPoolTask task;
+    void* ctx;
+    unsigned long generation;   // Incremented once per run
+    int pending;                // Helper threads still inside the current run
+    int shutdown;
+};
+
+typedef struct {
+    ThreadPool* pool;
+    int worker;
+} WorkerArgs;
+
+static void* worker_main(void* arg) {
+    WorkerArgs* args = arg;
+    ThreadPool* pool = args->pool;
+    int worker = args->worker;
+    free(args);
+
+    unsigned long seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        ThreadPoolTask task = pool->task;
+        void* ctx = pool->ctx;
+        pthread_mutex_unlock(&pool->lock);
+
+        task(ctx, worker, pool->num_workers);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+ThreadPool* thread_pool_create(int num_workers) {
+    if (num_workers <= 0) return NULL;
+
+    ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+
+    pool->num_workers = num_workers;
+    pool->threads = calloc((size_t)num_workers, sizeof(pthread_t));
+    if (!pool->threads) {
+        free(pool);
+        return NULL;
+    }
+
+    if (pthread_barrier_init(&pool->barrier, NULL, (unsigned)num_workers) != 0) {
+        free(pool->threads);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    // Resolve the kernel table before any worker can race on it
+    matrix_kernels();
+
+    for (int w = 1; w < num_workers; w++) {
+        WorkerArgs* args = malloc(sizeof(WorkerArgs));
+        if (args) {
+            args->pool = pool;
+            args->worker = w;
+        }
+        if (!args || pthread_create(&pool->threads[w - 1], NULL, worker_main, args) != 0) {
+            free(args);
+            pool->num_workers = w;  // Only join the threads that started
+            thread_pool_free(pool);
+            return NULL;
+        }
+    }
+
+    return pool;
+}
+
+void thread_pool_free(ThreadPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int w = 1; w < pool->num_workers; w++) {
+        pthread_join(pool->threads[w - 1], NULL);
+    }
+
+    pthread_barrier_destroy(&pool->barrier);
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
+
+int thread_pool_size(ThreadPool* pool) {
+    return pool ? pool->num_workers : 0;
+}
+
+void thread_pool_run(ThreadPool* pool, ThreadPoolTask task, void* ctx) {
+    if (!pool || !task) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->ctx = ctx;
+    pool->pending = pool->num_workers - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    task(ctx, 0, pool->num_workers);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_barrier(ThreadPool* pool) {
+    if (!pool || pool->num_workers == 1) return;
+
+    pthread_barrier_wait(&pool->barrier);
+}
+
+void thread_pool_range(int count, int worker, int num_workers, int* first, int* last) {
+    int base = count / num_workers;
+    int extra = count % num_workers;
+    *first = worker * base + (worker < extra ? worker : extra);
+    *last = *first + base + (worker < extra ? 1 : 0);
+}
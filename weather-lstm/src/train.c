@@ -1,5 +1,13 @@
 #include "../include/lstm.h"
 #include "../include/weather_data.h"
+#include "../include/matrix_kernels.h"
+#include "../include/train_parallel.h"
+#include "../include/profile.h"
+#include "../include/online.h"
+#include "../include/evaluate.h"
+#include "../include/optimizer.h"
+#include "../include/checkpoint.h"
+#include "../include/large_alloc.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,23 +16,228 @@
 void print_usage(const char* program_name) {
     printf("Usage: %s --data <csv_file> --epochs <num_epochs> --output <model_file> [options]\n", program_name);
     printf("Options:\n");
-    printf("  --data <file>        Path to weather data CSV file\n");
+    printf("  --data <file>        Path to weather data CSV or binary dataset file (- reads CSV from stdin)\n");
     printf("  --epochs <number>    Number of training epochs (default: 100)\n");
     printf("  --output <file>      Output model file path\n");
     printf("  --hidden <size>      Hidden layer size (default: 64)\n");
+    printf("  --layers <n>         Stacked LSTM layers, up to %d (default: 1)\n", LSTM_MAX_LAYERS);
     printf("  --sequence <length>  Sequence length (default: 10)\n");
     printf("  --learning-rate <lr> Learning rate (default: 0.001)\n");
+    printf("  --bptt-window <n>    Truncate backpropagation to the last n steps (default: full sequence)\n");
+    printf("  --batch-size <n>     Sequences per gradient update (default: 1)\n");
+    printf("  --optimizer <type>   Update rule: sgd, momentum or adam (default: sgd)\n");
+    printf("  --momentum <mu>      Velocity decay for --optimizer momentum (default: 0.9)\n");
+    printf("  --clip-norm <max>    Rescale gradients whose global L2 norm exceeds max (default: off)\n");
+    printf("  --threads <n>        Data-parallel worker threads (default: 1)\n");
+    printf("  --pipeline <n>       Threads running stacked layers as a wavefront (default: 1)\n");
+    printf("  --validation <frac>  Hold out this fraction of rows, from the end, and score on it (default: 0)\n");
+    printf("  --eval-every <n>     Score the held-out rows every n epochs (default: after training only)\n");
+    printf("  --eval-threads <n>   Threads scoring held-out windows (default: --threads)\n");
+    printf("  --profile <format>   Print a per-phase timing report: text or json (build with make PROFILE=1)\n");
+    printf("  --hugepages <mode>   Pages for buffers of 2 MB and up: default, thp or hugetlb (default: default)\n");
+    printf("  --numa               Interleave the dataset over NUMA nodes; workers build their state locally\n");
+    printf("\nCheckpoints (written by a background thread while training runs):\n");
+    printf("  --checkpoint <file>  Keep a resumable checkpoint of weights and optimizer state here\n");
+    printf("  --checkpoint-every <n>   Epochs between checkpoints (default: 10 without --checkpoint-seconds)\n");
+    printf("  --checkpoint-seconds <t> Also checkpoint after the first epoch ending t seconds after the last\n");
+    printf("  --resume <checkpoint>    Continue the interrupted run on the same --data up to --epochs\n");
+    printf("\nIncremental mode (continue an existing model on new rows only):\n");
+    printf("  --continue <model>   Start from this model's weights and normalization\n");
+    printf("  --update-every <n>   Train and save after every n new rows (default: at end of input)\n");
     printf("  --help               Show this help message\n");
 }
 
+// Read a CSV stream line by line. The first line that is not a data row is
+// taken as the header and decides the layout; comment lines are skipped.
+// Returns the number of rows handed to the online trainer, or -1.
+static long online_read_rows(FILE* in, OnlineTrainer* online, int update_every, int epochs,
+                             const char* model_file, long* skipped) {
+    char line[4096];
+    int has_timestamps = 0, header_seen = 0;
+    long rows = 0;
+    
+    while (fgets(line, sizeof(line), in)) {
+        size_t length = strcspn(line, "\n");
+        if (length == 0 || line[0] == '#') continue;
+        
+        WeatherPoint point;
+        if (weather_parse_csv_line(line, length, has_timestamps, &point) != 0) {
+            if (!header_seen) {
+                line[length] = '\0';
+                has_timestamps = weather_csv_header_has_timestamps(line);
+                header_seen = 1;
+            } else {
+                (*skipped)++;
+            }
+            continue;
+        }
+        header_seen = 1;
+        if (online_trainer_add(online, &point) != 0) return -1;
+        rows++;
+        
+        // Checkpoint after every update so a killed stream loses at most one batch
+        if (update_every > 0 && online_trainer_pending(online) >= update_every) {
+            double loss = online_trainer_update(online, epochs);
+            if (loss < 0.0 || save_lstm_model(online->network, model_file) != 0) return -1;
+            printf("Update: %ld rows seen, %ld windows trained, loss %.6f, saved %s\n",
+                   online->rows_seen, online->windows_trained, loss, model_file);
+            fflush(stdout);
+        }
+    }
+    
+    return ferror(in) ? -1 : rows;
+}
+
+// Incremental mode: continue model_in on the rows of data_file only
+static int train_online(const char* model_in, const char* data_file, const char* model_file, int epochs,
+                        double learning_rate, int bptt_window, int batch_size, int update_every,
+                        const OptimizerConfig* optimizer_config) {
+    printf("Weather LSTM Incremental Training\n");
+    printf("=================================\n");
+    printf("Continuing model: %s (incremental mode: only the new rows are trained)\n", model_in);
+    printf("Data: %s\n", strcmp(data_file, "-") == 0 ? "stdin" : data_file);
+    printf("Model file: %s\n", model_file);
+    printf("Epochs per update: %d\n", epochs);
+    printf("Optimizer: %s\n", optimizer_name(optimizer_config->type));
+    
+    LSTMNetwork* network = load_lstm_model(model_in);
+    if (!network) {
+        printf("Error: Could not load model from %s\n", model_in);
+        return 1;
+    }
+    network->learning_rate = learning_rate;
+    network->bptt_window = bptt_window;
+    network->batch_size = batch_size;
+    printf("Input size: %d, Hidden size: %d, Layers: %d, Sequence length: %d\n\n",
+           network->input_size, network->hidden_size, network->num_layers, network->sequence_length);
+    if (!network->norm_params) {
+        printf("Warning: Model has no normalization parameters; starting them from the new rows\n");
+    }
+    
+    Optimizer* optimizer = optimizer_create(network, optimizer_config);
+    network->optimizer = optimizer;
+    OnlineTrainer* online = optimizer ? online_trainer_create(network) : NULL;
+    if (!online) {
+        printf("Error: Could not allocate incremental training workspace\n");
+        optimizer_free(optimizer);
+        lstm_network_free(network);
+        return 1;
+    }
+    
+    // Binary datasets hold raw rows in memory already; CSV input streams
+    int status = 0;
+    long skipped = 0;
+    double start = profile_seconds();
+    if (strcmp(data_file, "-") != 0 && weather_is_binary(data_file)) {
+        WeatherDataset* dataset = weather_dataset_create(1);
+        int normalized = 0;
+        if (!dataset || weather_load_binary(data_file, dataset, NULL, &normalized) != 0 || normalized) {
+            printf("Error: %s must be a binary dataset of raw rows\n", data_file);
+            status = -1;
+        }
+        for (int i = 0; status == 0 && dataset && i < dataset->size; i++) {
+            status = online_trainer_add(online, &dataset->data[i]);
+        }
+        weather_dataset_free(dataset);
+    } else {
+        FILE* in = strcmp(data_file, "-") == 0 ? stdin : fopen(data_file, "r");
+        if (!in) {
+            printf("Error: Could not open file %s\n", data_file);
+            status = -1;
+        } else {
+            status = online_read_rows(in, online, update_every, epochs, model_file, &skipped) < 0 ? -1 : 0;
+            if (in != stdin) fclose(in);
+        }
+    }
+    
+    // Whatever is left over trains now
+    if (status == 0 && online_trainer_pending(online) > 0) {
+        double loss = online_trainer_update(online, epochs);
+        status = loss < 0.0 ? -1 : 0;
+        if (status == 0) {
+            printf("Update: %ld rows seen, %ld windows trained, loss %.6f\n",
+                   online->rows_seen, online->windows_trained, loss);
+        }
+    }
+    if (status == 0 && save_lstm_model(network, model_file) != 0) {
+        printf("Error: Could not save model\n");
+        status = -1;
+    }
+    
+    if (status == 0) {
+        if (skipped > 0) printf("Warning: %ld invalid lines were skipped\n", skipped);
+        if (online->windows_trained == 0) {
+            printf("Note: Need more than %d rows to form a window; the model is unchanged\n", online->context);
+        }
+        printf("\nTrained %ld new windows from %ld rows in %.2f seconds\n", online->windows_trained,
+               online->rows_seen, profile_seconds() - start);
+        printf("Normalization widened in %d of the updates\n", online->renormalized);
+        printf("Model saved to %s\n", model_file);
+    } else {
+        printf("Error: Incremental training failed\n");
+    }
+    
+    online_trainer_free(online);
+    optimizer_free(optimizer);
+    lstm_network_free(network);
+    return status == 0 ? 0 : 1;
+}
+
+typedef struct {
+    Evaluator* evaluator;
+    TrainingData* held_out;
+    int eval_every;             // 0 scores after training only
+    Checkpointer* checkpointer;
+} EpochHooks;
+
+// Epoch callback: score the held-out windows every few epochs and hand
+// snapshots to the checkpoint writer when one is due
+static void after_epoch(LSTMNetwork* network, int epoch, double loss, void* context) {
+    EpochHooks* hooks = context;
+    
+    if (hooks->evaluator && hooks->eval_every > 0 && epoch % hooks->eval_every == 0) {
+        EvaluationResult result;
+        if (evaluator_run(hooks->evaluator, network, hooks->held_out, &result) != 0) {
+            printf("Epoch %d: Evaluation failed\n", epoch);
+        } else {
+            printf("Epoch %d: Training Loss = %.6f, Validation Loss = %.6f, Temperature MAE = %.3f (%.3f s)\n",
+                   epoch, loss, result.loss, result.mae[0], result.seconds);
+        }
+    }
+    
+    if (hooks->checkpointer && checkpointer_epoch(hooks->checkpointer, network, network->optimizer, epoch) < 0) {
+        printf("Epoch %d: Could not take a checkpoint\n", epoch);
+    }
+}
+
 int main(int argc, char* argv[]) {
     // Default parameters
     char* data_file = NULL;
     char* model_file = NULL;
     int epochs = 100;
     int hidden_size = 64;
+    int num_layers = 1;
     int sequence_length = 10;
     double learning_rate = 0.001;
+    int bptt_window = 0;
+    int batch_size = 1;
+    int threads = 1;
+    int pipeline = 1;
+    char* resume_file = NULL;
+    char* continue_file = NULL;
+    int update_every = 0;
+    double validation = 0.0;
+    int eval_every = 0;
+    int eval_threads = 0;
+    char* checkpoint_file = NULL;
+    int checkpoint_every = 0;
+    double checkpoint_seconds = 0.0;
+    OptimizerConfig optimizer_config;
+    optimizer_config_default(&optimizer_config, OPTIMIZER_SGD);
+    int profile = 0;
+    ProfileFormat profile_format = PROFILE_FORMAT_TEXT;
+    LargeAllocPolicy memory_policy;
+    large_alloc_policy_default(&memory_policy);
     
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -36,10 +249,60 @@ int main(int argc, char* argv[]) {
             model_file = argv[++i];
         } else if (strcmp(argv[i], "--hidden") == 0 && i + 1 < argc) {
             hidden_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--layers") == 0 && i + 1 < argc) {
+            num_layers = atoi(argv[++i]);
         } else if (strcmp(argv[i], "--sequence") == 0 && i + 1 < argc) {
             sequence_length = atoi(argv[++i]);
         } else if (strcmp(argv[i], "--learning-rate") == 0 && i + 1 < argc) {
             learning_rate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--bptt-window") == 0 && i + 1 < argc) {
+            bptt_window = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch-size") == 0 && i + 1 < argc) {
+            batch_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--optimizer") == 0 && i + 1 < argc) {
+            if (optimizer_parse(argv[++i], &optimizer_config.type) != 0) {
+                printf("Error: Unknown optimizer %s (use sgd, momentum or adam)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--momentum") == 0 && i + 1 < argc) {
+            optimizer_config.momentum = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--clip-norm") == 0 && i + 1 < argc) {
+            optimizer_config.clip_norm = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc) {
+            pipeline = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+            resume_file = argv[++i];
+        } else if (strcmp(argv[i], "--continue") == 0 && i + 1 < argc) {
+            continue_file = argv[++i];
+        } else if (strcmp(argv[i], "--update-every") == 0 && i + 1 < argc) {
+            update_every = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--validation") == 0 && i + 1 < argc) {
+            validation = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--eval-every") == 0 && i + 1 < argc) {
+            eval_every = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--eval-threads") == 0 && i + 1 < argc) {
+            eval_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpoint_file = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+            checkpoint_every = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--checkpoint-seconds") == 0 && i + 1 < argc) {
+            checkpoint_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            if (profile_format_parse(argv[++i], &profile_format) != 0) {
+                printf("Error: Unknown profile format %s (use text or json)\n", argv[i]);
+                return 1;
+            }
+            profile = 1;
+        } else if (strcmp(argv[i], "--hugepages") == 0 && i + 1 < argc) {
+            if (large_pages_parse(argv[++i], &memory_policy.pages) != 0) {
+                printf("Error: Unknown hugepage mode %s (use default, thp or hugetlb)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--numa") == 0) {
+            memory_policy.numa = 1;
         } else if (strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return 0;
@@ -57,10 +320,105 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    if (epochs <= 0 || hidden_size <= 0 || sequence_length <= 0 || learning_rate <= 0) {
+    if (epochs <= 0 || hidden_size <= 0 || sequence_length <= 0 || learning_rate <= 0 || bptt_window < 0 ||
+        batch_size <= 0 || threads <= 0 || num_layers <= 0 || num_layers > LSTM_MAX_LAYERS || pipeline <= 0) {
+        printf("Error: Invalid parameter values\n");
+        return 1;
+    }
+    
+    if (validation < 0.0 || validation >= 1.0 || eval_every < 0 || eval_threads < 0 ||
+        optimizer_config.momentum < 0.0 || optimizer_config.momentum >= 1.0 || optimizer_config.clip_norm < 0.0) {
         printf("Error: Invalid parameter values\n");
         return 1;
     }
+    if ((eval_every > 0 || eval_threads > 0) && validation == 0.0) {
+        printf("Error: --eval-every and --eval-threads need --validation\n");
+        return 1;
+    }
+    if (eval_threads == 0) eval_threads = threads;
+    
+    if (checkpoint_every < 0 || checkpoint_seconds < 0.0) {
+        printf("Error: Invalid parameter values\n");
+        return 1;
+    }
+    if ((checkpoint_every > 0 || checkpoint_seconds > 0.0) && !checkpoint_file) {
+        printf("Error: --checkpoint-every and --checkpoint-seconds need --checkpoint\n");
+        return 1;
+    }
+    if (checkpoint_file && checkpoint_every == 0 && checkpoint_seconds == 0.0) checkpoint_every = 10;
+    
+    // Before the first allocation, so the dataset and weights follow it
+    large_alloc_set_policy(&memory_policy);
+    
+    // Data-parallel workers each run a whole batch; pipelining splits one
+    if (threads > 1 && pipeline > 1) {
+        printf("Error: --pipeline cannot be combined with --threads\n");
+        return 1;
+    }
+    
+    // --resume continues a checkpointed run; --continue trains a model on
+    // new rows. A file of the wrong kind is an error, not a silent switch.
+    if (resume_file && continue_file) {
+        printf("Error: --resume and --continue cannot be combined\n");
+        return 1;
+    }
+    CheckpointInfo resume_info;
+    int resume_checkpoint = 0;
+    if (resume_file) {
+        resume_checkpoint = checkpoint_read_info(resume_file, &resume_info);
+        if (resume_checkpoint < 0) {
+            printf("Error: Could not read %s\n", resume_file);
+            return 1;
+        }
+        if (resume_checkpoint == 0) {
+            printf("Error: %s has no training state; use --continue to train the model on new rows\n",
+                   resume_file);
+            return 1;
+        }
+    }
+    if (resume_checkpoint) {
+        if (resume_info.state.optimizer_type != (uint32_t)optimizer_config.type) {
+            printf("Error: %s was trained with --optimizer %s\n", resume_file,
+                   optimizer_name((OptimizerType)resume_info.state.optimizer_type));
+            return 1;
+        }
+        if (resume_info.state.epoch >= epochs) {
+            printf("Error: %s already completed %d of %d epochs\n", resume_file, resume_info.state.epoch, epochs);
+            return 1;
+        }
+        if (update_every > 0) {
+            printf("Error: --update-every applies to incremental mode only\n");
+            return 1;
+        }
+        
+        // The shape is the checkpoint's own
+        hidden_size = resume_info.model.hidden_size;
+        num_layers = resume_info.model.version == 1 ? 1 : (int)resume_info.model.num_layers;
+        sequence_length = resume_info.model.sequence_length;
+        if (num_layers <= 0 || num_layers > LSTM_MAX_LAYERS || sequence_length <= 0) {
+            printf("Error: Corrupt checkpoint header in %s\n", resume_file);
+            return 1;
+        }
+    } else if (continue_file) {
+        if (checkpoint_read_info(continue_file, &resume_info) == 1) {
+            printf("Note: %s is a checkpoint; its weights are continued on new rows, not its run "
+                   "(use --resume for that)\n", continue_file);
+        }
+        if (checkpoint_file) {
+            printf("Error: Incremental mode saves after every update; drop --checkpoint\n");
+            return 1;
+        }
+        if (update_every < 0 || threads > 1 || pipeline > 1 || validation > 0.0) {
+            printf("Error: --continue trains on one thread, without --validation, with a non-negative --update-every\n");
+            return 1;
+        }
+        return train_online(continue_file, data_file, model_file, epochs, learning_rate, bptt_window,
+                            batch_size, update_every, &optimizer_config);
+    }
+    if (strcmp(data_file, "-") == 0) {
+        printf("Error: Reading from stdin needs --continue with a model file\n");
+        return 1;
+    }
     
     printf("Weather LSTM Training\n");
     printf("====================\n");
@@ -68,22 +426,46 @@ int main(int argc, char* argv[]) {
     printf("Model file: %s\n", model_file);
     printf("Epochs: %d\n", epochs);
     printf("Hidden size: %d\n", hidden_size);
+    printf("Layers: %d\n", num_layers);
     printf("Sequence length: %d\n", sequence_length);
     printf("Learning rate: %.4f\n", learning_rate);
+    printf("Batch size: %d\n", batch_size);
+    printf("Optimizer: %s\n", optimizer_name(optimizer_config.type));
+    printf("Threads: %d\n", threads);
+    printf("Matrix kernels: %s\n", matrix_kernels()->name);
+    printf("Memory: %s pages, %s\n", large_pages_name(memory_policy.pages),
+           memory_policy.numa ? "NUMA placement" : "no NUMA placement");
+    if (resume_checkpoint) {
+        printf("Resuming from checkpoint: %s (%d of %d epochs done)\n", resume_file, resume_info.state.epoch, epochs);
+    }
+    if (checkpoint_file) {
+        printf("Checkpoint: %s", checkpoint_file);
+        if (checkpoint_every > 0) printf(", every %d epochs", checkpoint_every);
+        if (checkpoint_seconds > 0.0) printf(", every %g s", checkpoint_seconds);
+        printf("\n");
+    }
     printf("\n");
     
     // Initialize random seed
     srand(time(NULL));
+    double run_start = profile_seconds();
     
     // Load weather data
     printf("Loading weather data...\n");
+    PROFILE_BEGIN(PROFILE_LOAD);
     WeatherDataset* dataset = weather_dataset_create(1000);
     if (!dataset) {
         printf("Error: Could not create dataset\n");
         return 1;
     }
     
-    if (weather_load_csv(data_file, dataset) != 0) {
+    // Binary datasets are mapped in place and carry precomputed normalization
+    int binary = weather_is_binary(data_file);
+    int prenormalized = 0;
+    NormalizationParams file_params;
+    int load_status = binary ? weather_load_binary(data_file, dataset, &file_params, &prenormalized)
+                             : weather_load_csv(data_file, dataset);
+    if (load_status != 0) {
         printf("Error: Could not load weather data from %s\n", data_file);
         weather_dataset_free(dataset);
         return 1;
@@ -98,7 +480,17 @@ int main(int argc, char* argv[]) {
     
     // Calculate and apply normalization
     printf("Normalizing data...\n");
-    NormalizationParams* norm_params = calculate_normalization_params(dataset);
+    NormalizationParams* norm_params = NULL;
+    if (resume_checkpoint && resume_info.model.has_norm_params && !prenormalized) {
+        // The weights were trained on rows scaled by the checkpoint's params
+        norm_params = malloc(sizeof(NormalizationParams));
+        if (norm_params) *norm_params = resume_info.model.norm_params;
+    } else if (binary) {
+        norm_params = malloc(sizeof(NormalizationParams));
+        if (norm_params) *norm_params = file_params;
+    } else {
+        norm_params = calculate_normalization_params(dataset);
+    }
     if (!norm_params) {
         printf("Error: Could not calculate normalization parameters\n");
         weather_dataset_free(dataset);
@@ -106,52 +498,196 @@ int main(int argc, char* argv[]) {
     }
     
     print_normalization_params(norm_params);
-    normalize_dataset(dataset, norm_params);
+    if (!prenormalized) {
+        normalize_dataset(dataset, norm_params);
+    }
+    PROFILE_WORK(PROFILE_LOAD, 0, (size_t)dataset->size * sizeof(WeatherPoint));
+    PROFILE_END(PROFILE_LOAD);
+    
+    // Hold out the newest rows; no training window reaches into them
+    WeatherDataset* held_out_rows = NULL;
+    if (validation > 0.0) {
+        WeatherDataset* train_rows = weather_dataset_create(dataset->size);
+        held_out_rows = weather_dataset_create((int)(dataset->size * validation) + 1);
+        if (train_rows && held_out_rows) {
+            split_dataset(dataset, train_rows, held_out_rows, 1.0 - validation);
+        }
+        weather_dataset_free(dataset);
+        dataset = train_rows;
+        if (!dataset || !held_out_rows || dataset->size <= sequence_length ||
+            held_out_rows->size <= sequence_length) {
+            printf("Error: Both sides of the validation split need more than %d data points\n", sequence_length);
+            free(norm_params);
+            weather_dataset_free(dataset);
+            weather_dataset_free(held_out_rows);
+            return 1;
+        }
+        printf("Held out the last %d rows for validation\n", held_out_rows->size);
+    }
     
     // Create training data
     printf("Creating training sequences...\n");
+    PROFILE_BEGIN(PROFILE_SEQUENCES);
     TrainingData* training_data = create_training_data(dataset, sequence_length);
-    if (!training_data) {
+    PROFILE_END(PROFILE_SEQUENCES);
+    TrainingData* held_out = held_out_rows ? create_training_data(held_out_rows, sequence_length) : NULL;
+    if (!training_data || (held_out_rows && !held_out)) {
         printf("Error: Could not create training data\n");
+        free_training_data(training_data);
         free(norm_params);
         weather_dataset_free(dataset);
+        weather_dataset_free(held_out_rows);
         return 1;
     }
     
     printf("Created %d training sequences\n", training_data->num_sequences);
     
     // Create LSTM network
-    printf("Creating LSTM network...\n");
-    LSTMNetwork* network = lstm_network_create(6, hidden_size, 6); // 6 weather features
+    printf(resume_checkpoint ? "Loading LSTM network...\n" : "Creating LSTM network...\n");
+    LSTMNetwork* network = NULL;
+    if (resume_checkpoint) {
+        network = load_lstm_model(resume_file);
+        if (network && (network->input_size != 6 || network->output_size != 6)) {
+            lstm_network_free(network);
+            network = NULL;
+        }
+    } else {
+        network = lstm_network_create_stacked(6, hidden_size, 6, num_layers); // 6 weather features
+    }
     if (!network) {
         printf("Error: Could not create LSTM network\n");
         free_training_data(training_data);
+        free_training_data(held_out);
         free(norm_params);
         weather_dataset_free(dataset);
+        weather_dataset_free(held_out_rows);
         return 1;
     }
     
     network->learning_rate = learning_rate;
     network->sequence_length = sequence_length;
+    network->bptt_window = bptt_window;
+    network->batch_size = batch_size;
+    network->pipeline_threads = pipeline;
+    free(network->norm_params);
     network->norm_params = norm_params;
     
+    // Optimizer state sits beside the weights for the whole run
+    Optimizer* optimizer = optimizer_create(network, &optimizer_config);
+    int first_epoch = 0;
+    Checkpointer* checkpointer = NULL;
+    if (optimizer && resume_checkpoint && checkpoint_restore(resume_file, optimizer, &first_epoch) != 0) {
+        optimizer_free(optimizer);
+        optimizer = NULL;
+    }
+    if (optimizer && checkpoint_file) {
+        checkpointer = checkpointer_create(network, optimizer, checkpoint_file, checkpoint_every, checkpoint_seconds);
+        if (!checkpointer) {
+            optimizer_free(optimizer);
+            optimizer = NULL;
+        }
+    }
+    if (!optimizer) {
+        printf("Error: Could not create the optimizer and checkpoint state\n");
+        free_training_data(training_data);
+        free_training_data(held_out);
+        weather_dataset_free(dataset);
+        weather_dataset_free(held_out_rows);
+        lstm_network_free(network);
+        return 1;
+    }
+    network->optimizer = optimizer;
+    
+    // One evaluator serves every pass, so scoring allocates nothing
+    Evaluator* evaluator = NULL;
+    EpochHooks hooks = {NULL, held_out, eval_every, checkpointer};
+    if (held_out) {
+        evaluator = evaluator_create(network, eval_threads, 64);
+        if (!evaluator) {
+            printf("Error: Could not create the evaluator\n");
+            checkpointer_free(checkpointer);
+            optimizer_free(optimizer);
+            free_training_data(training_data);
+            free_training_data(held_out);
+            weather_dataset_free(dataset);
+            weather_dataset_free(held_out_rows);
+            lstm_network_free(network);
+            return 1;
+        }
+        printf("Created %d validation sequences, scored on %d threads\n", held_out->num_sequences, eval_threads);
+        hooks.evaluator = evaluator;
+    }
+    if ((evaluator && eval_every > 0) || checkpointer) {
+        network->epoch_callback = after_epoch;
+        network->epoch_context = &hooks;
+    }
+    
+    // A resumed run trains only the epochs it has left, numbered after the
+    // ones in the checkpoint
+    int run_epochs = epochs - first_epoch;
+    network->first_epoch = first_epoch;
+    
     // Train the network
     printf("Starting training...\n");
-    clock_t start_time = clock();
-    
-    lstm_train(network, training_data, epochs);
+    if (threads > 1) {
+        ParallelTrainStats stats;
+        if (lstm_train_parallel(network, training_data, run_epochs, threads, &stats) != 0) {
+            printf("Error: Parallel training failed\n");
+            checkpointer_free(checkpointer);
+            evaluator_free(evaluator);
+            optimizer_free(optimizer);
+            free_training_data(training_data);
+            free_training_data(held_out);
+            weather_dataset_free(dataset);
+            weather_dataset_free(held_out_rows);
+            lstm_network_free(network);
+            return 1;
+        }
+        
+        // Speedup is against a measured 1-thread reference. Utilization is
+        // compute time over threads x wall time; the rest is barrier wait and
+        // the serial weight update.
+        double speedup = parallel_train_speedup(&stats);
+        printf("Training completed in %.2f seconds\n", stats.wall_seconds);
+        printf("Throughput: %.1f sequences/s on %d threads\n",
+               stats.sequences / stats.wall_seconds, stats.threads);
+        if (speedup > 0.0) {
+            printf("Speedup: %.2fx over 1 thread, %.1f%% scaling efficiency (reference: %ld sequences, %.1f/s)\n",
+                   speedup, 100.0 * speedup / stats.threads, stats.reference_sequences,
+                   stats.reference_sequences / stats.reference_seconds);
+        }
+        printf("Worker utilization: %.1f%%\n", 100.0 * parallel_train_utilization(&stats));
+    } else {
+        // Wall time, so pipelined layers are not billed once per thread
+        double start_time = profile_seconds();
+        
+        lstm_train(network, training_data, run_epochs);
+        
+        double training_time = profile_seconds() - start_time;
+        printf("Training completed in %.2f seconds\n", training_time);
+    }
     
-    clock_t end_time = clock();
-    double training_time = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
-    printf("Training completed in %.2f seconds\n", training_time);
+    // Training never waited on the writer; the last checkpoint lands now
+    if (checkpointer) {
+        CheckpointStats stats;
+        int flushed = checkpointer_flush(checkpointer);
+        checkpointer_stats(checkpointer, &stats);
+        printf("Checkpoints: %ld written to %s, %ld superseded before writing\n", stats.written, checkpoint_file,
+               stats.replaced);
+        printf("Checkpoint cost: %.2f ms of snapshots on the training thread, %.3f s of background writes\n",
+               1000.0 * stats.snapshot_seconds, stats.write_seconds);
+        if (flushed != 0) printf("Error: %ld checkpoint writes failed\n", stats.failures);
+    }
     
     // Test the model on the last sequence
     printf("\nTesting model on last sequence...\n");
-    Matrix** test_sequence = training_data->inputs[training_data->num_sequences - 1];
-    Matrix* predicted = lstm_network_predict(network, test_sequence, sequence_length);
-    Matrix* actual = training_data->targets[training_data->num_sequences - 1];
+    int last = training_data->num_sequences - 1;
+    Matrix* predicted = matrix_create(network->output_size, 1);
+    Matrix* actual = matrix_wrap(training_data_target(training_data, last), network->output_size, 1, 1);
     
-    if (predicted && actual) {
+    if (predicted && actual &&
+        lstm_network_predict_window(network, training_data_input(training_data, last, 0),
+                                    sequence_length, predicted) == 0) {
         double test_loss = calculate_loss(predicted, actual);
         printf("Test loss: %.6f\n", test_loss);
         
@@ -167,8 +703,19 @@ int main(int argc, char* argv[]) {
         print_weather_point(&pred_weather);
         printf("Actual weather:\n");
         print_weather_point(&actual_weather);
-        
-        matrix_free(predicted);
+    }
+    matrix_free(predicted);
+    matrix_free(actual);
+    
+    // Every held-out window, scored once more with the final weights
+    if (evaluator) {
+        EvaluationResult result;
+        printf("\nEvaluating on held-out data...\n");
+        if (evaluator_run(evaluator, network, held_out, &result) == 0) {
+            evaluation_print(stdout, &result);
+        } else {
+            printf("Error: Evaluation failed\n");
+        }
     }
     
     // Save the trained model
@@ -179,9 +726,19 @@ int main(int argc, char* argv[]) {
         printf("Error: Could not save model\n");
     }
     
+    if (profile) {
+        profile_report(stdout, profile_format, profile_seconds() - run_start,
+                       (long)run_epochs * training_data->num_sequences);
+    }
+    
     // Clean up
+    checkpointer_free(checkpointer);
+    evaluator_free(evaluator);
+    optimizer_free(optimizer);
     free_training_data(training_data);
+    free_training_data(held_out);
     weather_dataset_free(dataset);
+    weather_dataset_free(held_out_rows);
     lstm_network_free(network);
     
     printf("\nTraining completed successfully!\n");
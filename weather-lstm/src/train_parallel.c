@@ -0,0 +1,245 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "../include/train_parallel.h"
+#include "../include/bptt.h"
+#include "../include/optimizer.h"
+#include "../include/thread_pool.h"
+#include <time.h>
+
+typedef struct {
+    LSTMNetwork* network;
+    TrainingData* data;
+    ThreadPool* pool;
+    int epochs;
+    int batch_size;
+    BPTTTrainer** trainers;     // [threads] per-worker tape, state and gradients
+    double* losses;             // [threads] loss of the worker's current batch
+    double* busy;               // [threads] seconds spent in forward/backward
+    int* failures;              // [threads] batches the worker had to skip
+    double final_loss;
+} ParallelContext;
+
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Each worker builds its own trainer. Large buffers are left untouched at
+// allocation (large_alloc.h), so the tape, gradients and arena fault in on
+// the worker's NUMA node rather than the caller's.
+static void parallel_create_worker(void* arg, int worker, int num_workers) {
+    ParallelContext* ctx = arg;
+    (void)num_workers;
+
+    ctx->trainers[worker] = bptt_trainer_create(ctx->network, ctx->data->sequence_length, ctx->batch_size);
+}
+
+// Worker body: the whole epoch loop runs inside one pool run, with barriers
+// separating compute, reduction and update phases of each step
+static void parallel_train_worker(void* arg, int worker, int num_workers) {
+    ParallelContext* ctx = arg;
+    LSTMNetwork* network = ctx->network;
+    TrainingData* data = ctx->data;
+    BPTTTrainer* trainer = ctx->trainers[worker];
+    int per_step = ctx->batch_size * num_workers;
+
+    for (int epoch = 0; epoch < ctx->epochs; epoch++) {
+        double total_loss = 0.0;
+
+        for (int base = 0; base < data->num_sequences; base += per_step) {
+            int first = base + worker * ctx->batch_size;
+            int count = data->num_sequences - first;
+            if (count > ctx->batch_size) count = ctx->batch_size;
+
+            // Compute: each worker reads the shared weights and fills its own buffers
+            double start = monotonic_seconds();
+            lstm_gradients_zero(trainer->grads);
+            ctx->losses[worker] = 0.0;
+            if (count > 0) {
+                if (bptt_load_batch(trainer, data, first, count) != 0 ||
+                    bptt_forward(trainer, network, trainer->inputs, data->sequence_length) != 0) {
+                    ctx->failures[worker]++;
+                } else {
+                    double loss = bptt_backward(trainer, network, trainer->targets, network->bptt_window);
+                    if (loss < 0.0) {
+                        ctx->failures[worker]++;
+                        lstm_gradients_zero(trainer->grads);
+                    } else {
+                        ctx->losses[worker] = loss;
+                    }
+                }
+            }
+            ctx->busy[worker] += monotonic_seconds() - start;
+
+            // Pairwise tree reduction into worker 0, log2(threads) levels
+            for (int span = 1; span < num_workers; span *= 2) {
+                thread_pool_barrier(ctx->pool);
+                if (worker % (2 * span) == 0 && worker + span < num_workers) {
+                    lstm_gradients_add(trainer->grads, ctx->trainers[worker + span]->grads);
+                }
+            }
+
+            // Update: worker 0 owns the weights; the others wait so the next
+            // forward pass sees the new values
+            if (worker == 0) {
+                int step_count = data->num_sequences - base;
+                if (step_count > per_step) step_count = per_step;
+                for (int w = 0; w < num_workers; w++) {
+                    total_loss += ctx->losses[w];
+                }
+                if (network->optimizer) {
+                    optimizer_step(network->optimizer, network, trainer->grads, 1.0 / step_count);
+                } else {
+                    lstm_gradients_apply(network, trainer->grads, network->learning_rate / step_count);
+                }
+            }
+            thread_pool_barrier(ctx->pool);
+        }
+
+        if (worker == 0) {
+            double avg_loss = total_loss / data->num_sequences;
+            ctx->final_loss = avg_loss;
+            int done = network->first_epoch + epoch;
+            if (done % 10 == 0) {
+                printf("Epoch %d/%d: Average Loss = %.6f\n", done + 1, network->first_epoch + ctx->epochs, avg_loss);
+            }
+
+            // The other workers only read the weights until the next update,
+            // which waits for worker 0 at the reduction barrier
+            if (network->epoch_callback) {
+                network->epoch_callback(network, done + 1, avg_loss, network->epoch_context);
+            }
+        }
+    }
+}
+
+// Time forward and backward over the first few batches on the calling
+// thread. Gradients are discarded, so the weights are unchanged.
+static void parallel_reference(ParallelContext* ctx, BPTTTrainer* trainer, ParallelTrainStats* stats) {
+    LSTMNetwork* network = ctx->network;
+    TrainingData* data = ctx->data;
+    double seconds = 0.0;
+    long sequences = 0;
+
+    // The first batch warms the caches and is not counted
+    for (int b = 0; b <= PARALLEL_REFERENCE_BATCHES; b++) {
+        int first = (b * ctx->batch_size) % data->num_sequences;
+        int count = data->num_sequences - first;
+        if (count > ctx->batch_size) count = ctx->batch_size;
+
+        double start = monotonic_seconds();
+        lstm_gradients_zero(trainer->grads);
+        if (bptt_load_batch(trainer, data, first, count) != 0 ||
+            bptt_forward(trainer, network, trainer->inputs, data->sequence_length) != 0 ||
+            bptt_backward(trainer, network, trainer->targets, network->bptt_window) < 0.0) {
+            sequences = 0;
+            break;
+        }
+        if (b > 0) {
+            seconds += monotonic_seconds() - start;
+            sequences += count;
+        }
+    }
+    lstm_gradients_zero(trainer->grads);
+
+    stats->reference_sequences = sequences;
+    stats->reference_seconds = sequences > 0 ? seconds : 0.0;
+}
+
+int lstm_train_parallel(LSTMNetwork* network, TrainingData* data, int epochs, int threads,
+                        ParallelTrainStats* stats) {
+    if (!network || !data || epochs <= 0 || threads <= 0 || data->num_sequences <= 0) return -1;
+
+    int batch_size = network->batch_size > 0 ? network->batch_size : 1;
+    if (batch_size > data->num_sequences) batch_size = data->num_sequences;
+
+    // More workers than batches would leave threads idle on every step
+    int max_threads = (data->num_sequences + batch_size - 1) / batch_size;
+    if (threads > max_threads) threads = max_threads;
+
+    printf("Starting training for %d epochs on %d threads...\n", epochs, threads);
+    if (network->bptt_window > 0 && network->bptt_window < data->sequence_length) {
+        printf("Truncated BPTT window: %d steps\n", network->bptt_window);
+    }
+    if (batch_size > 1) {
+        printf("Mini-batch size: %d sequences per thread\n", batch_size);
+    }
+
+    ParallelContext ctx = {0};
+    ctx.network = network;
+    ctx.data = data;
+    ctx.epochs = epochs;
+    ctx.batch_size = batch_size;
+    ctx.trainers = calloc((size_t)threads, sizeof(BPTTTrainer*));
+    ctx.losses = calloc((size_t)threads, sizeof(double));
+    ctx.busy = calloc((size_t)threads, sizeof(double));
+    ctx.failures = calloc((size_t)threads, sizeof(int));
+    ctx.pool = thread_pool_create(threads);
+
+    int ok = ctx.trainers && ctx.losses && ctx.busy && ctx.failures && ctx.pool;
+    if (ok) thread_pool_run(ctx.pool, parallel_create_worker, &ctx);
+    for (int w = 0; ok && w < threads; w++) {
+        ok = ctx.trainers[w] != NULL;
+    }
+
+    ParallelTrainStats reference = {0};
+    if (ok && threads > 1) {
+        parallel_reference(&ctx, ctx.trainers[0], &reference);
+    }
+
+    if (ok) {
+        double start = monotonic_seconds();
+        thread_pool_run(ctx.pool, parallel_train_worker, &ctx);
+        double wall = monotonic_seconds() - start;
+
+        int failures = 0;
+        for (int w = 0; w < threads; w++) {
+            failures += ctx.failures[w];
+        }
+
+        if (stats) {
+            stats->threads = threads;
+            stats->sequences = (long)epochs * data->num_sequences;
+            stats->wall_seconds = wall;
+            stats->busy_seconds = 0.0;
+            for (int w = 0; w < threads; w++) {
+                stats->busy_seconds += ctx.busy[w];
+            }
+            stats->reference_sequences = reference.reference_sequences;
+            stats->reference_seconds = reference.reference_seconds;
+            stats->final_loss = ctx.final_loss;
+        }
+        if (failures > 0) {
+            printf("Warning: %d batches failed and were skipped\n", failures);
+        }
+        arena_print_usage(ctx.trainers[0]->arena, "Workspace arena per thread");
+        printf("Training completed.\n");
+    } else {
+        printf("Error: Could not allocate parallel training workspace\n");
+    }
+
+    thread_pool_free(ctx.pool);
+    for (int w = 0; ctx.trainers && w < threads; w++) {
+        bptt_trainer_free(ctx.trainers[w]);
+    }
+    free(ctx.trainers);
+    free(ctx.losses);
+    free(ctx.busy);
+    free(ctx.failures);
+
+    return ok ? 0 : -1;
+}
+
+double parallel_train_utilization(const ParallelTrainStats* stats) {
+    if (!stats || stats->threads <= 0 || stats->wall_seconds <= 0.0) return 0.0;
+
+    return stats->busy_seconds / (stats->threads * stats->wall_seconds);
+}
+
+double parallel_train_speedup(const ParallelTrainStats* stats) {
+    if (!stats || stats->reference_sequences <= 0 || stats->wall_seconds <= 0.0) return 0.0;
+
+    double serial = stats->reference_seconds / stats->reference_sequences * stats->sequences;
+    return serial / stats->wall_seconds;
+}
@@ -0,0 +1,295 @@
+#include "../include/tuning.h"
+#include "../include/bptt.h"
+#include "../include/lstm_fixed.h"
+#include "../include/matrix_kernels.h"
+#include "../include/profile.h"
+#include "../include/thread_pool.h"
+#include <math.h>
+#include <pthread.h>
+
+typedef struct {
+    double* features;
+    int num_rows;
+    int split_row;
+    SweepTrial* trials;
+    LSTMNetwork** networks;
+    int count;
+    const SweepOptions* options;
+
+    pthread_mutex_t lock;   // Guards next and checkpoint_best
+    int next;               // Next trial to hand out
+    double* checkpoint_best;
+    int checkpoints;
+} SweepRun;
+
+void sweep_options_default(SweepOptions* options) {
+    if (!options) return;
+
+    options->epochs = 50;
+    options->batch_size = 8;
+    options->eval_every = 5;
+    options->patience = 4;
+    options->prune_factor = 1.5;
+    options->cores = 1;
+    options->seed = 42;
+}
+
+int sweep_grid(SweepTrial* trials, int max, const int* hidden, int n_hidden, const int* sequence,
+               int n_sequence, const double* learning_rate, int n_learning_rate) {
+    if (!trials || !hidden || !sequence || !learning_rate) return -1;
+
+    int count = n_hidden * n_sequence * n_learning_rate;
+    if (count <= 0 || count > max) return -1;
+
+    SweepTrial* trial = trials;
+    for (int h = 0; h < n_hidden; h++) {
+        for (int s = 0; s < n_sequence; s++) {
+            for (int r = 0; r < n_learning_rate; r++) {
+                memset(trial, 0, sizeof(*trial));
+                trial->hidden_size = hidden[h];
+                trial->sequence_length = sequence[s];
+                trial->learning_rate = learning_rate[r];
+                trial++;
+            }
+        }
+    }
+
+    return count;
+}
+
+double lstm_validation_loss(LSTMNetwork* network, TrainingData* data) {
+    if (!network || !data || data->num_sequences <= 0) return -1.0;
+
+    Matrix* output = matrix_create(network->output_size, 1);
+    Matrix* target = matrix_wrap(training_data_target(data, 0), network->output_size, 1, 1);
+    if (!output || !target) {
+        matrix_free(output);
+        matrix_free(target);
+        return -1.0;
+    }
+
+    double total = 0.0;
+    int status = 0;
+    for (int s = 0; s < data->num_sequences && status == 0; s++) {
+        status = lstm_network_predict_window(network, training_data_input(data, s, 0), data->sequence_length,
+                                             output);
+        matrix_rebind(target, training_data_target(data, s));
+        if (status == 0) total += calculate_loss(output, target);
+    }
+    matrix_free(output);
+    matrix_free(target);
+
+    return status == 0 ? total / data->num_sequences : -1.0;
+}
+
+// Record loss at checkpoint; returns 1 when the trial should be pruned
+static int sweep_checkpoint(SweepRun* run, int checkpoint, double loss) {
+    if (checkpoint >= run->checkpoints) return 0;
+
+    pthread_mutex_lock(&run->lock);
+    double best = run->checkpoint_best[checkpoint];
+    int prune = run->options->prune_factor > 0.0 && checkpoint > 0 && loss > run->options->prune_factor * best;
+    if (loss < best) run->checkpoint_best[checkpoint] = loss;
+    pthread_mutex_unlock(&run->lock);
+
+    return prune;
+}
+
+static void sweep_trial_run(SweepRun* run, SweepTrial* trial, LSTMNetwork* network) {
+    const SweepOptions* options = run->options;
+    int T = trial->sequence_length;
+    double start = profile_seconds();
+
+    // Validation windows start T rows early so their targets begin at split_row
+    TrainingData* train = training_data_view(run->features, WEATHER_NUM_FEATURES, run->split_row, T);
+    TrainingData* valid = training_data_view(run->features + (size_t)(run->split_row - T) * WEATHER_NUM_FEATURES,
+                                             WEATHER_NUM_FEATURES, run->num_rows - run->split_row + T, T);
+    int batch_size = options->batch_size;
+    if (train && batch_size > train->num_sequences) batch_size = train->num_sequences;
+    BPTTTrainer* trainer = train && valid ? bptt_trainer_create(network, T, batch_size) : NULL;
+
+    trial->status = SWEEP_FAILED;
+    trial->best_loss = INFINITY;
+    if (trainer) {
+        trial->initial_loss = lstm_validation_loss(network, valid);
+        trial->best_loss = trial->initial_loss;
+        sweep_checkpoint(run, 0, trial->initial_loss);
+        trial->status = trial->initial_loss < 0.0 ? SWEEP_FAILED : SWEEP_FINISHED;
+
+        int stale = 0;
+        for (int epoch = 1; epoch <= options->epochs && trial->status == SWEEP_FINISHED; epoch++) {
+            bptt_train_epoch(trainer, network, train);
+            trial->epochs_run = epoch;
+            if (epoch % options->eval_every != 0 && epoch != options->epochs) continue;
+
+            double loss = lstm_validation_loss(network, valid);
+            if (loss < 0.0) {
+                trial->status = SWEEP_FAILED;
+            } else if (loss < trial->best_loss) {
+                trial->best_loss = loss;
+                trial->best_epoch = epoch;
+                stale = 0;
+            } else {
+                stale++;
+            }
+
+            if (trial->status != SWEEP_FINISHED || epoch == options->epochs) continue;
+            if (sweep_checkpoint(run, epoch / options->eval_every, loss)) {
+                trial->status = SWEEP_PRUNED;
+            } else if (options->patience > 0 && stale >= options->patience) {
+                trial->status = SWEEP_PLATEAU;
+            }
+        }
+    }
+
+    bptt_trainer_free(trainer);
+    free_training_data(train);
+    free_training_data(valid);
+    trial->seconds = profile_seconds() - start;
+}
+
+static void sweep_worker(void* ctx, int worker, int num_workers) {
+    SweepRun* run = ctx;
+    (void)worker;
+    (void)num_workers;
+
+    // Workers pull trials until the queue is empty, so uneven trial costs balance out
+    for (;;) {
+        pthread_mutex_lock(&run->lock);
+        int index = run->next++;
+        pthread_mutex_unlock(&run->lock);
+        if (index >= run->count) break;
+
+        SweepTrial* trial = &run->trials[index];
+        sweep_trial_run(run, trial, run->networks[index]);
+
+        pthread_mutex_lock(&run->lock);
+        printf("Trial %d/%d: hidden %d, sequence %d, learning rate %g: %s after %d epochs, "
+               "best loss %.6f (%.2f s)\n",
+               index + 1, run->count, trial->hidden_size, trial->sequence_length, trial->learning_rate,
+               sweep_status_name(trial->status), trial->epochs_run, trial->best_loss, trial->seconds);
+        fflush(stdout);
+        pthread_mutex_unlock(&run->lock);
+    }
+}
+
+int sweep_run(double* features, int num_rows, int split_row, SweepTrial* trials, int count,
+              const SweepOptions* options) {
+    if (!features || !trials || !options || count <= 0 || split_row <= 0 || split_row >= num_rows ||
+        options->epochs <= 0 || options->eval_every <= 0 || options->batch_size <= 0 || options->cores <= 0) {
+        return -1;
+    }
+
+    SweepRun run;
+    memset(&run, 0, sizeof(run));
+    run.features = features;
+    run.num_rows = num_rows;
+    run.split_row = split_row;
+    run.trials = trials;
+    run.count = count;
+    run.options = options;
+    run.checkpoints = options->epochs / options->eval_every + 1;
+    run.checkpoint_best = malloc((size_t)run.checkpoints * sizeof(double));
+    run.networks = calloc((size_t)count, sizeof(LSTMNetwork*));
+    if (!run.checkpoint_best || !run.networks) {
+        free(run.checkpoint_best);
+        free(run.networks);
+        return -1;
+    }
+    for (int c = 0; c < run.checkpoints; c++) run.checkpoint_best[c] = INFINITY;
+
+    // Weights are drawn here, in trial order, so a seed fixes every trial's
+    // starting point regardless of how the workers interleave
+    srand(options->seed);
+    for (int i = 0; i < count; i++) {
+        SweepTrial* trial = &trials[i];
+        trial->status = SWEEP_PENDING;
+        trial->initial_loss = 0.0;
+        trial->best_loss = INFINITY;
+        trial->best_epoch = 0;
+        trial->epochs_run = 0;
+        trial->seconds = 0.0;
+        if (trial->hidden_size <= 0 || trial->sequence_length <= 0 || trial->learning_rate <= 0.0 ||
+            trial->sequence_length >= split_row) {
+            continue;
+        }
+        LSTMNetwork* network = lstm_network_create(WEATHER_NUM_FEATURES, trial->hidden_size, WEATHER_NUM_FEATURES);
+        if (!network) continue;
+        network->sequence_length = trial->sequence_length;
+        network->learning_rate = trial->learning_rate;
+        network->batch_size = options->batch_size;
+        run.networks[i] = network;
+    }
+
+    // Resolve the lazily chosen kernels before the workers race to do it
+    matrix_kernels();
+    lstm_fixed_step_lookup(WEATHER_NUM_FEATURES, 0);
+
+    int cores = options->cores < count ? options->cores : count;
+    ThreadPool* pool = thread_pool_create(cores);
+    pthread_mutex_init(&run.lock, NULL);
+    if (pool) {
+        thread_pool_run(pool, sweep_worker, &run);
+    } else {
+        sweep_worker(&run, 0, 1);
+    }
+    pthread_mutex_destroy(&run.lock);
+    thread_pool_free(pool);
+
+    for (int i = 0; i < count; i++) {
+        if (!run.networks[i]) {
+            trials[i].status = SWEEP_FAILED;
+            trials[i].best_loss = INFINITY;
+        }
+        lstm_network_free(run.networks[i]);
+    }
+    free(run.networks);
+    free(run.checkpoint_best);
+
+    return 0;
+}
+
+double sweep_efficiency(const SweepTrial* trial) {
+    if (!trial || trial->status == SWEEP_FAILED || trial->status == SWEEP_PENDING || trial->seconds <= 0.0) {
+        return 0.0;
+    }
+
+    return (trial->initial_loss - trial->best_loss) / trial->seconds;
+}
+
+// Negative when a ranks ahead of b
+static int sweep_compare(const SweepTrial* a, const SweepTrial* b, int by_loss) {
+    int a_failed = a->status == SWEEP_FAILED || a->status == SWEEP_PENDING;
+    int b_failed = b->status == SWEEP_FAILED || b->status == SWEEP_PENDING;
+    if (a_failed != b_failed) return a_failed - b_failed;
+
+    double ka = by_loss ? a->best_loss : -sweep_efficiency(a);
+    double kb = by_loss ? b->best_loss : -sweep_efficiency(b);
+    return (ka > kb) - (ka < kb);
+}
+
+void sweep_rank(SweepTrial* trials, int count, int by_loss) {
+    if (!trials) return;
+
+    // Insertion sort: sweeps are small, and it keeps ties in grid order
+    for (int i = 1; i < count; i++) {
+        SweepTrial key = trials[i];
+        int j = i - 1;
+        while (j >= 0 && sweep_compare(&key, &trials[j], by_loss) < 0) {
+            trials[j + 1] = trials[j];
+            j--;
+        }
+        trials[j + 1] = key;
+    }
+}
+
+const char* sweep_status_name(SweepStatus status) {
+    switch (status) {
+        case SWEEP_PENDING:  return "pending";
+        case SWEEP_FINISHED: return "finished";
+        case SWEEP_PLATEAU:  return "plateau";
+        case SWEEP_PRUNED:   return "pruned";
+        case SWEEP_FAILED:   return "failed";
+    }
+    return "unknown";
+}
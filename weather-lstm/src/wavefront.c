@@ -0,0 +1,54 @@
+#include "../include/wavefront.h"
+#include <stdlib.h>
+
+typedef struct {
+    ThreadPool* pool;
+    int layers;
+    int steps;
+    int reverse;
+    WavefrontStep step;
+    void* ctx;
+    int* failed;        // [workers] set by a worker whose step failed
+} WavefrontRun;
+
+// Steps of tick k for the layers this worker owns. Workers keep meeting at
+// the barriers after a failure so that none of them waits forever.
+static void wavefront_worker(void* arg, int worker, int num_workers) {
+    WavefrontRun* run = arg;
+    int ticks = run->steps + run->layers - 1;
+    
+    for (int k = 0; k < ticks; k++) {
+        for (int l = worker; l < run->layers && !run->failed[worker]; l += num_workers) {
+            // Forward: layer l is l ticks behind layer 0; reverse: behind the top layer
+            int lag = run->reverse ? run->layers - 1 - l : l;
+            int j = k - lag;
+            if (j < 0 || j >= run->steps) continue;
+            int t = run->reverse ? run->steps - 1 - j : j;
+            if (run->step(run->ctx, l, t) != 0) run->failed[worker] = 1;
+        }
+        if (num_workers > 1) thread_pool_barrier(run->pool);
+    }
+}
+
+int wavefront_run(ThreadPool* pool, int layers, int steps, int reverse, WavefrontStep step, void* ctx) {
+    if (layers <= 0 || steps <= 0 || !step) return -1;
+    
+    int workers = pool ? thread_pool_size(pool) : 1;
+    int* failed = calloc((size_t)workers, sizeof(int));
+    if (!failed) return -1;
+    
+    WavefrontRun run = {pool, layers, steps, reverse, step, ctx, failed};
+    if (workers > 1 && layers > 1) {
+        thread_pool_run(pool, wavefront_worker, &run);
+    } else {
+        run.pool = NULL;
+        wavefront_worker(&run, 0, 1);
+    }
+    
+    int status = 0;
+    for (int w = 0; w < workers; w++) {
+        if (failed[w]) status = -1;
+    }
+    free(failed);
+    return status;
+}
@@ -0,0 +1,133 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "../include/weather_columns.h"
+#include "../include/matrix_kernels.h"
+
+// Round a column length up so the next column stays aligned
+static int columns_stride(int capacity) {
+    int per_line = MATRIX_ALIGNMENT / (int)sizeof(double);
+    int stride = (capacity + per_line - 1) / per_line * per_line;
+    return stride > 0 ? stride : per_line;
+}
+
+static void column_fill(int n, double* x, double value) {
+    for (int i = 0; i < n; i++) {
+        x[i] = value;
+    }
+}
+
+WeatherColumns* weather_columns_create(int capacity) {
+    if (capacity < 0) return NULL;
+    
+    WeatherColumns* columns = malloc(sizeof(WeatherColumns));
+    if (!columns) return NULL;
+    
+    int stride = columns_stride(capacity);
+    void* storage = NULL;
+    if (posix_memalign(&storage, MATRIX_ALIGNMENT, (size_t)stride * WEATHER_NUM_FEATURES * sizeof(double)) != 0) {
+        free(columns);
+        return NULL;
+    }
+    
+    columns->storage = storage;
+    for (int f = 0; f < WEATHER_NUM_FEATURES; f++) {
+        columns->columns[f] = columns->storage + (size_t)f * stride;
+    }
+    columns->size = 0;
+    columns->capacity = capacity;
+    
+    return columns;
+}
+
+void weather_columns_free(WeatherColumns* columns) {
+    if (!columns) return;
+    
+    free(columns->storage);
+    free(columns);
+}
+
+WeatherColumns* weather_columns_from_dataset(WeatherDataset* dataset) {
+    if (!dataset) return NULL;
+    
+    WeatherColumns* columns = weather_columns_create(dataset->size);
+    if (!columns) return NULL;
+    
+    // Transpose row blocks so each output column is written sequentially
+    const double* rows = weather_dataset_features(dataset);
+    for (int i = 0; i < dataset->size; i++) {
+        const double* row = rows + (size_t)i * WEATHER_NUM_FEATURES;
+        for (int f = 0; f < WEATHER_NUM_FEATURES; f++) {
+            columns->columns[f][i] = row[f];
+        }
+    }
+    columns->size = dataset->size;
+    
+    return columns;
+}
+
+WeatherDataset* weather_columns_to_dataset(WeatherColumns* columns) {
+    if (!columns) return NULL;
+    
+    WeatherDataset* dataset = weather_dataset_create(columns->size > 0 ? columns->size : 1);
+    if (!dataset) return NULL;
+    
+    double* rows = weather_dataset_features(dataset);
+    for (int i = 0; i < columns->size; i++) {
+        double* row = rows + (size_t)i * WEATHER_NUM_FEATURES;
+        for (int f = 0; f < WEATHER_NUM_FEATURES; f++) {
+            row[f] = columns->columns[f][i];
+        }
+    }
+    dataset->size = columns->size;
+    
+    return dataset;
+}
+
+NormalizationParams* weather_columns_normalization_params(WeatherColumns* columns) {
+    if (!columns || columns->size == 0) return NULL;
+    
+    NormalizationParams* params = malloc(sizeof(NormalizationParams));
+    if (!params) return NULL;
+    
+    const MatrixKernels* kernels = matrix_kernels();
+    double* pairs = (double*)params;
+    for (int f = 0; f < WEATHER_NUM_FEATURES; f++) {
+        kernels->minmax(columns->size, columns->columns[f], &pairs[2 * f], &pairs[2 * f + 1]);
+    }
+    
+    return params;
+}
+
+// Constant columns map to 0.5, as in normalize_dataset
+void weather_columns_normalize(WeatherColumns* columns, NormalizationParams* params) {
+    if (!columns || !params) return;
+    
+    const MatrixKernels* kernels = matrix_kernels();
+    const double* pairs = (const double*)params;
+    for (int f = 0; f < WEATHER_NUM_FEATURES; f++) {
+        double min = pairs[2 * f];
+        double range = pairs[2 * f + 1] - min;
+        if (range > 0) {
+            kernels->rescale(columns->size, columns->columns[f], min, range);
+        } else {
+            column_fill(columns->size, columns->columns[f], 0.5);
+        }
+    }
+}
+
+// Constant columns map back to their minimum, as in denormalize_point
+void weather_columns_denormalize(WeatherColumns* columns, NormalizationParams* params) {
+    if (!columns || !params) return;
+    
+    const MatrixKernels* kernels = matrix_kernels();
+    const double* pairs = (const double*)params;
+    for (int f = 0; f < WEATHER_NUM_FEATURES; f++) {
+        double min = pairs[2 * f];
+        double range = pairs[2 * f + 1] - min;
+        if (range > 0) {
+            kernels->affine(columns->size, columns->columns[f], range, min);
+        } else {
+            column_fill(columns->size, columns->columns[f], min);
+        }
+    }
+}
@@ -1,11 +1,20 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include "../include/weather_data.h"
+#include "../include/thread_pool.h"
+#include "../include/large_alloc.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // Create weather dataset
 WeatherDataset* weather_dataset_create(int initial_capacity) {
     WeatherDataset* dataset = malloc(sizeof(WeatherDataset));
     if (!dataset) return NULL;
     
-    dataset->data = malloc(initial_capacity * sizeof(WeatherPoint));
+    dataset->data = large_alloc_shared((size_t)initial_capacity * sizeof(WeatherPoint));
     if (!dataset->data) {
         free(dataset);
         return NULL;
@@ -13,6 +22,8 @@ WeatherDataset* weather_dataset_create(int initial_capacity) {
     
     dataset->size = 0;
     dataset->capacity = initial_capacity;
+    dataset->map_base = NULL;
+    dataset->map_size = 0;
     return dataset;
 }
 
@@ -20,22 +31,52 @@ WeatherDataset* weather_dataset_create(int initial_capacity) {
 void weather_dataset_free(WeatherDataset* dataset) {
     if (!dataset) return;
     
-    free(dataset->data);
+    if (dataset->map_base) {
+        munmap(dataset->map_base, dataset->map_size);
+    } else {
+        large_free(dataset->data);
+    }
     free(dataset);
 }
 
-// Add weather point to dataset
-int weather_dataset_add(WeatherDataset* dataset, WeatherPoint point) {
-    if (!dataset) return -1;
-    
-    // Resize if needed
-    if (dataset->size >= dataset->capacity) {
-        int new_capacity = dataset->capacity * 2;
-        WeatherPoint* new_data = realloc(dataset->data, new_capacity * sizeof(WeatherPoint));
+// Ensure room for at least capacity points. A mapped dataset is first moved
+// to the heap, since the mapping cannot grow.
+int weather_dataset_reserve(WeatherDataset* dataset, int capacity) {
+    if (!dataset || capacity < 0) return -1;
+    
+    if (dataset->map_base) {
+        int new_capacity = capacity > dataset->size ? capacity : dataset->size;
+        if (new_capacity < 16) new_capacity = 16;
+        WeatherPoint* new_data = large_alloc_shared((size_t)new_capacity * sizeof(WeatherPoint));
         if (!new_data) return -1;
         
+        memcpy(new_data, dataset->data, (size_t)dataset->size * sizeof(WeatherPoint));
+        munmap(dataset->map_base, dataset->map_size);
+        dataset->map_base = NULL;
+        dataset->map_size = 0;
         dataset->data = new_data;
         dataset->capacity = new_capacity;
+        return 0;
+    }
+    
+    if (capacity <= dataset->capacity) return 0;
+    
+    WeatherPoint* new_data = large_realloc(dataset->data, (size_t)capacity * sizeof(WeatherPoint));
+    if (!new_data) return -1;
+    
+    dataset->data = new_data;
+    dataset->capacity = capacity;
+    return 0;
+}
+
+// Add weather point to dataset
+int weather_dataset_add(WeatherDataset* dataset, WeatherPoint point) {
+    if (!dataset) return -1;
+    
+    // Resize if needed (a mapped dataset always moves to the heap)
+    if (dataset->map_base || dataset->size >= dataset->capacity) {
+        int new_capacity = dataset->capacity > 8 ? dataset->capacity * 2 : 16;
+        if (weather_dataset_reserve(dataset, new_capacity) != 0) return -1;
     }
     
     dataset->data[dataset->size] = point;
@@ -43,91 +84,554 @@ int weather_dataset_add(WeatherDataset* dataset, WeatherPoint point) {
     return 0;
 }
 
-// Load weather data from CSV
-int weather_load_csv(const char* filename, WeatherDataset* dataset) {
-    if (!filename || !dataset) return -1;
+// Row-major feature view of the dataset
+double* weather_dataset_features(WeatherDataset* dataset) {
+    if (!dataset || !dataset->data) return NULL;
     
-    FILE* file = fopen(filename, "r");
-    if (!file) {
+    return (double*)dataset->data;
+}
+
+// ---------------------------------------------------------------------------
+// CSV parsing
+//
+// The file is mapped and split into chunks at line boundaries. Workers count
+// the lines of their chunk, the dataset is reserved once for the total, and
+// each worker parses straight into its slice of the dataset. Rejected lines
+// leave gaps that are closed in order afterwards, so points and warning line
+// numbers come out exactly as a sequential read would produce them.
+// ---------------------------------------------------------------------------
+
+#define CSV_CHUNK_MIN_BYTES (1 << 20)   // Smaller files parse on one thread
+#define CSV_FALLBACK_BUFFER 128
+
+static const double csv_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int csv_is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static int csv_is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// strtod over [p, end) for the inputs the fast path declines (long
+// mantissas, large exponents, nan/inf); the text is copied so strtod never
+// reads past the mapping
+static const char* csv_parse_fallback(const char* p, const char* end, double* out) {
+    const char* q = p;
+    while (q < end && *q != ',' && *q != '\n') q++;
+    
+    size_t n = (size_t)(q - p);
+    char stack_buffer[CSV_FALLBACK_BUFFER];
+    char* buffer = n < sizeof(stack_buffer) ? stack_buffer : malloc(n + 1);
+    if (!buffer) return NULL;
+    
+    memcpy(buffer, p, n);
+    buffer[n] = '\0';
+    char* stop;
+    *out = strtod(buffer, &stop);
+    size_t used = (size_t)(stop - buffer);
+    if (buffer != stack_buffer) free(buffer);
+    
+    return used > 0 ? p + used : NULL;
+}
+
+// Parse one number after optional whitespace, like %lf. Returns the first
+// character after it, or NULL if there is no number. Decimal inputs with at
+// most 19 significant digits whose value is an exact integer below 2^53
+// scaled by a power of ten up to 1e22 are converted with a single multiply
+// or divide, which is correctly rounded; everything else goes to strtod.
+static const char* csv_parse_double(const char* p, const char* end, double* out) {
+    while (p < end && csv_is_space(*p)) p++;
+    if (p >= end) return NULL;
+    
+    const char* start = p;
+    int negative = 0;
+    if (*p == '+' || *p == '-') {
+        negative = *p == '-';
+        p++;
+    }
+    
+    uint64_t mantissa = 0;
+    int digits = 0;         // Significant digits accumulated
+    int any_digit = 0;
+    int exponent = 0;
+    
+    while (p < end && *p == '0') {
+        any_digit = 1;
+        p++;
+    }
+    while (p < end && csv_is_digit(*p)) {
+        if (digits >= 19) return csv_parse_fallback(start, end, out);
+        mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+        digits++;
+        any_digit = 1;
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        if (digits == 0) {
+            while (p < end && *p == '0') {
+                exponent--;
+                any_digit = 1;
+                p++;
+            }
+        }
+        while (p < end && csv_is_digit(*p)) {
+            if (digits >= 19) return csv_parse_fallback(start, end, out);
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            digits++;
+            exponent--;
+            any_digit = 1;
+            p++;
+        }
+    }
+    if (!any_digit) return csv_parse_fallback(start, end, out);
+    
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        int exp_negative = 0;
+        if (q < end && (*q == '+' || *q == '-')) {
+            exp_negative = *q == '-';
+            q++;
+        }
+        if (q < end && csv_is_digit(*q)) {
+            int value = 0;
+            while (q < end && csv_is_digit(*q)) {
+                if (value < 10000) value = value * 10 + (*q - '0');
+                q++;
+            }
+            exponent += exp_negative ? -value : value;
+            p = q;
+        }
+    }
+    
+    if (mantissa > ((uint64_t)1 << 53) || exponent < -22 || exponent > 22) {
+        return csv_parse_fallback(start, end, out);
+    }
+    
+    double value = (double)mantissa;
+    value = exponent < 0 ? value / csv_pow10[-exponent] : value * csv_pow10[exponent];
+    *out = negative ? -value : value;
+    return p;
+}
+
+// Legacy row: six comma-separated numbers. Returns the fields parsed with
+// sscanf("%lf,%lf,...") semantics, including -1 for a blank line.
+static int csv_parse_legacy(const char* p, const char* end, WeatherPoint* point) {
+    double* fields = (double*)point;
+    
+    for (int k = 0; k < WEATHER_NUM_FEATURES; k++) {
+        if (k > 0) {
+            if (p >= end || *p != ',') return k;
+            p++;
+        }
+        const char* next = csv_parse_double(p, end, &fields[k]);
+        if (!next) {
+            if (k == 0) {
+                while (p < end && csv_is_space(*p)) p++;
+                return p >= end ? -1 : 0;
+            }
+            return k;
+        }
+        p = next;
+    }
+    
+    return WEATHER_NUM_FEATURES;
+}
+
+// Timestamped row: timestamp,unix_timestamp followed by the six values.
+// Fields are split like strtok (empty fields are skipped) and read like atof.
+static int csv_parse_timestamped(const char* p, const char* end, WeatherPoint* point) {
+    double* fields = (double*)point;
+    int token = 0;
+    
+    while (p < end && token < 2 + WEATHER_NUM_FEATURES) {
+        while (p < end && *p == ',') p++;
+        if (p >= end) break;
+        
+        const char* field_end = p;
+        while (field_end < end && *field_end != ',') field_end++;
+        if (token >= 2) {
+            double value;
+            fields[token - 2] = csv_parse_double(p, field_end, &value) ? value : 0.0;
+        }
+        token++;
+        p = field_end;
+    }
+    
+    return token > 2 ? token - 2 : 0;
+}
+
+typedef struct {
+    int line;       // Line number within the chunk, from 1
+    int parsed;
+} CSVWarning;
+
+typedef struct {
+    const char* begin;
+    const char* end;
+    int lines;
+    int slot;               // First dataset slot reserved for this chunk
+    int rows;               // Valid rows parsed
+    CSVWarning* warnings;
+    int num_warnings;
+    int warning_capacity;
+    int failed;
+} CSVChunk;
+
+typedef struct {
+    ThreadPool* pool;
+    CSVChunk* chunks;
+    WeatherDataset* dataset;
+    int has_timestamps;
+    int reserve_failed;
+} CSVParseJob;
+
+static int csv_count_lines(const char* p, const char* end) {
+    int lines = 0;
+    while (p < end) {
+        const char* nl = memchr(p, '\n', (size_t)(end - p));
+        lines++;
+        if (!nl) break;
+        p = nl + 1;
+    }
+    return lines;
+}
+
+static void csv_add_warning(CSVChunk* chunk, int line, int parsed) {
+    if (chunk->num_warnings == chunk->warning_capacity) {
+        int capacity = chunk->warning_capacity ? chunk->warning_capacity * 2 : 16;
+        CSVWarning* grown = realloc(chunk->warnings, (size_t)capacity * sizeof(CSVWarning));
+        if (!grown) {
+            chunk->failed = 1;
+            return;
+        }
+        chunk->warnings = grown;
+        chunk->warning_capacity = capacity;
+    }
+    chunk->warnings[chunk->num_warnings].line = line;
+    chunk->warnings[chunk->num_warnings].parsed = parsed;
+    chunk->num_warnings++;
+}
+
+static void csv_parse_worker(void* arg, int worker, int num_workers) {
+    CSVParseJob* job = arg;
+    CSVChunk* chunk = &job->chunks[worker];
+    
+    // Pass 1: line counts give every chunk an upper bound on its rows
+    chunk->lines = csv_count_lines(chunk->begin, chunk->end);
+    thread_pool_barrier(job->pool);
+    
+    if (worker == 0) {
+        int total = job->dataset->size;
+        for (int w = 0; w < num_workers; w++) {
+            job->chunks[w].slot = total;
+            total += job->chunks[w].lines;
+        }
+        job->reserve_failed = weather_dataset_reserve(job->dataset, total) != 0;
+    }
+    thread_pool_barrier(job->pool);
+    if (job->reserve_failed) return;
+    
+    // Pass 2: parse each line into the chunk's slice of the dataset
+    WeatherPoint* out = job->dataset->data + chunk->slot;
+    const char* p = chunk->begin;
+    for (int line = 1; p < chunk->end; line++) {
+        const char* nl = memchr(p, '\n', (size_t)(chunk->end - p));
+        const char* line_end = nl ? nl : chunk->end;
+        
+        WeatherPoint point;
+        int parsed = job->has_timestamps ? csv_parse_timestamped(p, line_end, &point)
+                                         : csv_parse_legacy(p, line_end, &point);
+        if (parsed == WEATHER_NUM_FEATURES) {
+            out[chunk->rows++] = point;
+        } else {
+            csv_add_warning(chunk, line, parsed);
+        }
+        
+        if (!nl) break;
+        p = nl + 1;
+    }
+}
+
+// Map a text file for sequential reading. An empty file gives *text == NULL.
+static int csv_map_file(const char* filename, const char** text, size_t* size) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Could not open file %s\n", filename);
+        return -1;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
         printf("Error: Could not open file %s\n", filename);
+        close(fd);
         return -1;
     }
     
-    char line[512];  // Increased buffer size for timestamp columns
-    int line_count = 0;
+    *size = (size_t)st.st_size;
+    *text = NULL;
+    if (*size > 0) {
+        void* mapped = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            printf("Error: Could not map file %s\n", filename);
+            close(fd);
+            return -1;
+        }
+        *text = mapped;
+        posix_madvise(mapped, *size, POSIX_MADV_SEQUENTIAL);
+    }
+    close(fd);
+    
+    return 0;
+}
+
+// Load weather data from CSV, parsing on up to threads threads (0 picks one
+// per online CPU). Points are appended to dataset in file order.
+int weather_load_csv_threads(const char* filename, WeatherDataset* dataset, int threads) {
+    if (!filename || !dataset) return -1;
+    
+    const char* text = NULL;
+    size_t size = 0;
+    if (csv_map_file(filename, &text, &size) != 0) return -1;
+    
+    const char* end = text ? text + size : NULL;
+    const char* body = end;
     int has_timestamps = 0;
     
     // Read and analyze header line
-    if (fgets(line, sizeof(line), file)) {
-        line_count++;
+    if (text) {
+        const char* nl = memchr(text, '\n', size);
+        body = nl ? nl + 1 : end;
+        size_t header_length = (size_t)((nl ? nl : end) - text);
+        char* header = malloc(header_length + 1);
+        if (!header) {
+            munmap((void*)text, size);
+            return -1;
+        }
+        memcpy(header, text, header_length);
+        header[header_length] = '\0';
+        
         // Check if header contains timestamp columns
-        if (strstr(line, "timestamp") != NULL || strstr(line, "unix_timestamp") != NULL) {
+        if (weather_csv_header_has_timestamps(header)) {
             has_timestamps = 1;
             printf("Detected CSV format with timestamps\n");
         } else {
             printf("Detected legacy CSV format without timestamps\n");
         }
+        free(header);
     }
     
-    while (fgets(line, sizeof(line), file)) {
-        line_count++;
-        WeatherPoint point;
-        int parsed = 0;
+    int status = 0;
+    size_t body_size = text ? (size_t)(end - body) : 0;
+    if (body_size > 0) {
+        if (threads <= 0) {
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            size_t max_chunks = body_size / CSV_CHUNK_MIN_BYTES + 1;
+            threads = cpus > 0 ? (int)cpus : 1;
+            if ((size_t)threads > max_chunks) threads = (int)max_chunks;
+        }
         
-        if (has_timestamps) {
-            // New format: timestamp,unix_timestamp,temp,pressure,humidity,wind_speed,wind_dir,precipitation
-            // We skip the first two columns (timestamp and unix_timestamp)
-            char* token = strtok(line, ",");
-            if (token) token = strtok(NULL, ",");  // Skip timestamp
-            if (token) token = strtok(NULL, ",");  // Skip unix_timestamp (now pointing to temperature)
-            
-            // Parse weather data (token already points to temperature)
-            if (token) {
-                point.temperature = atof(token);
-                if ((token = strtok(NULL, ","))) {
-                    point.pressure = atof(token);
-                    if ((token = strtok(NULL, ","))) {
-                        point.humidity = atof(token);
-                        if ((token = strtok(NULL, ","))) {
-                            point.wind_speed = atof(token);
-                            if ((token = strtok(NULL, ","))) {
-                                point.wind_direction = atof(token);
-                                if ((token = strtok(NULL, ",\n"))) {
-                                    point.precipitation = atof(token);
-                                    parsed = 6;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        } else {
-            // Legacy format: temp,pressure,humidity,wind_speed,wind_dir,precipitation
-            parsed = sscanf(line, "%lf,%lf,%lf,%lf,%lf,%lf",
-                           &point.temperature,
-                           &point.pressure,
-                           &point.humidity,
-                           &point.wind_speed,
-                           &point.wind_direction,
-                           &point.precipitation);
+        CSVChunk* chunks = calloc((size_t)threads, sizeof(CSVChunk));
+        ThreadPool* pool = chunks ? thread_pool_create(threads) : NULL;
+        if (!pool) {
+            printf("Error: Could not allocate parser workspace\n");
+            free(chunks);
+            munmap((void*)text, size);
+            return -1;
         }
         
-        if (parsed == 6) {
-            if (weather_dataset_add(dataset, point) != 0) {
-                printf("Error: Failed to add data point at line %d\n", line_count);
-                fclose(file);
-                return -1;
+        // Chunk boundaries move forward to the start of the next line
+        const char* p = body;
+        for (int w = 0; w < threads; w++) {
+            const char* chunk_end = w == threads - 1 ? end : body + body_size * (size_t)(w + 1) / (size_t)threads;
+            if (chunk_end < p) chunk_end = p;
+            if (chunk_end < end && chunk_end > body && chunk_end[-1] != '\n') {
+                const char* nl = memchr(chunk_end, '\n', (size_t)(end - chunk_end));
+                chunk_end = nl ? nl + 1 : end;
             }
+            chunks[w].begin = p;
+            chunks[w].end = chunk_end;
+            p = chunk_end;
+        }
+        
+        CSVParseJob job = {pool, chunks, dataset, has_timestamps, 0};
+        thread_pool_run(pool, csv_parse_worker, &job);
+        thread_pool_free(pool);
+        
+        if (job.reserve_failed) {
+            printf("Error: Could not allocate memory for weather data\n");
+            status = -1;
         } else {
-            printf("Warning: Invalid data format at line %d (parsed %d fields)\n", line_count, parsed);
+            // Close the gaps left by rejected lines and report them in file order
+            int line_base = 1;  // The header is line 1
+            for (int w = 0; w < threads; w++) {
+                memmove(dataset->data + dataset->size, dataset->data + chunks[w].slot,
+                        (size_t)chunks[w].rows * sizeof(WeatherPoint));
+                dataset->size += chunks[w].rows;
+                for (int i = 0; i < chunks[w].num_warnings; i++) {
+                    printf("Warning: Invalid data format at line %d (parsed %d fields)\n",
+                           line_base + chunks[w].warnings[i].line, chunks[w].warnings[i].parsed);
+                }
+                if (chunks[w].failed) {
+                    printf("Warning: Some invalid lines in %s were not reported\n", filename);
+                }
+                line_base += chunks[w].lines;
+            }
+        }
+        
+        for (int w = 0; w < threads; w++) {
+            free(chunks[w].warnings);
         }
+        free(chunks);
     }
     
-    fclose(file);
-    printf("Loaded %d weather data points from %s\n", dataset->size, filename);
+    if (text) munmap((void*)text, size);
+    if (status == 0) {
+        printf("Loaded %d weather data points from %s\n", dataset->size, filename);
+    }
+    return status;
+}
+
+int weather_csv_header_has_timestamps(const char* header) {
+    return header && (strstr(header, "timestamp") != NULL || strstr(header, "unix_timestamp") != NULL);
+}
+
+// One line of a stream, parsed like the bulk loader parses its rows
+int weather_parse_csv_line(const char* line, size_t length, int has_timestamps, WeatherPoint* point) {
+    if (!line || !point) return -1;
+    
+    const char* end = line + length;
+    if (end > line && end[-1] == '\r') end--;
+    WeatherPoint parsed;
+    int fields = has_timestamps ? csv_parse_timestamped(line, end, &parsed) : csv_parse_legacy(line, end, &parsed);
+    if (fields != WEATHER_NUM_FEATURES) return -1;
+    
+    *point = parsed;
     return 0;
 }
 
+// Load weather data from CSV
+int weather_load_csv(const char* filename, WeatherDataset* dataset) {
+    return weather_load_csv_threads(filename, dataset, 0);
+}
+
+// Load a multi-station CSV: a header whose first column is "station", then
+// rows of station id followed by the six legacy fields. Rows of one station
+// must be contiguous; an id that reappears later starts a new group.
+WeatherStations* weather_load_stations_csv(const char* filename, WeatherDataset* dataset) {
+    if (!filename || !dataset) return NULL;
+    
+    const char* text = NULL;
+    size_t size = 0;
+    if (csv_map_file(filename, &text, &size) != 0) return NULL;
+    
+    const char* end = text ? text + size : NULL;
+    if (!text || size < 7 || strncmp(text, "station", 7) != 0) {
+        printf("Error: %s is not a multi-station CSV (expected a leading station column)\n", filename);
+        if (text) munmap((void*)text, size);
+        return NULL;
+    }
+    
+    const char* nl = memchr(text, '\n', size);
+    const char* p = nl ? nl + 1 : end;
+    int lines = csv_count_lines(p, end);
+    
+    WeatherStations* stations = calloc(1, sizeof(WeatherStations));
+    int capacity = 16;
+    if (stations) {
+        stations->ids = malloc((size_t)capacity * sizeof(char*));
+        stations->starts = malloc((size_t)(capacity + 1) * sizeof(int));
+    }
+    if (!stations || !stations->ids || !stations->starts ||
+        weather_dataset_reserve(dataset, dataset->size + lines) != 0) {
+        printf("Error: Could not allocate memory for weather data\n");
+        weather_stations_free(stations);
+        munmap((void*)text, size);
+        return NULL;
+    }
+    
+    int status = 0;
+    const char* current = NULL;     // Id of the open group, within the mapping
+    size_t current_length = 0;
+    for (int line = 2; p < end && status == 0; line++) {
+        nl = memchr(p, '\n', (size_t)(end - p));
+        const char* line_end = nl ? nl : end;
+        const char* comma = memchr(p, ',', (size_t)(line_end - p));
+        
+        WeatherPoint point;
+        int parsed = -1;
+        if (comma) {
+            parsed = csv_parse_legacy(comma + 1, line_end, &point);
+            if (parsed < 0) parsed = 0;
+        } else {
+            for (const char* c = p; c < line_end && parsed == -1; c++) {
+                if (!csv_is_space(*c)) parsed = 0;
+            }
+        }
+        if (parsed == WEATHER_NUM_FEATURES) {
+            size_t length = (size_t)(comma - p);
+            if (!current || length != current_length || memcmp(p, current, length) != 0) {
+                if (stations->count == capacity) {
+                    capacity *= 2;
+                    char** ids = realloc(stations->ids, (size_t)capacity * sizeof(char*));
+                    if (ids) stations->ids = ids;
+                    int* starts = realloc(stations->starts, (size_t)(capacity + 1) * sizeof(int));
+                    if (starts) stations->starts = starts;
+                    if (!ids || !starts) {
+                        status = -1;
+                        break;
+                    }
+                }
+                char* id = malloc(length + 1);
+                if (!id) {
+                    status = -1;
+                    break;
+                }
+                memcpy(id, p, length);
+                id[length] = '\0';
+                stations->ids[stations->count] = id;
+                stations->starts[stations->count] = dataset->size;
+                stations->count++;
+                current = p;
+                current_length = length;
+            }
+            dataset->data[dataset->size++] = point;
+        } else if (parsed != -1) {
+            printf("Warning: Invalid data format at line %d (parsed %d fields)\n", line, parsed);
+        }
+        
+        if (!nl) break;
+        p = nl + 1;
+    }
+    munmap((void*)text, size);
+    
+    if (status != 0) {
+        printf("Error: Could not allocate memory for weather data\n");
+        weather_stations_free(stations);
+        return NULL;
+    }
+    stations->starts[stations->count] = dataset->size;
+    
+    printf("Loaded %d weather data points for %d stations from %s\n", dataset->size, stations->count, filename);
+    return stations;
+}
+
+void weather_stations_free(WeatherStations* stations) {
+    if (!stations) return;
+    
+    for (int s = 0; s < stations->count; s++) {
+        free(stations->ids[s]);
+    }
+    free(stations->ids);
+    free(stations->starts);
+    free(stations);
+}
+
 // Save weather data to CSV
 int weather_save_csv(const char* filename, WeatherDataset* dataset) {
     if (!filename || !dataset) return -1;
@@ -158,6 +662,145 @@ int weather_save_csv(const char* filename, WeatherDataset* dataset) {
     return 0;
 }
 
+static const char* weather_column_names[WEATHER_NUM_FEATURES] = {
+    "temperature", "pressure", "humidity", "wind_speed", "wind_direction", "precipitation"
+};
+
+// Non-zero if the file starts with the binary dataset magic
+int weather_is_binary(const char* filename) {
+    if (!filename) return 0;
+    
+    FILE* file = fopen(filename, "rb");
+    if (!file) return 0;
+    
+    char magic[8];
+    int match = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                memcmp(magic, WEATHER_BINARY_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+    return match;
+}
+
+// Save dataset in the binary format. params is stored for later runs; if
+// NULL it is computed from the dataset (which must then hold raw values).
+int weather_save_binary(const char* filename, WeatherDataset* dataset, NormalizationParams* params, int normalized) {
+    if (!filename || !dataset || dataset->size <= 0 || (normalized && !params)) return -1;
+    
+    WeatherBinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WEATHER_BINARY_MAGIC, sizeof(header.magic));
+    header.version = WEATHER_BINARY_VERSION;
+    header.byte_order = WEATHER_BINARY_BYTE_ORDER;
+    header.num_columns = WEATHER_NUM_FEATURES;
+    header.flags = normalized ? WEATHER_BINARY_NORMALIZED : 0;
+    header.rows = (uint64_t)dataset->size;
+    header.data_offset = (sizeof(header) + 63) & ~(uint64_t)63;
+    for (int c = 0; c < WEATHER_NUM_FEATURES; c++) {
+        strncpy(header.columns[c], weather_column_names[c], sizeof(header.columns[c]) - 1);
+    }
+    
+    if (params) {
+        header.norm_params = *params;
+    } else {
+        NormalizationParams* computed = calculate_normalization_params(dataset);
+        if (!computed) return -1;
+        header.norm_params = *computed;
+        free(computed);
+    }
+    
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        printf("Error: Could not create file %s\n", filename);
+        return -1;
+    }
+    
+    static const char padding[64] = {0};
+    size_t pad = (size_t)header.data_offset - sizeof(header);
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(padding, 1, pad, file) == pad &&
+             fwrite(dataset->data, sizeof(WeatherPoint), (size_t)dataset->size, file) == (size_t)dataset->size;
+    if (fclose(file) != 0) ok = 0;
+    
+    if (!ok) {
+        printf("Error: Could not write %s\n", filename);
+        return -1;
+    }
+    
+    printf("Saved %d weather data points to %s\n", dataset->size, filename);
+    return 0;
+}
+
+// Map a binary dataset file into dataset, replacing its contents. The rows
+// are used in place through a private mapping; nothing is parsed or copied.
+int weather_load_binary(const char* filename, WeatherDataset* dataset, NormalizationParams* params, int* normalized) {
+    if (!filename || !dataset) return -1;
+    
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Could not open file %s\n", filename);
+        return -1;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(WeatherBinaryHeader)) {
+        printf("Error: %s is not a binary weather dataset\n", filename);
+        close(fd);
+        return -1;
+    }
+    
+    size_t map_size = (size_t)st.st_size;
+    void* base = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        printf("Error: Could not map %s\n", filename);
+        return -1;
+    }
+    
+    const WeatherBinaryHeader* header = base;
+    int valid = memcmp(header->magic, WEATHER_BINARY_MAGIC, sizeof(header->magic)) == 0;
+    if (valid && (header->version != WEATHER_BINARY_VERSION || header->byte_order != WEATHER_BINARY_BYTE_ORDER)) {
+        printf("Error: %s has unsupported version %u or byte order\n", filename, header->version);
+        valid = 0;
+    } else if (valid) {
+        valid = header->num_columns == WEATHER_NUM_FEATURES &&
+                header->data_offset % 64 == 0 && header->data_offset >= sizeof(WeatherBinaryHeader) &&
+                header->data_offset <= map_size && header->rows > 0 && header->rows <= INT_MAX &&
+                header->rows <= (map_size - header->data_offset) / sizeof(WeatherPoint);
+        for (int c = 0; valid && c < WEATHER_NUM_FEATURES; c++) {
+            valid = strncmp(header->columns[c], weather_column_names[c], sizeof(header->columns[c])) == 0;
+        }
+        if (!valid) {
+            printf("Error: %s has an unexpected schema or is truncated\n", filename);
+        }
+    } else {
+        printf("Error: %s is not a binary weather dataset\n", filename);
+    }
+    
+    if (!valid) {
+        munmap(base, map_size);
+        return -1;
+    }
+    
+    // Training streams through the rows; ask for them to be read ahead
+    posix_madvise(base, map_size, POSIX_MADV_WILLNEED);
+    
+    if (params) *params = header->norm_params;
+    if (normalized) *normalized = (header->flags & WEATHER_BINARY_NORMALIZED) != 0;
+    
+    if (dataset->map_base) {
+        munmap(dataset->map_base, dataset->map_size);
+    } else {
+        large_free(dataset->data);
+    }
+    dataset->data = (WeatherPoint*)((char*)base + header->data_offset);
+    dataset->size = (int)header->rows;
+    dataset->capacity = dataset->size;
+    dataset->map_base = base;
+    dataset->map_size = map_size;
+    
+    printf("Mapped %d weather data points from %s\n", dataset->size, filename);
+    return 0;
+}
+
 // Calculate normalization parameters
 NormalizationParams* calculate_normalization_params(WeatherDataset* dataset) {
     if (!dataset || dataset->size == 0) return NULL;
@@ -165,56 +808,64 @@ NormalizationParams* calculate_normalization_params(WeatherDataset* dataset) {
     NormalizationParams* params = malloc(sizeof(NormalizationParams));
     if (!params) return NULL;
     
-    // Initialize min/max with first data point
-    WeatherPoint* first = &dataset->data[0];
-    params->temp_min = params->temp_max = first->temperature;
-    params->pressure_min = params->pressure_max = first->pressure;
-    params->humidity_min = params->humidity_max = first->humidity;
-    params->wind_speed_min = params->wind_speed_max = first->wind_speed;
-    params->wind_dir_min = params->wind_dir_max = first->wind_direction;
-    params->precip_min = params->precip_max = first->precipitation;
-    
-    // Find actual min/max values
+    // Initialize min/max with first data point, then widen
+    normalization_params_init(params, &dataset->data[0]);
     for (int i = 1; i < dataset->size; i++) {
-        WeatherPoint* point = &dataset->data[i];
-        
-        if (point->temperature < params->temp_min) params->temp_min = point->temperature;
-        if (point->temperature > params->temp_max) params->temp_max = point->temperature;
-        
-        if (point->pressure < params->pressure_min) params->pressure_min = point->pressure;
-        if (point->pressure > params->pressure_max) params->pressure_max = point->pressure;
-        
-        if (point->humidity < params->humidity_min) params->humidity_min = point->humidity;
-        if (point->humidity > params->humidity_max) params->humidity_max = point->humidity;
-        
-        if (point->wind_speed < params->wind_speed_min) params->wind_speed_min = point->wind_speed;
-        if (point->wind_speed > params->wind_speed_max) params->wind_speed_max = point->wind_speed;
-        
-        if (point->wind_direction < params->wind_dir_min) params->wind_dir_min = point->wind_direction;
-        if (point->wind_direction > params->wind_dir_max) params->wind_dir_max = point->wind_direction;
-        
-        if (point->precipitation < params->precip_min) params->precip_min = point->precipitation;
-        if (point->precipitation > params->precip_max) params->precip_max = point->precipitation;
+        normalization_params_fold(params, &dataset->data[i]);
     }
     
     return params;
 }
 
+// Running min/max: start from one point, then widen with every later one
+void normalization_params_init(NormalizationParams* params, const WeatherPoint* point) {
+    if (!params || !point) return;
+    
+    params->temp_min = params->temp_max = point->temperature;
+    params->pressure_min = params->pressure_max = point->pressure;
+    params->humidity_min = params->humidity_max = point->humidity;
+    params->wind_speed_min = params->wind_speed_max = point->wind_speed;
+    params->wind_dir_min = params->wind_dir_max = point->wind_direction;
+    params->precip_min = params->precip_max = point->precipitation;
+}
+
+void normalization_params_fold(NormalizationParams* params, const WeatherPoint* point) {
+    if (!params || !point) return;
+    
+    if (point->temperature < params->temp_min) params->temp_min = point->temperature;
+    if (point->temperature > params->temp_max) params->temp_max = point->temperature;
+    
+    if (point->pressure < params->pressure_min) params->pressure_min = point->pressure;
+    if (point->pressure > params->pressure_max) params->pressure_max = point->pressure;
+    
+    if (point->humidity < params->humidity_min) params->humidity_min = point->humidity;
+    if (point->humidity > params->humidity_max) params->humidity_max = point->humidity;
+    
+    if (point->wind_speed < params->wind_speed_min) params->wind_speed_min = point->wind_speed;
+    if (point->wind_speed > params->wind_speed_max) params->wind_speed_max = point->wind_speed;
+    
+    if (point->wind_direction < params->wind_dir_min) params->wind_dir_min = point->wind_direction;
+    if (point->wind_direction > params->wind_dir_max) params->wind_dir_max = point->wind_direction;
+    
+    if (point->precipitation < params->precip_min) params->precip_min = point->precipitation;
+    if (point->precipitation > params->precip_max) params->precip_max = point->precipitation;
+}
+
 // Normalize dataset
 void normalize_dataset(WeatherDataset* dataset, NormalizationParams* params) {
     if (!dataset || !params) return;
     
+    // Normalize to [0, 1] range, handle cases where min == max
+    double temp_range = params->temp_max - params->temp_min;
+    double pressure_range = params->pressure_max - params->pressure_min;
+    double humidity_range = params->humidity_max - params->humidity_min;
+    double wind_speed_range = params->wind_speed_max - params->wind_speed_min;
+    double wind_dir_range = params->wind_dir_max - params->wind_dir_min;
+    double precip_range = params->precip_max - params->precip_min;
+    
     for (int i = 0; i < dataset->size; i++) {
         WeatherPoint* point = &dataset->data[i];
         
-        // Normalize to [0, 1] range, handle cases where min == max
-        double temp_range = params->temp_max - params->temp_min;
-        double pressure_range = params->pressure_max - params->pressure_min;
-        double humidity_range = params->humidity_max - params->humidity_min;
-        double wind_speed_range = params->wind_speed_max - params->wind_speed_min;
-        double wind_dir_range = params->wind_dir_max - params->wind_dir_min;
-        double precip_range = params->precip_max - params->precip_min;
-        
         point->temperature = (temp_range > 0) ? (point->temperature - params->temp_min) / temp_range : 0.5;
         point->pressure = (pressure_range > 0) ? (point->pressure - params->pressure_min) / pressure_range : 0.5;
         point->humidity = (humidity_range > 0) ? (point->humidity - params->humidity_min) / humidity_range : 0.5;
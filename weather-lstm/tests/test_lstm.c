@@ -1,8 +1,27 @@
 #include "../include/lstm.h"
 #include "../include/weather_data.h"
+#include "../include/weather_columns.h"
+#include "../include/matrix_kernels.h"
+#include "../include/bptt.h"
+#include "../include/thread_pool.h"
+#include "../include/train_parallel.h"
+#include "../include/batch_predict.h"
+#include "../include/inference_server.h"
+#include "../include/precision.h"
+#include "../include/lstm_fixed.h"
+#include "../include/arena.h"
+#include "../include/wavefront.h"
+#include "../include/profile.h"
+#include "../include/online.h"
+#include "../include/tuning.h"
+#include "../include/evaluate.h"
+#include "../include/optimizer.h"
+#include "../include/checkpoint.h"
+#include "../include/large_alloc.h"
 #include <stdio.h>
 #include <assert.h>
 #include <math.h>
+#include <stdint.h>
 
 // Test matrix operations
 void test_matrix_operations() {
@@ -53,6 +72,404 @@ void test_matrix_operations() {
     printf("Matrix operations tests passed!\n");
 }
 
+// Test contiguous matrix storage and the row-pointer compatibility path
+void test_matrix_storage() {
+    printf("Testing matrix storage layout...\n");
+    
+    Matrix* m = matrix_create(5, 7);
+    assert(m != NULL);
+    assert(m->stride >= m->cols);
+    assert(((uintptr_t)m->storage % MATRIX_ALIGNMENT) == 0);
+    
+    // Rows are laid out back to back in one buffer
+    for (int i = 0; i < m->rows; i++) {
+        assert(m->data[i] == m->storage + (size_t)i * m->stride);
+    }
+    
+    // Writes through either access path are visible through the other
+    m->data[3][4] = 2.5;
+    assert(MATRIX_AT(m, 3, 4) == 2.5);
+    MATRIX_AT(m, 4, 6) = -1.0;
+    assert(matrix_get(m, 4, 6) == -1.0);
+    
+    Matrix* t = matrix_transpose(m);
+    assert(t != NULL);
+    assert(t->rows == 7 && t->cols == 5);
+    assert(MATRIX_AT(t, 4, 3) == 2.5);
+    assert(t->data[6][4] == -1.0);
+    
+    matrix_free(t);
+    matrix_free(m);
+    
+    printf("Matrix storage layout tests passed!\n");
+}
+
+// Test output-parameter matrix operations
+void test_matrix_into() {
+    printf("Testing output-parameter matrix operations...\n");
+    
+    Matrix* W = matrix_create(3, 2);
+    Matrix* x = matrix_create(2, 1);
+    Matrix* bias = matrix_create(3, 1);
+    Matrix* y = matrix_create(3, 1);
+    
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 2; j++) {
+            matrix_set(W, i, j, i * 2 + j + 1);  // [1 2; 3 4; 5 6]
+        }
+        matrix_set(bias, i, 0, 0.5);
+    }
+    matrix_set(x, 0, 0, 1.0);
+    matrix_set(x, 1, 0, -1.0);
+    
+    // y = W x + b = [-1; -1; -1] + 0.5
+    assert(gemv_add_bias_into(y, W, x, bias) == 0);
+    for (int i = 0; i < 3; i++) {
+        assert(fabs(matrix_get(y, i, 0) + 0.5) < 1e-12);
+    }
+    
+    // y += W x
+    assert(gemv_accumulate_into(y, W, x) == 0);
+    assert(fabs(matrix_get(y, 2, 0) + 1.5) < 1e-12);
+    
+    // Elementwise ops may alias dest with an operand
+    assert(matrix_add_into(y, y, bias) == 0);
+    assert(fabs(matrix_get(y, 0, 0) + 1.0) < 1e-12);
+    
+    // Outer product accumulation matches multiply by the transpose
+    Matrix* outer = matrix_create(3, 2);
+    assert(matrix_outer_accumulate(outer, bias, x, 2.0) == 0);
+    assert(fabs(matrix_get(outer, 1, 0) - 1.0) < 1e-12);
+    assert(fabs(matrix_get(outer, 1, 1) + 1.0) < 1e-12);
+    
+    // Batched products broadcast the bias over columns and reduce rows
+    Matrix* X = matrix_create(2, 3);
+    Matrix* Y = matrix_create(3, 3);
+    for (int j = 0; j < 3; j++) {
+        matrix_set(X, 0, j, j);
+        matrix_set(X, 1, j, 1.0);
+    }
+    assert(gemm_add_bias_into(Y, W, X, bias) == 0);
+    assert(fabs(matrix_get(Y, 2, 1) - 11.5) < 1e-12);  // 5*1 + 6*1 + 0.5
+    assert(gemm_accumulate_into(Y, W, X) == 0);
+    assert(fabs(matrix_get(Y, 0, 0) - 4.5) < 1e-12);   // 2 * (1*0 + 2*1) + 0.5
+    matrix_zero(y);
+    assert(matrix_accumulate_row_sums(y, Y) == 0);
+    assert(fabs(matrix_get(y, 0, 0) - (4.5 + 6.5 + 8.5)) < 1e-12);
+    matrix_free(X);
+    matrix_free(Y);
+    
+    // Shape mismatches and illegal aliasing are rejected
+    assert(matrix_multiply_into(y, x, W) == -1);
+    assert(matrix_transpose_into(W, W) == -1);
+    assert(gemv_add_bias_into(x, W, x, bias) == -1);
+    
+    matrix_free(W);
+    matrix_free(x);
+    matrix_free(bias);
+    matrix_free(y);
+    matrix_free(outer);
+    
+    printf("Output-parameter matrix operations tests passed!\n");
+}
+
+// Test every kernel table this CPU supports against the scalar reference
+void test_matrix_kernels() {
+    printf("Testing matrix kernels...\n");
+    
+    static const char* names[] = {"scalar", "avx2", "avx512", "neon"};
+    const char* original = matrix_kernels()->name;
+    
+    // Odd sizes exercise the vector tails
+    int m = 37, n = 19, p = 23;
+    double A[37 * 19], B[19 * 23], x[19], act[61];
+    double C_ref[37 * 23], y_ref[37], sig_ref[61], tanh_ref[61];
+    for (int i = 0; i < m * n; i++) A[i] = sin(0.37 * i);
+    for (int i = 0; i < n * p; i++) B[i] = cos(0.11 * i);
+    for (int i = 0; i < n; i++) x[i] = 0.05 * i - 0.4;
+    for (int i = 0; i < 61; i++) act[i] = -30.0 + i;
+    
+    assert(matrix_kernels_select("scalar") == 0);
+    const MatrixKernels* ref = matrix_kernels();
+    ref->gemm(m, p, n, A, n, B, p, C_ref, p, 0);
+    ref->gemv(m, n, A, n, x, y_ref, 0);
+    memcpy(sig_ref, act, sizeof(act));
+    memcpy(tanh_ref, act, sizeof(act));
+    ref->sigmoid(61, sig_ref);
+    ref->tanh(61, tanh_ref);
+    
+    for (size_t t = 0; t < sizeof(names) / sizeof(names[0]); t++) {
+        if (!matrix_kernels_available(names[t])) continue;
+        assert(matrix_kernels_select(names[t]) == 0);
+        const MatrixKernels* k = matrix_kernels();
+        
+        double C[37 * 23], y[37], sig[61], th[61];
+        k->gemm(m, p, n, A, n, B, p, C, p, 0);
+        k->gemm(m, p, n, A, n, B, p, C, p, 1);  // C = 2 A B
+        for (int i = 0; i < m * p; i++) {
+            assert(fabs(C[i] - 2.0 * C_ref[i]) < 1e-10);
+        }
+        
+        for (int i = 0; i < m; i++) y[i] = 1.0;
+        k->gemv(m, n, A, n, x, y, 1);
+        for (int i = 0; i < m; i++) {
+            assert(fabs(y[i] - (1.0 + y_ref[i])) < 1e-12);
+        }
+        
+        memcpy(sig, act, sizeof(act));
+        memcpy(th, act, sizeof(act));
+        k->sigmoid(61, sig);
+        k->tanh(61, th);
+        for (int i = 0; i < 61; i++) {
+            assert(fabs(sig[i] - sig_ref[i]) < 1e-12);
+            assert(fabs(th[i] - tanh_ref[i]) < 1e-12);
+        }
+        
+        // Elementwise kernels: y = 2 * (x + x) - x = 3x
+        double e[19];
+        k->add(n, x, x, e);
+        k->scale(n, 2.0, e);
+        k->axpy(n, -1.0, x, e);
+        for (int i = 0; i < n; i++) {
+            assert(fabs(e[i] - 3.0 * x[i]) < 1e-12);
+        }
+        
+        // Column kernels must match the scalar expressions bit for bit
+        double lo, hi, r[61];
+        k->minmax(61, act, &lo, &hi);
+        assert(lo == -30.0 && hi == 30.0);
+        k->minmax(19, x, &lo, &hi);
+        assert(lo == x[0] && hi == x[18]);
+        memcpy(r, act, sizeof(act));
+        k->rescale(61, r, -30.0, 7.0);
+        for (int i = 0; i < 61; i++) {
+            assert(r[i] == (act[i] - -30.0) / 7.0);
+        }
+        k->affine(61, r, 7.0, -30.0);
+        for (int i = 0; i < 61; i++) {
+            assert(r[i] == ((act[i] - -30.0) / 7.0) * 7.0 + -30.0);
+        }
+        
+        // Optimizer updates round exactly like the scalar expressions
+        double w_mom[61], v_mom[61], w_adam[61], m_adam[61], v_adam[61];
+        for (int i = 0; i < 61; i++) {
+            w_mom[i] = w_adam[i] = 0.01 * i;
+            v_mom[i] = m_adam[i] = 0.1 * sin(i);
+            v_adam[i] = 0.01 * (1.0 + cos(i));
+        }
+        k->momentum(61, 0.05, 0.5, 0.9, act, v_mom, w_mom);
+        k->adam(61, 0.01, 0.5, 0.9, 0.999, 1e-8, 1.25, act, m_adam, v_adam, w_adam);
+        for (int i = 0; i < 61; i++) {
+            double v = 0.9 * (0.1 * sin(i)) + 0.5 * act[i];
+            assert(v_mom[i] == v && w_mom[i] == 0.01 * i - 0.05 * v);
+            double g = 0.5 * act[i];
+            double mi = 0.9 * (0.1 * sin(i)) + (1.0 - 0.9) * g;
+            double vi = 0.999 * (0.01 * (1.0 + cos(i))) + (1.0 - 0.999) * (g * g);
+            assert(m_adam[i] == mi && v_adam[i] == vi);
+            assert(w_adam[i] == 0.01 * i - 0.01 * mi / (sqrt(vi * 1.25) + 1e-8));
+        }
+        double squares = 0.0;
+        for (int i = 0; i < 61; i++) squares += act[i] * act[i];
+        assert(fabs(k->sumsq(61, act) - squares) < 1e-9 && k->sumsq(0, act) == 0.0);
+        
+        // Reduced-precision gemv on the transposed A, against double sums
+        float At[19 * 37], xf[19], yf[37], scale[37];
+        int8_t Aq[19 * 37];
+        for (int i = 0; i < m; i++) {
+            scale[i] = 0.01f * (i + 1);
+            for (int j = 0; j < n; j++) {
+                At[j * m + i] = (float)A[i * n + j];
+                Aq[j * m + i] = (int8_t)((i * 7 + j * 13) % 255 - 127);
+            }
+        }
+        for (int j = 0; j < n; j++) xf[j] = (float)x[j];
+        for (int i = 0; i < m; i++) yf[i] = 1.0f;
+        k->gemv_f32(m, n, At, m, xf, yf, 1);
+        for (int i = 0; i < m; i++) {
+            assert(fabs(yf[i] - (1.0 + y_ref[i])) < 1e-5);
+        }
+        k->gemv_i8(m, n, Aq, m, scale, xf, yf, 0);
+        for (int i = 0; i < m; i++) {
+            double sum = 0.0;
+            for (int j = 0; j < n; j++) sum += (double)Aq[j * m + i] * xf[j];
+            assert(fabs(yf[i] - scale[i] * sum) < 1e-4);
+        }
+    }
+    
+    assert(matrix_kernels_select("no-such-kernel") == -1);
+    assert(matrix_kernels_select(original) == 0);
+    
+    printf("Matrix kernels tests passed (active: %s)!\n", original);
+}
+
+// Arena blocks are aligned, released in O(1) and fall back to the heap when full
+void test_arena() {
+    printf("Testing scratch arena...\n");
+    
+    Arena* arena = arena_create(arena_matrix_bytes(4, 3) + arena_view_bytes(4));
+    assert(arena != NULL && arena->used == 0);
+    
+    Matrix* m = matrix_create_in(arena, 4, 3);
+    assert(m != NULL && m->in_arena && m->rows == 4 && m->cols == 3);
+    assert(((size_t)m->storage % MATRIX_ALIGNMENT) == 0);
+    for (int i = 0; i < 12; i++) {
+        assert(m->storage[i] == 0.0);
+    }
+    matrix_set(m, 3, 2, 7.0);
+    assert(m->data[3][2] == 7.0);
+    matrix_free(m);  // No-op for arena matrices
+    
+    size_t mark = arena_mark(arena);
+    Matrix* v = matrix_wrap_in(arena, m->storage, 4, 3, 3);
+    assert(v != NULL && v->in_arena && matrix_get(v, 3, 2) == 7.0);
+    assert(arena->used == arena->capacity);
+    
+    // Full: the next matrix comes from the heap and is freed normally
+    Matrix* spill = matrix_create_in(arena, 2, 2);
+    assert(spill != NULL && !spill->in_arena && arena->overflows == 1);
+    matrix_free(spill);
+    
+    arena_release(arena, mark);
+    assert(arena->used == mark);
+    arena_reset(arena);
+    assert(arena->used == 0 && arena->peak == arena->capacity);
+    assert(arena_alloc(arena, arena->capacity + 1) == NULL);
+    
+    // Without an arena the constructors behave like matrix_create/matrix_wrap
+    Matrix* heap = matrix_create_in(NULL, 2, 2);
+    assert(heap != NULL && !heap->in_arena);
+    matrix_free(heap);
+    arena_free(arena);
+    
+    printf("Scratch arena tests passed!\n");
+}
+
+// Test large buffer placement under every page mode
+void test_large_alloc() {
+    printf("Testing large buffer allocation...\n");
+    
+    LargePages pages;
+    assert(large_pages_parse("thp", &pages) == 0 && pages == LARGE_PAGES_THP);
+    assert(large_pages_parse("huge", &pages) != 0);
+    assert(strcmp(large_pages_name(LARGE_PAGES_HUGETLB), "hugetlb") == 0);
+    assert(large_alloc_nodes() >= 1);
+    
+    LargeAllocPolicy policy;
+    large_alloc_policy_default(&policy);
+    assert(policy.pages == LARGE_PAGES_DEFAULT && !policy.numa && policy.min_bytes == LARGE_HUGEPAGE_SIZE);
+    
+    // Each mode with a low threshold so small blocks take the mapped path;
+    // hugetlb falls back to THP when the pool is empty
+    for (int mode = 0; mode < LARGE_PAGES_NUM_MODES; mode++) {
+        policy.pages = (LargePages)mode;
+        policy.numa = mode > 0;
+        policy.min_bytes = 4096;
+        large_alloc_set_policy(&policy);
+        
+        size_t bytes = 3 * LARGE_HUGEPAGE_SIZE + 100;
+        unsigned char* block = large_alloc(bytes);
+        assert(block != NULL && ((size_t)block % MATRIX_ALIGNMENT) == 0);
+        for (size_t i = 0; i < bytes; i += 4096) {
+            assert(block[i] == 0);
+        }
+        memset(block, 0xAB, bytes);
+        
+        LargeResidency residency;
+        assert(large_alloc_residency(block, bytes, 64, &residency) == 0 || residency.pages_sampled == 0);
+        assert(residency.bytes == bytes && residency.local_pages + residency.remote_pages <= residency.pages_sampled);
+        
+        // Growing keeps the contents and zero-fills the rest; shrinking
+        // then growing again must not bring old bytes back
+        block = large_realloc(block, 2 * bytes);
+        assert(block != NULL && block[0] == 0xAB && block[bytes - 1] == 0xAB && block[bytes] == 0);
+        block = large_realloc(block, 10);
+        assert(block != NULL && block[9] == 0xAB);
+        block = large_realloc(block, 100);
+        assert(block != NULL && block[9] == 0xAB && block[10] == 0 && block[99] == 0);
+        large_free(block);
+        
+        // Shared blocks, matrices and datasets all go through the layer
+        double* shared = large_alloc_shared(8 * 4096);
+        assert(shared != NULL && shared[4095] == 0.0);
+        large_free(shared);
+        Matrix* m = matrix_create(64, 64);
+        assert(m != NULL && matrix_get(m, 63, 63) == 0.0);
+        matrix_free(m);
+        WeatherDataset* dataset = weather_dataset_create(2);
+        for (int i = 0; i < 1000; i++) {
+            WeatherPoint point = {i, 0.0, 0.0, 0.0, 0.0, 0.0};
+            assert(weather_dataset_add(dataset, point) == 0);
+        }
+        assert(dataset->size == 1000 && dataset->data[999].temperature == 999.0);
+        weather_dataset_free(dataset);
+    }
+    
+    // Blocks outlive a policy change
+    large_alloc_policy_default(&policy);
+    policy.pages = LARGE_PAGES_THP;
+    policy.min_bytes = 4096;
+    large_alloc_set_policy(&policy);
+    void* mapped = large_alloc(8192);
+    large_alloc_set_policy(NULL);
+    void* heap = large_alloc(8192);
+    assert(mapped != NULL && heap != NULL);
+    large_free(mapped);
+    large_free(heap);
+    large_free(NULL);
+    assert(large_alloc_policy()->pages == LARGE_PAGES_DEFAULT);
+    
+    printf("Large buffer allocation tests passed!\n");
+}
+
+// Test profile counters and reports; hot-path hooks only with PROFILE=1
+void test_profile() {
+    printf("Testing profiler...\n");
+    
+    ProfileFormat format;
+    assert(profile_format_parse("json", &format) == 0 && format == PROFILE_FORMAT_JSON);
+    assert(profile_format_parse("xml", &format) == -1);
+    
+    double before = profile_seconds();
+    uint64_t start = profile_clock_ns();
+    assert(profile_seconds() >= before);
+    
+    profile_reset();
+    profile_add_time(PROFILE_UPDATE, start);
+    profile_add_work(PROFILE_UPDATE, 1000, 24);
+    profile_add_work(PROFILE_NUM_PHASES, 1, 1);
+    ProfileCounters counters;
+    profile_snapshot(PROFILE_UPDATE, &counters);
+    assert(counters.calls == 1 && counters.flops == 1000 && counters.bytes == 24);
+    assert(strcmp(profile_phase_name(PROFILE_MODEL_IO), "model_io") == 0);
+    
+    FILE* out = tmpfile();
+    assert(profile_report(out, PROFILE_FORMAT_JSON, 0.5, 10) == 0);
+    rewind(out);
+    char line[2048];
+    assert(fgets(line, sizeof(line), out) != NULL);
+    assert(strstr(line, "\"sequences_per_second\": 20.000") != NULL);
+    assert(strstr(line, "\"name\": \"update\", \"seconds\"") != NULL);
+    fclose(out);
+    
+    // One step lands in the gate phase, with FLOPs from the tensor shapes
+    LSTMCell* cell = lstm_cell_create(3, 4);
+    Matrix* x = matrix_create(3, 1);
+    profile_reset();
+    assert(lstm_cell_step(cell, x) == 0);
+    profile_snapshot(PROFILE_GATES, &counters);
+    if (profile_enabled()) {
+        assert(counters.calls == 1 && counters.flops == 2 * 16 * (3 + 4));
+    } else {
+        assert(counters.calls == 0 && profile_allocations() == 0);
+    }
+    profile_reset();
+    
+    matrix_free(x);
+    lstm_cell_free(cell);
+    
+    printf("Profiler tests passed!\n");
+}
+
 // Test weather data operations
 void test_weather_data() {
     printf("Testing weather data operations...\n");
@@ -127,6 +544,18 @@ void test_lstm_cell() {
     assert(output != NULL);
     assert(output->rows == 32 && output->cols == 1);
     
+    // In-place step from the same state gives the same hidden state
+    Matrix* saved_cell = matrix_create(32, 1);
+    lstm_cell_reset_state(cell);
+    assert(lstm_cell_step(cell, input) == 0);
+    for (int i = 0; i < 32; i++) {
+        assert(fabs(matrix_get(cell->hidden_state, i, 0) - matrix_get(output, i, 0)) < 1e-12);
+    }
+    matrix_copy(saved_cell, cell->cell_state);
+    assert(lstm_cell_step(cell, input) == 0);
+    assert(matrix_get(cell->cell_state, 0, 0) != matrix_get(saved_cell, 0, 0));
+    matrix_free(saved_cell);
+    
     // Check that output values are reasonable (between -1 and 1 due to tanh)
     for (int i = 0; i < 32; i++) {
         double val = matrix_get(output, i, 0);
@@ -140,6 +569,134 @@ void test_lstm_cell() {
     printf("LSTM cell operations tests passed!\n");
 }
 
+// Unfused reference for one gate: act(W_g x + U_g h + b_g)
+static Matrix* reference_gate(Matrix* W, Matrix* U, Matrix* b, Matrix* x, Matrix* h, int use_tanh) {
+    Matrix* wx = matrix_multiply(W, x);
+    Matrix* uh = matrix_multiply(U, h);
+    Matrix* sum = matrix_add(wx, uh);
+    Matrix* gate = matrix_add(sum, b);
+    if (use_tanh) {
+        apply_tanh(gate);
+    } else {
+        apply_sigmoid(gate);
+    }
+    matrix_free(wx);
+    matrix_free(uh);
+    matrix_free(sum);
+    return gate;
+}
+
+// Test fused four-gate layout against a per-gate reference
+void test_lstm_fused_gates() {
+    printf("Testing fused LSTM gate layout...\n");
+    
+    int H = 8;
+    LSTMCell* cell = lstm_cell_create(6, H);
+    assert(cell != NULL);
+    assert(cell->W->rows == LSTM_NUM_GATES * H && cell->W->cols == 6);
+    assert(cell->U->rows == LSTM_NUM_GATES * H && cell->U->cols == H);
+    assert(cell->b->rows == LSTM_NUM_GATES * H);
+    
+    // Per-gate matrices are views into the stacked ones
+    assert(cell->W_f->storage == cell->W->storage);
+    assert(cell->U_o->storage == MATRIX_ROW(cell->U, LSTM_GATE_OUTPUT * H));
+    assert(matrix_get(cell->b_f, 0, 0) == 1.0);
+    
+    Matrix* x = matrix_create(6, 1);
+    for (int i = 0; i < 6; i++) {
+        matrix_set(x, i, 0, 0.1 * (i + 1));
+    }
+    
+    // Run two steps so the recurrent term is exercised
+    assert(lstm_cell_step(cell, x) == 0);
+    Matrix* h_prev = matrix_create(H, 1);
+    Matrix* c_prev = matrix_create(H, 1);
+    matrix_copy(h_prev, cell->hidden_state);
+    matrix_copy(c_prev, cell->cell_state);
+    assert(lstm_cell_step(cell, x) == 0);
+    
+    Matrix* f = reference_gate(cell->W_f, cell->U_f, cell->b_f, x, h_prev, 0);
+    Matrix* in = reference_gate(cell->W_i, cell->U_i, cell->b_i, x, h_prev, 0);
+    Matrix* g = reference_gate(cell->W_c, cell->U_c, cell->b_c, x, h_prev, 1);
+    Matrix* o = reference_gate(cell->W_o, cell->U_o, cell->b_o, x, h_prev, 0);
+    
+    for (int i = 0; i < H; i++) {
+        double c = matrix_get(f, i, 0) * matrix_get(c_prev, i, 0) +
+                   matrix_get(in, i, 0) * matrix_get(g, i, 0);
+        double h = matrix_get(o, i, 0) * tanh(c);
+        assert(fabs(matrix_get(cell->forget_gate, i, 0) - matrix_get(f, i, 0)) < 1e-12);
+        assert(fabs(matrix_get(cell->candidate_gate, i, 0) - matrix_get(g, i, 0)) < 1e-12);
+        assert(fabs(matrix_get(cell->cell_state, i, 0) - c) < 1e-12);
+        assert(fabs(matrix_get(cell->hidden_state, i, 0) - h) < 1e-12);
+    }
+    
+    matrix_free(f);
+    matrix_free(in);
+    matrix_free(g);
+    matrix_free(o);
+    matrix_free(h_prev);
+    matrix_free(c_prev);
+    matrix_free(x);
+    lstm_cell_free(cell);
+    
+    printf("Fused LSTM gate layout tests passed!\n");
+}
+
+// Specialized shapes must agree with the generic GEMM path
+void test_lstm_fixed_shapes() {
+    printf("Testing shape-specialized LSTM steps...\n");
+    
+    int previous = lstm_fixed_set_enabled(1);
+    assert(lstm_fixed_step_lookup(6, 64) != NULL);
+    assert(lstm_fixed_step_lookup(6, 48) == NULL);
+    assert(lstm_fixed_step_lookup(5, 64) == NULL);
+    
+    static const int sizes[] = {32, 64, 128, 256};
+    Matrix* x = matrix_create(6, 1);
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int H = sizes[s];
+        LSTMCell* cell = lstm_cell_create(6, H);
+        Matrix* gates = matrix_create(LSTM_NUM_GATES * H, 1);
+        Matrix* h = matrix_create(H, 1);
+        Matrix* c = matrix_create(H, 1);
+        Matrix* t = matrix_create(H, 1);
+        Matrix* t_ref = matrix_create(H, 1);
+        
+        // Three steps of each path from the same state
+        lstm_fixed_set_enabled(0);
+        for (int step = 0; step < 3; step++) {
+            for (int i = 0; i < 6; i++) matrix_set(x, i, 0, sin(0.7 * (i + 6 * step)));
+            assert(lstm_cell_step_state(cell, x, cell->hidden_state, cell->cell_state, cell->gates,
+                                        cell->cell_state, t_ref, cell->hidden_state) == 0);
+        }
+        lstm_fixed_set_enabled(1);
+        for (int step = 0; step < 3; step++) {
+            for (int i = 0; i < 6; i++) matrix_set(x, i, 0, sin(0.7 * (i + 6 * step)));
+            assert(lstm_cell_step_state(cell, x, h, c, gates, c, t, h) == 0);
+        }
+        
+        for (int i = 0; i < H; i++) {
+            assert(fabs(matrix_get(h, i, 0) - matrix_get(cell->hidden_state, i, 0)) < 1e-12);
+            assert(fabs(matrix_get(c, i, 0) - matrix_get(cell->cell_state, i, 0)) < 1e-12);
+            assert(fabs(matrix_get(t, i, 0) - matrix_get(t_ref, i, 0)) < 1e-12);
+        }
+        for (int i = 0; i < LSTM_NUM_GATES * H; i++) {
+            assert(fabs(matrix_get(gates, i, 0) - matrix_get(cell->gates, i, 0)) < 1e-12);
+        }
+        
+        matrix_free(gates);
+        matrix_free(h);
+        matrix_free(c);
+        matrix_free(t);
+        matrix_free(t_ref);
+        lstm_cell_free(cell);
+    }
+    matrix_free(x);
+    lstm_fixed_set_enabled(previous);
+    
+    printf("Shape-specialized LSTM step tests passed!\n");
+}
+
 // Test LSTM network
 void test_lstm_network() {
     printf("Testing LSTM network operations...\n");
@@ -177,6 +734,1315 @@ void test_lstm_network() {
     printf("LSTM network operations tests passed!\n");
 }
 
+// Batched inference must match the single-window path column by column
+void test_batch_predict() {
+    printf("Testing batch prediction...\n");
+    
+    LSTMNetwork* network = lstm_network_create(6, 16, 6);
+    assert(network != NULL);
+    
+    int steps = 5, count = 3;
+    double features[(3 + 5) * 6];
+    for (int i = 0; i < (count + steps) * 6; i++) features[i] = sin(0.7 * i);
+    
+    // Overlapping windows, fewer than the batch size so padding is exercised
+    BatchPredictor* predictor = batch_predictor_create(network, 4);
+    assert(predictor != NULL);
+    double* windows[3] = {features, features + 6, features + 12};
+    assert(batch_predictor_run(predictor, network, windows, count, steps) == 0);
+    assert(predictor->columns == count);
+    assert(batch_predictor_run(predictor, network, windows, 5, steps) == -1);
+    
+    Matrix* expected = matrix_create(6, 1);
+    for (int b = 0; b < count; b++) {
+        assert(lstm_network_predict_window(network, windows[b], steps, expected) == 0);
+        for (int k = 0; k < 6; k++) {
+            assert(fabs(MATRIX_AT(predictor->output, k, b) - matrix_get(expected, k, 0)) < 1e-12);
+        }
+    }
+    
+    // Multi-station files are indexed by contiguous station groups
+    const char* path = "test_stations.csv";
+    FILE* file = fopen(path, "w");
+    fprintf(file, "station,temperature,pressure,humidity,wind_speed,wind_direction,precipitation\n");
+    fprintf(file, "KSEA,45.0,30.0,60.0,8.0,180.0,0.0\nKSEA,46.0,30.1,61.0,9.0,181.0,0.1\n\n");
+    fprintf(file, "KPDX,50.0,29.9,70.0,5.0,90.0,0.2\nKPDX,bad\n");
+    fclose(file);
+    
+    WeatherDataset* dataset = weather_dataset_create(1);
+    WeatherStations* stations = weather_load_stations_csv(path, dataset);
+    assert(stations != NULL && stations->count == 2 && dataset->size == 3);
+    assert(strcmp(stations->ids[0], "KSEA") == 0 && strcmp(stations->ids[1], "KPDX") == 0);
+    assert(stations->starts[0] == 0 && stations->starts[1] == 2 && stations->starts[2] == 3);
+    assert(dataset->data[2].precipitation == 0.2);
+    assert(weather_load_stations_csv("data/test_weather.csv", dataset) == NULL);
+    remove(path);
+    
+    weather_stations_free(stations);
+    weather_dataset_free(dataset);
+    matrix_free(expected);
+    batch_predictor_free(predictor);
+    lstm_network_free(network);
+    
+    printf("Batch prediction tests passed!\n");
+}
+
+// Versioned model files round-trip every tensor and load as mapped views
+void test_model_file() {
+    printf("Testing model file format...\n");
+    
+    const char* path = "test_model_file.bin";
+    LSTMNetwork* network = lstm_network_create(6, 10, 6);
+    network->sequence_length = 7;
+    network->norm_params = calloc(1, sizeof(NormalizationParams));
+    network->norm_params->temp_max = 100.0;
+    assert(save_lstm_model(network, path) == 0);
+    
+    LSTMNetwork* loaded = load_lstm_model(path);
+    assert(loaded != NULL && loaded->map_base != NULL);
+    assert(loaded->hidden_size == 10 && loaded->sequence_length == 7);
+    assert(loaded->norm_params && loaded->norm_params->temp_max == 100.0);
+    LSTMCell* a = network->lstm_layer;
+    LSTMCell* b = loaded->lstm_layer;
+    assert(memcmp(a->W->storage, b->W->storage, 40 * 6 * sizeof(double)) == 0);
+    assert(memcmp(a->U->storage, b->U->storage, 40 * 10 * sizeof(double)) == 0);
+    assert(memcmp(a->b->storage, b->b->storage, 40 * sizeof(double)) == 0);
+    assert(memcmp(network->W_output->storage, loaded->W_output->storage, 6 * 10 * sizeof(double)) == 0);
+    assert(((uintptr_t)b->W->storage % MATRIX_ALIGNMENT) == 0);
+    assert(((uintptr_t)b->U->storage % MATRIX_ALIGNMENT) == 0);
+    assert(b->W_o->storage == b->W->storage + 30 * 6);
+    
+    // Same weights, same predictions
+    double window[7 * 6];
+    for (int i = 0; i < 7 * 6; i++) window[i] = cos(0.3 * i);
+    Matrix* expected = matrix_create(6, 1);
+    Matrix* actual = matrix_create(6, 1);
+    assert(lstm_network_predict_window(network, window, 7, expected) == 0);
+    assert(lstm_network_predict_window(loaded, window, 7, actual) == 0);
+    assert(memcmp(expected->storage, actual->storage, 6 * sizeof(double)) == 0);
+    
+    // Private mapping: updating loaded weights leaves the file alone
+    MATRIX_AT(b->U, 0, 0) += 1.0;
+    LSTMNetwork* again = load_lstm_model(path);
+    assert(again && MATRIX_AT(again->lstm_layer->U, 0, 0) == MATRIX_AT(a->U, 0, 0));
+    lstm_network_free(again);
+    
+    // A flipped weight byte fails the checksum
+    FILE* file = fopen(path, "r+b");
+    fseek(file, (long)((LSTMModelHeader*)loaded->map_base)->tensors[LSTM_TENSOR_U].offset + 3, SEEK_SET);
+    fputc(0x5A, file);
+    fclose(file);
+    assert(load_lstm_model(path) == NULL);
+    
+    // Headers with a bad tensor count or window length are rejected
+    for (int field = 0; field < 2; field++) {
+        assert(save_lstm_model(network, path) == 0);
+        LSTMModelHeader header;
+        file = fopen(path, "r+b");
+        assert(fread(&header, sizeof(header), 1, file) == 1);
+        if (field == 0) header.num_tensors++;
+        else header.sequence_length = 0;
+        rewind(file);
+        fwrite(&header, sizeof(header), 1, file);
+        fclose(file);
+        assert(load_lstm_model(path) == NULL);
+    }
+    
+    // Legacy files still load: dimensions, output layer and norm params
+    file = fopen(path, "wb");
+    int dims[3] = {6, 10, 6}, sequence_length = 5, has_norm = 0;
+    double learning_rate = 0.01;
+    fwrite(dims, sizeof(int), 3, file);
+    fwrite(&learning_rate, sizeof(double), 1, file);
+    fwrite(&sequence_length, sizeof(int), 1, file);
+    fwrite(network->W_output->storage, sizeof(double), 6 * 10, file);
+    fwrite(network->b_output->storage, sizeof(double), 6, file);
+    fwrite(&has_norm, sizeof(int), 1, file);
+    fclose(file);
+    LSTMNetwork* legacy = load_lstm_model(path);
+    assert(legacy && legacy->map_base == NULL && legacy->sequence_length == 5);
+    assert(memcmp(network->W_output->storage, legacy->W_output->storage, 6 * 10 * sizeof(double)) == 0);
+    remove(path);
+    
+    matrix_free(expected);
+    matrix_free(actual);
+    lstm_network_free(legacy);
+    lstm_network_free(loaded);
+    lstm_network_free(network);
+    
+    printf("Model file format tests passed!\n");
+}
+
+// Forecast step h continues the state, so it equals a replay of the window
+// followed by the first h - 1 predictions
+void test_forecast() {
+    printf("Testing multi-step forecast...\n");
+    
+    LSTMNetwork* network = lstm_network_create(6, 12, 6);
+    network->sequence_length = 4;
+    WeatherDataset* dataset = weather_dataset_create(8);
+    for (int i = 0; i < 6; i++) {
+        WeatherPoint point = {0.1 * i, 0.5, 0.3 + 0.05 * i, 0.2, 0.7, 0.0};
+        weather_dataset_add(dataset, point);
+    }
+    
+    int horizon = 5;
+    WeatherDataset* forecast = lstm_forecast(network, dataset, horizon);
+    assert(forecast != NULL && forecast->size == horizon);
+    
+    WeatherPoint next = lstm_predict_next(network, dataset, network->sequence_length);
+    assert(memcmp(&next, &forecast->data[0], sizeof(WeatherPoint)) == 0);
+    
+    // Replay buffer: last window, then the predictions fed back so far
+    double replay[(4 + 5) * 6];
+    memcpy(replay, &dataset->data[2], 4 * sizeof(WeatherPoint));
+    memcpy(replay + 4 * 6, forecast->data, (size_t)horizon * sizeof(WeatherPoint));
+    Matrix* expected = matrix_create(6, 1);
+    for (int h = 1; h < horizon; h++) {
+        assert(lstm_network_predict_window(network, replay, 4 + h, expected) == 0);
+        WeatherPoint replayed = matrix_to_weather_point(expected);
+        assert(fabs(replayed.temperature - forecast->data[h].temperature) < 1e-12);
+        assert(fabs(replayed.precipitation - forecast->data[h].precipitation) < 1e-12);
+    }
+    
+    assert(lstm_forecast(network, dataset, 0) == NULL);
+    network->sequence_length = 7;
+    assert(lstm_forecast(network, dataset, 3) == NULL);
+    
+    matrix_free(expected);
+    weather_dataset_free(forecast);
+    weather_dataset_free(dataset);
+    lstm_network_free(network);
+    
+    printf("Multi-step forecast tests passed!\n");
+}
+
+// float32 weights track the double network closely; int8 stays within the
+// quantization step
+void test_reduced_precision() {
+    printf("Testing reduced-precision inference...\n");
+    
+    LSTMNetwork* network = lstm_network_create(6, 20, 6);
+    double window[5 * 6];
+    for (int i = 0; i < 5 * 6; i++) window[i] = 0.5 + 0.4 * sin(0.3 * i);
+    
+    double reference[6], output[6];
+    double tolerance[LSTM_NUM_PRECISIONS] = {0.0, 1e-5, 2e-2};
+    for (int p = 0; p < LSTM_NUM_PRECISIONS; p++) {
+        ReducedModel* model = reduced_model_create(network, (LSTMPrecision)p);
+        assert(model != NULL);
+        assert(reduced_model_predict_window(model, window, 5, p == 0 ? reference : output) == 0);
+        if (p > 0) {
+            for (int i = 0; i < 6; i++) {
+                assert(fabs(output[i] - reference[i]) <= tolerance[p]);
+            }
+        }
+        reduced_model_free(model);
+    }
+    
+    LSTMPrecision precision;
+    assert(lstm_precision_parse("int8", &precision) == 0 && precision == LSTM_PRECISION_INT8);
+    assert(lstm_precision_parse("f16", &precision) == -1);
+    assert(strcmp(lstm_precision_name(LSTM_PRECISION_F32), "f32") == 0);
+    
+    lstm_network_free(network);
+    
+    printf("Reduced-precision inference tests passed!\n");
+}
+
+// Stateful serving: t observations give the prediction of a t-step window
+void test_inference_server() {
+    printf("Testing inference server...\n");
+    
+    const char* path = "test_serve_model.bin";
+    LSTMNetwork* network = lstm_network_create(6, 8, 6);
+    assert(save_lstm_model(network, path) == 0);
+    
+    InferenceServer* server = inference_server_create();
+    assert(server != NULL);
+    assert(inference_server_add_model(server, "default", path) == 0);
+    assert(inference_server_add_model(server, "default", path) == -1);
+    assert(inference_server_add_model(server, "second", path) == 0);
+    
+    double rows[4 * 6];
+    for (int i = 0; i < 4 * 6; i++) rows[i] = 0.5 + 0.4 * sin(0.9 * i);
+    
+    FILE* out = tmpfile();
+    char line[256], reply[256];
+    for (int t = 0; t < 4; t++) {
+        double* r = rows + t * 6;
+        snprintf(line, sizeof(line), "OBS KSEA %.17g,%.17g,%.17g,%.17g,%.17g,%.17g\n",
+                 r[0], r[1], r[2], r[3], r[4], r[5]);
+        assert(inference_server_handle(server, line, out) == 0);
+    }
+    StationState* station = &server->stations[0];
+    assert(server->num_stations == 1 && station->steps == 4);
+    
+    Matrix* expected = matrix_create(6, 1);
+    assert(lstm_network_predict_window(server->models[0], rows, 4, expected) == 0);
+    for (int k = 0; k < 6; k++) {
+        assert(fabs(matrix_get(station->output, k, 0) - matrix_get(expected, k, 0)) < 1e-12);
+    }
+    
+    // Many stations force the index to grow; lookups must survive rehashing
+    for (int s = 0; s < 100; s++) {
+        snprintf(line, sizeof(line), "OBS S%d 0.1,0.2,0.3,0.4,0.5,0.6\n", s);
+        inference_server_handle(server, line, out);
+    }
+    assert(server->num_stations == 101);
+    
+    assert(inference_server_handle(server, "BIND KSEA second\n", out) == 0);
+    assert(server->stations[0].model == 1 && server->stations[0].steps == 0);
+    
+    // Over-long station ids are refused, not truncated onto another station
+    char id[80];
+    memset(id, 'K', sizeof(id));
+    id[63] = '\0';
+    snprintf(line, sizeof(line), "OBS %s 0.1,0.2,0.3,0.4,0.5,0.6\n", id);
+    assert(inference_server_handle(server, line, out) == 0);
+    assert(server->num_stations == 102);
+    id[63] = 'A';
+    id[64] = '\0';
+    snprintf(line, sizeof(line), "OBS %s 0.1,0.2,0.3,0.4,0.5,0.6\n", id);
+    assert(inference_server_handle(server, line, out) == 0);
+    snprintf(line, sizeof(line), "BIND %s second\n", id);
+    assert(inference_server_handle(server, line, out) == 0);
+    assert(server->num_stations == 102);
+    assert(inference_server_handle(server, "QUIT\n", out) == 1);
+    
+    // Every request got exactly one reply line
+    rewind(out);
+    int replies = 0, errors = 0;
+    while (fgets(reply, sizeof(reply), out)) {
+        replies++;
+        if (strncmp(reply, "ERR", 3) == 0) errors++;
+    }
+    assert(replies == 4 + 100 + 5 && errors == 2);
+    fclose(out);
+    remove(path);
+    
+    matrix_free(expected);
+    inference_server_free(server);
+    lstm_network_free(network);
+    
+    printf("Inference server tests passed!\n");
+}
+
+// Loss of a network on one sequence, for finite differences
+static double sequence_loss(LSTMNetwork* network, Matrix** sequence, int steps, Matrix* target) {
+    Matrix* prediction = lstm_network_predict(network, sequence, steps);
+    double loss = calculate_loss(prediction, target);
+    matrix_free(prediction);
+    return loss;
+}
+
+// Compare one analytic gradient entry with a central difference
+static void check_gradient(LSTMNetwork* network, Matrix** sequence, int steps, Matrix* target,
+                           Matrix* param, Matrix* grad, int row, int col) {
+    double eps = 1e-6;
+    double saved = MATRIX_AT(param, row, col);
+    MATRIX_AT(param, row, col) = saved + eps;
+    double plus = sequence_loss(network, sequence, steps, target);
+    MATRIX_AT(param, row, col) = saved - eps;
+    double minus = sequence_loss(network, sequence, steps, target);
+    MATRIX_AT(param, row, col) = saved;
+    
+    double numeric = (plus - minus) / (2.0 * eps);
+    double analytic = MATRIX_AT(grad, row, col);
+    double denom = fmax(1e-8, fabs(numeric) + fabs(analytic));
+    assert(fabs(numeric - analytic) / denom < 1e-4 || fabs(numeric - analytic) < 1e-9);
+}
+
+// Test BPTT gradients against finite differences
+void test_bptt_gradients() {
+    printf("Testing BPTT gradients...\n");
+    
+    int steps = 5;
+    LSTMNetwork* network = lstm_network_create(3, 4, 2);
+    assert(network != NULL);
+    
+    Matrix* sequence[5];
+    for (int t = 0; t < steps; t++) {
+        sequence[t] = matrix_create(3, 1);
+        for (int i = 0; i < 3; i++) {
+            matrix_set(sequence[t], i, 0, sin(1.0 + t * 3 + i));
+        }
+    }
+    Matrix* target = matrix_create(2, 1);
+    matrix_set(target, 0, 0, 0.3);
+    matrix_set(target, 1, 0, -0.2);
+    
+    BPTTTrainer* trainer = bptt_trainer_create(network, steps, 1);
+    assert(trainer != NULL);
+    assert(bptt_forward(trainer, network, sequence, steps) == 0);
+    double loss = bptt_backward(trainer, network, target, 0);
+    assert(fabs(loss - sequence_loss(network, sequence, steps, target)) < 1e-12);
+    
+    LSTMCell* cell = network->lstm_layer;
+    LSTMGradients* g = trainer->grads;
+    for (int r = 0; r < cell->W->rows; r += 3) {
+        check_gradient(network, sequence, steps, target, cell->W, g->dW[0], r, r % 3);
+        check_gradient(network, sequence, steps, target, cell->U, g->dU[0], r, r % 4);
+        check_gradient(network, sequence, steps, target, cell->b, g->db[0], r, 0);
+    }
+    for (int r = 0; r < 2; r++) {
+        check_gradient(network, sequence, steps, target, network->W_output, g->dW_output, r, 1 + r);
+        check_gradient(network, sequence, steps, target, network->b_output, g->db_output, r, 0);
+    }
+    
+    // A truncated window keeps the output gradient but drops early-step terms
+    Matrix* full_dW = matrix_create(cell->W->rows, cell->W->cols);
+    matrix_copy(full_dW, g->dW[0]);
+    lstm_gradients_zero(g);
+    assert(bptt_forward(trainer, network, sequence, steps) == 0);
+    bptt_backward(trainer, network, target, 1);
+    assert(fabs(matrix_get(g->dW[0], 0, 0) - matrix_get(full_dW, 0, 0)) > 1e-12);
+    
+    // A gradient step lowers the loss
+    lstm_gradients_zero(g);
+    bptt_forward(trainer, network, sequence, steps);
+    bptt_backward(trainer, network, target, 0);
+    lstm_gradients_apply(network, g, 0.05);
+    assert(sequence_loss(network, sequence, steps, target) < loss);
+    
+    matrix_free(full_dW);
+    bptt_trainer_free(trainer);
+    for (int t = 0; t < steps; t++) {
+        matrix_free(sequence[t]);
+    }
+    matrix_free(target);
+    lstm_network_free(network);
+    
+    printf("BPTT gradients tests passed!\n");
+}
+
+// Test that a padded mini-batch matches per-sequence gradients summed
+void test_bptt_batch() {
+    printf("Testing mini-batch BPTT...\n");
+    
+    int steps = 4;
+    int count = 5;
+    LSTMNetwork* network = lstm_network_create(3, 4, 2);
+    assert(network != NULL);
+    
+    // Windows over 9 rows of 3 features; targets are the first 2 of the next row
+    double features[(5 + 4) * 3];
+    for (int r = 0; r < count + steps; r++) {
+        for (int i = 0; i < 3; i++) {
+            features[r * 3 + i] = cos(0.7 * r + 1.3 * i);
+        }
+    }
+    TrainingData* view = training_data_view(features, 3, count + steps, steps);
+    assert(view != NULL && view->num_sequences == count);
+    
+    BPTTTrainer* single = bptt_trainer_create(network, steps, 1);
+    BPTTTrainer* batch = bptt_trainer_create(network, steps, 3);
+    assert(single != NULL && batch != NULL);
+    assert(bptt_load_batch(batch, view, 4, 4) == -1);
+    
+    double single_loss = 0.0;
+    for (int s = 0; s < count; s++) {
+        assert(bptt_load_batch(single, view, s, 1) == 0);
+        assert(single->inputs[0]->storage == features + s * 3);  // read in place
+        assert(bptt_forward(single, network, single->inputs, steps) == 0);
+        single_loss += bptt_backward(single, network, single->targets, 0);
+    }
+    
+    // Batches of 3 and a padded batch of 2
+    double batch_loss = 0.0;
+    for (int first = 0; first < count; first += 3) {
+        int n = count - first < 3 ? count - first : 3;
+        assert(bptt_load_batch(batch, view, first, n) == 0);
+        assert(bptt_forward(batch, network, batch->inputs, steps) == 0);
+        batch_loss += bptt_backward(batch, network, batch->targets, 0);
+    }
+    assert(fabs(single_loss - batch_loss) < 1e-12);
+    
+    Matrix* a[] = {single->grads->dW[0], single->grads->dU[0], single->grads->db[0],
+                   single->grads->dW_output, single->grads->db_output};
+    Matrix* b[] = {batch->grads->dW[0], batch->grads->dU[0], batch->grads->db[0],
+                   batch->grads->dW_output, batch->grads->db_output};
+    for (int p = 0; p < 5; p++) {
+        for (int i = 0; i < a[p]->rows; i++) {
+            for (int j = 0; j < a[p]->cols; j++) {
+                assert(fabs(matrix_get(a[p], i, j) - matrix_get(b[p], i, j)) < 1e-10);
+            }
+        }
+    }
+    
+    bptt_trainer_free(single);
+    bptt_trainer_free(batch);
+    free_training_data(view);
+    lstm_network_free(network);
+    
+    printf("Mini-batch BPTT tests passed!\n");
+}
+
+// Wavefront step: checks that both dependencies of (layer, t) already ran
+typedef struct {
+    int reverse;
+    int steps;
+    int done[3][5];
+} WavefrontOrder;
+
+static int wavefront_order_step(void* arg, int layer, int t) {
+    WavefrontOrder* order = arg;
+    int prev_t = order->reverse ? t + 1 : t - 1;
+    int prev_layer = order->reverse ? layer + 1 : layer - 1;
+    if (prev_t >= 0 && prev_t < order->steps && !order->done[layer][prev_t]) return -1;
+    if (prev_layer >= 0 && prev_layer < 3 && !order->done[prev_layer][t]) return -1;
+    order->done[layer][t] = 1;
+    return 0;
+}
+
+// Test stacked layers: gradients, pipelined passes, model files and batches
+void test_stacked_layers() {
+    printf("Testing stacked layers...\n");
+    
+    // Wavefront order holds serially and across workers, in both directions
+    ThreadPool* pool = thread_pool_create(2);
+    assert(pool != NULL);
+    for (int r = 0; r < 2; r++) {
+        for (int p = 0; p < 2; p++) {
+            WavefrontOrder order = {0};
+            order.reverse = r;
+            order.steps = 5;
+            assert(wavefront_run(p ? pool : NULL, 3, 5, r, wavefront_order_step, &order) == 0);
+            for (int l = 0; l < 3; l++) {
+                for (int t = 0; t < 5; t++) assert(order.done[l][t]);
+            }
+        }
+    }
+    
+    int steps = 5;
+    LSTMNetwork* network = lstm_network_create_stacked(3, 4, 2, 2);
+    assert(network != NULL && network->num_layers == 2);
+    assert(network->lstm_layer == network->layers[0] && lstm_network_top(network) == network->layers[1]);
+    assert(network->layers[1]->W->cols == 4);
+    assert(lstm_network_create_stacked(3, 4, 2, LSTM_MAX_LAYERS + 1) == NULL);
+    
+    Matrix* sequence[5];
+    for (int t = 0; t < steps; t++) {
+        sequence[t] = matrix_create(3, 1);
+        for (int i = 0; i < 3; i++) {
+            matrix_set(sequence[t], i, 0, sin(1.0 + t * 3 + i));
+        }
+    }
+    Matrix* target = matrix_create(2, 1);
+    matrix_set(target, 0, 0, 0.3);
+    matrix_set(target, 1, 0, -0.2);
+    
+    // Gradients reach both layers through the inter-layer connection
+    BPTTTrainer* serial = bptt_trainer_create(network, steps, 1);
+    assert(serial != NULL && serial->num_layers == 2);
+    assert(bptt_forward(serial, network, sequence, steps) == 0);
+    double loss = bptt_backward(serial, network, target, 0);
+    assert(fabs(loss - sequence_loss(network, sequence, steps, target)) < 1e-12);
+    
+    LSTMGradients* g = serial->grads;
+    for (int l = 0; l < 2; l++) {
+        LSTMCell* cell = network->layers[l];
+        for (int r = 0; r < cell->W->rows; r += 3) {
+            check_gradient(network, sequence, steps, target, cell->W, g->dW[l], r, r % cell->W->cols);
+            check_gradient(network, sequence, steps, target, cell->U, g->dU[l], r, r % 4);
+            check_gradient(network, sequence, steps, target, cell->b, g->db[l], r, 0);
+        }
+    }
+    
+    // Pipelined passes run the same arithmetic, so results match exactly
+    BPTTTrainer* pipelined = bptt_trainer_create(network, steps, 1);
+    assert(pipelined != NULL);
+    pipelined->pool = pool;
+    assert(bptt_forward(pipelined, network, sequence, steps) == 0);
+    assert(bptt_backward(pipelined, network, target, 0) == loss);
+    for (int l = 0; l < 2; l++) {
+        Matrix* a[] = {serial->grads->dW[l], serial->grads->dU[l], serial->grads->db[l]};
+        Matrix* b[] = {pipelined->grads->dW[l], pipelined->grads->dU[l], pipelined->grads->db[l]};
+        for (int p = 0; p < 3; p++) {
+            assert(memcmp(a[p]->storage, b[p]->storage, (size_t)a[p]->rows * a[p]->cols * sizeof(double)) == 0);
+        }
+    }
+    
+    // A gradient step lowers the loss
+    lstm_gradients_apply(network, g, 0.05);
+    assert(sequence_loss(network, sequence, steps, target) < loss);
+    
+    bptt_trainer_free(serial);
+    bptt_trainer_free(pipelined);
+    for (int t = 0; t < steps; t++) {
+        matrix_free(sequence[t]);
+    }
+    matrix_free(target);
+    lstm_network_free(network);
+    
+    // Model files carry every layer
+    const char* path = "test_stacked_model.bin";
+    network = lstm_network_create_stacked(6, 8, 6, 3);
+    assert(network != NULL && save_lstm_model(network, path) == 0);
+    LSTMNetwork* loaded = load_lstm_model(path);
+    assert(loaded != NULL && loaded->num_layers == 3);
+    assert(((LSTMModelHeader*)loaded->map_base)->num_layers == 3);
+    for (int l = 0; l < 3; l++) {
+        assert(memcmp(network->layers[l]->U->storage, loaded->layers[l]->U->storage, 32 * 8 * sizeof(double)) == 0);
+    }
+    remove(path);
+    
+    double features[(3 + 5) * 6];
+    for (int i = 0; i < (3 + 5) * 6; i++) features[i] = 0.5 + 0.4 * sin(0.7 * i);
+    double* windows[3] = {features, features + 6, features + 12};
+    Matrix* expected = matrix_create(6, 1);
+    Matrix* actual = matrix_create(6, 1);
+    
+    // Batched, pipelined and per-step state all match the window prediction
+    BatchPredictor* predictor = batch_predictor_create(loaded, 4);
+    assert(predictor != NULL);
+    Matrix* hidden = matrix_create(3 * 8, 1);
+    Matrix* cell = matrix_create(3 * 8, 1);
+    Matrix* x = matrix_create(6, 1);
+    for (int p = 0; p < 2; p++) {
+        predictor->pool = p ? pool : NULL;
+        assert(batch_predictor_run(predictor, loaded, windows, 3, steps) == 0);
+        for (int b = 0; b < 3; b++) {
+            assert(lstm_network_predict_window(network, windows[b], steps, expected) == 0);
+            for (int k = 0; k < 6; k++) {
+                assert(fabs(MATRIX_AT(predictor->output, k, b) - matrix_get(expected, k, 0)) < 1e-12);
+            }
+        }
+    }
+    matrix_zero(hidden);
+    matrix_zero(cell);
+    for (int t = 0; t < steps; t++) {
+        memcpy(x->storage, windows[2] + t * 6, 6 * sizeof(double));
+        assert(lstm_network_step_state(loaded, x, hidden, cell, actual) == 0);
+    }
+    for (int k = 0; k < 6; k++) {
+        assert(fabs(matrix_get(actual, k, 0) - matrix_get(expected, k, 0)) < 1e-12);
+    }
+    
+    matrix_free(x);
+    matrix_free(hidden);
+    matrix_free(cell);
+    matrix_free(expected);
+    matrix_free(actual);
+    batch_predictor_free(predictor);
+    lstm_network_free(loaded);
+    lstm_network_free(network);
+    thread_pool_free(pool);
+    
+    printf("Stacked layers tests passed!\n");
+}
+
+// Test renormalization, streaming CSV lines and incremental updates
+void test_online_training() {
+    printf("Testing online training...\n");
+    
+    // Widening the normalization leaves raw-unit predictions unchanged, even
+    // for a feature that had no range before
+    LSTMNetwork* network = lstm_network_create(6, 8, 6);
+    network->sequence_length = 3;
+    network->norm_params = calloc(1, sizeof(NormalizationParams));
+    double* bounds = (double*)network->norm_params;
+    for (int j = 0; j < 6; j++) {
+        bounds[2 * j] = 10.0 * j;
+        bounds[2 * j + 1] = j == 5 ? 50.0 : 10.0 * j + 5.0;
+    }
+    NormalizationParams wider = *network->norm_params;
+    double* wide = (double*)&wider;
+    for (int j = 0; j < 6; j++) {
+        wide[2 * j] -= 2.0;
+        wide[2 * j + 1] += 3.0 + j;
+    }
+    
+    WeatherPoint raw[3];
+    for (int t = 0; t < 3; t++) {
+        double* f = (double*)&raw[t];
+        for (int j = 0; j < 6; j++) f[j] = 10.0 * j + 1.0 + t;
+    }
+    raw[1].precipitation = 50.0;
+    
+    Matrix* outputs[2] = {matrix_create(6, 1), matrix_create(6, 1)};
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) assert(lstm_network_renormalize(network, &wider) == 0);
+        WeatherPoint window[3];
+        memcpy(window, raw, sizeof(raw));
+        WeatherDataset staged = {window, 3, 3, NULL, 0};
+        normalize_dataset(&staged, network->norm_params);
+        assert(lstm_network_predict_window(network, (double*)window, 3, outputs[pass]) == 0);
+        WeatherPoint point = matrix_to_weather_point(outputs[pass]);
+        denormalize_point(&point, network->norm_params);
+        memcpy(outputs[pass]->storage, &point, sizeof(point));
+    }
+    for (int k = 0; k < 6; k++) {
+        assert(fabs(matrix_get(outputs[0], k, 0) - matrix_get(outputs[1], k, 0)) < 1e-9);
+    }
+    assert(network->norm_params->temp_min == wider.temp_min);
+    
+    // Stream lines parse like the bulk loader's rows
+    WeatherPoint point;
+    const char* legacy = "45.2,29.85,65.0,8.5,180.0,0.0\r\n";
+    assert(weather_parse_csv_line(legacy, strlen(legacy) - 1, 0, &point) == 0 && point.humidity == 65.0);
+    const char* stamped = "2024-01-01 00:00,1704067200,45.2,29.85,65.0,8.5,180.0,0.25";
+    assert(weather_parse_csv_line(stamped, strlen(stamped), 1, &point) == 0 && point.precipitation == 0.25);
+    assert(weather_parse_csv_line("temperature,pressure", 20, 0, &point) == -1);
+    assert(weather_csv_header_has_timestamps("timestamp,unix_timestamp,temperature"));
+    
+    // Only windows ending in new rows train; the last rows stay as context
+    OnlineTrainer* online = online_trainer_create(network);
+    assert(online != NULL && online->context == 3);
+    for (int t = 0; t < 3; t++) {
+        assert(online_trainer_add(online, &raw[t]) == 0);
+    }
+    assert(online_trainer_pending(online) == 0 && online_trainer_update(online, 1) == 0.0);
+    for (int t = 0; t < 100; t++) {
+        point = raw[t % 3];
+        point.temperature = 30.0 + t;
+        assert(online_trainer_add(online, &point) == 0);
+    }
+    assert(online_trainer_pending(online) == 100);
+    double first = online_trainer_update(online, 1);
+    assert(first > 0.0 && online->windows_trained == 100 && online->count == 3);
+    assert(online->renormalized == 1 && network->norm_params->temp_max == 129.0);
+    assert(online->rows[2].temperature == 129.0);
+    
+    // Training again on the same rows lowers the loss
+    for (int t = 0; t < 100; t++) {
+        point = raw[t % 3];
+        point.temperature = 30.0 + t;
+        online_trainer_add(online, &point);
+    }
+    assert(online_trainer_update(online, 20) < first);
+    assert(online->renormalized == 1);
+    
+    online_trainer_free(online);
+    matrix_free(outputs[0]);
+    matrix_free(outputs[1]);
+    lstm_network_free(network);
+    
+    printf("Online training tests passed!\n");
+}
+
+void test_hyperparameter_sweep() {
+    printf("Testing hyperparameter sweep...\n");
+    
+    int hidden[2] = {4, 8};
+    int sequence[2] = {3, 5};
+    double rates[2] = {0.05, 1e-9};
+    SweepTrial trials[8];
+    assert(sweep_grid(trials, 7, hidden, 2, sequence, 2, rates, 2) == -1);
+    assert(sweep_grid(trials, 8, hidden, 2, sequence, 2, rates, 2) == 8);
+    assert(trials[0].hidden_size == 4 && trials[1].learning_rate == 1e-9 && trials[2].sequence_length == 5);
+    assert(trials[7].hidden_size == 8 && trials[7].sequence_length == 5);
+    
+    // A smooth normalized series, shared by every trial
+    int rows = 240;
+    double* features = malloc((size_t)rows * 6 * sizeof(double));
+    for (int t = 0; t < rows; t++) {
+        for (int j = 0; j < 6; j++) {
+            features[t * 6 + j] = 0.5 + 0.4 * sin(0.15 * t + j);
+        }
+    }
+    
+    // Validation loss is the mean window MSE of the network's predictions
+    LSTMNetwork* network = lstm_network_create(6, 4, 6);
+    TrainingData* view = training_data_view(features, 6, 10, 3);
+    Matrix* output = matrix_create(6, 1);
+    double expected = 0.0;
+    for (int s = 0; s < view->num_sequences; s++) {
+        lstm_network_predict_window(network, training_data_input(view, s, 0), 3, output);
+        for (int k = 0; k < 6; k++) {
+            double diff = matrix_get(output, k, 0) - training_data_target(view, s)[k];
+            expected += diff * diff / 6.0;
+        }
+    }
+    assert(fabs(lstm_validation_loss(network, view) - expected / view->num_sequences) < 1e-12);
+    matrix_free(output);
+    free_training_data(view);
+    lstm_network_free(network);
+    
+    // Without early stopping the seed fixes every trial, whatever the core count
+    SweepOptions options;
+    sweep_options_default(&options);
+    options.epochs = 4;
+    options.eval_every = 2;
+    options.patience = 0;
+    options.prune_factor = 0.0;
+    SweepTrial serial[8];
+    memcpy(serial, trials, sizeof(trials));
+    assert(sweep_run(features, rows, 200, serial, 8, &options) == 0);
+    options.cores = 3;
+    assert(sweep_run(features, rows, 200, trials, 8, &options) == 0);
+    for (int i = 0; i < 8; i++) {
+        assert(serial[i].status == SWEEP_FINISHED && serial[i].epochs_run == 4);
+        assert(trials[i].best_loss == serial[i].best_loss && trials[i].initial_loss == serial[i].initial_loss);
+        assert(serial[i].best_loss <= serial[i].initial_loss);
+    }
+    assert(serial[0].best_loss < serial[0].initial_loss && serial[0].best_epoch > 0);
+    
+    // A trial that barely learns falls behind the best at the first checkpoint
+    options.cores = 1;
+    options.epochs = 8;
+    options.prune_factor = 1.0;
+    assert(sweep_grid(trials, 8, hidden, 1, sequence, 1, rates, 2) == 2);
+    assert(sweep_run(features, rows, 200, trials, 2, &options) == 0);
+    assert(trials[0].status == SWEEP_FINISHED && trials[0].epochs_run == 8);
+    assert(trials[1].status == SWEEP_PRUNED && trials[1].epochs_run == 2);
+    
+    // Ranking: failed last, otherwise by loss removed per second or by best loss
+    SweepTrial ranked[3];
+    memset(ranked, 0, sizeof(ranked));
+    ranked[0].status = SWEEP_FAILED;
+    ranked[1] = (SweepTrial){8, 3, 0.01, SWEEP_FINISHED, 1.0, 0.2, 4, 4, 4.0};     // 0.2 per second
+    ranked[2] = (SweepTrial){4, 3, 0.01, SWEEP_PRUNED, 1.0, 0.5, 2, 2, 1.0};       // 0.5 per second
+    assert(fabs(sweep_efficiency(&ranked[1]) - 0.2) < 1e-12 && sweep_efficiency(&ranked[0]) == 0.0);
+    sweep_rank(ranked, 3, 0);
+    assert(ranked[0].hidden_size == 4 && ranked[1].hidden_size == 8 && ranked[2].status == SWEEP_FAILED);
+    sweep_rank(ranked, 3, 1);
+    assert(ranked[0].hidden_size == 8 && ranked[2].status == SWEEP_FAILED);
+    
+    // Windows need more training rows than steps
+    trials[0].sequence_length = 200;
+    assert(sweep_run(features, rows, 200, trials, 1, &options) == 0 && trials[0].status == SWEEP_FAILED);
+    assert(trials[0].epochs_run == 0 && sweep_efficiency(&trials[0]) == 0.0);
+    assert(sweep_run(features, rows, rows, trials, 1, &options) == -1);
+    
+    free(features);
+    
+    printf("Hyperparameter sweep tests passed!\n");
+}
+
+// Epoch callback for test_evaluation: counts calls and records the last epoch
+static void count_epochs(LSTMNetwork* network, int epoch, double loss, void* context) {
+    int* seen = context;
+    (void)network;
+    assert(loss > 0.0);
+    seen[0]++;
+    seen[1] = epoch;
+}
+
+void test_evaluation() {
+    printf("Testing held-out evaluation...\n");
+    
+    int rows = 131;
+    double* features = malloc((size_t)rows * 6 * sizeof(double));
+    for (int t = 0; t < rows; t++) {
+        for (int j = 0; j < 6; j++) {
+            features[t * 6 + j] = 0.5 + 0.4 * sin(0.2 * t + j);
+        }
+    }
+    TrainingData* windows = training_data_view(features, 6, rows, 4);
+    
+    for (int layers = 1; layers <= 2; layers++) {
+        LSTMNetwork* network = lstm_network_create_stacked(6, 8, 6, layers);
+        network->norm_params = calloc(1, sizeof(NormalizationParams));
+        double* bounds = (double*)network->norm_params;
+        for (int j = 0; j < 6; j++) {
+            bounds[2 * j] = -1.0;
+            bounds[2 * j + 1] = j == 5 ? -1.0 : 1.0 + j;   // Precipitation has no range
+        }
+        
+        // Reference: one window at a time through the network's own state
+        double mae[6] = {0.0}, sse[6] = {0.0}, loss = 0.0;
+        Matrix* output = matrix_create(6, 1);
+        for (int s = 0; s < windows->num_sequences; s++) {
+            lstm_network_predict_window(network, training_data_input(windows, s, 0), 4, output);
+            for (int k = 0; k < 6; k++) {
+                double error = matrix_get(output, k, 0) - training_data_target(windows, s)[k];
+                double raw = error * (k == 5 ? 0.0 : 2.0 + k);
+                mae[k] += fabs(raw);
+                sse[k] += raw * raw;
+                loss += error * error;
+            }
+        }
+        matrix_free(output);
+        
+        // Batches of 5 leave a ragged last batch; 4 threads split 127 windows unevenly
+        EvaluationResult results[2];
+        int thread_counts[2] = {1, 4};
+        for (int r = 0; r < 2; r++) {
+            Evaluator* evaluator = evaluator_create(network, thread_counts[r], 5);
+            assert(evaluator != NULL);
+            assert(evaluator_run(evaluator, network, windows, &results[r]) == 0);
+            assert(results[r].windows == windows->num_sequences && results[r].raw_units);
+            evaluator_free(evaluator);
+        }
+        double n = windows->num_sequences;
+        for (int k = 0; k < 6; k++) {
+            for (int r = 0; r < 2; r++) {
+                assert(fabs(results[r].mae[k] - mae[k] / n) < 1e-9);
+                assert(fabs(results[r].rmse[k] - sqrt(sse[k] / n)) < 1e-9);
+            }
+        }
+        assert(results[0].mae[5] == 0.0 && results[1].rmse[5] == 0.0);
+        assert(fabs(results[0].loss - loss / (n * 6)) < 1e-12 && fabs(results[1].loss - results[0].loss) < 1e-12);
+        
+        // Without normalization params the errors stay in normalized units
+        free(network->norm_params);
+        network->norm_params = NULL;
+        Evaluator* evaluator = evaluator_create(network, 2, 64);
+        EvaluationResult plain;
+        assert(evaluator_run(evaluator, network, windows, &plain) == 0 && !plain.raw_units);
+        assert(fabs(plain.rmse[0] - results[0].rmse[0] / 2.0) < 1e-9);
+        
+        // More workers than windows leaves some idle
+        TrainingData* few = training_data_view(features, 6, 6, 4);
+        assert(evaluator_run(evaluator, network, few, &plain) == 0 && plain.windows == 2);
+        free_training_data(few);
+        evaluator_free(evaluator);
+        
+        lstm_network_free(network);
+    }
+    
+    // Networks that are not weather-shaped are rejected
+    LSTMNetwork* other = lstm_network_create(3, 4, 3);
+    assert(evaluator_create(other, 1, 8) == NULL);
+    lstm_network_free(other);
+    
+    // The epoch callback sees every epoch with its average loss
+    LSTMNetwork* network = lstm_network_create(6, 4, 6);
+    network->sequence_length = 4;
+    network->batch_size = 8;
+    int seen[2] = {0, 0};
+    network->epoch_callback = count_epochs;
+    network->epoch_context = seen;
+    lstm_train(network, windows, 3);
+    assert(seen[0] == 3 && seen[1] == 3);
+    ParallelTrainStats stats;
+    assert(lstm_train_parallel(network, windows, 2, 2, &stats) == 0);
+    assert(seen[0] == 5 && seen[1] == 2);
+    
+    // A resumed run numbers its epochs after the completed ones
+    network->first_epoch = 3;
+    lstm_train(network, windows, 2);
+    assert(seen[0] == 7 && seen[1] == 5);
+    assert(lstm_train_parallel(network, windows, 2, 2, &stats) == 0);
+    assert(seen[0] == 9 && seen[1] == 5);
+    lstm_network_free(network);
+    
+    free_training_data(windows);
+    free(features);
+    
+    printf("Held-out evaluation tests passed!\n");
+}
+
+void test_optimizer() {
+    printf("Testing optimizers...\n");
+    
+    OptimizerType type;
+    assert(optimizer_parse("adam", &type) == 0 && type == OPTIMIZER_ADAM);
+    assert(optimizer_parse("rmsprop", &type) == -1);
+    assert(strcmp(optimizer_name(OPTIMIZER_MOMENTUM), "momentum") == 0);
+    
+    LSTMNetwork* network = lstm_network_create_stacked(6, 5, 6, 2);
+    network->learning_rate = 0.1;
+    LSTMGradients* grads = lstm_gradients_create(network);
+    Matrix* tensors[2][OPTIMIZER_MAX_TENSORS];
+    int count = 0;
+    for (int l = 0; l < 2; l++) {
+        tensors[0][count] = network->layers[l]->W; tensors[1][count++] = grads->dW[l];
+        tensors[0][count] = network->layers[l]->U; tensors[1][count++] = grads->dU[l];
+        tensors[0][count] = network->layers[l]->b; tensors[1][count++] = grads->db[l];
+    }
+    tensors[0][count] = network->W_output; tensors[1][count++] = grads->dW_output;
+    tensors[0][count] = network->b_output; tensors[1][count++] = grads->db_output;
+    size_t total = 0;
+    for (int t = 0; t < count; t++) {
+        for (int i = 0; i < tensors[1][t]->rows * tensors[1][t]->cols; i++) {
+            tensors[1][t]->storage[i] = sin(0.3 * (double)(total + i)) + 0.01;
+        }
+        total += (size_t)tensors[1][t]->rows * tensors[1][t]->cols;
+    }
+    
+    double* before = malloc(total * sizeof(double));
+    double* after = malloc(total * sizeof(double));
+    #define SNAPSHOT(dst) do { size_t at = 0; for (int t = 0; t < count; t++) { \
+        size_t n = (size_t)tensors[0][t]->rows * tensors[0][t]->cols; \
+        memcpy((dst) + at, tensors[0][t]->storage, n * sizeof(double)); at += n; } } while (0)
+    #define GRAD(i) (sin(0.3 * (double)(i)) + 0.01)
+    
+    // Plain SGD matches lstm_gradients_apply
+    OptimizerConfig config;
+    optimizer_config_default(&config, OPTIMIZER_SGD);
+    Optimizer* sgd = optimizer_create(network, &config);
+    assert(sgd != NULL && sgd->slots == 0 && sgd->state == NULL && sgd->num_tensors == count);
+    SNAPSHOT(before);
+    assert(optimizer_step(sgd, network, grads, 0.5) == 0);
+    SNAPSHOT(after);
+    for (size_t i = 0; i < total; i++) {
+        assert(fabs(after[i] - (before[i] - 0.05 * GRAD(i))) < 1e-14);
+    }
+    lstm_gradients_apply(network, grads, -0.05);
+    optimizer_free(sgd);
+    
+    // Momentum: the second step moves by lr * (mu + 1) * g
+    optimizer_config_default(&config, OPTIMIZER_MOMENTUM);
+    config.momentum = 0.5;
+    Optimizer* momentum = optimizer_create(network, &config);
+    assert(momentum->slots == 1 && momentum->offsets[1] % (MATRIX_ALIGNMENT / sizeof(double)) == 0);
+    SNAPSHOT(before);
+    optimizer_step(momentum, network, grads, 1.0);
+    optimizer_step(momentum, network, grads, 1.0);
+    SNAPSHOT(after);
+    for (size_t i = 0; i < total; i++) {
+        assert(fabs(after[i] - (before[i] - 0.1 * GRAD(i) - 0.1 * 1.5 * GRAD(i))) < 1e-12);
+    }
+    optimizer_reset(momentum);
+    assert(momentum->steps == 0 && MATRIX_ROW(momentum->state, 0)[0] == 0.0);
+    optimizer_free(momentum);
+    
+    // Adam: bias correction makes the first step lr * g / (|g| + eps), about lr for every weight
+    optimizer_config_default(&config, OPTIMIZER_ADAM);
+    Optimizer* adam = optimizer_create(network, &config);
+    assert(adam->slots == 2 && adam->state->rows == 2 && (size_t)adam->state->cols == adam->size);
+    SNAPSHOT(before);
+    optimizer_step(adam, network, grads, 3.0);
+    SNAPSHOT(after);
+    for (size_t i = 0; i < total; i++) {
+        double g = 3.0 * GRAD(i);
+        assert(fabs(after[i] - (before[i] - 0.1 * g / (fabs(g) + 1e-8))) < 1e-12);
+    }
+    assert(adam->steps == 1);
+    optimizer_free(adam);
+    
+    // Clipping rescales the whole gradient to the limit, so SGD moves lr * limit
+    optimizer_config_default(&config, OPTIMIZER_SGD);
+    config.clip_norm = 1.0;
+    Optimizer* clipped = optimizer_create(network, &config);
+    double norm = lstm_gradients_norm(grads);
+    double squares = 0.0;
+    for (size_t i = 0; i < total; i++) squares += GRAD(i) * GRAD(i);
+    assert(fabs(norm - sqrt(squares)) < 1e-9 && norm > 2.0);
+    SNAPSHOT(before);
+    optimizer_step(clipped, network, grads, 2.0);
+    SNAPSHOT(after);
+    assert(fabs(clipped->last_norm - 2.0 * norm) < 1e-9);
+    double moved = 0.0;
+    for (size_t i = 0; i < total; i++) moved += (after[i] - before[i]) * (after[i] - before[i]);
+    assert(fabs(sqrt(moved) - 0.1) < 1e-12);
+    optimizer_free(clipped);
+    
+    // Bad settings and mismatched shapes are rejected
+    optimizer_config_default(&config, OPTIMIZER_ADAM);
+    config.beta2 = 1.0;
+    assert(optimizer_create(network, &config) == NULL);
+    optimizer_config_default(&config, OPTIMIZER_ADAM);
+    adam = optimizer_create(network, &config);
+    LSTMNetwork* other = lstm_network_create(6, 5, 6);
+    LSTMGradients* other_grads = lstm_gradients_create(other);
+    assert(optimizer_step(adam, other, other_grads, 1.0) == -1);
+    lstm_gradients_free(other_grads);
+    lstm_network_free(other);
+    optimizer_free(adam);
+    #undef SNAPSHOT
+    #undef GRAD
+    free(before);
+    free(after);
+    lstm_gradients_free(grads);
+    lstm_network_free(network);
+    
+    // Both training engines route their updates through network->optimizer
+    int rows = 80;
+    double* features = malloc((size_t)rows * 6 * sizeof(double));
+    for (int t = 0; t < rows; t++) {
+        for (int j = 0; j < 6; j++) features[t * 6 + j] = 0.5 + 0.4 * sin(0.2 * t + j);
+    }
+    TrainingData* data = training_data_view(features, 6, rows, 4);
+    network = lstm_network_create(6, 6, 6);
+    network->sequence_length = 4;
+    network->batch_size = 8;
+    network->learning_rate = 0.01;
+    adam = optimizer_create(network, &config);
+    network->optimizer = adam;
+    BPTTTrainer* trainer = bptt_trainer_create(network, 4, 8);
+    double first = bptt_train_epoch(trainer, network, data);
+    for (int epoch = 0; epoch < 10; epoch++) bptt_train_epoch(trainer, network, data);
+    assert(bptt_train_epoch(trainer, network, data) < first);
+    int batches = (data->num_sequences + 7) / 8;
+    assert(adam->steps == 12L * batches);
+    bptt_trainer_free(trainer);
+    ParallelTrainStats stats;
+    assert(lstm_train_parallel(network, data, 1, 2, &stats) == 0);
+    assert(adam->steps == 12L * batches + (data->num_sequences + 15) / 16);
+    optimizer_free(adam);
+    lstm_network_free(network);
+    free_training_data(data);
+    free(features);
+    
+    printf("Optimizer tests passed!\n");
+}
+
+void test_checkpoint() {
+    printf("Testing background checkpoints...\n");
+    
+    const char* path = "test_checkpoint.bin";
+    LSTMNetwork* network = lstm_network_create_stacked(6, 5, 6, 2);
+    network->sequence_length = 4;
+    NormalizationParams params;
+    memset(&params, 0, sizeof(params));
+    params.temp_max = 40.0;
+    network->norm_params = malloc(sizeof(NormalizationParams));
+    *network->norm_params = params;
+    
+    OptimizerConfig config;
+    optimizer_config_default(&config, OPTIMIZER_ADAM);
+    Optimizer* optimizer = optimizer_create(network, &config);
+    for (size_t i = 0; i < 2 * optimizer->size; i++) optimizer->state->storage[i] = 0.001 * (double)i;
+    optimizer->steps = 17;
+    
+    // Only due epochs snapshot; every one of them reaches the disk
+    Checkpointer* checkpointer = checkpointer_create(network, optimizer, path, 3, 0.0);
+    assert(checkpointer != NULL);
+    assert(checkpointer_epoch(checkpointer, network, optimizer, 1) == 0);
+    assert(checkpointer_epoch(checkpointer, network, optimizer, 3) == 1);
+    double w = MATRIX_AT(network->layers[1]->U, 2, 3);
+    double m = optimizer->state->storage[5];
+    
+    // Later changes do not leak into a snapshot already taken
+    assert(checkpointer_flush(checkpointer) == 0);
+    MATRIX_AT(network->layers[1]->U, 2, 3) += 1.0;
+    CheckpointStats stats;
+    checkpointer_stats(checkpointer, &stats);
+    assert(stats.taken == 1 && stats.written == 1 && stats.failures == 0);
+    
+    CheckpointInfo info;
+    assert(checkpoint_read_info(path, &info) == 1);
+    assert(info.state.epoch == 3 && info.state.steps == 17 && info.state.slots == 2);
+    assert(info.model.hidden_size == 5 && info.model.num_layers == 2 && info.model.has_norm_params);
+    
+    // The weights load like any model file
+    LSTMNetwork* loaded = load_lstm_model(path);
+    assert(loaded != NULL && loaded->sequence_length == 4);
+    assert(MATRIX_AT(loaded->layers[1]->U, 2, 3) == w);
+    assert(loaded->norm_params->temp_max == 40.0);
+    
+    Optimizer* restored = optimizer_create(loaded, &config);
+    int epoch = -1;
+    assert(checkpoint_restore(path, restored, &epoch) == 0);
+    assert(epoch == 3 && restored->steps == 17 && restored->state->storage[5] == m);
+    assert(memcmp(restored->state->storage, optimizer->state->storage, 2 * optimizer->size * sizeof(double)) == 0);
+    
+    // A restore needs the same update rule
+    OptimizerConfig other;
+    optimizer_config_default(&other, OPTIMIZER_MOMENTUM);
+    Optimizer* momentum = optimizer_create(loaded, &other);
+    assert(checkpoint_restore(path, momentum, &epoch) == -1);
+    optimizer_free(momentum);
+    
+    // Back-to-back snapshots leave the newest on disk
+    for (int e = 4; e <= 8; e++) {
+        optimizer->steps = e;
+        assert(checkpointer_save(checkpointer, network, optimizer, e) == 0);
+    }
+    checkpointer_free(checkpointer);
+    assert(checkpoint_read_info(path, &info) == 1 && info.state.epoch == 8 && info.state.steps == 8);
+    lstm_network_free(loaded);
+    loaded = load_lstm_model(path);
+    assert(MATRIX_AT(loaded->layers[1]->U, 2, 3) == w + 1.0);
+    
+    // A corrupted state section is refused and leaves the optimizer clean
+    FILE* file = fopen(path, "r+b");
+    fseek(file, -8, SEEK_END);
+    double garbage = 12345.0;
+    fwrite(&garbage, sizeof(double), 1, file);
+    fclose(file);
+    assert(checkpoint_restore(path, restored, &epoch) == -1);
+    assert(restored->steps == 0 && restored->state->storage[5] == 0.0);
+    
+    // A plain model file has no state section
+    assert(save_lstm_model(network, path) == 0);
+    assert(checkpoint_read_info(path, &info) == 0);
+    assert(checkpoint_read_info("missing_checkpoint.bin", &info) == -1);
+    
+    optimizer_free(restored);
+    optimizer_free(optimizer);
+    lstm_network_free(loaded);
+    lstm_network_free(network);
+    remove(path);
+    
+    printf("Checkpoint tests passed!\n");
+}
+
+// Test the chunked CSV parser against strtod and across thread counts
+void test_csv_parser() {
+    printf("Testing CSV parser...\n");
+    
+    const char* path = "test_parser.csv";
+    FILE* file = fopen(path, "w");
+    assert(file != NULL);
+    fprintf(file, "temperature,pressure,humidity,wind_speed,wind_direction,precipitation\n");
+    for (int i = 0; i < 500; i++) {
+        if (i % 97 == 5) fprintf(file, "not,a,row\n");
+        if (i % 131 == 7) fprintf(file, "\n");
+        fprintf(file, "%.1f,%.2f,%.17g,%d,%.3e,%.4f\n",
+                -20.0 + 0.3 * i, 29.0 + 0.01 * i, 1.0 / (i + 3), i, 360.0 / (i + 1), 0.0001 * i);
+    }
+    // A line far beyond the old 512-byte limit, and no trailing newline
+    fprintf(file, "1,2,3,4,5,0.");
+    for (int i = 0; i < 700; i++) fputc('1', file);
+    fprintf(file, "\n7.,+8,.5,1e2,-0.0,123456789012345678901234");
+    fclose(file);
+    
+    WeatherDataset* serial = weather_dataset_create(2);
+    WeatherDataset* parallel = weather_dataset_create(2);
+    assert(weather_load_csv_threads(path, serial, 1) == 0);
+    assert(weather_load_csv_threads(path, parallel, 3) == 0);
+    assert(serial->size == 502);
+    assert(parallel->size == serial->size);
+    assert(memcmp(serial->data, parallel->data, serial->size * sizeof(WeatherPoint)) == 0);
+    
+    // Values are bit-identical to strtod
+    for (int i = 0; i < 500; i += 37) {
+        char text[64];
+        snprintf(text, sizeof(text), "%.17g", 1.0 / (i + 3));
+        assert(serial->data[i].humidity == strtod(text, NULL));
+        snprintf(text, sizeof(text), "%.3e", 360.0 / (i + 1));
+        assert(serial->data[i].wind_direction == strtod(text, NULL));
+    }
+    assert(fabs(serial->data[500].precipitation - 0.1111111111) < 1e-9);
+    WeatherPoint* last = &serial->data[501];
+    assert(last->temperature == 7.0 && last->pressure == 8.0 && last->humidity == 0.5);
+    assert(last->wind_speed == 100.0 && last->wind_direction == 0.0);
+    assert(last->precipitation == strtod("123456789012345678901234", NULL));
+    
+    remove(path);
+    weather_dataset_free(serial);
+    weather_dataset_free(parallel);
+    
+    printf("CSV parser tests passed!\n");
+}
+
+// Test binary dataset round trip through a mapped file
+// Copy the first bytes of a file, as a truncated download would leave it
+static void copy_prefix(const char* from, const char* to, size_t bytes) {
+    FILE* in = fopen(from, "rb");
+    FILE* out = fopen(to, "wb");
+    assert(in && out);
+    for (size_t i = 0; i < bytes; i++) {
+        int c = fgetc(in);
+        assert(c != EOF);
+        fputc(c, out);
+    }
+    fclose(in);
+    fclose(out);
+}
+
+void test_binary_dataset() {
+    printf("Testing binary dataset format...\n");
+    
+    const char* path = "test_dataset.wdb";
+    WeatherDataset* dataset = weather_dataset_create(4);
+    for (int i = 0; i < 10; i++) {
+        WeatherPoint point = {40.0 + i, 29.5 + 0.1 * i, 50.0, 5.0 + i, 10.0 * i, 0.01 * i};
+        weather_dataset_add(dataset, point);
+    }
+    NormalizationParams* params = calculate_normalization_params(dataset);
+    assert(weather_save_binary(path, dataset, params, 0) == 0);
+    assert(weather_is_binary(path));
+    
+    WeatherDataset* mapped = weather_dataset_create(1);
+    NormalizationParams loaded_params;
+    int normalized = 1;
+    assert(weather_load_binary(path, mapped, &loaded_params, &normalized) == 0);
+    assert(mapped->map_base != NULL);
+    assert(mapped->size == 10 && normalized == 0);
+    assert(((uintptr_t)mapped->data % 64) == 0);
+    assert(memcmp(mapped->data, dataset->data, 10 * sizeof(WeatherPoint)) == 0);
+    assert(loaded_params.temp_max == 49.0 && loaded_params.wind_dir_max == 90.0);
+    
+    // Private mapping: normalizing in place leaves the file untouched
+    normalize_dataset(mapped, &loaded_params);
+    assert(fabs(mapped->data[9].temperature - 1.0) < 1e-12);
+    WeatherDataset* again = weather_dataset_create(1);
+    assert(weather_load_binary(path, again, NULL, NULL) == 0);
+    assert(again->data[9].temperature == 49.0);
+    
+    // Growing a mapped dataset copies it to the heap
+    WeatherPoint extra = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+    assert(weather_dataset_add(again, extra) == 0);
+    assert(again->map_base == NULL && again->size == 11);
+    assert(again->data[10].precipitation == 6.0 && again->data[0].temperature == 40.0);
+    
+    // Truncated files are rejected: inside the header, and before the data
+    const char* truncated = "test_dataset_truncated.wdb";
+    WeatherBinaryHeader header;
+    FILE* file = fopen(path, "rb");
+    assert(fread(&header, sizeof(header), 1, file) == 1);
+    fclose(file);
+    copy_prefix(path, truncated, sizeof(header) - 1);
+    assert(weather_load_binary(truncated, again, NULL, NULL) == -1);
+    copy_prefix(path, truncated, (size_t)header.data_offset - 16);
+    assert(weather_load_binary(truncated, again, NULL, NULL) == -1);
+    copy_prefix(path, truncated, (size_t)header.data_offset + 2 * sizeof(WeatherPoint));
+    assert(weather_load_binary(truncated, again, NULL, NULL) == -1);
+    remove(truncated);
+    assert(again->size == 11 && again->map_base == NULL);
+    
+    // Bad headers are rejected
+    assert(weather_is_binary("data/test_weather.csv") == 0);
+    file = fopen(path, "r+b");
+    fputc('X', file);
+    fclose(file);
+    assert(weather_load_binary(path, again, NULL, NULL) == -1);
+    remove(path);
+    
+    free(params);
+    weather_dataset_free(dataset);
+    weather_dataset_free(mapped);
+    weather_dataset_free(again);
+    
+    printf("Binary dataset format tests passed!\n");
+}
+
+// Columnar dataset must agree exactly with the row-oriented functions
+void test_weather_columns() {
+    printf("Testing columnar weather dataset...\n");
+    
+    WeatherDataset* dataset = weather_dataset_create(4);
+    for (int i = 0; i < 37; i++) {
+        WeatherPoint point = {40.0 + sin(0.3 * i) * 20.0, 29.5 + 0.01 * i, 50.0, 5.0 + (i % 7), 10.0 * i, 0.001 * (i % 5)};
+        weather_dataset_add(dataset, point);
+    }
+    
+    WeatherColumns* columns = weather_columns_from_dataset(dataset);
+    assert(columns != NULL && columns->size == 37);
+    for (int f = 0; f < WEATHER_NUM_FEATURES; f++) {
+        assert(((uintptr_t)columns->columns[f] % MATRIX_ALIGNMENT) == 0);
+    }
+    assert(columns->columns[0][5] == dataset->data[5].temperature);
+    assert(columns->columns[5][36] == dataset->data[36].precipitation);
+    
+    NormalizationParams* expected = calculate_normalization_params(dataset);
+    NormalizationParams* params = weather_columns_normalization_params(columns);
+    assert(memcmp(expected, params, sizeof(NormalizationParams)) == 0);
+    
+    // Humidity is constant and takes the min == max branch
+    normalize_dataset(dataset, expected);
+    weather_columns_normalize(columns, params);
+    WeatherDataset* rows = weather_columns_to_dataset(columns);
+    assert(rows != NULL && rows->size == 37);
+    assert(memcmp(rows->data, dataset->data, 37 * sizeof(WeatherPoint)) == 0);
+    assert(columns->columns[2][0] == 0.5);
+    
+    weather_columns_denormalize(columns, params);
+    for (int i = 0; i < 37; i++) {
+        denormalize_point(&dataset->data[i], expected);
+        for (int f = 0; f < WEATHER_NUM_FEATURES; f++) {
+            assert(columns->columns[f][i] == weather_dataset_features(dataset)[i * WEATHER_NUM_FEATURES + f]);
+        }
+    }
+    
+    WeatherColumns* empty = weather_columns_create(0);
+    assert(empty != NULL && weather_columns_normalization_params(empty) == NULL);
+    
+    free(expected);
+    free(params);
+    weather_columns_free(columns);
+    weather_columns_free(empty);
+    weather_dataset_free(rows);
+    weather_dataset_free(dataset);
+    
+    printf("Columnar weather dataset tests passed!\n");
+}
+
 // Test training data creation
 void test_training_data() {
     printf("Testing training data creation...\n");
@@ -203,16 +2069,34 @@ void test_training_data() {
     assert(training_data->sequence_length == 3);
     assert(training_data->num_sequences == 5); // 8 - 3 = 5 sequences
     
-    // Check first sequence
-    assert(training_data->inputs[0] != NULL);
-    assert(training_data->targets[0] != NULL);
+    // Windows point into the dataset rather than copying it
+    assert(training_data->feature_size == WEATHER_NUM_FEATURES);
+    assert(training_data_input(training_data, 0, 0) == &dataset->data[0].temperature);
+    assert(training_data_input(training_data, 2, 1) == &dataset->data[3].temperature);
     
     // Check that input sequence has correct values
-    Matrix* first_input = training_data->inputs[0][0];
-    assert(matrix_get(first_input, 0, 0) == 45.0); // First temperature
+    assert(training_data_input(training_data, 0, 0)[0] == 45.0); // First temperature
+    assert(training_data_target(training_data, 0)[0] == 48.0);   // Fourth temperature (45 + 3)
+    assert(training_data_target(training_data, 4)[2] == 60.0);   // Last humidity
     
-    Matrix* first_target = training_data->targets[0];
-    assert(matrix_get(first_target, 0, 0) == 48.0); // Fourth temperature (45 + 3)
+    // Window prediction matches the per-step matrix path
+    LSTMNetwork* network = lstm_network_create(6, 4, 6);
+    Matrix* sequence[3];
+    for (int t = 0; t < 3; t++) {
+        sequence[t] = weather_point_to_matrix(&dataset->data[1 + t]);
+    }
+    Matrix* expected = lstm_network_predict(network, sequence, 3);
+    Matrix* output = matrix_create(6, 1);
+    assert(lstm_network_predict_window(network, training_data_input(training_data, 1, 0), 3, output) == 0);
+    for (int i = 0; i < 6; i++) {
+        assert(fabs(matrix_get(output, i, 0) - matrix_get(expected, i, 0)) < 1e-12);
+    }
+    for (int t = 0; t < 3; t++) {
+        matrix_free(sequence[t]);
+    }
+    matrix_free(expected);
+    matrix_free(output);
+    lstm_network_free(network);
     
     free_training_data(training_data);
     weather_dataset_free(dataset);
@@ -220,15 +2104,139 @@ void test_training_data() {
     printf("Training data creation tests passed!\n");
 }
 
+// Pool task: each worker sums its slice of [0, count) into its own slot
+typedef struct {
+    ThreadPool* pool;
+    int count;
+    long* partial;
+    long total;
+} PoolSumTask;
+
+static void pool_sum_task(void* arg, int worker, int num_workers) {
+    PoolSumTask* task = arg;
+    int first, last;
+    thread_pool_range(task->count, worker, num_workers, &first, &last);
+    for (int i = first; i < last; i++) {
+        task->partial[worker] += i;
+    }
+    
+    // Every partial sum is visible after the barrier
+    thread_pool_barrier(task->pool);
+    if (worker == 0) {
+        for (int w = 0; w < num_workers; w++) {
+            task->total += task->partial[w];
+        }
+    }
+}
+
+// Test thread pool and data-parallel training
+void test_parallel_training() {
+    printf("Testing parallel training...\n");
+    
+    ThreadPool* pool = thread_pool_create(3);
+    assert(pool != NULL && thread_pool_size(pool) == 3);
+    long partial[3] = {0, 0, 0};
+    PoolSumTask task = {pool, 100, partial, 0};
+    thread_pool_run(pool, pool_sum_task, &task);
+    assert(task.total == 4950);
+    
+    // The pool is reusable across runs
+    task.total = 0;
+    partial[0] = partial[1] = partial[2] = 0;
+    thread_pool_run(pool, pool_sum_task, &task);
+    assert(task.total == 4950);
+    thread_pool_free(pool);
+    
+    int first, last;
+    thread_pool_range(10, 3, 4, &first, &last);
+    assert(first == 8 && last == 10);
+    
+    // Two threads with one sequence each make the same update as one
+    // thread with batches of two
+    WeatherDataset* dataset = weather_dataset_create(16);
+    for (int i = 0; i < 12; i++) {
+        WeatherPoint point = {0.5 + 0.3 * sin(i), 0.4, 0.6 + 0.1 * cos(i), 0.2, 0.5, 0.0};
+        weather_dataset_add(dataset, point);
+    }
+    TrainingData* data = create_training_data(dataset, 4);
+    assert(data != NULL);
+    
+    LSTMNetwork* serial = lstm_network_create(6, 5, 6);
+    LSTMNetwork* parallel = lstm_network_create(6, 5, 6);
+    assert(serial != NULL && parallel != NULL);
+    matrix_copy(parallel->lstm_layer->W, serial->lstm_layer->W);
+    matrix_copy(parallel->lstm_layer->U, serial->lstm_layer->U);
+    matrix_copy(parallel->lstm_layer->b, serial->lstm_layer->b);
+    matrix_copy(parallel->W_output, serial->W_output);
+    matrix_copy(parallel->b_output, serial->b_output);
+    serial->learning_rate = parallel->learning_rate = 0.1;
+    serial->batch_size = 2;
+    
+    lstm_train(serial, data, 3);
+    ParallelTrainStats stats;
+    assert(lstm_train_parallel(parallel, data, 3, 2, &stats) == 0);
+    assert(stats.threads == 2);
+    assert(stats.sequences == 3L * data->num_sequences);
+    assert(stats.wall_seconds > 0.0);
+    double utilization = parallel_train_utilization(&stats);
+    assert(utilization > 0.0 && utilization <= 1.0 + 1e-9);
+    assert(stats.reference_sequences > 0 && stats.reference_seconds > 0.0);
+    assert(parallel_train_speedup(&stats) > 0.0);
+    
+    Matrix* a[] = {serial->lstm_layer->W, serial->lstm_layer->U, serial->lstm_layer->b,
+                   serial->W_output, serial->b_output};
+    Matrix* b[] = {parallel->lstm_layer->W, parallel->lstm_layer->U, parallel->lstm_layer->b,
+                   parallel->W_output, parallel->b_output};
+    for (int p = 0; p < 5; p++) {
+        for (int i = 0; i < a[p]->rows; i++) {
+            for (int j = 0; j < a[p]->cols; j++) {
+                assert(fabs(matrix_get(a[p], i, j) - matrix_get(b[p], i, j)) < 1e-10);
+            }
+        }
+    }
+    
+    lstm_network_free(serial);
+    lstm_network_free(parallel);
+    free_training_data(data);
+    weather_dataset_free(dataset);
+    
+    printf("Parallel training tests passed!\n");
+}
+
 int main() {
     printf("Running Weather LSTM Tests\n");
     printf("==========================\n\n");
     
     test_matrix_operations();
+    test_matrix_storage();
+    test_matrix_into();
+    test_arena();
+    test_large_alloc();
+    test_profile();
+    test_matrix_kernels();
     test_weather_data();
     test_lstm_cell();
+    test_lstm_fused_gates();
+    test_lstm_fixed_shapes();
     test_lstm_network();
+    test_model_file();
+    test_forecast();
+    test_reduced_precision();
+    test_batch_predict();
+    test_inference_server();
+    test_csv_parser();
+    test_binary_dataset();
+    test_weather_columns();
     test_training_data();
+    test_bptt_gradients();
+    test_bptt_batch();
+    test_stacked_layers();
+    test_online_training();
+    test_hyperparameter_sweep();
+    test_evaluation();
+    test_optimizer();
+    test_checkpoint();
+    test_parallel_training();
     
     printf("\n==========================\n");
     printf("All tests passed! ✅\n");